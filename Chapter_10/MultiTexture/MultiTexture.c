@@ -50,36 +50,40 @@ typedef struct
    GLuint baseMapTexId;
    GLuint lightMapTexId;
 
+   // Loads the textures while the quad is already drawn
+   ESTextureStreamer *textureStreamer;
+
+   // Vertex and index buffer for the quad
+   GLuint vboIds[2];
+
+   // Vertex array object holding the quad's vertex state
+   ESVertexArrayCache *vaoCache;
+   GLuint vao;
+
 } UserData;
 
 ///
-// Load texture from disk
+// Start loading a texture from disk; it is drawn with a gray placeholder
+// until esUpdateTextureStreamer has uploaded it
 //
-GLuint LoadTexture ( void *ioContext, char *fileName )
+GLuint LoadTexture ( ESTextureStreamer *streamer, char *ktxFileName, char *tgaFileName )
 {
-   int width,
-       height;
-
-   char *buffer = esLoadTGA ( ioContext, fileName, &width, &height );
    GLuint texId;
 
-   if ( buffer == NULL )
+   // Prefer the compressed copy with mipmaps built by ETCCompress; the
+   // mipmaps of the TGA fallback are generated
+   texId = esStreamTexture ( streamer, ktxFileName, tgaFileName, GL_TRUE, NULL );
+
+   if ( texId == 0 )
    {
-      esLogMessage ( "Error loading (%s) image.\n", fileName );
       return 0;
    }
 
-   glGenTextures ( 1, &texId );
-   glBindTexture ( GL_TEXTURE_2D, texId );
-
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer );
-   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
 
-   free ( buffer );
-
    return texId;
 }
 
@@ -126,15 +130,63 @@ int Init ( ESContext *esContext )
    userData->baseMapLoc = glGetUniformLocation ( userData->programObject, "s_baseMap" );
    userData->lightMapLoc = glGetUniformLocation ( userData->programObject, "s_lightMap" );
 
-   // Load the textures
-   userData->baseMapTexId = LoadTexture ( esContext->platformData, "basemap.tga" );
-   userData->lightMapTexId = LoadTexture ( esContext->platformData, "lightmap.tga" );
+   // Load the textures in the background, uploading at most 256 KB a frame
+   userData->textureStreamer = esCreateTextureStreamer ( esContext->platformData, 256 * 1024 );
+
+   if ( userData->textureStreamer == NULL )
+   {
+      return FALSE;
+   }
+
+   userData->baseMapTexId = LoadTexture ( userData->textureStreamer, "basemap.ktx", "basemap.tga" );
+   userData->lightMapTexId = LoadTexture ( userData->textureStreamer, "lightmap.ktx", "lightmap.tga" );
 
    if ( userData->baseMapTexId == 0 || userData->lightMapTexId == 0 )
    {
       return FALSE;
    }
 
+   // Store the quad in buffer objects and capture its vertex state in a VAO
+   {
+      GLfloat vVertices[] = { -0.5f,  0.5f, 0.0f,  // Position 0
+                               0.0f,  0.0f,        // TexCoord 0 
+                              -0.5f, -0.5f, 0.0f,  // Position 1
+                               0.0f,  1.0f,        // TexCoord 1
+                               0.5f, -0.5f, 0.0f,  // Position 2
+                               1.0f,  1.0f,        // TexCoord 2
+                               0.5f,  0.5f, 0.0f,  // Position 3
+                               1.0f,  0.0f         // TexCoord 3
+                            };
+      GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+      ESVertexLayout layout;
+
+      glGenBuffers ( 2, userData->vboIds );
+      glBindBuffer ( GL_ARRAY_BUFFER, userData->vboIds[0] );
+      glBufferData ( GL_ARRAY_BUFFER, sizeof ( vVertices ), vVertices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->vboIds[1] );
+      glBufferData ( GL_ELEMENT_ARRAY_BUFFER, sizeof ( indices ), indices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+      esInitVertexLayout ( &layout );
+      // Load the vertex position
+      esVertexLayoutAttrib ( &layout, 0, userData->vboIds[0], 3, GL_FLOAT,
+                             GL_FALSE, 5 * sizeof ( GLfloat ), 0 );
+      // Load the texture coordinate
+      esVertexLayoutAttrib ( &layout, 1, userData->vboIds[0], 2, GL_FLOAT,
+                             GL_FALSE, 5 * sizeof ( GLfloat ), 3 * sizeof ( GLfloat ) );
+      layout.indexBuffer = userData->vboIds[1];
+
+      userData->vaoCache = esCreateVertexArrayCache ();
+
+      if ( userData->vaoCache == NULL )
+      {
+         return FALSE;
+      }
+
+      userData->vao = esGetVertexArray ( userData->vaoCache, &layout );
+   }
+
    glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
    return TRUE;
 }
@@ -145,16 +197,9 @@ int Init ( ESContext *esContext )
 void Draw ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
-   GLfloat vVertices[] = { -0.5f,  0.5f, 0.0f,  // Position 0
-                            0.0f,  0.0f,        // TexCoord 0 
-                           -0.5f, -0.5f, 0.0f,  // Position 1
-                            0.0f,  1.0f,        // TexCoord 1
-                            0.5f, -0.5f, 0.0f,  // Position 2
-                            1.0f,  1.0f,        // TexCoord 2
-                            0.5f,  0.5f, 0.0f,  // Position 3
-                            1.0f,  0.0f         // TexCoord 3
-                         };
-   GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+
+   // Upload the part of the textures that has been loaded since the last frame
+   esUpdateTextureStreamer ( userData->textureStreamer );
 
    // Set the viewport
    glViewport ( 0, 0, esContext->width, esContext->height );
@@ -165,15 +210,8 @@ void Draw ( ESContext *esContext )
    // Use the program object
    glUseProgram ( userData->programObject );
 
-   // Load the vertex position
-   glVertexAttribPointer ( 0, 3, GL_FLOAT,
-                           GL_FALSE, 5 * sizeof ( GLfloat ), vVertices );
-   // Load the texture coordinate
-   glVertexAttribPointer ( 1, 2, GL_FLOAT,
-                           GL_FALSE, 5 * sizeof ( GLfloat ), &vVertices[3] );
-
-   glEnableVertexAttribArray ( 0 );
-   glEnableVertexAttribArray ( 1 );
+   // Bind the vertex and index buffers
+   glBindVertexArray ( userData->vao );
 
    // Bind the base map
    glActiveTexture ( GL_TEXTURE0 );
@@ -189,7 +227,9 @@ void Draw ( ESContext *esContext )
    // Set the light map sampler to texture unit 1
    glUniform1i ( userData->lightMapLoc, 1 );
 
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
+
+   glBindVertexArray ( 0 );
 }
 
 ///
@@ -199,10 +239,16 @@ void ShutDown ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
 
+   esDeleteTextureStreamer ( userData->textureStreamer );
+
    // Delete texture object
    glDeleteTextures ( 1, &userData->baseMapTexId );
    glDeleteTextures ( 1, &userData->lightMapTexId );
 
+   // Delete the vertex array and buffer objects
+   esDeleteVertexArrayCache ( userData->vaoCache );
+   glDeleteBuffers ( 2, userData->vboIds );
+
    // Delete program object
    glDeleteProgram ( userData->programObject );
 }
@@ -0,0 +1,51 @@
+LOCAL_PATH			:= $(call my-dir)
+SRC_PATH			:= ../..
+COMMON_PATH			:= $(SRC_PATH)/../../Common
+COMMON_INC_PATH		:= $(COMMON_PATH)/Include
+COMMON_SRC_PATH		:= $(COMMON_PATH)/Source
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := EnvironmentMapping
+LOCAL_CFLAGS    += -DANDROID
+
+
+LOCAL_SRC_FILES := $(COMMON_SRC_PATH)/esAtlas.c \
+				   $(COMMON_SRC_PATH)/esBufferArena.c \
+				   $(COMMON_SRC_PATH)/esBvh.c \
+				   $(COMMON_SRC_PATH)/esCache.c \
+				   $(COMMON_SRC_PATH)/esCubemap.c \
+				   $(COMMON_SRC_PATH)/esDirtyRange.c \
+				   $(COMMON_SRC_PATH)/esKTX.c \
+				   $(COMMON_SRC_PATH)/esMeshCodec.c \
+				   $(COMMON_SRC_PATH)/esMipmap.c \
+				   $(COMMON_SRC_PATH)/esNoise.c \
+				   $(COMMON_SRC_PATH)/esPVR.c \
+				   $(COMMON_SRC_PATH)/esResidency.c \
+				   $(COMMON_SRC_PATH)/esShader.c \
+				   $(COMMON_SRC_PATH)/esShapes.c \
+				   $(COMMON_SRC_PATH)/esTGA.c \
+				   $(COMMON_SRC_PATH)/esTangents.c \
+				   $(COMMON_SRC_PATH)/esTextureStreamer.c \
+				   $(COMMON_SRC_PATH)/esTexture.c \
+				   $(COMMON_SRC_PATH)/esUploadScheduler.c \
+				   $(COMMON_SRC_PATH)/esThread.c \
+				   $(COMMON_SRC_PATH)/esTransform.c \
+				   $(COMMON_SRC_PATH)/esVertexArray.c \
+				   $(COMMON_SRC_PATH)/esUtil.c \
+				   $(COMMON_SRC_PATH)/Android/esUtil_Android.c \
+				   $(SRC_PATH)/EnvironmentMapping.c
+				   
+				   
+				   
+
+LOCAL_C_INCLUDES	:= $(SRC_PATH) \
+					   $(COMMON_INC_PATH)
+				   
+LOCAL_LDLIBS    := -llog -landroid -lEGL -lGLESv3
+
+LOCAL_STATIC_LIBRARIES := android_native_app_glue
+
+include $(BUILD_SHARED_LIBRARY)
+
+$(call import-module,android/native_app_glue)
@@ -0,0 +1,315 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// EnvironmentMapping.c
+//
+//    This is an example that lights spheres with image based lighting
+//    built from the envMap.pvr cube map.  The faces are decoded on the
+//    CPU and filtered into a specular cube map, whose mip levels are
+//    prefiltered for increasing roughness, and an irradiance cube map.
+//    The filtered maps are kept in the disk cache, so later runs load
+//    them straight away.  The spheres go from mirror-like on the left to
+//    fully rough on the right.
+//
+#include <stdlib.h>
+#include <math.h>
+#include "esUtil.h"
+
+#define NUM_SPHERES     5
+#define PI              3.14159265f
+
+typedef struct
+{
+   // Handle to a program object
+   GLuint programObject;
+
+   // Uniform locations
+   GLint  mvpLoc;
+   GLint  eyePositionLoc;
+   GLint  maxLodLoc;
+   GLint  specularMapLoc;
+   GLint  irradianceMapLoc;
+
+   // Vertex data
+   GLfloat  *vertices;
+   GLfloat  *normals;
+   GLuint   *indices;
+   int       numIndices;
+
+   // Filtered cube maps and the number of levels of the specular one
+   GLuint    specularMap;
+   GLuint    irradianceMap;
+   int       numLevels;
+
+   // Rotation angle of the camera around the spheres
+   GLfloat   angle;
+
+   // Camera
+   GLfloat   eyePosition[3];
+   ESMatrix  mvpMatrix;
+
+} UserData;
+
+// Attribute locations
+#define ATTRIB_LOCATION_POS      0
+#define ATTRIB_LOCATION_NORMAL   1
+
+///
+// Decode envMap.pvr and filter it into the specular and irradiance maps
+//
+int LoadEnvironment ( ESContext *esContext, const char *fileName )
+{
+   UserData     *userData = esContext->userData;
+   ESFileMapping file;
+   GLubyte      *faces = NULL;
+   GLboolean     srgb = GL_FALSE;
+   int           width, height, numFaces = 0;
+
+   if ( esMapFile ( esContext->platformData, fileName, &file ) )
+   {
+      faces = esDecodePVR ( file.data, file.size, &width, &height, &numFaces, &srgb );
+      esUnmapFile ( &file );
+   }
+
+   if ( faces == NULL || numFaces != 6 )
+   {
+      esLogMessage ( "Error loading (%s) cube map.\n", fileName );
+      free ( faces );
+      return FALSE;
+   }
+
+   // The six faces are stacked one below the other
+   userData->specularMap = esCreateFilteredCubemap ( faces, width, height * 6, 4, ES_CUBEMAP_FACES, srgb, 0,
+                                                     esContext->cacheDir, &userData->irradianceMap,
+                                                     &userData->numLevels );
+   free ( faces );
+
+   return userData->specularMap != 0;
+}
+
+///
+// Initialize the shader and program object
+//
+int Init ( ESContext *esContext )
+{
+   UserData *userData = ( UserData * ) esContext->userData;
+   const char vShaderStr[] =
+      "#version 300 es                                    \n"
+      "uniform mat4 u_mvpMatrix;                          \n"
+      "layout(location = 0) in vec4 a_position;           \n"
+      "layout(location = 1) in vec3 a_normal;             \n"
+      "out vec3 v_position;                               \n"
+      "out vec3 v_normal;                                 \n"
+      "out float v_roughness;                             \n"
+      "void main()                                        \n"
+      "{                                                  \n"
+      "   // One sphere per instance, in a row, rougher   \n"
+      "   // to the right                                 \n"
+      "   float offset = float( gl_InstanceID ) - 2.0;    \n"
+      "   vec4 position = a_position +                    \n"
+      "                   vec4( 2.5 * offset, 0.0, 0.0, 0.0 ); \n"
+      "   v_position = position.xyz;                      \n"
+      "   v_normal = a_normal;                            \n"
+      "   v_roughness = float( gl_InstanceID ) / 4.0;     \n"
+      "   gl_Position = u_mvpMatrix * position;           \n"
+      "}                                                  \n";
+
+   const char fShaderStr[] =
+      "#version 300 es                                    \n"
+      "precision mediump float;                           \n"
+      "uniform samplerCube s_specularMap;                 \n"
+      "uniform samplerCube s_irradianceMap;               \n"
+      "uniform vec3 u_eyePosition;                        \n"
+      "uniform float u_maxLod;                            \n"
+      "in vec3 v_position;                                \n"
+      "in vec3 v_normal;                                  \n"
+      "in float v_roughness;                              \n"
+      "layout(location = 0) out vec4 outColor;            \n"
+      "void main()                                        \n"
+      "{                                                  \n"
+      "   vec3 normal = normalize( v_normal );            \n"
+      "   vec3 view = normalize( v_position - u_eyePosition ); \n"
+      "   vec3 reflection = reflect( view, normal );      \n"
+      "                                                   \n"
+      "   // Level n of the specular map is prefiltered   \n"
+      "   // for roughness n / maxLod                     \n"
+      "   vec3 specular = textureLod( s_specularMap,      \n"
+      "            reflection, v_roughness * u_maxLod ).rgb; \n"
+      "   vec3 diffuse = texture( s_irradianceMap,        \n"
+      "                           normal ).rgb;           \n"
+      "   outColor = vec4( 0.25 * diffuse + 0.75 * specular, 1.0 ); \n"
+      "}                                                  \n";
+
+   if ( !LoadEnvironment ( esContext, "envMap.pvr" ) )
+   {
+      return FALSE;
+   }
+
+   // Load the shaders and get a linked program object
+   userData->programObject = esLoadProgram ( vShaderStr, fShaderStr );
+
+   // Get the uniform locations
+   userData->mvpLoc = glGetUniformLocation ( userData->programObject, "u_mvpMatrix" );
+   userData->eyePositionLoc = glGetUniformLocation ( userData->programObject, "u_eyePosition" );
+   userData->maxLodLoc = glGetUniformLocation ( userData->programObject, "u_maxLod" );
+   userData->specularMapLoc = glGetUniformLocation ( userData->programObject, "s_specularMap" );
+   userData->irradianceMapLoc = glGetUniformLocation ( userData->programObject, "s_irradianceMap" );
+
+   // Generate the vertex data
+   userData->numIndices = esGenSphere ( 40, 1.0f, &userData->vertices, &userData->normals,
+                                        NULL, &userData->indices );
+
+   // Starting rotation angle of the camera
+   userData->angle = 0.0f;
+
+   glEnable ( GL_DEPTH_TEST );
+   glClearColor ( 0.0f, 0.0f, 0.0f, 0.0f );
+
+   return TRUE;
+}
+
+///
+// Update the camera based on time
+//
+void Update ( ESContext *esContext, float deltaTime )
+{
+   UserData *userData = ( UserData * ) esContext->userData;
+   ESMatrix  perspective;
+   ESMatrix  view;
+   float     aspect;
+   float     radians;
+
+   // Orbit the camera around the spheres
+   userData->angle += deltaTime * 20.0f;
+
+   if ( userData->angle >= 360.0f )
+   {
+      userData->angle -= 360.0f;
+   }
+
+   radians = userData->angle * PI / 180.0f;
+   userData->eyePosition[0] = 10.0f * sinf ( radians );
+   userData->eyePosition[1] = 2.0f;
+   userData->eyePosition[2] = 10.0f * cosf ( radians );
+
+   // Compute the window aspect ratio
+   aspect = ( GLfloat ) esContext->width / ( GLfloat ) esContext->height;
+
+   // Generate a perspective matrix with a 60 degree FOV
+   esMatrixLoadIdentity ( &perspective );
+   esPerspective ( &perspective, 60.0f, aspect, 1.0f, 30.0f );
+
+   esMatrixLookAt ( &view, userData->eyePosition[0], userData->eyePosition[1], userData->eyePosition[2],
+                    0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f );
+
+   esMatrixMultiply ( &userData->mvpMatrix, &view, &perspective );
+}
+
+///
+// Draw the spheres
+//
+void Draw ( ESContext *esContext )
+{
+   UserData *userData = esContext->userData;
+
+   // Set the viewport
+   glViewport ( 0, 0, esContext->width, esContext->height );
+
+   // Clear the color buffer
+   glClear ( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+   // Use the program object
+   glUseProgram ( userData->programObject );
+
+   // Load the vertex position and normal
+   glVertexAttribPointer ( ATTRIB_LOCATION_POS, 3, GL_FLOAT,
+                           GL_FALSE, 3 * sizeof ( GLfloat ), userData->vertices );
+   glEnableVertexAttribArray ( ATTRIB_LOCATION_POS );
+
+   glVertexAttribPointer ( ATTRIB_LOCATION_NORMAL, 3, GL_FLOAT,
+                           GL_FALSE, 3 * sizeof ( GLfloat ), userData->normals );
+   glEnableVertexAttribArray ( ATTRIB_LOCATION_NORMAL );
+
+   // Load the uniforms
+   glUniformMatrix4fv ( userData->mvpLoc, 1, GL_FALSE, ( GLfloat * ) &userData->mvpMatrix.m[0][0] );
+   glUniform3fv ( userData->eyePositionLoc, 1, userData->eyePosition );
+   glUniform1f ( userData->maxLodLoc, ( GLfloat ) ( userData->numLevels - 1 ) );
+
+   // Bind the cube maps
+   glActiveTexture ( GL_TEXTURE0 );
+   glBindTexture ( GL_TEXTURE_CUBE_MAP, userData->specularMap );
+   glUniform1i ( userData->specularMapLoc, 0 );
+
+   glActiveTexture ( GL_TEXTURE1 );
+   glBindTexture ( GL_TEXTURE_CUBE_MAP, userData->irradianceMap );
+   glUniform1i ( userData->irradianceMapLoc, 1 );
+
+   // Draw the spheres
+   glDrawElementsInstanced ( GL_TRIANGLES, userData->numIndices, GL_UNSIGNED_INT, userData->indices, NUM_SPHERES );
+}
+
+///
+// Cleanup
+//
+void Shutdown ( ESContext *esContext )
+{
+   UserData *userData = esContext->userData;
+
+   free ( userData->vertices );
+   free ( userData->normals );
+   free ( userData->indices );
+
+   // Delete texture objects
+   glDeleteTextures ( 1, &userData->specularMap );
+   glDeleteTextures ( 1, &userData->irradianceMap );
+
+   // Delete program object
+   glDeleteProgram ( userData->programObject );
+}
+
+
+int esMain ( ESContext *esContext )
+{
+   esContext->userData = calloc ( 1, sizeof ( UserData ) );
+
+   esCreateWindow ( esContext, "EnvironmentMapping", 800, 600, ES_WINDOW_RGB | ES_WINDOW_DEPTH );
+
+   if ( !Init ( esContext ) )
+   {
+      return GL_FALSE;
+   }
+
+   esRegisterShutdownFunc ( esContext, Shutdown );
+   esRegisterUpdateFunc ( esContext, Update );
+   esRegisterDrawFunc ( esContext, Draw );
+
+   return GL_TRUE;
+}
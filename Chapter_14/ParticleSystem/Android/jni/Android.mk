@@ -10,9 +10,28 @@ LOCAL_MODULE    := ParticleSystem
 LOCAL_CFLAGS    += -DANDROID
 
 
-LOCAL_SRC_FILES := $(COMMON_SRC_PATH)/esShader.c \
+LOCAL_SRC_FILES := $(COMMON_SRC_PATH)/esAtlas.c \
+				   $(COMMON_SRC_PATH)/esBufferArena.c \
+				   $(COMMON_SRC_PATH)/esBvh.c \
+				   $(COMMON_SRC_PATH)/esCache.c \
+				   $(COMMON_SRC_PATH)/esCubemap.c \
+				   $(COMMON_SRC_PATH)/esDirtyRange.c \
+				   $(COMMON_SRC_PATH)/esKTX.c \
+				   $(COMMON_SRC_PATH)/esMeshCodec.c \
+				   $(COMMON_SRC_PATH)/esMipmap.c \
+				   $(COMMON_SRC_PATH)/esNoise.c \
+				   $(COMMON_SRC_PATH)/esPVR.c \
+				   $(COMMON_SRC_PATH)/esResidency.c \
+				   $(COMMON_SRC_PATH)/esShader.c \
 				   $(COMMON_SRC_PATH)/esShapes.c \
+				   $(COMMON_SRC_PATH)/esTGA.c \
+				   $(COMMON_SRC_PATH)/esTangents.c \
+				   $(COMMON_SRC_PATH)/esTextureStreamer.c \
+				   $(COMMON_SRC_PATH)/esTexture.c \
+				   $(COMMON_SRC_PATH)/esUploadScheduler.c \
+				   $(COMMON_SRC_PATH)/esThread.c \
 				   $(COMMON_SRC_PATH)/esTransform.c \
+				   $(COMMON_SRC_PATH)/esVertexArray.c \
 				   $(COMMON_SRC_PATH)/esUtil.c \
 				   $(COMMON_SRC_PATH)/Android/esUtil_Android.c \
 				   $(SRC_PATH)/ParticleSystem.c
@@ -62,6 +62,11 @@ typedef struct
    // Particle vertex data
    float particleData[ NUM_PARTICLES * PARTICLE_SIZE ];
 
+   // Particle VBO and the vertex array object that sources it
+   GLuint particleVBO;
+   ESVertexArrayCache *vaoCache;
+   GLuint particleVAO;
+
    // Current time
    float time;
 
@@ -70,30 +75,40 @@ typedef struct
 ///
 // Load texture from disk
 //
-GLuint LoadTexture ( void *ioContext, char *fileName )
+GLuint LoadTexture ( void *ioContext, char *ktxFileName, char *tgaFileName )
 {
    int width,
        height;
-   char *buffer = esLoadTGA ( ioContext, fileName, &width, &height );
    GLuint texId;
+   GLint  numLevels = 1;
+
+   // Prefer the compressed copy with mipmaps built by ETCCompress
+   texId = esLoadKTX ( ioContext, ktxFileName, NULL );
 
-   if ( buffer == NULL )
+   if ( texId != 0 )
    {
-      esLogMessage ( "Error loading (%s) image.\n", fileName );
-      return 0;
+      glGetTexParameteriv ( GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &numLevels );
+   }
+   else
+   {
+      glGenTextures ( 1, &texId );
+      glBindTexture ( GL_TEXTURE_2D, texId );
+
+      // Upload straight from the mapped file, without a copy on the heap
+      if ( !esLoadTGATexture ( ioContext, tgaFileName, GL_TEXTURE_2D, &width, &height ) )
+      {
+         esLogMessage ( "Error loading (%s) image.\n", tgaFileName );
+         glDeleteTextures ( 1, &texId );
+         return 0;
+      }
    }
 
-   glGenTextures ( 1, &texId );
-   glBindTexture ( GL_TEXTURE_2D, texId );
-
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer );
-   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+   // Small particles sample the smaller levels when there are any
+   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
 
-   free ( buffer );
-
    return texId;
 }
 
@@ -180,10 +195,40 @@ int Init ( ESContext *esContext )
 
    }
 
+   // Store the particles in a VBO and capture the vertex state in a VAO
+   {
+      ESVertexLayout layout;
+
+      glGenBuffers ( 1, &userData->particleVBO );
+      glBindBuffer ( GL_ARRAY_BUFFER, userData->particleVBO );
+      glBufferData ( GL_ARRAY_BUFFER, sizeof ( userData->particleData ),
+                     userData->particleData, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+
+      esInitVertexLayout ( &layout );
+      esVertexLayoutAttrib ( &layout, ATTRIBUTE_LIFETIME_LOCATION, userData->particleVBO,
+                             1, GL_FLOAT, GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ), 0 );
+      esVertexLayoutAttrib ( &layout, ATTRIBUTE_ENDPOSITION_LOCATION, userData->particleVBO,
+                             3, GL_FLOAT, GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ),
+                             1 * sizeof ( GLfloat ) );
+      esVertexLayoutAttrib ( &layout, ATTRIBUTE_STARTPOSITION_LOCATION, userData->particleVBO,
+                             3, GL_FLOAT, GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ),
+                             4 * sizeof ( GLfloat ) );
+
+      userData->vaoCache = esCreateVertexArrayCache ();
+
+      if ( userData->vaoCache == NULL )
+      {
+         return FALSE;
+      }
+
+      userData->particleVAO = esGetVertexArray ( userData->vaoCache, &layout );
+   }
+
    // Initialize time to cause reset on first update
    userData->time = 1.0f;
 
-   userData->textureId = LoadTexture ( esContext->platformData, "smoke.tga" );
+   userData->textureId = LoadTexture ( esContext->platformData, "smoke.ktx", "smoke.tga" );
 
    if ( userData->textureId <= 0 )
    {
@@ -248,22 +293,7 @@ void Draw ( ESContext *esContext )
    glUseProgram ( userData->programObject );
 
    // Load the vertex attributes
-   glVertexAttribPointer ( ATTRIBUTE_LIFETIME_LOCATION, 1, GL_FLOAT,
-                           GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ),
-                           userData->particleData );
-
-   glVertexAttribPointer ( ATTRIBUTE_ENDPOSITION_LOCATION, 3, GL_FLOAT,
-                           GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ),
-                           &userData->particleData[1] );
-
-   glVertexAttribPointer ( ATTRIBUTE_STARTPOSITION_LOCATION, 3, GL_FLOAT,
-                           GL_FALSE, PARTICLE_SIZE * sizeof ( GLfloat ),
-                           &userData->particleData[4] );
-
-
-   glEnableVertexAttribArray ( ATTRIBUTE_LIFETIME_LOCATION );
-   glEnableVertexAttribArray ( ATTRIBUTE_ENDPOSITION_LOCATION );
-   glEnableVertexAttribArray ( ATTRIBUTE_STARTPOSITION_LOCATION );
+   glBindVertexArray ( userData->particleVAO );
 
    // Blend particles
    glEnable ( GL_BLEND );
@@ -277,6 +307,8 @@ void Draw ( ESContext *esContext )
    glUniform1i ( userData->samplerLoc, 0 );
 
    glDrawArrays ( GL_POINTS, 0, NUM_PARTICLES );
+
+   glBindVertexArray ( 0 );
 }
 
 ///
@@ -289,6 +321,10 @@ void ShutDown ( ESContext *esContext )
    // Delete texture object
    glDeleteTextures ( 1, &userData->textureId );
 
+   // Delete the vertex array and buffer objects
+   esDeleteVertexArrayCache ( userData->vaoCache );
+   glDeleteBuffers ( 1, &userData->particleVBO );
+
    // Delete program object
    glDeleteProgram ( userData->programObject );
 }
@@ -38,7 +38,6 @@
 #include <math.h>
 #include <stddef.h>
 #include "esUtil.h"
-#include "Noise3D.h"
 
 #define NUM_PARTICLES   200
 #define EMISSION_RATE   0.3f
@@ -86,6 +85,10 @@ typedef struct
    // Particle VBOs
    GLuint particleVBOs[2];
 
+   // Vertex array objects sourcing each of the particle VBOs
+   ESVertexArrayCache *vaoCache;
+   GLuint particleVAOs[2];
+
    // Index into particleVBOs (0 or 1) as to which is the source.
    // Ping-pong between the two VBOs
    GLuint curSrcIndex;
@@ -101,33 +104,69 @@ typedef struct
 ///
 // Load texture from disk
 //
-GLuint LoadTexture ( void *ioContext, char *fileName )
+GLuint LoadTexture ( void *ioContext, char *ktxFileName, char *tgaFileName )
 {
    int width,
        height;
-   char *buffer = esLoadTGA ( ioContext, fileName, &width, &height );
    GLuint texId;
+   GLint  numLevels = 1;
+
+   // Prefer the compressed copy with mipmaps built by ETCCompress
+   texId = esLoadKTX ( ioContext, ktxFileName, NULL );
 
-   if ( buffer == NULL )
+   if ( texId != 0 )
    {
-      esLogMessage ( "Error loading (%s) image.\n", fileName );
-      return 0;
+      glGetTexParameteriv ( GL_TEXTURE_2D, GL_TEXTURE_IMMUTABLE_LEVELS, &numLevels );
    }
+   else
+   {
+      glGenTextures ( 1, &texId );
+      glBindTexture ( GL_TEXTURE_2D, texId );
 
-   glGenTextures ( 1, &texId );
-   glBindTexture ( GL_TEXTURE_2D, texId );
+      // Upload straight from the mapped file, without a copy on the heap
+      if ( !esLoadTGATexture ( ioContext, tgaFileName, GL_TEXTURE_2D, &width, &height ) )
+      {
+         esLogMessage ( "Error loading (%s) image.\n", tgaFileName );
+         glDeleteTextures ( 1, &texId );
+         return 0;
+      }
+   }
 
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer );
-   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+   // Small particles sample the smaller levels when there are any
+   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
 
-   free ( buffer );
-
    return texId;
 }
 
+///
+// Get the vertex array object that sources the particle attributes from vboID
+//
+GLuint GetParticleVertexArray ( ESVertexArrayCache *vaoCache, GLuint vboID )
+{
+   ESVertexLayout layout;
+
+   esInitVertexLayout ( &layout );
+   esVertexLayoutAttrib ( &layout, ATTRIBUTE_POSITION, vboID, 2, GL_FLOAT,
+                          GL_FALSE, sizeof ( Particle ), 0 );
+
+   esVertexLayoutAttrib ( &layout, ATTRIBUTE_VELOCITY, vboID, 2, GL_FLOAT,
+                          GL_FALSE, sizeof ( Particle ), offsetof ( Particle, velocity[0] ) );
+
+   esVertexLayoutAttrib ( &layout, ATTRIBUTE_SIZE, vboID, 1, GL_FLOAT,
+                          GL_FALSE, sizeof ( Particle ), offsetof ( Particle, size ) );
+
+   esVertexLayoutAttrib ( &layout, ATTRIBUTE_CURTIME, vboID, 1, GL_FLOAT,
+                          GL_FALSE, sizeof ( Particle ), offsetof ( Particle, curtime ) );
+
+   esVertexLayoutAttrib ( &layout, ATTRIBUTE_LIFETIME, vboID, 1, GL_FLOAT,
+                          GL_FALSE, sizeof ( Particle ), offsetof ( Particle, lifetime ) );
+
+   return esGetVertexArray ( vaoCache, &layout );
+}
+
 void InitEmitParticles ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
@@ -294,7 +333,7 @@ int Init ( ESContext *esContext )
 
    glClearColor ( 0.0f, 0.0f, 0.0f, 0.0f );
 
-   userData->textureId = LoadTexture ( esContext->platformData, "smoke.tga" );
+   userData->textureId = LoadTexture ( esContext->platformData, "smoke.ktx", "smoke.tga" );
 
    if ( userData->textureId <= 0 )
    {
@@ -302,7 +341,7 @@ int Init ( ESContext *esContext )
    }
 
    // Create a 3D noise texture for random values
-   userData->noiseTextureId = Create3DNoiseTexture ( 128, 50.0 );
+   userData->noiseTextureId = esCreateNoiseTexture3D ( 128, 50.0f, 1, GL_FALSE, esContext->cacheDir );
 
    // Initialize particle data
    for ( i = 0; i < NUM_PARTICLES; i++ )
@@ -327,48 +366,33 @@ int Init ( ESContext *esContext )
       glBufferData ( GL_ARRAY_BUFFER, sizeof ( Particle ) * NUM_PARTICLES, particleData, GL_DYNAMIC_COPY );
    }
 
-   return TRUE;
-}
+   glBindBuffer ( GL_ARRAY_BUFFER, 0 );
 
-void SetupVertexAttributes ( ESContext *esContext, GLuint vboID )
-{
-   glBindBuffer ( GL_ARRAY_BUFFER, vboID );
-   glVertexAttribPointer ( ATTRIBUTE_POSITION, 2, GL_FLOAT,
-                           GL_FALSE, sizeof ( Particle ),
-                           ( const void * ) NULL );
-
-   glVertexAttribPointer ( ATTRIBUTE_VELOCITY, 2, GL_FLOAT,
-                           GL_FALSE, sizeof ( Particle ),
-                           ( const void * ) offsetof ( Particle, velocity[0] ) );
-
-   glVertexAttribPointer ( ATTRIBUTE_SIZE, 1, GL_FLOAT,
-                           GL_FALSE, sizeof ( Particle ),
-                           ( const void * ) offsetof ( Particle, size ) );
-
-   glVertexAttribPointer ( ATTRIBUTE_CURTIME, 1, GL_FLOAT,
-                           GL_FALSE, sizeof ( Particle ),
-                           ( const void * ) offsetof ( Particle, curtime ) );
-
-   glVertexAttribPointer ( ATTRIBUTE_LIFETIME, 1, GL_FLOAT,
-                           GL_FALSE, sizeof ( Particle ),
-                           ( const void * ) offsetof ( Particle, lifetime ) );
-
-   glEnableVertexAttribArray ( ATTRIBUTE_POSITION );
-   glEnableVertexAttribArray ( ATTRIBUTE_VELOCITY );
-   glEnableVertexAttribArray ( ATTRIBUTE_SIZE );
-   glEnableVertexAttribArray ( ATTRIBUTE_CURTIME );
-   glEnableVertexAttribArray ( ATTRIBUTE_LIFETIME );
+   // Capture the vertex state for each of the VBOs
+   userData->vaoCache = esCreateVertexArrayCache ();
+
+   if ( userData->vaoCache == NULL )
+   {
+      return FALSE;
+   }
+
+   for ( i = 0; i < 2; i++ )
+   {
+      userData->particleVAOs[i] = GetParticleVertexArray ( userData->vaoCache, userData->particleVBOs[i] );
+   }
+
+   return TRUE;
 }
 
 void EmitParticles ( ESContext *esContext, float deltaTime )
 {
    UserData *userData = esContext->userData;
-   GLuint srcVBO = userData->particleVBOs[ userData->curSrcIndex ];
+   GLuint srcVAO = userData->particleVAOs[ userData->curSrcIndex ];
    GLuint dstVBO = userData->particleVBOs[ ( userData->curSrcIndex + 1 ) % 2 ];
 
    glUseProgram ( userData->emitProgramObject );
 
-   SetupVertexAttributes ( esContext, srcVBO );
+   glBindVertexArray ( srcVAO );
 
    // Set transform feedback buffer
    glBindBuffer ( GL_TRANSFORM_FEEDBACK_BUFFER, dstVBO );
@@ -398,7 +422,7 @@ void EmitParticles ( ESContext *esContext, float deltaTime )
    glDisable ( GL_RASTERIZER_DISCARD );
    glUseProgram ( 0 );
    glBindBufferBase ( GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0 );
-   glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+   glBindVertexArray ( 0 );
    glBindTexture ( GL_TEXTURE_3D, 0 );
 
    // Ping pong the buffers
@@ -439,7 +463,7 @@ void Draw ( ESContext *esContext )
    glUseProgram ( userData->drawProgramObject );
 
    // Load the VBO and vertex attributes
-   SetupVertexAttributes ( esContext, userData->particleVBOs[ userData->curSrcIndex ] );
+   glBindVertexArray ( userData->particleVAOs[ userData->curSrcIndex ] );
 
    // Set uniforms
    glUniform1f ( userData->drawTimeLoc, userData->time );
@@ -458,6 +482,8 @@ void Draw ( ESContext *esContext )
    glUniform1i ( userData->samplerLoc, 0 );
 
    glDrawArrays ( GL_POINTS, 0, NUM_PARTICLES );
+
+   glBindVertexArray ( 0 );
 }
 
 ///
@@ -474,6 +500,7 @@ void ShutDown ( ESContext *esContext )
    glDeleteProgram ( userData->drawProgramObject );
    glDeleteProgram ( userData->emitProgramObject );
 
+   esDeleteVertexArrayCache ( userData->vaoCache );
    glDeleteBuffers ( 2, &userData->particleVBOs[0] );
 }
 
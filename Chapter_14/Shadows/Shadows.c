@@ -61,15 +61,14 @@ typedef struct
    GLuint shadowMapTextureWidth;
    GLuint shadowMapTextureHeight;
 
-   // VBOs of the model
-   GLuint groundPositionVBO;
-   GLuint groundIndicesIBO;
-   GLuint cubePositionVBO;
-   GLuint cubeIndicesIBO;
-   
-   // Number of indices
-   int    groundNumIndices;
-   int    cubeNumIndices;
+   // Buffer arena holding the vertices and indices of both models
+   ESBufferArena *meshArena;
+   ESMeshHandle   groundMesh;
+   ESMeshHandle   cubeMesh;
+
+   // Vertex array object shared by the models
+   ESVertexArrayCache *vaoCache;
+   GLuint meshVAO;
 
    // dimension of grid
    int    groundGridSize;
@@ -231,6 +230,7 @@ int Init ( ESContext *esContext )
 {
    GLfloat *positions;
    GLuint *indices;
+   int numIndices;
 
    UserData *userData = esContext->userData;
    const char vShadowMapShaderStr[] =  
@@ -312,41 +312,71 @@ int Init ( ESContext *esContext )
    // Get the sampler location
    userData->shadowMapSamplerLoc = glGetUniformLocation ( userData->sceneProgramObject, "s_shadowMap" );
 
+   // Both models are packed into the same vertex and index buffers
+   userData->meshArena = esCreateBufferArena ( 3 * sizeof( GLfloat ), 4096, 4096 );
+
+   if ( userData->meshArena == NULL )
+   {
+      return FALSE;
+   }
+
    // Generate the vertex and index data for the ground
    userData->groundGridSize = 3;
-   userData->groundNumIndices = esGenSquareGrid( userData->groundGridSize, &positions, &indices );
+   numIndices = esGenSquareGrid( userData->groundGridSize, &positions, &indices );
 
-   // Index buffer object for the ground model
-   glGenBuffers ( 1, &userData->groundIndicesIBO );
-   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->groundIndicesIBO );
-   glBufferData ( GL_ELEMENT_ARRAY_BUFFER, userData->groundNumIndices * sizeof( GLuint ), indices, GL_STATIC_DRAW );
-   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
-   free( indices );
+   if ( positions == NULL || indices == NULL ||
+        !esBufferArenaAlloc ( userData->meshArena, positions, userData->groundGridSize * userData->groundGridSize,
+                              indices, numIndices, &userData->groundMesh ) )
+   {
+      free( indices );
+      free( positions );
+      return FALSE;
+   }
 
-   // Position VBO for ground model
-   glGenBuffers ( 1, &userData->groundPositionVBO );
-   glBindBuffer ( GL_ARRAY_BUFFER, userData->groundPositionVBO );
-   glBufferData ( GL_ARRAY_BUFFER, userData->groundGridSize * userData->groundGridSize * sizeof( GLfloat ) * 3, 
-                  positions, GL_STATIC_DRAW );
+   free( indices );
    free( positions );
 
    // Generate the vertex and index date for the cube model
-   userData->cubeNumIndices = esGenCube ( 1.0f, &positions,
-                                          NULL, NULL, &indices );
-
-   // Index buffer object for cube model
-   glGenBuffers ( 1, &userData->cubeIndicesIBO );
-   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->cubeIndicesIBO );
-   glBufferData ( GL_ELEMENT_ARRAY_BUFFER, sizeof( GLuint ) * userData->cubeNumIndices, indices, GL_STATIC_DRAW );
-   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
-   free( indices );
+   numIndices = esGenCube ( 1.0f, &positions, NULL, NULL, &indices );
 
-   // Position VBO for cube model
-   glGenBuffers ( 1, &userData->cubePositionVBO );
-   glBindBuffer ( GL_ARRAY_BUFFER, userData->cubePositionVBO );
-   glBufferData ( GL_ARRAY_BUFFER, 24 * sizeof( GLfloat ) * 3, positions, GL_STATIC_DRAW );
+   if ( positions == NULL || indices == NULL ||
+        !esBufferArenaAlloc ( userData->meshArena, positions, 24,
+                              indices, numIndices, &userData->cubeMesh ) )
+   {
+      free( indices );
+      free( positions );
+      return FALSE;
+   }
+
+   free( indices );
    free( positions );
 
+   // Meshes in the same arena page share their buffers, so one VAO draws both.
+   // The pages are sized to hold both models, so a split means the sizes above are wrong.
+   if ( userData->cubeMesh.page != userData->groundMesh.page )
+   {
+      esLogMessage ( "Shadows: the ground and cube meshes were placed in different arena pages\n" );
+      return FALSE;
+   }
+
+   userData->vaoCache = esCreateVertexArrayCache ();
+
+   if ( userData->vaoCache == NULL )
+   {
+      return FALSE;
+   }
+
+   {
+      ESVertexLayout layout;
+
+      esInitVertexLayout ( &layout );
+      esVertexLayoutAttrib ( &layout, POSITION_LOC, userData->groundMesh.vertexBuffer, 3, GL_FLOAT,
+                             GL_FALSE, 3 * sizeof(GLfloat), 0 );
+      layout.indexBuffer = userData->groundMesh.indexBuffer;
+
+      userData->meshVAO = esGetVertexArray ( userData->vaoCache, &layout );
+   }
+
    // setup transformation matrices
    userData->eyePosition[0] = -5.0f;
    userData->eyePosition[1] = 3.0f;
@@ -381,15 +411,10 @@ void DrawScene ( ESContext *esContext,
 {
    UserData *userData = esContext->userData;
  
-   // Draw the ground
-   // Load the vertex position
-   glBindBuffer ( GL_ARRAY_BUFFER, userData->groundPositionVBO );
-   glVertexAttribPointer ( POSITION_LOC, 3, GL_FLOAT, 
-                           GL_FALSE, 3 * sizeof(GLfloat), (const void*)NULL );
-   glEnableVertexAttribArray ( POSITION_LOC );   
+   // Bind the vertex and index buffers of both models
+   glBindVertexArray ( userData->meshVAO );
 
-   // Bind the index buffer
-   glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, userData->groundIndicesIBO );
+   // Draw the ground
 
    // Load the MVP matrix for the ground model
    glUniformMatrix4fv ( mvpLoc, 1, GL_FALSE, (GLfloat*) &userData->groundMvpMatrix.m[0][0] );
@@ -398,17 +423,10 @@ void DrawScene ( ESContext *esContext,
    // Set the ground color to light gray
    glVertexAttrib4f ( COLOR_LOC, 0.9f, 0.9f, 0.9f, 1.0f );
 
-   glDrawElements ( GL_TRIANGLES, userData->groundNumIndices, GL_UNSIGNED_INT, (const void*)NULL );
+   glDrawElements ( GL_TRIANGLES, userData->groundMesh.numIndices, GL_UNSIGNED_INT,
+                    (const void*) ( userData->groundMesh.firstIndex * sizeof( GLuint ) ) );
 
    // Draw the cube
-   // Load the vertex position
-   glBindBuffer( GL_ARRAY_BUFFER, userData->cubePositionVBO );
-   glVertexAttribPointer ( POSITION_LOC, 3, GL_FLOAT, 
-                           GL_FALSE, 3 * sizeof(GLfloat), (const void*)NULL );
-   glEnableVertexAttribArray ( POSITION_LOC );   
-
-   // Bind the index buffer
-   glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, userData->cubeIndicesIBO );
 
    // Load the MVP matrix for the cube model
    glUniformMatrix4fv ( mvpLoc, 1, GL_FALSE, (GLfloat*) &userData->cubeMvpMatrix.m[0][0] );
@@ -417,7 +435,10 @@ void DrawScene ( ESContext *esContext,
    // Set the cube color to red
    glVertexAttrib4f ( COLOR_LOC, 1.0f, 0.0f, 0.0f, 1.0f );
 
-   glDrawElements ( GL_TRIANGLES, userData->cubeNumIndices, GL_UNSIGNED_INT, (const void*)NULL );
+   glDrawElements ( GL_TRIANGLES, userData->cubeMesh.numIndices, GL_UNSIGNED_INT,
+                    (const void*) ( userData->cubeMesh.firstIndex * sizeof( GLuint ) ) );
+
+   glBindVertexArray ( 0 );
 }
 
 void Draw ( ESContext *esContext )
@@ -482,11 +503,8 @@ void Shutdown ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
 
-   glDeleteBuffers( 1, &userData->groundPositionVBO );
-   glDeleteBuffers( 1, &userData->groundIndicesIBO );
-
-   glDeleteBuffers( 1, &userData->cubePositionVBO );
-   glDeleteBuffers( 1, &userData->cubeIndicesIBO );
+   esDeleteVertexArrayCache ( userData->vaoCache );
+   esDeleteBufferArena ( userData->meshArena );
    
    // Delete shadow map
    glBindFramebuffer ( GL_FRAMEBUFFER, userData->shadowMapBufferId );
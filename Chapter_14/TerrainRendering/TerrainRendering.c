@@ -39,6 +39,17 @@
 
 #define POSITION_LOC    0
 
+// Frames averaged for each frame time report
+#define NUM_TIMED_FRAMES   300
+
+// Heightmap and grid buffer bytes uploaded per frame, and the time spent on them
+#define UPLOAD_BYTES_PER_FRAME     ( 128 * 1024 )
+#define UPLOAD_SECONDS_PER_FRAME   0.002
+
+// Version of the grid in its disk cache key, to increment whenever the
+// grid generator changes its output
+#define GRID_VERSION               1
+
 typedef struct
 {
    // Handle to a program object
@@ -51,9 +62,16 @@ typedef struct
    // Sampler location
    GLint samplerLoc;
 
+   // Grid dimension for procedural vertices, 0 to read a_position
+   GLint gridSizeLoc;
+
    // Texture handle
    GLuint textureId;
 
+   // Heightmap file, kept mapped until its images are uploaded from it
+   ESFileMapping heightmapFile;
+   int           pendingHeightmap;
+
    // VBOs
    GLuint positionVBO;
    GLuint indicesIBO;
@@ -61,44 +79,114 @@ typedef struct
    // Number of indices
    int    numIndices;
 
+   // Grid arrays, kept until the buffers are uploaded from them
+   GLfloat *positions;
+   GLuint  *indices;
+   int      pendingUploads;
+
    // dimension of grid
    int    gridSize;
 
+   // Rebuild the grid from gl_VertexID and gl_InstanceID instead of the buffers
+   int    procedural;
+
+   // Frame time accumulated for the current mode
+   float  frameTime;
+   int    numFrames;
+
    // MVP matrix
    ESMatrix  mvpMatrix;
 } UserData;
 
+///
+// Release the heightmap file once its images are uploaded
+//
+void ESCALLBACK HeightmapUploaded ( void *data, GLboolean uploaded )
+{
+   UserData *userData = data;
+
+   if ( --userData->pendingHeightmap == 0 )
+   {
+      esUnmapFile ( &userData->heightmapFile );
+
+      if ( uploaded )
+      {
+         esLogMessage ( "Heightmap uploaded\n" );
+      }
+   }
+}
+
 ///
 // Load texture from disk
 //
-GLuint LoadTexture (  void *ioContext, char *fileName )
+GLuint LoadTexture ( ESContext *esContext, char *ktxFileName, char *tgaFileName )
 {
+   UserData *userData = esContext->userData;
+   void     *ioContext = esContext->platformData;
    int width,
        height;
+   GLuint texId = 0;
 
-   char *buffer = esLoadTGA ( ioContext, fileName, &width, &height );
-   GLuint texId;
+   // Prefer the compressed copy built by ETCCompress, sent through the
+   // upload scheduler straight from the mapped file.  The vertex shader
+   // only reads level 0, so it is built without mipmaps.
+   userData->pendingHeightmap = 0;
 
-   if ( buffer == NULL )
+   if ( esMapFile ( ioContext, ktxFileName, &userData->heightmapFile ) )
    {
-      esLogMessage ( "Error loading (%s) image.\n", fileName );
-      return 0;
+      texId = esScheduleTextureKTX ( esContext->uploadScheduler, userData->heightmapFile.data,
+                                     userData->heightmapFile.size, NULL, HeightmapUploaded, userData,
+                                     &userData->pendingHeightmap );
+
+      if ( userData->pendingHeightmap == 0 )
+      {
+         esUnmapFile ( &userData->heightmapFile );
+      }
    }
 
-   glGenTextures ( 1, &texId );
-   glBindTexture ( GL_TEXTURE_2D, texId );
+   if ( texId == 0 )
+   {
+      glGenTextures ( 1, &texId );
+      glBindTexture ( GL_TEXTURE_2D, texId );
+
+      // Upload straight from the mapped file, without a copy on the heap
+      if ( !esLoadTGATexture ( ioContext, tgaFileName, GL_TEXTURE_2D, &width, &height ) )
+      {
+         esLogMessage ( "Error loading (%s) image.\n", tgaFileName );
+         glDeleteTextures ( 1, &texId );
+         return 0;
+      }
+   }
 
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, buffer );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
 
-   free ( buffer );
-
    return texId;
 }
 
+///
+// Release the grid arrays once both buffers are uploaded
+//
+void ESCALLBACK GridUploaded ( void *data, GLboolean uploaded )
+{
+   UserData *userData = data;
+
+   if ( --userData->pendingUploads == 0 )
+   {
+      free ( userData->positions );
+      free ( userData->indices );
+      userData->positions = NULL;
+      userData->indices = NULL;
+
+      if ( uploaded )
+      {
+         esLogMessage ( "Grid buffers uploaded\n" );
+      }
+   }
+}
+
 ///
 // Initialize the MVP matrix
 //
@@ -137,28 +225,46 @@ int InitMVP ( ESContext *esContext )
 //
 int Init ( ESContext *esContext )
 {
-   GLfloat *positions;
-   GLuint *indices;
+   GLsizeiptr positionsSize,
+              indicesSize;
+   GLuint64   gridKey;
+   int        gridParams[2];
+   int        numVertices;
 
    UserData *userData = esContext->userData;
    const char vShaderStr[] =
       "#version 300 es                                      \n"
       "uniform mat4 u_mvpMatrix;                            \n"
       "uniform vec3 u_lightDirection;                       \n"
+      "uniform int u_gridSize;                              \n"
       "layout(location = 0) in vec4 a_position;             \n"
       "uniform sampler2D s_texture;                         \n"
       "out vec4 v_color;                                    \n"
       "void main()                                          \n"
       "{                                                    \n"
+      "   vec4 position = a_position;                       \n"
+      "                                                     \n"
+      "   // rebuild the grid vertex from the vertex and    \n"
+      "   // instance IDs, one triangle strip per row       \n"
+      "   if ( u_gridSize > 0 )                             \n"
+      "   {                                                 \n"
+      "      ivec2 cell = ivec2( gl_InstanceID + 1 -        \n"
+      "                          ( gl_VertexID & 1 ),       \n"
+      "                          gl_VertexID >> 1 );        \n"
+      "      position = vec4( vec2( cell ) /                \n"
+      "                       float( u_gridSize - 1 ),      \n"
+      "                       0.0, 1.0 );                   \n"
+      "   }                                                 \n"
+      "                                                     \n"
       "   // compute vertex normal from height map          \n"
       "   float hxl = textureOffset( s_texture,             \n"
-      "                  a_position.xy, ivec2(-1,  0) ).w;  \n"
+      "                  position.xy, ivec2(-1,  0) ).x;    \n"
       "   float hxr = textureOffset( s_texture,             \n"
-      "                  a_position.xy, ivec2( 1,  0) ).w;  \n"
+      "                  position.xy, ivec2( 1,  0) ).x;    \n"
       "   float hyl = textureOffset( s_texture,             \n"
-      "                  a_position.xy, ivec2( 0, -1) ).w;  \n"
+      "                  position.xy, ivec2( 0, -1) ).x;    \n"
       "   float hyr = textureOffset( s_texture,             \n"
-      "                  a_position.xy, ivec2( 0,  1) ).w;  \n"
+      "                  position.xy, ivec2( 0,  1) ).x;    \n"
       "   vec3 u = normalize( vec3(0.05, 0.0, hxr-hxl) );   \n"
       "   vec3 v = normalize( vec3(0.0, 0.05, hyr-hyl) );   \n"
       "   vec3 normal = cross( u, v );                      \n"
@@ -168,10 +274,10 @@ int Init ( ESContext *esContext )
       "   v_color = vec4( vec3(diffuse), 1.0 );             \n"
       "                                                     \n"
       "   // get vertex position from height map            \n"
-      "   float h = texture ( s_texture, a_position.xy ).w; \n"
-      "   vec4 v_position = vec4 ( a_position.xy,           \n"
+      "   float h = texture ( s_texture, position.xy ).x;   \n"
+      "   vec4 v_position = vec4 ( position.xy,             \n"
       "                            h/2.5,                   \n"
-      "                            a_position.w );          \n"
+      "                            position.w );            \n"
       "   gl_Position = u_mvpMatrix * v_position;           \n"
       "}                                                    \n";
 
@@ -195,34 +301,77 @@ int Init ( ESContext *esContext )
 
    // Get the sampler location
    userData->samplerLoc = glGetUniformLocation ( userData->programObject, "s_texture" );
+   userData->gridSizeLoc = glGetUniformLocation ( userData->programObject, "u_gridSize" );
+
+   // The heightmap and the grid buffers are filled over the first frames,
+   // a share of them per frame, while the procedural grid is drawn
+   esContext->uploadScheduler = esCreateUploadScheduler ( UPLOAD_BYTES_PER_FRAME, UPLOAD_SECONDS_PER_FRAME );
+
+   if ( esContext->uploadScheduler == NULL )
+   {
+      return FALSE;
+   }
 
-   // Load the heightmap
-   userData->textureId = LoadTexture ( esContext->platformData, "heightmap.tga" );
+   // Load the heightmap.  It is scheduled ahead of the grid buffers, and
+   // the terrain is drawn once it is in place.
+   userData->textureId = LoadTexture ( esContext, "heightmap.ktx", "heightmap.tga" );
 
    if ( userData->textureId == 0 )
    {
       return FALSE;
    }
 
-   // Generate the position and indices of a square grid for the base terrain
+   // Load the position and indices of a square grid for the base terrain
+   // from the disk cache, where they are stored compressed, or generate
+   // them and store them
    userData->gridSize = 200;
-   userData->numIndices = esGenSquareGrid ( userData->gridSize, &positions, &indices );
+   gridParams[0] = GRID_VERSION;
+   gridParams[1] = userData->gridSize;
+   gridKey = esHash64 ( ES_HASH_SEED, gridParams, sizeof ( gridParams ) );
+
+   if ( !esCacheLoadMesh ( esContext->cacheDir, "TerrainRendering-grid", gridKey, 3 * sizeof ( GLfloat ),
+                           ( void ** ) &userData->positions, &numVertices, &userData->indices,
+                           &userData->numIndices ) ||
+        numVertices != userData->gridSize * userData->gridSize )
+   {
+      free ( userData->positions );
+      free ( userData->indices );
+      userData->numIndices = esGenSquareGrid ( userData->gridSize, &userData->positions, &userData->indices );
+      esCacheStoreMesh ( esContext->cacheDir, "TerrainRendering-grid", gridKey, userData->positions,
+                         userData->gridSize * userData->gridSize, 3 * sizeof ( GLfloat ),
+                         userData->indices, userData->numIndices );
+   }
+   positionsSize = userData->gridSize * userData->gridSize * sizeof ( GLfloat ) * 3;
+   indicesSize = userData->numIndices * sizeof ( GLuint );
 
    // Index buffer for base terrain
    glGenBuffers ( 1, &userData->indicesIBO );
    glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->indicesIBO );
-   glBufferData ( GL_ELEMENT_ARRAY_BUFFER, userData->numIndices * sizeof ( GLuint ),
-                  indices, GL_STATIC_DRAW );
+   glBufferData ( GL_ELEMENT_ARRAY_BUFFER, indicesSize, NULL, GL_STATIC_DRAW );
    glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
-   free ( indices );
 
    // Position VBO for base terrain
    glGenBuffers ( 1, &userData->positionVBO );
    glBindBuffer ( GL_ARRAY_BUFFER, userData->positionVBO );
-   glBufferData ( GL_ARRAY_BUFFER,
-                  userData->gridSize * userData->gridSize * sizeof ( GLfloat ) * 3,
-                  positions, GL_STATIC_DRAW );
-   free ( positions );
+   glBufferData ( GL_ARRAY_BUFFER, positionsSize, NULL, GL_STATIC_DRAW );
+
+   userData->pendingUploads = 2;
+
+   if ( !esScheduleBufferUpload ( esContext->uploadScheduler, userData->indicesIBO, 0, indicesSize,
+                                  userData->indices, GridUploaded, userData ) ||
+         !esScheduleBufferUpload ( esContext->uploadScheduler, userData->positionVBO, 0, positionsSize,
+                                   userData->positions, GridUploaded, userData ) )
+   {
+      return FALSE;
+   }
+
+   esLogMessage ( "Grid buffers: %d bytes of positions, %d bytes of indices; procedural grid: 0 bytes\n",
+                  ( int ) positionsSize, ( int ) indicesSize );
+   esLogMessage ( "Press 'p' to switch between procedural and buffer vertices\n" );
+
+   userData->procedural = GL_TRUE;
+   userData->frameTime = 0.0f;
+   userData->numFrames = 0;
 
    glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
 
@@ -244,18 +393,14 @@ void Draw ( ESContext *esContext )
    // Clear the color buffer
    glClear ( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
+   if ( userData->pendingHeightmap > 0 )
+   {
+      return;
+   }
+
    // Use the program object
    glUseProgram ( userData->programObject );
 
-   // Load the vertex position
-   glBindBuffer ( GL_ARRAY_BUFFER, userData->positionVBO );
-   glVertexAttribPointer ( POSITION_LOC, 3, GL_FLOAT,
-                           GL_FALSE, 3 * sizeof ( GLfloat ), ( const void * ) NULL );
-   glEnableVertexAttribArray ( POSITION_LOC );
-
-   // Bind the index buffer
-   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->indicesIBO );
-
    // Bind the height map
    glActiveTexture ( GL_TEXTURE0 );
    glBindTexture ( GL_TEXTURE_2D, userData->textureId );
@@ -269,8 +414,65 @@ void Draw ( ESContext *esContext )
    // Set the height map sampler to texture unit to 0
    glUniform1i ( userData->samplerLoc, 0 );
 
-   // Draw the grid
-   glDrawElements ( GL_TRIANGLES, userData->numIndices, GL_UNSIGNED_INT, ( const void * ) NULL );
+   if ( userData->procedural )
+   {
+      // No vertex or index data, each row of quads is an instanced strip of 2 * gridSize vertices
+      glDisableVertexAttribArray ( POSITION_LOC );
+      glUniform1i ( userData->gridSizeLoc, userData->gridSize );
+      glDrawArraysInstanced ( GL_TRIANGLE_STRIP, 0, 2 * userData->gridSize, userData->gridSize - 1 );
+   }
+   else
+   {
+      // Load the vertex position
+      glBindBuffer ( GL_ARRAY_BUFFER, userData->positionVBO );
+      glVertexAttribPointer ( POSITION_LOC, 3, GL_FLOAT,
+                              GL_FALSE, 3 * sizeof ( GLfloat ), ( const void * ) NULL );
+      glEnableVertexAttribArray ( POSITION_LOC );
+
+      // Bind the index buffer
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->indicesIBO );
+
+      // Draw the grid
+      glUniform1i ( userData->gridSizeLoc, 0 );
+      glDrawElements ( GL_TRIANGLES, userData->numIndices, GL_UNSIGNED_INT, ( const void * ) NULL );
+   }
+}
+
+///
+// Report the average frame time of the current mode
+//
+void Update ( ESContext *esContext, float deltaTime )
+{
+   UserData *userData = esContext->userData;
+
+   userData->frameTime += deltaTime;
+
+   if ( ++userData->numFrames == NUM_TIMED_FRAMES )
+   {
+      esLogMessage ( "%s grid: %.3f ms per frame\n", userData->procedural ? "Procedural" : "Buffer",
+                     1000.0f * userData->frameTime / NUM_TIMED_FRAMES );
+      userData->frameTime = 0.0f;
+      userData->numFrames = 0;
+   }
+}
+
+///
+// Switch between procedural and buffer vertices
+//
+void Key ( ESContext *esContext, unsigned char key, int x, int y )
+{
+   UserData *userData = esContext->userData;
+
+   if ( ( key == 'p' || key == 'P' ) && userData->pendingUploads > 0 )
+   {
+      esLogMessage ( "Grid buffers are still uploading\n" );
+   }
+   else if ( key == 'p' || key == 'P' )
+   {
+      userData->procedural = !userData->procedural;
+      userData->frameTime = 0.0f;
+      userData->numFrames = 0;
+   }
 }
 
 ///
@@ -280,6 +482,11 @@ void Shutdown ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
 
+   // Drops the uploads still pending, which releases the heightmap file
+   // and the grid arrays
+   esDeleteUploadScheduler ( esContext->uploadScheduler );
+   esContext->uploadScheduler = NULL;
+
    glDeleteBuffers ( 1, &userData->positionVBO );
    glDeleteBuffers ( 1, &userData->indicesIBO );
 
@@ -301,6 +508,8 @@ int esMain ( ESContext *esContext )
 
    esRegisterShutdownFunc ( esContext, Shutdown );
    esRegisterDrawFunc ( esContext, Draw );
+   esRegisterUpdateFunc ( esContext, Update );
+   esRegisterKeyFunc ( esContext, Key );
 
    return GL_TRUE;
 }
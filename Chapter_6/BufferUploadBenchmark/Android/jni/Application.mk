@@ -0,0 +1 @@
+APP_PLATFORM := android-18
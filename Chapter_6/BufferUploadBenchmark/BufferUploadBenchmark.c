@@ -0,0 +1,507 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// BufferUploadBenchmark.c
+//
+//    This example measures the cost of streaming vertex data to the GPU
+//    every frame using each of the buffer upload paths available in
+//    OpenGL ES 3.0: glBufferData, glBufferSubData, buffer orphaning,
+//    glMapBufferRange with the various access flags and client-side
+//    vertex arrays.  Each path runs for a fixed number of frames and the
+//    average frame time and upload throughput are logged.
+//
+//    Keys:
+//       n     - skip to the next upload path
+//       + / - - double / halve the amount of data streamed per frame
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esUtil.h"
+
+#define VERTEX_POS_SIZE       4 // x, y, z and w
+#define VERTEX_POS_INDX       0
+#define VERTEX_STRIDE         ( sizeof ( GLfloat ) * VERTEX_POS_SIZE )
+
+// Default amount of vertex data streamed each frame
+#define DEFAULT_UPLOAD_SIZE   ( 4 * 1024 * 1024 )
+#define MIN_UPLOAD_SIZE       ( 64 * 1024 )
+#define MAX_UPLOAD_SIZE       ( 64 * 1024 * 1024 )
+
+// Number of frames to ignore and to measure for each upload path
+#define WARMUP_FRAMES         30
+#define MEASURE_FRAMES        300
+
+// Number of segments in the buffer used by the unsynchronized path
+#define NUM_RING_SEGMENTS     3
+
+typedef enum
+{
+   UPLOAD_BUFFER_DATA,
+   UPLOAD_BUFFER_SUB_DATA,
+   UPLOAD_ORPHAN,
+   UPLOAD_MAP_INVALIDATE_BUFFER,
+   UPLOAD_MAP_INVALIDATE_RANGE,
+   UPLOAD_MAP_UNSYNCHRONIZED,
+   UPLOAD_MAP_FLUSH_EXPLICIT,
+   UPLOAD_CLIENT_ARRAYS,
+   NUM_UPLOAD_MODES
+} UploadMode;
+
+static const char *uploadModeNames[NUM_UPLOAD_MODES] =
+{
+   "glBufferData",
+   "glBufferSubData",
+   "orphan + glBufferSubData",
+   "map INVALIDATE_BUFFER",
+   "map INVALIDATE_RANGE",
+   "map UNSYNCHRONIZED ring",
+   "map FLUSH_EXPLICIT",
+   "client arrays"
+};
+
+typedef struct
+{
+   // Handle to a program object
+   GLuint programObject;
+
+   // Streaming vertex buffer
+   GLuint vboId;
+
+   // Fences guarding each segment of the unsynchronized ring buffer
+   GLsync ringFences[NUM_RING_SEGMENTS];
+   int    ringSegment;
+
+   // Vertex data copied to the GPU every frame
+   GLfloat *vertices;
+   GLsizei  uploadSize;
+
+   // Benchmark state
+   UploadMode mode;
+   int        frame;
+   float      elapsedTime;
+   float      maxFrameTime;
+
+} UserData;
+
+///
+// Fill the client side copy of the streamed vertex data
+//
+static GLboolean CreateVertexData ( UserData *userData, GLsizei uploadSize )
+{
+   GLsizei numVertices = uploadSize / VERTEX_STRIDE;
+   GLfloat *vertices;
+   GLsizei i;
+
+   // Keep the current data if the new block cannot be allocated
+   vertices = malloc ( uploadSize );
+
+   if ( vertices == NULL )
+   {
+      esLogMessage ( "Error allocating %d bytes of vertex data\n", uploadSize );
+      return GL_FALSE;
+   }
+
+   free ( userData->vertices );
+   userData->vertices = vertices;
+
+   srand ( 0 );
+
+   for ( i = 0; i < numVertices; i++ )
+   {
+      GLfloat *pos = &vertices[i * VERTEX_POS_SIZE];
+
+      pos[0] = ( ( float ) rand() / ( float ) RAND_MAX ) * 2.0f - 1.0f;
+      pos[1] = ( ( float ) rand() / ( float ) RAND_MAX ) * 2.0f - 1.0f;
+      pos[2] = 0.0f;
+      pos[3] = 1.0f;
+   }
+
+   userData->uploadSize = uploadSize;
+   return GL_TRUE;
+}
+
+///
+// Release the fences of the unsynchronized ring buffer
+//
+static void DeleteRingFences ( UserData *userData )
+{
+   int i;
+
+   for ( i = 0; i < NUM_RING_SEGMENTS; i++ )
+   {
+      if ( userData->ringFences[i] != NULL )
+      {
+         glDeleteSync ( userData->ringFences[i] );
+         userData->ringFences[i] = NULL;
+      }
+   }
+
+   userData->ringSegment = 0;
+}
+
+///
+// (Re)allocate the storage of the streaming buffer for the current mode
+//
+static void ResetUploadMode ( UserData *userData, UploadMode mode )
+{
+   GLsizeiptr bufferSize = userData->uploadSize;
+
+   if ( mode == UPLOAD_MAP_UNSYNCHRONIZED )
+   {
+      bufferSize *= NUM_RING_SEGMENTS;
+   }
+
+   DeleteRingFences ( userData );
+
+   glBindBuffer ( GL_ARRAY_BUFFER, userData->vboId );
+   glBufferData ( GL_ARRAY_BUFFER, bufferSize, NULL, GL_STREAM_DRAW );
+   glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+
+   userData->mode = mode;
+   userData->frame = 0;
+   userData->elapsedTime = 0.0f;
+   userData->maxFrameTime = 0.0f;
+}
+
+///
+// Log the results of the current mode
+//
+static void ReportUploadMode ( UserData *userData )
+{
+   float avgFrameTime = userData->elapsedTime / ( float ) MEASURE_FRAMES;
+   float megaBytes = ( float ) userData->uploadSize / ( 1024.0f * 1024.0f );
+
+   esLogMessage ( "%-28s %8.2f MB/frame  %8.1f MB/s  avg %7.3f ms  max %7.3f ms\n",
+                  uploadModeNames[userData->mode],
+                  megaBytes,
+                  megaBytes * ( float ) MEASURE_FRAMES / userData->elapsedTime,
+                  avgFrameTime * 1000.0f,
+                  userData->maxFrameTime * 1000.0f );
+}
+
+///
+// Copy this frame's vertex data into the streaming buffer.  Returns the
+// offset of the data in the buffer, or -1 on failure.
+//
+static GLintptr UploadVertexData ( UserData *userData )
+{
+   GLsizeiptr size = userData->uploadSize;
+   GLintptr   offset = 0;
+   void      *mapped = NULL;
+
+   glBindBuffer ( GL_ARRAY_BUFFER, userData->vboId );
+
+   switch ( userData->mode )
+   {
+      case UPLOAD_BUFFER_DATA:
+         glBufferData ( GL_ARRAY_BUFFER, size, userData->vertices, GL_STREAM_DRAW );
+         break;
+
+      case UPLOAD_BUFFER_SUB_DATA:
+         glBufferSubData ( GL_ARRAY_BUFFER, 0, size, userData->vertices );
+         break;
+
+      case UPLOAD_ORPHAN:
+         // Detach the old storage so the driver does not need to wait for
+         // draws that are still reading it
+         glBufferData ( GL_ARRAY_BUFFER, size, NULL, GL_STREAM_DRAW );
+         glBufferSubData ( GL_ARRAY_BUFFER, 0, size, userData->vertices );
+         break;
+
+      case UPLOAD_MAP_INVALIDATE_BUFFER:
+         mapped = glMapBufferRange ( GL_ARRAY_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+         break;
+
+      case UPLOAD_MAP_INVALIDATE_RANGE:
+         mapped = glMapBufferRange ( GL_ARRAY_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT );
+         break;
+
+      case UPLOAD_MAP_UNSYNCHRONIZED:
+      {
+         GLsync fence = userData->ringFences[userData->ringSegment];
+
+         // Only wait for the GPU if it is still reading the segment
+         if ( fence != NULL )
+         {
+            glClientWaitSync ( fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED );
+            glDeleteSync ( fence );
+            userData->ringFences[userData->ringSegment] = NULL;
+         }
+
+         offset = userData->ringSegment * size;
+         mapped = glMapBufferRange ( GL_ARRAY_BUFFER, offset, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                                     GL_MAP_INVALIDATE_RANGE_BIT );
+         break;
+      }
+
+      case UPLOAD_MAP_FLUSH_EXPLICIT:
+         mapped = glMapBufferRange ( GL_ARRAY_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT |
+                                     GL_MAP_INVALIDATE_RANGE_BIT );
+         break;
+
+      default:
+         break;
+   }
+
+   if ( userData->mode >= UPLOAD_MAP_INVALIDATE_BUFFER &&
+         userData->mode <= UPLOAD_MAP_FLUSH_EXPLICIT )
+   {
+      if ( mapped == NULL )
+      {
+         esLogMessage ( "Error mapping vertex buffer object." );
+         return -1;
+      }
+
+      // Copy the data into the mapped buffer
+      memcpy ( mapped, userData->vertices, size );
+
+      if ( userData->mode == UPLOAD_MAP_FLUSH_EXPLICIT )
+      {
+         glFlushMappedBufferRange ( GL_ARRAY_BUFFER, 0, size );
+      }
+
+      // Unmap the buffer
+      if ( glUnmapBuffer ( GL_ARRAY_BUFFER ) == GL_FALSE )
+      {
+         esLogMessage ( "Error unmapping array buffer object." );
+         return -1;
+      }
+   }
+
+   return offset;
+}
+
+///
+// Initialize the shader and program object
+//
+int Init ( ESContext *esContext )
+{
+   UserData *userData = esContext->userData;
+   const char vShaderStr[] =
+      "#version 300 es                            \n"
+      "layout(location = 0) in vec4 a_position;   \n"
+      "void main()                                \n"
+      "{                                          \n"
+      "    gl_Position = a_position;              \n"
+      "    gl_PointSize = 1.0;                    \n"
+      "}";
+
+
+   const char fShaderStr[] =
+      "#version 300 es                                  \n"
+      "precision mediump float;                         \n"
+      "out vec4 o_fragColor;                            \n"
+      "void main()                                      \n"
+      "{                                                \n"
+      "    o_fragColor = vec4 ( 0.0, 0.0, 0.0, 1.0 );   \n"
+      "}" ;
+
+   GLuint programObject;
+
+   // Create the program object
+   programObject = esLoadProgram ( vShaderStr, fShaderStr );
+
+   if ( programObject == 0 )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( userData, 0, sizeof ( UserData ) );
+
+   // Store the program object
+   userData->programObject = programObject;
+
+   if ( !CreateVertexData ( userData, DEFAULT_UPLOAD_SIZE ) )
+   {
+      return GL_FALSE;
+   }
+
+   glGenBuffers ( 1, &userData->vboId );
+   ResetUploadMode ( userData, UPLOAD_BUFFER_DATA );
+
+   glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
+   return GL_TRUE;
+}
+
+///
+// Accumulate frame times and advance to the next upload path when done
+//
+void Update ( ESContext *esContext, float deltaTime )
+{
+   UserData *userData = esContext->userData;
+
+   // deltaTime is the duration of the previous frame
+   if ( userData->frame > WARMUP_FRAMES )
+   {
+      userData->elapsedTime += deltaTime;
+
+      if ( deltaTime > userData->maxFrameTime )
+      {
+         userData->maxFrameTime = deltaTime;
+      }
+   }
+
+   if ( userData->frame == WARMUP_FRAMES + MEASURE_FRAMES )
+   {
+      ReportUploadMode ( userData );
+      ResetUploadMode ( userData, ( userData->mode + 1 ) % NUM_UPLOAD_MODES );
+   }
+}
+
+///
+// Stream the vertex data and draw it as points
+//
+void Draw ( ESContext *esContext )
+{
+   UserData *userData = esContext->userData;
+   GLsizei   numVertices = userData->uploadSize / VERTEX_STRIDE;
+
+   glViewport ( 0, 0, esContext->width, esContext->height );
+   glClear ( GL_COLOR_BUFFER_BIT );
+   glUseProgram ( userData->programObject );
+
+   glEnableVertexAttribArray ( VERTEX_POS_INDX );
+
+   if ( userData->mode == UPLOAD_CLIENT_ARRAYS )
+   {
+      // The driver copies the data out of client memory at draw time
+      glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+      glVertexAttribPointer ( VERTEX_POS_INDX, VERTEX_POS_SIZE,
+                              GL_FLOAT, GL_FALSE, VERTEX_STRIDE,
+                              userData->vertices );
+   }
+   else
+   {
+      GLintptr offset = UploadVertexData ( userData );
+
+      if ( offset < 0 )
+      {
+         // Skip a path the driver cannot service rather than stalling on it
+         esLogMessage ( "%-28s upload failed, skipping\n", uploadModeNames[userData->mode] );
+         glDisableVertexAttribArray ( VERTEX_POS_INDX );
+         glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+         ResetUploadMode ( userData, ( userData->mode + 1 ) % NUM_UPLOAD_MODES );
+         return;
+      }
+
+      glVertexAttribPointer ( VERTEX_POS_INDX, VERTEX_POS_SIZE,
+                              GL_FLOAT, GL_FALSE, VERTEX_STRIDE,
+                              ( const void * ) offset );
+   }
+
+   glDrawArrays ( GL_POINTS, 0, numVertices );
+
+   if ( userData->mode == UPLOAD_MAP_UNSYNCHRONIZED )
+   {
+      // Fence the segment just drawn from and move on to the next one
+      userData->ringFences[userData->ringSegment] = glFenceSync ( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+      userData->ringSegment = ( userData->ringSegment + 1 ) % NUM_RING_SEGMENTS;
+   }
+
+   glDisableVertexAttribArray ( VERTEX_POS_INDX );
+   glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+
+   userData->frame++;
+}
+
+///
+// Handle keyboard input
+//
+void Key ( ESContext *esContext, unsigned char key, int x, int y )
+{
+   UserData *userData = esContext->userData;
+   GLsizei   uploadSize = userData->uploadSize;
+
+   switch ( key )
+   {
+      case 'n':
+      case 'N':
+         ResetUploadMode ( userData, ( userData->mode + 1 ) % NUM_UPLOAD_MODES );
+         return;
+
+      case '+':
+      case '=':
+         uploadSize *= 2;
+         break;
+
+      case '-':
+         uploadSize /= 2;
+         break;
+
+      default:
+         return;
+   }
+
+   if ( uploadSize < MIN_UPLOAD_SIZE || uploadSize > MAX_UPLOAD_SIZE )
+   {
+      return;
+   }
+
+   if ( CreateVertexData ( userData, uploadSize ) )
+   {
+      ResetUploadMode ( userData, userData->mode );
+   }
+}
+
+void Shutdown ( ESContext *esContext )
+{
+   UserData *userData = esContext->userData;
+
+   DeleteRingFences ( userData );
+   free ( userData->vertices );
+
+   glDeleteProgram ( userData->programObject );
+   glDeleteBuffers ( 1, &userData->vboId );
+}
+
+int esMain ( ESContext *esContext )
+{
+   esContext->userData = malloc ( sizeof ( UserData ) );
+
+   esCreateWindow ( esContext, "BufferUploadBenchmark", 320, 240, ES_WINDOW_RGB );
+
+   if ( !Init ( esContext ) )
+   {
+      return GL_FALSE;
+   }
+
+   esRegisterShutdownFunc ( esContext, Shutdown );
+   esRegisterUpdateFunc ( esContext, Update );
+   esRegisterDrawFunc ( esContext, Draw );
+   esRegisterKeyFunc ( esContext, Key );
+
+   return GL_TRUE;
+}
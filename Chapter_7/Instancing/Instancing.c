@@ -66,6 +66,18 @@ typedef struct
    // Rotation angle
    GLfloat   angle[NUM_INSTANCES];
 
+   // CPU copy of the per-instance MVPs and the instances changed since the last upload
+   ESMatrix      mvp[NUM_INSTANCES];
+   ESDirtyRanges dirty;
+
+   // Aspect ratio the MVPs were computed with
+   GLfloat   aspect;
+
+   // When set, only one row of cubes spins at a time
+   int       sparse;
+   int       activeRow;
+   float     rowTime;
+
 } UserData;
 
 ///
@@ -152,6 +164,13 @@ int Init ( ESContext *esContext )
       glGenBuffers ( 1, &userData->mvpVBO );
       glBindBuffer ( GL_ARRAY_BUFFER, userData->mvpVBO );
       glBufferData ( GL_ARRAY_BUFFER, NUM_INSTANCES * sizeof ( ESMatrix ), NULL, GL_DYNAMIC_DRAW );
+
+      // Every MVP is computed on the first update since the aspect ratio is unknown
+      esInitDirtyRanges ( &userData->dirty, sizeof ( ESMatrix ) );
+      userData->aspect = 0.0f;
+      userData->sparse = GL_FALSE;
+      userData->activeRow = 0;
+      userData->rowTime = 0.0f;
    }
    glBindBuffer ( GL_ARRAY_BUFFER, 0 );
 
@@ -160,63 +179,102 @@ int Init ( ESContext *esContext )
 }
 
 
+///
+// Compute the MVP of one instance into the CPU copy and mark it dirty
+//
+void UpdateInstanceMVP ( UserData *userData, int instance, ESMatrix *perspective )
+{
+   ESMatrix modelview;
+   int      numRows = ( int ) sqrtf ( NUM_INSTANCES );
+   int      numColumns = numRows;
+   float    translateX = ( ( float ) ( instance % numRows ) / ( float ) numRows ) * 2.0f - 1.0f;
+   float    translateY = ( ( float ) ( instance / numColumns ) / ( float ) numColumns ) * 2.0f - 1.0f;
+
+   // Generate a model view matrix to rotate/translate the cube
+   esMatrixLoadIdentity ( &modelview );
+
+   // Per-instance translation
+   esTranslate ( &modelview, translateX, translateY, -2.0f );
+
+   // Rotate the cube
+   esRotate ( &modelview, userData->angle[instance], 1.0, 0.0, 1.0 );
+
+   // Compute the final MVP by multiplying the
+   // modevleiw and perspective matrices together
+   esMatrixMultiply ( &userData->mvp[instance], &modelview, perspective );
+
+   esMarkDirty ( &userData->dirty, instance, 1 );
+}
+
 ///
 // Update MVP matrix based on time
 //
 void Update ( ESContext *esContext, float deltaTime )
 {
    UserData *userData = ( UserData * ) esContext->userData;
-   ESMatrix *matrixBuf;
    ESMatrix perspective;
    float    aspect;
    int      instance = 0;
-   int      numRows;
-   int      numColumns;
+   int      numColumns = ( int ) sqrtf ( NUM_INSTANCES );
+   int      aspectChanged;
 
 
    // Compute the window aspect ratio
    aspect = ( GLfloat ) esContext->width / ( GLfloat ) esContext->height;
+   aspectChanged = ( aspect != userData->aspect );
+   userData->aspect = aspect;
 
    // Generate a perspective matrix with a 60 degree FOV
    esMatrixLoadIdentity ( &perspective );
    esPerspective ( &perspective, 60.0f, aspect, 1.0f, 20.0f );
 
-   glBindBuffer ( GL_ARRAY_BUFFER, userData->mvpVBO );
-   matrixBuf = ( ESMatrix * ) glMapBufferRange ( GL_ARRAY_BUFFER, 0, sizeof ( ESMatrix ) * NUM_INSTANCES, GL_MAP_WRITE_BIT );
+   // In sparse mode the spinning row moves on every second
+   userData->rowTime += deltaTime;
 
-   // Compute a per-instance MVP that translates and rotates each instance differnetly
-   numRows = ( int ) sqrtf ( NUM_INSTANCES );
-   numColumns = numRows;
+   if ( userData->rowTime >= 1.0f )
+   {
+      userData->rowTime = 0.0f;
+      userData->activeRow = ( userData->activeRow + 1 ) % numColumns;
+   }
 
    for ( instance = 0; instance < NUM_INSTANCES; instance++ )
    {
-      ESMatrix modelview;
-      float translateX = ( ( float ) ( instance % numRows ) / ( float ) numRows ) * 2.0f - 1.0f;
-      float translateY = ( ( float ) ( instance / numColumns ) / ( float ) numColumns ) * 2.0f - 1.0f;
+      int spinning = !userData->sparse || instance / numColumns == userData->activeRow;
 
-      // Generate a model view matrix to rotate/translate the cube
-      esMatrixLoadIdentity ( &modelview );
-
-      // Per-instance translation
-      esTranslate ( &modelview, translateX, translateY, -2.0f );
+      if ( spinning )
+      {
+         // Compute a rotation angle based on time to rotate the cube
+         userData->angle[instance] += ( deltaTime * 40.0f );
 
-      // Compute a rotation angle based on time to rotate the cube
-      userData->angle[instance] += ( deltaTime * 40.0f );
+         if ( userData->angle[instance] >= 360.0f )
+         {
+            userData->angle[instance] -= 360.0f;
+         }
+      }
 
-      if ( userData->angle[instance] >= 360.0f )
+      // Only instances whose MVP changed are recomputed and uploaded
+      if ( spinning || aspectChanged )
       {
-         userData->angle[instance] -= 360.0f;
+         UpdateInstanceMVP ( userData, instance, &perspective );
       }
+   }
 
-      // Rotate the cube
-      esRotate ( &modelview, userData->angle[instance], 1.0, 0.0, 1.0 );
+   // Upload just the changed matrices; adjacent instances coalesce into one range
+   glBindBuffer ( GL_ARRAY_BUFFER, userData->mvpVBO );
+   esFlushDirtyRanges ( &userData->dirty, GL_ARRAY_BUFFER, userData->mvp, ES_FLUSH_MAP_EXPLICIT );
+}
 
-      // Compute the final MVP by multiplying the
-      // modevleiw and perspective matrices together
-      esMatrixMultiply ( &matrixBuf[instance], &modelview, &perspective );
-   }
+///
+// Toggle between spinning every cube and a single row
+//
+void Key ( ESContext *esContext, unsigned char key, int x, int y )
+{
+   UserData *userData = esContext->userData;
 
-   glUnmapBuffer ( GL_ARRAY_BUFFER );
+   if ( key == 's' || key == 'S' )
+   {
+      userData->sparse = !userData->sparse;
+   }
 }
 
 ///
@@ -305,6 +363,7 @@ int esMain ( ESContext *esContext )
 
    esRegisterShutdownFunc ( esContext, Shutdown );
    esRegisterUpdateFunc ( esContext, Update );
+   esRegisterKeyFunc ( esContext, Key );
    esRegisterDrawFunc ( esContext, Draw );
 
    return GL_TRUE;
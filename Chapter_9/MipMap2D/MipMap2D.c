@@ -32,11 +32,42 @@
 // MipMap2D.c
 //
 //    This is a simple example that demonstrates generating a mipmap chain
-//    and rendering with it
+//    and rendering with it.  The image and its mipmap chain are kept in
+//    the disk cache, so they are only generated on the first run.
+//
+//    Press 'c' to switch between two checkerboards.  Texture memory is
+//    kept under a budget that only fits one of them, so the levels of the
+//    one not drawn are dropped, and come back one per frame when it is
+//    drawn again.
 //
 #include <stdlib.h>
+#include <string.h>
 #include "esUtil.h"
 
+// Version of the checkerboard generator, to increment whenever it
+// changes its output
+#define CHECKER_VERSION   1
+
+// Parameters of the checkerboard and version of its generator, which are
+// also its disk cache key
+typedef struct
+{
+   int version;
+   int width;
+   int height;
+   int checkSize;
+} CheckImageParams;
+
+// A checkerboard texture, with its mipmap chain kept to upload the levels
+// the residency manager dropped
+typedef struct
+{
+   CheckImageParams params;
+   const GLubyte   *pixels;
+   ESFileMapping    mapping;
+   GLuint           textureId;
+} Checkerboard;
+
 typedef struct
 {
    // Handle to a program object
@@ -48,85 +79,22 @@ typedef struct
    // Offset location
    GLint offsetLoc;
 
-   // Texture handle
-   GLuint textureId;
-
-} UserData;
-
-
-///
-//  From an RGB8 source image, generate the next level mipmap
-//
-GLboolean GenMipMap2D ( GLubyte *src, GLubyte **dst, int srcWidth, int srcHeight, int *dstWidth, int *dstHeight )
-{
-   int x,
-       y;
-   int texelSize = 3;
-
-   *dstWidth = srcWidth / 2;
+   // Checkerboard textures and the one drawn
+   Checkerboard checkerboards[2];
+   int          current;
 
-   if ( *dstWidth <= 0 )
-   {
-      *dstWidth = 1;
-   }
+   // Keeps the textures under a memory budget
+   ESResidency *residency;
 
-   *dstHeight = srcHeight / 2;
+   // Vertex and index buffer for the quad
+   GLuint vboIds[2];
 
-   if ( *dstHeight <= 0 )
-   {
-      *dstHeight = 1;
-   }
-
-   *dst = malloc ( sizeof ( GLubyte ) * texelSize * ( *dstWidth ) * ( *dstHeight ) );
-
-   if ( *dst == NULL )
-   {
-      return GL_FALSE;
-   }
+   // Vertex array object holding the quad's vertex state
+   ESVertexArrayCache *vaoCache;
+   GLuint vao;
 
-   for ( y = 0; y < *dstHeight; y++ )
-   {
-      for ( x = 0; x < *dstWidth; x++ )
-      {
-         int srcIndex[4];
-         float r = 0.0f,
-               g = 0.0f,
-               b = 0.0f;
-         int sample;
-
-         // Compute the offsets for 2x2 grid of pixels in previous
-         // image to perform box filter
-         srcIndex[0] =
-            ( ( ( y * 2 ) * srcWidth ) + ( x * 2 ) ) * texelSize;
-         srcIndex[1] =
-            ( ( ( y * 2 ) * srcWidth ) + ( x * 2 + 1 ) ) * texelSize;
-         srcIndex[2] =
-            ( ( ( ( y * 2 ) + 1 ) * srcWidth ) + ( x * 2 ) ) * texelSize;
-         srcIndex[3] =
-            ( ( ( ( y * 2 ) + 1 ) * srcWidth ) + ( x * 2 + 1 ) ) * texelSize;
-
-         // Sum all pixels
-         for ( sample = 0; sample < 4; sample++ )
-         {
-            r += src[srcIndex[sample]];
-            g += src[srcIndex[sample] + 1];
-            b += src[srcIndex[sample] + 2];
-         }
-
-         // Average results
-         r /= 4.0;
-         g /= 4.0;
-         b /= 4.0;
-
-         // Store resulting pixels
-         ( *dst ) [ ( y * ( *dstWidth ) + x ) * texelSize ] = ( GLubyte ) ( r );
-         ( *dst ) [ ( y * ( *dstWidth ) + x ) * texelSize + 1] = ( GLubyte ) ( g );
-         ( *dst ) [ ( y * ( *dstWidth ) + x ) * texelSize + 2] = ( GLubyte ) ( b );
-      }
-   }
+} UserData;
 
-   return GL_TRUE;
-}
 
 ///
 //  Generate an RGB8 checkerboard image
@@ -168,73 +136,116 @@ GLubyte *GenCheckImage ( int width, int height, int checkSize )
 }
 
 ///
-// Create a mipmapped 2D texture image
+// Generate the checkerboard followed by its mipmap chain
 //
-GLuint CreateMipMappedTexture2D( )
+GLboolean ESCALLBACK GenMipMappedCheckImage ( void *userData, void *data, size_t size )
 {
-   // Texture object handle
-   GLuint textureId;
-   int    width = 256,
-          height = 256;
-   int    level;
-   GLubyte *pixels;
-   GLubyte *prevImage;
-   GLubyte *newImage;
+   CheckImageParams *params = userData;
+   size_t    baseSize = params->width * params->height * 3;
+   GLubyte  *pixels;
+   GLboolean generated;
 
-   pixels = GenCheckImage ( width, height, 8 );
+   // The base level is followed by the rest of the chain
+   if ( size != baseSize + ( size_t ) esMipChainSize ( params->width, params->height, 3, NULL ) )
+   {
+      return GL_FALSE;
+   }
+
+   pixels = GenCheckImage ( params->width, params->height, params->checkSize );
 
    if ( pixels == NULL )
    {
-      return 0;
+      return GL_FALSE;
    }
 
-   // Generate a texture object
-   glGenTextures ( 1, &textureId );
+   // Generate every level below the base one, down to 1x1
+   memcpy ( data, pixels, baseSize );
+   generated = esGenMipChain ( pixels, params->width, params->height, 3, ES_MIP_FILTER_BOX, GL_FALSE,
+                               ( GLubyte * ) data + baseSize );
 
-   // Bind the texture object
-   glBindTexture ( GL_TEXTURE_2D, textureId );
+   free ( pixels );
+   return generated;
+}
 
-   // Load mipmap level 0
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, width, height,
-                  0, GL_RGB, GL_UNSIGNED_BYTE, pixels );
+///
+// Upload a level of a checkerboard dropped by the residency manager again
+//
+GLboolean ESCALLBACK RestoreCheckerLevel ( void *userData, GLuint texture, GLenum target, int level,
+                                           int textureLevel )
+{
+   Checkerboard  *board = userData;
+   const GLubyte *pixels = board->pixels;
+   int            width = board->params.width;
+   int            height = board->params.height;
+   GLubyte       *rgba;
+   int            i;
+
+   // Levels are stored one after the other
+   for ( i = 0; i < level; i++ )
+   {
+      pixels += width * height * 3;
+      width = width > 1 ? width / 2 : 1;
+      height = height > 1 ? height / 2 : 1;
+   }
 
-   level = 1;
-   prevImage = &pixels[0];
+   // The texture is RGBA8, as esCreateTexture2D stores RGB images
+   rgba = malloc ( width * height * 4 );
 
-   while ( width > 1 && height > 1 )
+   if ( rgba == NULL )
    {
-      int newWidth,
-          newHeight;
+      return GL_FALSE;
+   }
 
-      // Generate the next mipmap level
-      GenMipMap2D ( prevImage, &newImage, width, height,
-                    &newWidth, &newHeight );
+   for ( i = 0; i < width * height; i++ )
+   {
+      rgba[i * 4] = pixels[i * 3];
+      rgba[i * 4 + 1] = pixels[i * 3 + 1];
+      rgba[i * 4 + 2] = pixels[i * 3 + 2];
+      rgba[i * 4 + 3] = 255;
+   }
 
-      // Load the mipmap level
-      glTexImage2D ( GL_TEXTURE_2D, level, GL_RGB,
-                     newWidth, newHeight, 0, GL_RGB,
-                     GL_UNSIGNED_BYTE, newImage );
+   glTexSubImage2D ( target, textureLevel, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rgba );
 
-      // Free the previous image
-      free ( prevImage );
+   free ( rgba );
+   return GL_TRUE;
+}
 
-      // Set the previous image for the next iteration
-      prevImage = newImage;
-      level++;
+///
+// Create a mipmapped 2D texture image
+//
+GLboolean CreateMipMappedTexture2D ( Checkerboard *board, ESResidency *residency, const char *cacheDir )
+{
+   CheckImageParams *params = &board->params;
+   int    width = params->width,
+          height = params->height;
+   int    numLevels;
+   size_t size;
+
+   size = width * height * 3 + esMipChainSize ( width, height, 3, &numLevels );
+   board->pixels = esCacheGenerate ( cacheDir, "MipMap2D-checker", params, sizeof ( CheckImageParams ), size,
+                                     GenMipMappedCheckImage, params, &board->mapping );
 
-      // Half the width and height
-      width = newWidth;
-      height = newHeight;
+   if ( board->pixels == NULL )
+   {
+      return GL_FALSE;
    }
 
-   free ( newImage );
+   // Load mipmap level 0 and the other levels, which follow it one after
+   // the other, into an immutable texture
+   board->textureId = esCreateTexture2D ( board->pixels, width, height, 3, numLevels );
+
+   if ( board->textureId == 0 )
+   {
+      return GL_FALSE;
+   }
 
    // Set the filtering mode
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
-   return textureId;
-
+   // The chain stays mapped to upload dropped levels again
+   return esResidencyAddTexture ( residency, board->textureId, GL_TEXTURE_2D, GL_RGBA8, width, height, 1,
+                                  numLevels, RestoreCheckerLevel, board );
 }
 
 
@@ -277,8 +288,71 @@ int Init ( ESContext *esContext )
    // Get the offset location
    userData->offsetLoc = glGetUniformLocation ( userData->programObject, "u_offset" );
 
-   // Load the texture
-   userData->textureId = CreateMipMappedTexture2D ();
+   // Budget the memory of one checkerboard and a bit: 256x256 RGBA8 with
+   // its mipmap chain takes about 341 KB
+   memset ( userData->checkerboards, 0, sizeof ( userData->checkerboards ) );
+   userData->current = 0;
+   userData->residency = esCreateResidency ( 448 * 1024 );
+
+   if ( userData->residency == NULL )
+   {
+      return FALSE;
+   }
+
+   // Load the textures
+   userData->checkerboards[0].params.version = CHECKER_VERSION;
+   userData->checkerboards[0].params.width = 256;
+   userData->checkerboards[0].params.height = 256;
+   userData->checkerboards[0].params.checkSize = 8;
+   userData->checkerboards[1].params = userData->checkerboards[0].params;
+   userData->checkerboards[1].params.checkSize = 32;
+
+   if ( !CreateMipMappedTexture2D ( &userData->checkerboards[0], userData->residency, esContext->cacheDir ) ||
+        !CreateMipMappedTexture2D ( &userData->checkerboards[1], userData->residency, esContext->cacheDir ) )
+   {
+      return FALSE;
+   }
+
+   // Store the quad in buffer objects and capture its vertex state in a VAO
+   {
+      GLfloat vVertices[] = { -0.5f,  0.5f, 0.0f, 1.5f,  // Position 0
+                               0.0f,  0.0f,              // TexCoord 0 
+                              -0.5f, -0.5f, 0.0f, 0.75f, // Position 1
+                               0.0f,  1.0f,              // TexCoord 1
+                               0.5f, -0.5f, 0.0f, 0.75f, // Position 2
+                               1.0f,  1.0f,              // TexCoord 2
+                               0.5f,  0.5f, 0.0f, 1.5f,  // Position 3
+                               1.0f,  0.0f               // TexCoord 3
+                            };
+      GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+      ESVertexLayout layout;
+
+      glGenBuffers ( 2, userData->vboIds );
+      glBindBuffer ( GL_ARRAY_BUFFER, userData->vboIds[0] );
+      glBufferData ( GL_ARRAY_BUFFER, sizeof ( vVertices ), vVertices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->vboIds[1] );
+      glBufferData ( GL_ELEMENT_ARRAY_BUFFER, sizeof ( indices ), indices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+      esInitVertexLayout ( &layout );
+      // Load the vertex position
+      esVertexLayoutAttrib ( &layout, 0, userData->vboIds[0], 4, GL_FLOAT,
+                             GL_FALSE, 6 * sizeof ( GLfloat ), 0 );
+      // Load the texture coordinate
+      esVertexLayoutAttrib ( &layout, 1, userData->vboIds[0], 2, GL_FLOAT,
+                             GL_FALSE, 6 * sizeof ( GLfloat ), 4 * sizeof ( GLfloat ) );
+      layout.indexBuffer = userData->vboIds[1];
+
+      userData->vaoCache = esCreateVertexArrayCache ();
+
+      if ( userData->vaoCache == NULL )
+      {
+         return FALSE;
+      }
+
+      userData->vao = esGetVertexArray ( userData->vaoCache, &layout );
+   }
 
    glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
    return TRUE;
@@ -290,16 +364,12 @@ int Init ( ESContext *esContext )
 void Draw ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
-   GLfloat vVertices[] = { -0.5f,  0.5f, 0.0f, 1.5f,  // Position 0
-                            0.0f,  0.0f,              // TexCoord 0 
-                           -0.5f, -0.5f, 0.0f, 0.75f, // Position 1
-                            0.0f,  1.0f,              // TexCoord 1
-                            0.5f, -0.5f, 0.0f, 0.75f, // Position 2
-                            1.0f,  1.0f,              // TexCoord 2
-                            0.5f,  0.5f, 0.0f, 1.5f,  // Position 3
-                            1.0f,  0.0f               // TexCoord 3
-                         };
-   GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+   GLuint    textureId = userData->checkerboards[userData->current].textureId;
+
+   // Drop levels of the checkerboard not drawn, and bring back those of
+   // the one drawn
+   esResidencyTouch ( userData->residency, textureId );
+   esUpdateResidency ( userData->residency );
 
    // Set the viewport
    glViewport ( 0, 0, esContext->width, esContext->height );
@@ -310,19 +380,12 @@ void Draw ( ESContext *esContext )
    // Use the program object
    glUseProgram ( userData->programObject );
 
-   // Load the vertex position
-   glVertexAttribPointer ( 0, 4, GL_FLOAT,
-                           GL_FALSE, 6 * sizeof ( GLfloat ), vVertices );
-   // Load the texture coordinate
-   glVertexAttribPointer ( 1, 2, GL_FLOAT,
-                           GL_FALSE, 6 * sizeof ( GLfloat ), &vVertices[4] );
-
-   glEnableVertexAttribArray ( 0 );
-   glEnableVertexAttribArray ( 1 );
+   // Bind the vertex and index buffers
+   glBindVertexArray ( userData->vao );
 
    // Bind the texture
    glActiveTexture ( GL_TEXTURE0 );
-   glBindTexture ( GL_TEXTURE_2D, userData->textureId );
+   glBindTexture ( GL_TEXTURE_2D, textureId );
 
    // Set the sampler texture unit to 0
    glUniform1i ( userData->samplerLoc, 0 );
@@ -330,12 +393,27 @@ void Draw ( ESContext *esContext )
    // Draw quad with nearest sampling
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
    glUniform1f ( userData->offsetLoc, -0.6f );
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
 
    // Draw quad with trilinear filtering
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
    glUniform1f ( userData->offsetLoc, 0.6f );
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
+
+   glBindVertexArray ( 0 );
+}
+
+///
+// Switch between the checkerboards
+//
+void Key ( ESContext *esContext, unsigned char key, int x, int y )
+{
+   UserData *userData = esContext->userData;
+
+   if ( key == 'c' || key == 'C' )
+   {
+      userData->current = 1 - userData->current;
+   }
 }
 
 ///
@@ -344,9 +422,25 @@ void Draw ( ESContext *esContext )
 void ShutDown ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
+   int       i;
+
+   // Delete texture objects
+   for ( i = 0; i < 2; i++ )
+   {
+      esResidencyRemoveTexture ( userData->residency, userData->checkerboards[i].textureId );
+      glDeleteTextures ( 1, &userData->checkerboards[i].textureId );
+
+      if ( userData->checkerboards[i].pixels != NULL )
+      {
+         esUnmapFile ( &userData->checkerboards[i].mapping );
+      }
+   }
+
+   esDeleteResidency ( userData->residency );
 
-   // Delete texture object
-   glDeleteTextures ( 1, &userData->textureId );
+   // Delete the vertex array and buffer objects
+   esDeleteVertexArrayCache ( userData->vaoCache );
+   glDeleteBuffers ( 2, userData->vboIds );
 
    // Delete program object
    glDeleteProgram ( userData->programObject );
@@ -365,6 +459,7 @@ int esMain ( ESContext *esContext )
    }
 
    esRegisterDrawFunc ( esContext, Draw );
+   esRegisterKeyFunc ( esContext, Key );
    esRegisterShutdownFunc ( esContext, ShutDown );
 
    return GL_TRUE;
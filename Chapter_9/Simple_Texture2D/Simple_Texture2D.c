@@ -68,17 +68,8 @@ GLuint CreateSimpleTexture2D( )
       255, 255,   0  // Yellow
    };
 
-   // Use tightly packed data
-   glPixelStorei ( GL_UNPACK_ALIGNMENT, 1 );
-
-   // Generate a texture object
-   glGenTextures ( 1, &textureId );
-
-   // Bind the texture object
-   glBindTexture ( GL_TEXTURE_2D, textureId );
-
-   // Load the texture
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels );
+   // Load the texture into immutable storage, left bound to GL_TEXTURE_2D
+   textureId = esCreateTexture2D ( pixels, 2, 2, 3, 1 );
 
    // Set the filtering mode
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
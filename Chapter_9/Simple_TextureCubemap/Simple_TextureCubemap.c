@@ -44,6 +44,9 @@ typedef struct
    // Sampler location
    GLint samplerLoc;
 
+   // Slices of the procedural sphere, 0 to read the attributes
+   GLint numSlicesLoc;
+
    // Texture handle
    GLuint textureId;
 
@@ -53,6 +56,9 @@ typedef struct
    GLfloat *normals;
    GLuint  *indices;
 
+   // Rebuild a UV sphere from gl_VertexID and gl_InstanceID instead of the arrays
+   int      procedural;
+
 } UserData;
 
 ///
@@ -78,35 +84,9 @@ GLuint CreateSimpleTextureCubemap( )
       255, 255, 255
    };
 
-   // Generate a texture object
-   glGenTextures ( 1, &textureId );
-
-   // Bind the texture object
-   glBindTexture ( GL_TEXTURE_CUBE_MAP, textureId );
-
-   // Load the cube face - Positive X
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_POSITIVE_X, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[0] );
-
-   // Load the cube face - Negative X
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_NEGATIVE_X, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[1] );
-
-   // Load the cube face - Positive Y
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_POSITIVE_Y, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[2] );
-
-   // Load the cube face - Negative Y
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[3] );
-
-   // Load the cube face - Positive Z
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_POSITIVE_Z, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[4] );
-
-   // Load the cube face - Negative Z
-   glTexImage2D ( GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, 0, GL_RGB, 1, 1, 0,
-                  GL_RGB, GL_UNSIGNED_BYTE, &cubePixels[5] );
+   // Load the faces, in the order Positive X, Negative X, Positive Y,
+   // Negative Y, Positive Z and Negative Z, into immutable storage
+   textureId = esCreateTextureCube ( cubePixels, 1, 3, 1 );
 
    // Set the filtering mode
    glTexParameteri ( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
@@ -124,15 +104,32 @@ int Init ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
    char vShaderStr[] =
-      "#version 300 es                            \n"
-      "layout(location = 0) in vec4 a_position;   \n"
-      "layout(location = 1) in vec3 a_normal;     \n"
-      "out vec3 v_normal;                         \n"
-      "void main()                                \n"
-      "{                                          \n"
-      "   gl_Position = a_position;               \n"
-      "   v_normal = a_normal;                    \n"
-      "}                                          \n";
+      "#version 300 es                                        \n"
+      "layout(location = 0) in vec4 a_position;               \n"
+      "layout(location = 1) in vec3 a_normal;                 \n"
+      "uniform int u_numSlices;                               \n"
+      "out vec3 v_normal;                                     \n"
+      "const float radius = 0.75;                             \n"
+      "const float pi = 3.14159265;                           \n"
+      "void main()                                            \n"
+      "{                                                      \n"
+      "   gl_Position = a_position;                           \n"
+      "   v_normal = a_normal;                                \n"
+      "                                                       \n"
+      "   // one triangle strip per band between parallels    \n"
+      "   if ( u_numSlices > 0 )                              \n"
+      "   {                                                   \n"
+      "      float theta = float( gl_InstanceID +             \n"
+      "                           ( gl_VertexID & 1 ) ) *     \n"
+      "                    2.0 * pi / float( u_numSlices );   \n"
+      "      float phi = float( gl_VertexID >> 1 ) *          \n"
+      "                  2.0 * pi / float( u_numSlices );     \n"
+      "      v_normal = vec3( sin( theta ) * sin( phi ),      \n"
+      "                       cos( theta ),                   \n"
+      "                       sin( theta ) * cos( phi ) );    \n"
+      "      gl_Position = vec4( radius * v_normal, 1.0 );    \n"
+      "   }                                                   \n"
+      "}                                                      \n";
 
    char fShaderStr[] =
       "#version 300 es                                     \n"
@@ -150,14 +147,16 @@ int Init ( ESContext *esContext )
 
    // Get the sampler locations
    userData->samplerLoc = glGetUniformLocation ( userData->programObject, "s_texture" );
+   userData->numSlicesLoc = glGetUniformLocation ( userData->programObject, "u_numSlices" );
 
    // Load the texture
    userData->textureId = CreateSimpleTextureCubemap ();
 
-   // Generate the vertex data
-   userData->numIndices = esGenSphere ( 20, 0.75f, &userData->vertices, &userData->normals,
-                                        NULL, &userData->indices );
-
+   // Generate the vertex data.  Two subdivisions give a smoother silhouette
+   // than a 20 slice UV sphere with 162 vertices instead of 231
+   userData->numIndices = esGenIcosphere ( 2, 0.75f, &userData->vertices, &userData->normals,
+                                           NULL, &userData->indices, NULL );
+   userData->procedural = GL_FALSE;
 
    glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
    return TRUE;
@@ -183,6 +182,23 @@ void Draw ( ESContext *esContext )
    // Use the program object
    glUseProgram ( userData->programObject );
 
+   // Bind the texture
+   glActiveTexture ( GL_TEXTURE0 );
+   glBindTexture ( GL_TEXTURE_CUBE_MAP, userData->textureId );
+
+   // Set the sampler texture unit to 0
+   glUniform1i ( userData->samplerLoc, 0 );
+
+   if ( userData->procedural )
+   {
+      // 20 slices and 10 bands, no vertex or index data
+      glDisableVertexAttribArray ( 0 );
+      glDisableVertexAttribArray ( 1 );
+      glUniform1i ( userData->numSlicesLoc, 20 );
+      glDrawArraysInstanced ( GL_TRIANGLE_STRIP, 0, 2 * ( 20 + 1 ), 20 / 2 );
+      return;
+   }
+
    // Load the vertex position
    glVertexAttribPointer ( 0, 3, GL_FLOAT,
                            GL_FALSE, 0, userData->vertices );
@@ -193,17 +209,24 @@ void Draw ( ESContext *esContext )
    glEnableVertexAttribArray ( 0 );
    glEnableVertexAttribArray ( 1 );
 
-   // Bind the texture
-   glActiveTexture ( GL_TEXTURE0 );
-   glBindTexture ( GL_TEXTURE_CUBE_MAP, userData->textureId );
-
-   // Set the sampler texture unit to 0
-   glUniform1i ( userData->samplerLoc, 0 );
-
+   glUniform1i ( userData->numSlicesLoc, 0 );
    glDrawElements ( GL_TRIANGLES, userData->numIndices,
                     GL_UNSIGNED_INT, userData->indices );
 }
 
+///
+// Switch between the icosphere arrays and the procedural sphere
+//
+void Key ( ESContext *esContext, unsigned char key, int x, int y )
+{
+   UserData *userData = esContext->userData;
+
+   if ( key == 'p' || key == 'P' )
+   {
+      userData->procedural = !userData->procedural;
+   }
+}
+
 ///
 // Cleanup
 //
@@ -235,6 +258,7 @@ int esMain ( ESContext *esContext )
 
    esRegisterDrawFunc ( esContext, Draw );
    esRegisterShutdownFunc ( esContext, ShutDown );
+   esRegisterKeyFunc ( esContext, Key );
 
    return GL_TRUE;
 }
@@ -35,6 +35,7 @@
 //    wrap modes available on 2D textures
 //
 #include <stdlib.h>
+#include <string.h>
 #include "esUtil.h"
 
 typedef struct
@@ -51,8 +52,29 @@ typedef struct
    // Texture handle
    GLuint textureId;
 
+   // Vertex and index buffer for the quad
+   GLuint vboIds[2];
+
+   // Vertex array object holding the quad's vertex state
+   ESVertexArrayCache *vaoCache;
+   GLuint vao;
+
 } UserData;
 
+// Version of the checkerboard generator, to increment whenever it
+// changes its output
+#define CHECKER_VERSION   1
+
+// Parameters of the checkerboard and version of its generator, which are
+// also its disk cache key
+typedef struct
+{
+   int version;
+   int width;
+   int height;
+   int checkSize;
+} CheckImageParams;
+
 ///
 //  Generate an RGB8 checkerboard image
 //
@@ -93,32 +115,48 @@ GLubyte *GenCheckImage ( int width, int height, int checkSize )
 }
 
 ///
-// Create a mipmapped 2D texture image
+// Generate the checkerboard for esCacheGenerate
+//
+GLboolean ESCALLBACK GenCachedCheckImage ( void *userData, void *data, size_t size )
+{
+   CheckImageParams *params = userData;
+   GLubyte *pixels = GenCheckImage ( params->width, params->height, params->checkSize );
+
+   if ( pixels == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   memcpy ( data, pixels, size );
+   free ( pixels );
+   return GL_TRUE;
+}
+
+///
+// Create a 2D texture image, from the disk cache after the first run
 //
-GLuint CreateTexture2D( )
+GLuint CreateTexture2D ( const char *cacheDir )
 {
    // Texture object handle
    GLuint textureId;
-   int    width = 256,
-          height = 256;
-   GLubyte *pixels;
+   CheckImageParams params = { CHECKER_VERSION, 256, 256, 64 };
+   int    width = params.width,
+          height = params.height;
+   const GLubyte *pixels;
+   ESFileMapping mapping;
 
-   pixels = GenCheckImage ( width, height, 64 );
+   pixels = esCacheGenerate ( cacheDir, "TextureWrap-checker", &params, sizeof ( params ), width * height * 3,
+                              GenCachedCheckImage, &params, &mapping );
 
    if ( pixels == NULL )
    {
       return 0;
    }
 
-   // Generate a texture object
-   glGenTextures ( 1, &textureId );
+   // Load mipmap level 0 into an immutable texture
+   textureId = esCreateTexture2D ( pixels, width, height, 3, 1 );
 
-   // Bind the texture object
-   glBindTexture ( GL_TEXTURE_2D, textureId );
-
-   // Load mipmap level 0
-   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGB, width, height,
-                  0, GL_RGB, GL_UNSIGNED_BYTE, pixels );
+   esUnmapFile ( &mapping );
 
    // Set the filtering mode
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
@@ -169,7 +207,48 @@ int Init ( ESContext *esContext )
    userData->offsetLoc = glGetUniformLocation ( userData->programObject, "u_offset" );
 
    // Load the texture
-   userData->textureId = CreateTexture2D ();
+   userData->textureId = CreateTexture2D ( esContext->cacheDir );
+
+   // Store the quad in buffer objects and capture its vertex state in a VAO
+   {
+      GLfloat vVertices[] = { -0.3f,  0.3f, 0.0f, 1.0f,  // Position 0
+                              -1.0f,  -1.0f,              // TexCoord 0
+                              -0.3f, -0.3f, 0.0f, 1.0f, // Position 1
+                              -1.0f,  2.0f,              // TexCoord 1
+                              0.3f, -0.3f, 0.0f, 1.0f, // Position 2
+                              2.0f,  2.0f,              // TexCoord 2
+                              0.3f,  0.3f, 0.0f, 1.0f,  // Position 3
+                              2.0f,  -1.0f               // TexCoord 3
+                            };
+      GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
+      ESVertexLayout layout;
+
+      glGenBuffers ( 2, userData->vboIds );
+      glBindBuffer ( GL_ARRAY_BUFFER, userData->vboIds[0] );
+      glBufferData ( GL_ARRAY_BUFFER, sizeof ( vVertices ), vVertices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, userData->vboIds[1] );
+      glBufferData ( GL_ELEMENT_ARRAY_BUFFER, sizeof ( indices ), indices, GL_STATIC_DRAW );
+      glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+      esInitVertexLayout ( &layout );
+      // Load the vertex position
+      esVertexLayoutAttrib ( &layout, 0, userData->vboIds[0], 4, GL_FLOAT,
+                             GL_FALSE, 6 * sizeof ( GLfloat ), 0 );
+      // Load the texture coordinate
+      esVertexLayoutAttrib ( &layout, 1, userData->vboIds[0], 2, GL_FLOAT,
+                             GL_FALSE, 6 * sizeof ( GLfloat ), 4 * sizeof ( GLfloat ) );
+      layout.indexBuffer = userData->vboIds[1];
+
+      userData->vaoCache = esCreateVertexArrayCache ();
+
+      if ( userData->vaoCache == NULL )
+      {
+         return FALSE;
+      }
+
+      userData->vao = esGetVertexArray ( userData->vaoCache, &layout );
+   }
 
    glClearColor ( 1.0f, 1.0f, 1.0f, 0.0f );
    return TRUE;
@@ -181,16 +260,6 @@ int Init ( ESContext *esContext )
 void Draw ( ESContext *esContext )
 {
    UserData *userData = esContext->userData;
-   GLfloat vVertices[] = { -0.3f,  0.3f, 0.0f, 1.0f,  // Position 0
-                           -1.0f,  -1.0f,              // TexCoord 0
-                           -0.3f, -0.3f, 0.0f, 1.0f, // Position 1
-                           -1.0f,  2.0f,              // TexCoord 1
-                           0.3f, -0.3f, 0.0f, 1.0f, // Position 2
-                           2.0f,  2.0f,              // TexCoord 2
-                           0.3f,  0.3f, 0.0f, 1.0f,  // Position 3
-                           2.0f,  -1.0f               // TexCoord 3
-                         };
-   GLushort indices[] = { 0, 1, 2, 0, 2, 3 };
 
    // Set the viewport
    glViewport ( 0, 0, esContext->width, esContext->height );
@@ -201,15 +270,8 @@ void Draw ( ESContext *esContext )
    // Use the program object
    glUseProgram ( userData->programObject );
 
-   // Load the vertex position
-   glVertexAttribPointer ( 0, 4, GL_FLOAT,
-                           GL_FALSE, 6 * sizeof ( GLfloat ), vVertices );
-   // Load the texture coordinate
-   glVertexAttribPointer ( 1, 2, GL_FLOAT,
-                           GL_FALSE, 6 * sizeof ( GLfloat ), &vVertices[4] );
-
-   glEnableVertexAttribArray ( 0 );
-   glEnableVertexAttribArray ( 1 );
+   // Bind the vertex and index buffers
+   glBindVertexArray ( userData->vao );
 
    // Bind the texture
    glActiveTexture ( GL_TEXTURE0 );
@@ -222,19 +284,21 @@ void Draw ( ESContext *esContext )
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
    glUniform1f ( userData->offsetLoc, -0.7f );
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
 
    // Draw quad with clamp to edge wrap mode
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
    glUniform1f ( userData->offsetLoc, 0.0f );
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
 
    // Draw quad with mirrored repeat
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_MIRRORED_REPEAT );
    glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_MIRRORED_REPEAT );
    glUniform1f ( userData->offsetLoc, 0.7f );
-   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, indices );
+   glDrawElements ( GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, ( const void * ) 0 );
+
+   glBindVertexArray ( 0 );
 }
 
 ///
@@ -247,6 +311,10 @@ void ShutDown ( ESContext *esContext )
    // Delete texture object
    glDeleteTextures ( 1, &userData->textureId );
 
+   // Delete the vertex array and buffer objects
+   esDeleteVertexArrayCache ( userData->vaoCache );
+   glDeleteBuffers ( 2, userData->vboIds );
+
    // Delete program object
    glDeleteProgram ( userData->programObject );
 }
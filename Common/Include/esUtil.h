@@ -95,6 +95,148 @@ typedef struct
    GLfloat   m[4][4];
 } ESMatrix;
 
+/// Maximum number of attributes in an ESVertexLayout
+#define ES_MAX_VERTEX_ATTRIBS   16
+
+typedef struct
+{
+   /// Buffer object the attribute is sourced from
+   GLuint     buffer;
+   GLint      size;
+   GLenum     type;
+   GLboolean  normalized;
+   /// Use glVertexAttribIPointer instead of glVertexAttribPointer
+   GLboolean  integer;
+   GLsizei    stride;
+   /// Byte offset of the first element in the buffer
+   GLuint     offset;
+   GLuint     divisor;
+} ESVertexAttrib;
+
+typedef struct
+{
+   /// Bit i is set when attribs[i] is enabled (i is the attribute location)
+   GLuint          enabledMask;
+   ESVertexAttrib  attribs[ES_MAX_VERTEX_ATTRIBS];
+   /// Element array buffer captured by the vertex array object
+   GLuint          indexBuffer;
+} ESVertexLayout;
+
+typedef struct ESVertexArrayCache ESVertexArrayCache;
+
+typedef struct
+{
+   /// Buffer objects holding the mesh
+   GLuint     vertexBuffer;
+   GLuint     indexBuffer;
+   /// Index of the mesh's first vertex in vertexBuffer (already added to its indices)
+   GLint      baseVertex;
+   /// Index of the mesh's first index in indexBuffer
+   GLuint     firstIndex;
+   GLsizei    numVertices;
+   GLsizei    numIndices;
+   /// Allocator bookkeeping
+   int        page;
+   int        vertexOrder;
+   int        indexOrder;
+} ESMeshHandle;
+
+typedef struct ESBufferArena ESBufferArena;
+
+typedef struct ESBvh ESBvh;
+
+typedef struct ESTextureStreamer ESTextureStreamer;
+
+typedef struct ESAtlas ESAtlas;
+
+typedef struct ESResidency ESResidency;
+
+typedef struct ESUploadScheduler ESUploadScheduler;
+
+typedef struct
+{
+   /// Array layer holding the image
+   int     layer;
+   /// Position and size of the image in texels, without its border
+   int     x;
+   int     y;
+   int     width;
+   int     height;
+   /// Maps the image's texture coordinates into the layer: uv * scale + offset
+   GLfloat scale[2];
+   GLfloat offset[2];
+} ESAtlasRegion;
+
+typedef struct
+{
+   /// Distance along the ray in units of the direction's length
+   GLfloat t;
+   /// Barycentric coordinates of the hit point, weights of the second and third vertex
+   GLfloat u;
+   GLfloat v;
+   /// Index of the triangle hit, -1 if none
+   int     triangle;
+} ESRayHit;
+
+typedef struct
+{
+   /// Contents of the file
+   const void *data;
+   /// Size of the file in bytes
+   int         size;
+
+   /// Platform mapping object, or the heap copy if the file could not be mapped
+   void       *platform;
+   void       *buffer;
+} ESFileMapping;
+
+/// Maximum number of disjoint ranges an ESDirtyRanges keeps before merging
+#define ES_MAX_DIRTY_RANGES   16
+
+/// esFlushDirtyRanges upload methods
+#define ES_FLUSH_BUFFER_SUB_DATA   0
+#define ES_FLUSH_MAP_EXPLICIT      1
+
+/// esCreateFilteredCubemap source layouts: a latitude-longitude image twice as wide as high, or six
+/// square faces +X, -X, +Y, -Y, +Z, -Z one below the other
+#define ES_CUBEMAP_EQUIRECT     0
+#define ES_CUBEMAP_FACES        1
+
+/// Initial value of an esHash64 hash
+#define ES_HASH_SEED            0xcbf29ce484222325ull
+
+/// esGenMipChain filters
+#define ES_MIP_FILTER_BOX       0
+#define ES_MIP_FILTER_KAISER    1
+#define ES_MIP_FILTER_LANCZOS   2
+
+typedef struct
+{
+   /// Size of one element in bytes
+   GLsizeiptr elementSize;
+   GLsizei    numRanges;
+   /// Sorted, non-adjacent [first, first + count) element ranges
+   GLint      first[ES_MAX_DIRTY_RANGES];
+   GLsizei    count[ES_MAX_DIRTY_RANGES];
+} ESDirtyRanges;
+
+/// Work function for esParallelFor, called with a [begin, end) subrange
+typedef void ( ESCALLBACK *ESParallelForFunc ) ( void *userData, int begin, int end );
+
+/// Uploads a level of a texture again for esUpdateResidency, all faces of a cube map.  The texture
+/// is bound to target; level counts from the full size image and textureLevel is the level of the
+/// texture to upload it to, lower when levels of an immutable texture have been dropped.  Returns
+/// GL_FALSE if the level could not be uploaded.
+typedef GLboolean ( ESCALLBACK *ESRestoreLevelFunc ) ( void *userData, GLuint texture, GLenum target, int level,
+                                                       int textureLevel );
+
+/// Fills size bytes at data for esCacheGenerate; returns GL_FALSE on failure
+typedef GLboolean ( ESCALLBACK *ESGenerateFunc ) ( void *userData, void *data, size_t size );
+
+/// Reports the end of an upload scheduled with esScheduleTextureUpload or esScheduleBufferUpload;
+/// uploaded is GL_FALSE if its object was deleted or the scheduler was deleted first
+typedef void ( ESCALLBACK *ESUploadDoneFunc ) ( void *userData, GLboolean uploaded );
+
 typedef struct ESContext ESContext;
 
 struct ESContext
@@ -111,6 +253,12 @@ struct ESContext
    /// Window height
    GLint       height;
 
+   /// Writable directory for the disk cache, NULL where there is none
+   const char *cacheDir;
+
+   /// Upload scheduler the main loop updates before drawing each frame, NULL if none
+   ESUploadScheduler *uploadScheduler;
+
 #ifndef __APPLE__
    /// Display handle
    EGLNativeDisplayType eglNativeDisplay;
@@ -249,7 +397,44 @@ int ESUTIL_API esGenCube ( float scale, GLfloat **vertices, GLfloat **normals,
 int ESUTIL_API esGenSquareGrid ( int size, GLfloat **vertices, GLuint **indices );
 
 //
-/// \brief Loads a 8-bit, 24-bit or 32-bit TGA image from a file
+/// \brief Generates geometry for a geodesic sphere by subdividing an icosahedron.  Vertices are spread
+///        evenly over the surface, so it needs far fewer vertices than esGenSphere for the same
+///        silhouette error.  Allocates memory for the vertex data and stores the results in the arrays.
+///        Generate index list for TRIANGLES
+/// \param subdivisions Number of times each triangle is split into four, 0 to 10
+/// \param radius Radius of the sphere
+/// \param vertices If not NULL, will contain array of float3 positions
+/// \param normals If not NULL, will contain array of float3 normals
+/// \param texCoords If not NULL, will contain array of float2 texCoords.  Vertices on the u seam and
+///        at the poles are duplicated so every triangle gets continuous coordinates
+/// \param indices If not NULL, will contain the array of indices for the triangles
+/// \param numVertices If not NULL, returns the number of vertices in the arrays, 10 * 4^subdivisions + 2
+///        without texCoords
+/// \return The number of indices required for rendering the buffers (the number of indices stored in the indices array
+///         if it is not NULL ) as GL_TRIANGLES
+//
+int ESUTIL_API esGenIcosphere ( int subdivisions, float radius, GLfloat **vertices, GLfloat **normals,
+                                GLfloat **texCoords, GLuint **indices, int *numVertices );
+
+//
+/// \brief Map a file into memory.  Falls back to reading the file when it cannot be mapped.
+/// \param ioContext Context related to IO facility on the platform.  On Android, NULL maps a file
+///        of the file system instead of an asset.
+/// \param fileName Name of the file on disk
+/// \param mapping Returns the contents of the file
+/// \return GL_TRUE on success, GL_FALSE if the file could not be opened
+//
+GLboolean ESUTIL_API esMapFile ( void *ioContext, const char *fileName, ESFileMapping *mapping );
+
+//
+/// \brief Release a file mapped by esMapFile
+/// \param mapping Mapping returned by esMapFile
+//
+void ESUTIL_API esUnmapFile ( ESFileMapping *mapping );
+
+//
+/// \brief Loads a TGA image from a file.  See esDecodeTGA for the supported files and the layout
+///        of the returned pixels.
 /// \param ioContext Context related to IO facility on the platform
 /// \param fileName Name of the file on disk
 /// \param width Width of loaded image in pixels
@@ -258,6 +443,825 @@ int ESUTIL_API esGenSquareGrid ( int size, GLfloat **vertices, GLuint **indices
 //
 char *ESUTIL_API esLoadTGA ( void *ioContext, const char *fileName, int *width, int *height );
 
+//
+/// \brief Decode a TGA image held in memory.  Uncompressed and run-length encoded true-color,
+///        grayscale and color-mapped images are supported.  Pixels are returned tightly packed as
+///        luminance (8-bit images), RGB (15, 16 and 24-bit) or RGBA (32-bit), rows from bottom to top
+///        as glTexImage2D expects, whatever the orientation stored in the file.
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \param width Returns the width of the image in pixels
+/// \param height Returns the height of the image in pixels
+/// \param components If not NULL, returns the number of bytes per decoded pixel: 1, 3 or 4
+/// \param pixels Receives width * height * components bytes.  If NULL, only the header is read.
+/// \return GL_TRUE on success, GL_FALSE if the file is malformed or not supported
+//
+GLboolean ESUTIL_API esDecodeTGA ( const void *data, int size, int *width, int *height, int *components, void *pixels );
+
+//
+/// \brief Return the pixels of a TGA image held in memory if they are already laid out as esDecodeTGA
+///        returns them, which is the case for uncompressed 8-bit grayscale images stored bottom to top
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \return Pointer into data, NULL if the image must be decoded
+//
+const void *ESUTIL_API esGetTGAPixelData ( const void *data, int size );
+
+//
+/// \brief Loads a TGA image from a file into level 0 of the texture bound to target, as GL_R8, GL_RGB8
+///        or GL_RGBA8.  The file is mapped rather than read, and the pixels are uploaded straight from
+///        the mapping when no decoding is needed, otherwise decoded into a mapped pixel unpack buffer,
+///        so the image is never copied on the heap.
+/// \param ioContext Context related to IO facility on the platform
+/// \param fileName Name of the file on disk
+/// \param target Texture target, GL_TEXTURE_2D or a cube map face
+/// \param width Width of loaded image in pixels
+/// \param height Height of loaded image in pixels
+/// \return GL_TRUE on success
+//
+GLboolean ESUTIL_API esLoadTGATexture ( void *ioContext, const char *fileName, GLenum target, int *width, int *height );
+
+//
+/// \brief Create an immutable 2D texture from an 8-bit image and its mip levels.  Storage is allocated
+///        with glTexStorage2D as GL_R8, GL_RG8 or GL_RGBA8, three component images being expanded
+///        to RGBA8 on the CPU rather than converted by the driver.  Rows are tightly packed.
+/// \param pixels Base level followed by the smaller levels, as esGenMipChain stores them.  If NULL,
+///        storage is only allocated.
+/// \param width Width of the base level in pixels
+/// \param height Height of the base level in pixels
+/// \param components Bytes per pixel: 1 (R8), 2 (RG8), 3 (RGB8) or 4 (RGBA8)
+/// \param numLevels Number of levels stored in pixels and allocated.  If 0, only the base level
+///        is stored, and the full mip chain is allocated and generated with glGenerateMipmap.
+/// \return The new texture, left bound to GL_TEXTURE_2D, 0 on failure
+//
+GLuint ESUTIL_API esCreateTexture2D ( const void *pixels, int width, int height, int components, int numLevels );
+
+//
+/// \brief Create an immutable 3D texture from an 8-bit volume and its mip levels, see esCreateTexture2D.
+///        The depth of the levels halves along with their width and height.
+/// \param pixels Base level followed by the smaller levels, slices tightly packed, or NULL
+/// \param width, height, depth Size of the base level in texels
+/// \param components Bytes per texel, 1 to 4
+/// \param numLevels Number of levels stored in pixels and allocated, 0 to generate the mip chain
+/// \return The new texture, left bound to GL_TEXTURE_3D, 0 on failure
+//
+GLuint ESUTIL_API esCreateTexture3D ( const void *pixels, int width, int height, int depth, int components,
+                                      int numLevels );
+
+//
+/// \brief Create an immutable cube map from six 8-bit faces and their mip levels, see esCreateTexture2D
+/// \param pixels Faces +X, -X, +Y, -Y, +Z and -Z one after the other, each one's base level followed by
+///        its smaller levels, or NULL
+/// \param size Width and height of the base level of the faces in pixels
+/// \param components Bytes per pixel, 1 to 4
+/// \param numLevels Number of levels stored for each face and allocated, 0 to generate the mip chain
+/// \return The new texture, left bound to GL_TEXTURE_CUBE_MAP, 0 on failure
+//
+GLuint ESUTIL_API esCreateTextureCube ( const void *pixels, int size, int components, int numLevels );
+
+//
+/// \brief Create a texture from a KTX or KTX2 file held in memory.  Every stored mip level, array
+///        layer and cube face is uploaded into immutable storage; compressed formats such as ETC2 and
+///        EAC are uploaded as they are.  The mip chain is generated only if the file stores none and
+///        is not compressed; compressed files without mip levels get the base level only.
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \param target If not NULL, returns the target the texture is bound to: GL_TEXTURE_2D,
+///        GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D or GL_TEXTURE_CUBE_MAP
+/// \return The new texture, left bound to its target, 0 on failure
+//
+GLuint ESUTIL_API esCreateTextureKTX ( const void *data, int size, GLenum *target );
+
+//
+/// \brief Upload a KTX or KTX2 file held in memory into the texture bound to target, as
+///        esCreateTextureKTX does.  The texture must not have immutable storage yet.
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \param target Target the texture is bound to, which must be the one the file is for
+/// \return GL_TRUE on success
+//
+GLboolean ESUTIL_API esUploadTextureKTX ( const void *data, int size, GLenum target );
+
+//
+/// \brief Create a texture from a KTX or KTX2 file held in memory, as esCreateTextureKTX does, but
+///        send its images through an upload scheduler over the next frames.  Files whose rows are
+///        padded, or without stored mip levels and not compressed, must be uploaded at once instead.
+/// \param scheduler Scheduler to send the images with
+/// \param data Contents of the file.  It is read until every upload is done.
+/// \param size Size of the file in bytes
+/// \param target If not NULL, returns the target the texture is bound to
+/// \param done If not NULL, called once per image as for esScheduleTextureUpload
+/// \param userData Passed to done
+/// \param numUploads If not NULL, returns the number of images scheduled, which is the number of
+///        calls to done to wait for.  It is set on failure too.
+/// \return The new texture, left bound to its target, 0 on failure
+//
+GLuint ESUTIL_API esScheduleTextureKTX ( ESUploadScheduler *scheduler, const void *data, int size, GLenum *target,
+                                         ESUploadDoneFunc done, void *userData, int *numUploads );
+
+//
+/// \brief Loads a KTX or KTX2 texture from a file, see esCreateTextureKTX
+/// \param ioContext Context related to IO facility on the platform
+/// \param fileName Name of the file on disk
+/// \param target If not NULL, returns the target the texture is bound to
+/// \return The new texture, 0 on failure
+//
+GLuint ESUTIL_API esLoadKTX ( void *ioContext, const char *fileName, GLenum *target );
+
+//
+/// \brief Create a texture from a PVR file, version 2 or 3, held in memory.  Every stored mip
+///        level, array layer and cube face is uploaded.  PVRTC is uploaded compressed when
+///        GL_IMG_texture_compression_pvrtc is supported and transcoded to RGBA8 otherwise.
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \param target If not NULL, returns the target the texture is bound to: GL_TEXTURE_2D,
+///        GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D or GL_TEXTURE_CUBE_MAP
+/// \return The new texture, left bound to its target, 0 on failure
+//
+GLuint ESUTIL_API esCreateTexturePVR ( const void *data, int size, GLenum *target );
+
+//
+/// \brief Decode the base level of a PVR file held in memory to RGBA8 on the CPU, as it would be
+///        sampled.  The faces of a cube map, +X, -X, +Y, -Y, +Z, -Z, or the layers of an array are
+///        stored one below the other, the layout of ES_CUBEMAP_FACES for esCreateFilteredCubemap.
+///        Formats of 8-bit channels and PVRTC are supported.
+/// \param data Contents of the file
+/// \param size Size of the file in bytes
+/// \param width, height Return the size of one image
+/// \param numImages Returns the number of images: 6 for a cube map
+/// \param srgb If not NULL, returns GL_TRUE if the pixels are sRGB encoded
+/// \return The pixels, to release with free, NULL on failure
+//
+GLubyte *ESUTIL_API esDecodePVR ( const void *data, int size, int *width, int *height, int *numImages,
+                                  GLboolean *srgb );
+
+//
+/// \brief Loads a PVR texture from a file, see esCreateTexturePVR
+/// \param ioContext Context related to IO facility on the platform
+/// \param fileName Name of the file on disk
+/// \param target If not NULL, returns the target the texture is bound to
+/// \return The new texture, 0 on failure
+//
+GLuint ESUTIL_API esLoadPVR ( void *ioContext, const char *fileName, GLenum *target );
+
+//
+/// \brief Create a texture streamer, which loads 2D textures on worker threads
+/// \param ioContext Context related to IO facility on the platform
+/// \param budget Bytes uploaded per call to esUpdateTextureStreamer
+/// \return The new streamer, NULL on failure
+//
+ESTextureStreamer *ESUTIL_API esCreateTextureStreamer ( void *ioContext, GLsizeiptr budget );
+
+//
+/// \brief Start loading a 2D texture from a KTX, KTX2 or TGA file.  The texture is returned at once
+///        with a 1x1 placeholder image; the file's contents replace it in a later call to
+///        esUpdateTextureStreamer.  The texture name never changes, and parameters set on it are kept.
+///        A KTX file is uploaded into a new texture object under the same name, which unbinds it from
+///        other texture units; if that upload fails the placeholder stays and fallbackFileName is loaded.
+/// \param streamer Streamer to load the texture with
+/// \param fileName Name of the file on disk
+/// \param fallbackFileName If not NULL, file loaded instead when fileName cannot be read
+/// \param mipmaps If GL_TRUE, generate the mip chain of a TGA image once it is uploaded
+/// \param placeholder RGBA color of the placeholder, mid gray if NULL
+/// \return The new texture, left bound to GL_TEXTURE_2D, 0 on failure
+//
+GLuint ESUTIL_API esStreamTexture ( ESTextureStreamer *streamer, const char *fileName, const char *fallbackFileName,
+                                    GLboolean mipmaps, const GLubyte placeholder[4] );
+
+//
+/// \brief Upload the textures loaded so far, up to the streamer's byte budget.  Call once per frame.
+/// \param streamer Streamer to update
+/// \return Number of textures still loading
+//
+int ESUTIL_API esUpdateTextureStreamer ( ESTextureStreamer *streamer );
+
+//
+/// \brief Stop the worker threads and delete the streamer.  Textures it created are not deleted;
+///        those still loading keep their placeholder.
+/// \param streamer Streamer to delete
+//
+void ESUTIL_API esDeleteTextureStreamer ( ESTextureStreamer *streamer );
+
+//
+/// \brief Create an upload scheduler, which spreads texture and buffer uploads over several frames.
+///        Set it as the uploadScheduler of the ESContext for the main loop to update it.
+/// \param byteBudget Bytes sent per call to esUpdateUploadScheduler
+/// \param timeBudget Seconds spent per call to esUpdateUploadScheduler, 0 for no limit.  Tiles are
+///        not started if they are predicted to overrun it; at least one tile is sent per call.
+/// \return The new scheduler, NULL on failure
+//
+ESUploadScheduler *ESUTIL_API esCreateUploadScheduler ( GLsizeiptr byteBudget, double timeBudget );
+
+//
+/// \brief Schedule an upload to a region of a level of a texture with allocated storage.  It is sent in
+///        bands of rows, or of slices, with glTexSubImage2D or glTexSubImage3D.
+/// \param scheduler Scheduler to send the upload with
+/// \param texture Texture to upload to
+/// \param target GL_TEXTURE_2D, a cube map face, GL_TEXTURE_3D or GL_TEXTURE_2D_ARRAY
+/// \param level Mip level to upload to
+/// \param xoffset, yoffset, zoffset Corner of the region in texels; zoffset is 0 for 2D targets
+/// \param width, height, depth Size of the region in texels; depth is 1 for 2D targets
+/// \param format, type Format and type of the pixels, as for glTexSubImage3D
+/// \param pixels Pixels of the region, rows tightly packed.  They are read until done is called.
+/// \param done If not NULL, called once the last tile is sent
+/// \param userData Passed to done
+/// \return GL_TRUE if the upload was scheduled
+//
+GLboolean ESUTIL_API esScheduleTextureUpload ( ESUploadScheduler *scheduler, GLuint texture, GLenum target, GLint level,
+                                               GLint xoffset, GLint yoffset, GLint zoffset,
+                                               GLsizei width, GLsizei height, GLsizei depth,
+                                               GLenum format, GLenum type, const void *pixels,
+                                               ESUploadDoneFunc done, void *userData );
+
+//
+/// \brief Schedule an upload to a region of a level of a texture with compressed storage, such as ETC2
+///        or EAC.  It is sent in bands of rows of 4x4 blocks, or of slices, with glCompressedTexSubImage2D
+///        or glCompressedTexSubImage3D.
+/// \param scheduler Scheduler to send the upload with
+/// \param texture Texture to upload to
+/// \param target GL_TEXTURE_2D, a cube map face, GL_TEXTURE_3D or GL_TEXTURE_2D_ARRAY
+/// \param level Mip level to upload to
+/// \param xoffset, yoffset, zoffset Corner of the region in texels, multiples of 4 in x and y
+/// \param width, height, depth Size of the region in texels
+/// \param internalFormat Compressed format of the texture
+/// \param imageSize Bytes of compressed data for the region
+/// \param data Compressed data of the region.  It is read until done is called.
+/// \param done If not NULL, called once the last tile is sent
+/// \param userData Passed to done
+/// \return GL_TRUE if the upload was scheduled
+//
+GLboolean ESUTIL_API esScheduleCompressedTextureUpload ( ESUploadScheduler *scheduler, GLuint texture, GLenum target,
+                                                         GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                                         GLsizei width, GLsizei height, GLsizei depth,
+                                                         GLenum internalFormat, GLsizei imageSize, const void *data,
+                                                         ESUploadDoneFunc done, void *userData );
+
+//
+/// \brief Schedule an upload to a range of a buffer with allocated storage, sent in pieces with
+///        glBufferSubData
+/// \param scheduler Scheduler to send the upload with
+/// \param buffer Buffer to upload to
+/// \param offset Start of the range in bytes
+/// \param size Size of the range in bytes
+/// \param data Contents of the range.  They are read until done is called.
+/// \param done If not NULL, called once the last piece is sent
+/// \param userData Passed to done
+/// \return GL_TRUE if the upload was scheduled
+//
+GLboolean ESUTIL_API esScheduleBufferUpload ( ESUploadScheduler *scheduler, GLuint buffer, GLintptr offset,
+                                              GLsizeiptr size, const void *data,
+                                              ESUploadDoneFunc done, void *userData );
+
+//
+/// \brief Send uploads in request order within the scheduler's budgets, then call the done callbacks of
+///        the uploads completed.  The application's texture and buffer bindings and unpack state are
+///        kept.  Called once per frame by the main loop.
+/// \param scheduler Scheduler to update, may be NULL
+/// \return Number of uploads still pending
+//
+int ESUTIL_API esUpdateUploadScheduler ( ESUploadScheduler *scheduler );
+
+//
+/// \brief Delete an upload scheduler.  Uploads still pending are dropped, and their done callbacks
+///        are called with uploaded set to GL_FALSE.
+/// \param scheduler Scheduler to delete
+//
+void ESUTIL_API esDeleteUploadScheduler ( ESUploadScheduler *scheduler );
+
+//
+/// \brief Size of the mip levels below the base level of an image, as esGenMipChain stores them
+/// \param width Width of the base level in pixels
+/// \param height Height of the base level in pixels
+/// \param components Bytes per pixel, 1 to 4
+/// \param numLevels If not NULL, returns the number of levels including the base level
+/// \return Size in bytes
+//
+GLsizeiptr ESUTIL_API esMipChainSize ( int width, int height, int components, int *numLevels );
+
+//
+/// \brief Generate the mip levels below the base level of an 8-bit image, down to 1x1.  Each level
+///        is half the size of the previous one, rounded down, and is filtered from it without
+///        dropping the last row or column of odd sizes.
+/// \param pixels Base level, tightly packed
+/// \param width Width of the base level in pixels
+/// \param height Height of the base level in pixels
+/// \param components Bytes per pixel: 1 (R8), 2 (RG8), 3 (RGB8) or 4 (RGBA8)
+/// \param filter ES_MIP_FILTER_BOX, or ES_MIP_FILTER_KAISER or ES_MIP_FILTER_LANCZOS for sharper levels
+/// \param srgb If GL_TRUE, the color channels are sRGB encoded and filtered in linear space; the
+///        fourth channel is alpha and is always linear
+/// \param chain Receives esMipChainSize bytes: level 1, then level 2 and so on, tightly packed
+/// \return GL_TRUE on success
+//
+GLboolean ESUTIL_API esGenMipChain ( const GLubyte *pixels, int width, int height, int components, int filter,
+                                     GLboolean srgb, GLubyte *chain );
+
+//
+/// \brief Create an atlas, which packs images into the layers of a 2D array texture.  Images get a
+///        border of repeated edge texels and are aligned so that the first 4 levels never mix two
+///        images, at a cost of at most 8 texels of border.  Smaller levels may blend neighbouring
+///        images at their edges.
+/// \param width Width of a layer in texels, a multiple of 2^(numLevels-1)
+/// \param height Height of a layer in texels, a multiple of 2^(numLevels-1)
+/// \param components Bytes per texel of the images: 1 (R8), 2 (RG8), 3 (RGB8) or 4 (RGBA8)
+/// \param numLevels Number of mip levels of the texture
+/// \return The new atlas, NULL on failure
+//
+ESAtlas *ESUTIL_API esCreateAtlas ( int width, int height, int components, int numLevels );
+
+//
+/// \brief Add an image to an atlas, in a new layer if it fits in none of the existing ones
+/// \param atlas Atlas to add the image to
+/// \param pixels Image, tightly packed with the atlas's number of components
+/// \param width Width of the image in texels
+/// \param height Height of the image in texels
+/// \param region Returns where the image was placed
+/// \return GL_TRUE on success, GL_FALSE if the image is larger than a layer
+//
+GLboolean ESUTIL_API esAtlasAdd ( ESAtlas *atlas, const GLubyte *pixels, int width, int height, ESAtlasRegion *region );
+
+//
+/// \brief Map texture coordinates in [0, 1] of an image to its region of the atlas
+/// \param region Region returned by esAtlasAdd
+/// \param texCoords First coordinate pair, modified in place
+/// \param count Number of coordinate pairs
+/// \param stride Number of floats from one pair to the next, 0 if they are tightly packed
+//
+void ESUTIL_API esAtlasRemapTexCoords ( const ESAtlasRegion *region, GLfloat *texCoords, int count, int stride );
+
+//
+/// \brief Create a GL_TEXTURE_2D_ARRAY texture holding every layer of an atlas and its mip levels.
+///        Filtering is trilinear, or bilinear with a single level, and coordinates are clamped to
+///        the edges.
+/// \param atlas Atlas holding the images
+/// \param numLayers If not NULL, returns the number of layers of the texture
+/// \return The new texture, left bound to GL_TEXTURE_2D_ARRAY, 0 on failure
+//
+GLuint ESUTIL_API esCreateAtlasTexture ( ESAtlas *atlas, int *numLayers );
+
+//
+/// \brief Delete an atlas.  Textures created from it are not deleted.
+/// \param atlas Atlas to delete
+//
+void ESUTIL_API esDeleteAtlas ( ESAtlas *atlas );
+
+//
+/// \brief Create a residency manager, which keeps the memory used by textures under a budget by
+///        dropping the largest levels of the least recently used ones
+/// \param budget Bytes of texture memory the tracked textures may use
+/// \return The new manager, NULL on failure
+//
+ESResidency *ESUTIL_API esCreateResidency ( GLsizeiptr budget );
+
+//
+/// \brief Track the memory of a texture.  Only textures given a restore function can have levels
+///        dropped; the others count against the budget but always stay resident.  Immutable
+///        textures are created again under the same name with fewer levels, which unbinds them
+///        from every texture unit and framebuffer; their sampling parameters are kept.
+/// \param residency Residency manager
+/// \param texture Texture to track
+/// \param target GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY or GL_TEXTURE_CUBE_MAP
+/// \param internalFormat Internal format of the texture's levels
+/// \param width, height Size of level 0
+/// \param depth Depth of level 0 or number of layers, ignored for 2D and cube map textures
+/// \param numLevels Number of levels of the texture
+/// \param restore Function uploading a dropped level again, or NULL
+/// \param userData Passed to restore
+/// \return GL_TRUE on success, GL_FALSE if the texture is already tracked or its format unknown
+//
+GLboolean ESUTIL_API esResidencyAddTexture ( ESResidency *residency, GLuint texture, GLenum target,
+                                             GLenum internalFormat, int width, int height, int depth,
+                                             int numLevels, ESRestoreLevelFunc restore, void *userData );
+
+//
+/// \brief Stop tracking a texture, before it is deleted.  The texture keeps its dropped levels.
+/// \param residency Residency manager
+/// \param texture Texture to forget
+//
+void ESUTIL_API esResidencyRemoveTexture ( ESResidency *residency, GLuint texture );
+
+//
+/// \brief Mark a texture as used in the current frame: it is not dropped from, and its dropped
+///        levels come back one per esUpdateResidency
+/// \param residency Residency manager
+/// \param texture Texture drawn with
+//
+void ESUTIL_API esResidencyTouch ( ESResidency *residency, GLuint texture );
+
+//
+/// \brief Drop levels of unused textures until the budget is met, restore levels of used ones, and
+///        start a new frame.  Call once per frame, after the textures drawn with were touched.
+///        The texture bindings of the active unit are kept.
+/// \param residency Residency manager
+/// \return Bytes used by the tracked textures
+//
+GLsizeiptr ESUTIL_API esUpdateResidency ( ESResidency *residency );
+
+//
+/// \brief Memory used by a tracked texture
+/// \param residency Residency manager
+/// \param texture Tracked texture, or 0 for the total of all of them
+/// \param baseLevel If not NULL and texture is tracked, returns its largest resident level
+/// \return Bytes of the texture's resident levels
+//
+GLsizeiptr ESUTIL_API esResidencyBytes ( ESResidency *residency, GLuint texture, int *baseLevel );
+
+//
+/// \brief Delete a residency manager.  Tracked textures are not deleted.
+/// \param residency Residency manager to delete
+//
+void ESUTIL_API esDeleteResidency ( ESResidency *residency );
+
+//
+/// \brief Hash data for esCacheLoad and esCacheStore keys
+/// \param hash ES_HASH_SEED, or the hash of the data before this block
+/// \param data Data to hash
+/// \param size Size of the data in bytes
+/// \return Hash of everything hashed so far
+//
+GLuint64 ESUTIL_API esHash64 ( GLuint64 hash, const void *data, size_t size );
+
+//
+/// \brief Map a file of the disk cache
+/// \param cacheDir Directory of the cache, NULL to always miss
+/// \param name Name of what produced the data
+/// \param key Hash of everything the data depends on
+/// \param mapping Returns the mapped file, to release with esUnmapFile
+/// \param size Returns the size of the data in bytes
+/// \return The data, aligned to 16 bytes within the file, or NULL if not cached
+//
+const void *ESUTIL_API esCacheLoad ( const char *cacheDir, const char *name, GLuint64 key,
+                                     ESFileMapping *mapping, size_t *size );
+
+//
+/// \brief Store data in the disk cache.  The file is written under a temporary name first, so
+///        readers never see it incomplete.
+/// \param cacheDir Directory of the cache, created if missing, NULL to store nothing
+/// \param name Name of what produced the data
+/// \param key Hash of everything the data depends on
+/// \param data Data to store
+/// \param size Size of the data in bytes
+/// \return GL_TRUE if the data was stored
+//
+GLboolean ESUTIL_API esCacheStore ( const char *cacheDir, const char *name, GLuint64 key,
+                                    const void *data, size_t size );
+
+//
+/// \brief Return the output of a deterministic generator from the disk cache, or run the generator
+///        and store its output.  The key is a hash of the parameters and the size.
+/// \param cacheDir Directory of the cache, NULL to always generate
+/// \param name Name of the generator
+/// \param params Every parameter the output depends on, with no uninitialized padding, and a version
+///        of the generator to increment whenever its output changes
+/// \param paramsSize Size of the parameters in bytes
+/// \param size Size of the output in bytes
+/// \param generate Generator, called on a miss
+/// \param userData Passed to generate
+/// \param mapping Returns the mapped file or the generated buffer, to release with esUnmapFile
+/// \return The output, or NULL if generate failed or memory is short
+//
+const void *ESUTIL_API esCacheGenerate ( const char *cacheDir, const char *name, const void *params, size_t paramsSize,
+                                         size_t size, ESGenerateFunc generate, void *userData,
+                                         ESFileMapping *mapping );
+
+//
+/// \brief Build image based lighting cubemaps from an environment image: a specular cubemap with
+///        up to 6 levels prefiltered with GGX for roughness level / (numLevels - 1), level 0 being
+///        a mirror, and a 32x32 irradiance cubemap holding irradiance over pi, so that diffuse
+///        lighting is albedo times its texel.  Both are RGB16F, linear, and filtered on the CPU
+///        with all cores.  The result is cached by a hash of the source and the parameters.
+/// \param pixels Source image, 8 bits per channel, such as the faces of a PVR cube map decoded by
+///        esDecodePVR
+/// \param width, height Size of the source image
+/// \param components Channels per pixel; 1 and 2 are gray, alpha is ignored
+/// \param layout ES_CUBEMAP_EQUIRECT or ES_CUBEMAP_FACES
+/// \param srgb If GL_TRUE, the source is sRGB encoded
+/// \param faceSize Face size of the specular cubemap, rounded up to a power of two, 0 for the
+///        source's
+/// \param cacheDir Directory of the disk cache, NULL to filter on every call
+/// \param irradiance Returns the irradiance cubemap
+/// \param numLevels Returns the number of levels of the specular cubemap
+/// \return The specular cubemap, left bound to GL_TEXTURE_CUBE_MAP, 0 on failure
+//
+GLuint ESUTIL_API esCreateFilteredCubemap ( const GLubyte *pixels, int width, int height, int components, int layout,
+                                            GLboolean srgb, int faceSize, const char *cacheDir,
+                                            GLuint *irradiance, int *numLevels );
+
+//
+/// \brief Generate a volume of gradient noise, normalized to [0, 255].  Octaves after the first
+///        double the frequency and halve the amplitude.  Slices are computed on all cores.
+/// \param size Width, height and depth of the volume
+/// \param frequency Lattice cells across the volume in the first octave
+/// \param octaves Number of octaves summed, 1 to 16
+/// \param tileable If GL_TRUE, the frequency is rounded to a whole number and the volume repeats
+/// \param volume Receives size * size * size bytes
+/// \return GL_FALSE if a parameter is invalid or memory is short
+//
+GLboolean ESUTIL_API esGenNoise3D ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLubyte *volume );
+
+//
+/// \brief Create a GL_R8 3D texture of gradient noise with esGenNoise3D, with linear filtering
+///        and mirrored repeat wrapping, or repeat wrapping if tileable
+/// \param cacheDir Directory of the disk cache, NULL to generate the noise on every call
+/// \return The texture, left bound to GL_TEXTURE_3D, 0 on failure
+//
+GLuint ESUTIL_API esCreateNoiseTexture3D ( int size, GLfloat frequency, int octaves, GLboolean tileable,
+                                           const char *cacheDir );
+
+//
+/// \brief Create the texture of esCreateNoiseTexture3D by rendering the noise on the GPU, one slice per
+///        draw into the layers of the texture.  The volume is rendered twice: once to read back its
+///        range, then stretched over it, so it matches the CPU volume to a few steps.  If the
+///        shader or the framebuffer is not supported, the same noise is generated on the CPU.
+/// \param cacheDir Directory of the disk cache, NULL to render the noise on every call.  On a miss
+///        the stretched texture is read back once more to be stored.
+/// \return The texture, left bound to GL_TEXTURE_3D, 0 on failure
+//
+GLuint ESUTIL_API esRenderNoiseTexture3D ( int size, GLfloat frequency, int octaves, GLboolean tileable,
+                                           const char *cacheDir );
+
+//
+/// \brief Reset a vertex layout to no enabled attributes and no index buffer
+/// \param layout Layout to initialize
+//
+void ESUTIL_API esInitVertexLayout ( ESVertexLayout *layout );
+
+//
+/// \brief Enable an attribute in a vertex layout.  Parameters match glVertexAttribPointer,
+///        except that the data is always sourced from a buffer object at a byte offset.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param buffer Buffer object the attribute is read from
+/// \param size, type, normalized, stride As for glVertexAttribPointer
+/// \param offset Byte offset of the first element in the buffer
+//
+void ESUTIL_API esVertexLayoutAttrib ( ESVertexLayout *layout, GLuint index, GLuint buffer,
+                                       GLint size, GLenum type, GLboolean normalized,
+                                       GLsizei stride, GLuint offset );
+
+//
+/// \brief Enable an integer attribute in a vertex layout.  Parameters match glVertexAttribIPointer,
+///        except that the data is always sourced from a buffer object at a byte offset.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param buffer Buffer object the attribute is read from
+/// \param size, type, stride As for glVertexAttribIPointer
+/// \param offset Byte offset of the first element in the buffer
+//
+void ESUTIL_API esVertexLayoutAttribI ( ESVertexLayout *layout, GLuint index, GLuint buffer,
+                                        GLint size, GLenum type, GLsizei stride, GLuint offset );
+
+//
+/// \brief Set the instance divisor of an attribute, as for glVertexAttribDivisor.  Call after
+///        the attribute has been enabled with esVertexLayoutAttrib or esVertexLayoutAttribI.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param divisor Number of instances drawn per element of the attribute, 0 to advance per vertex
+//
+void ESUTIL_API esVertexLayoutDivisor ( ESVertexLayout *layout, GLuint index, GLuint divisor );
+
+//
+/// \brief Create an empty vertex array cache.  Vertex array objects do not depend on the
+///        program, so one cache can serve every program that uses the same attribute locations.
+/// \return The new cache, NULL on failure
+//
+ESVertexArrayCache *ESUTIL_API esCreateVertexArrayCache ( void );
+
+//
+/// \brief Return a vertex array object matching the layout, creating it on first use
+/// \param cache Vertex array cache
+/// \param layout Vertex layout and bound buffers, initialized with esInitVertexLayout
+/// \return The vertex array object, 0 on failure
+//
+GLuint ESUTIL_API esGetVertexArray ( ESVertexArrayCache *cache, const ESVertexLayout *layout );
+
+//
+/// \brief Delete all vertex array objects held by the cache and free the cache
+/// \param cache Vertex array cache
+//
+void ESUTIL_API esDeleteVertexArrayCache ( ESVertexArrayCache *cache );
+
+//
+/// \brief Create a buffer arena for meshes that share a vertex layout
+/// \param vertexStride Size of one vertex in bytes
+/// \param verticesPerPage Minimum number of vertices in each vertex buffer
+/// \param indicesPerPage Minimum number of indices in each index buffer
+/// \return The new arena, NULL on failure
+//
+ESBufferArena *ESUTIL_API esCreateBufferArena ( GLsizei vertexStride, GLsizei verticesPerPage, GLsizei indicesPerPage );
+
+//
+/// \brief Copy a mesh into the arena.  The indices are rebased by the mesh's base vertex
+///        on upload, so the mesh is drawn with
+///        glDrawElements ( mode, mesh->numIndices, GL_UNSIGNED_INT, ( const void * ) ( mesh->firstIndex * sizeof ( GLuint ) ) )
+///        with mesh->vertexBuffer and mesh->indexBuffer bound.
+/// \param arena Buffer arena
+/// \param vertices Vertex data, numVertices * vertexStride bytes
+/// \param numVertices Number of vertices
+/// \param indices Indices relative to the first vertex of the mesh
+/// \param numIndices Number of indices
+/// \param mesh Returns the location of the mesh in the arena
+/// \return GL_TRUE on success, GL_FALSE on failure
+//
+GLboolean ESUTIL_API esBufferArenaAlloc ( ESBufferArena *arena, const void *vertices, GLsizei numVertices,
+                                          const GLuint *indices, GLsizei numIndices, ESMeshHandle *mesh );
+
+//
+/// \brief Return the space used by a mesh to the arena
+/// \param arena Buffer arena
+/// \param mesh Mesh returned by esBufferArenaAlloc
+//
+void ESUTIL_API esBufferArenaFree ( ESBufferArena *arena, ESMeshHandle *mesh );
+
+//
+/// \brief Delete the buffer objects owned by the arena and free the arena
+/// \param arena Buffer arena
+//
+void ESUTIL_API esDeleteBufferArena ( ESBufferArena *arena );
+
+//
+/// \brief Initialize an empty dirty range tracker
+/// \param dirty Dirty range tracker
+/// \param elementSize Size of one element of the tracked buffer in bytes
+//
+void ESUTIL_API esInitDirtyRanges ( ESDirtyRanges *dirty, GLsizeiptr elementSize );
+
+//
+/// \brief Record that elements [first, first + count) were modified.  Overlapping and adjacent
+///        ranges are coalesced; when the tracker is full the two closest ranges are merged.
+/// \param dirty Dirty range tracker
+/// \param first First modified element
+/// \param count Number of modified elements
+//
+void ESUTIL_API esMarkDirty ( ESDirtyRanges *dirty, GLint first, GLsizei count );
+
+//
+/// \brief Upload the dirty ranges from a CPU copy of the buffer and clear the tracker
+/// \param dirty Dirty range tracker
+/// \param target Buffer binding point the destination buffer is bound to
+/// \param data CPU copy of the whole buffer
+/// \param method ES_FLUSH_BUFFER_SUB_DATA issues one glBufferSubData per range,
+///        ES_FLUSH_MAP_EXPLICIT maps the span of the ranges with GL_MAP_FLUSH_EXPLICIT_BIT
+///        and flushes each range with glFlushMappedBufferRange
+/// \return Number of bytes uploaded
+//
+GLsizeiptr ESUTIL_API esFlushDirtyRanges ( ESDirtyRanges *dirty, GLenum target, const void *data, GLenum method );
+
+//
+/// \brief Return the number of processor cores available to the application
+//
+int ESUTIL_API esGetNumCores ( void );
+
+//
+/// \brief Return a monotonic wall clock time in seconds, for measuring intervals
+//
+double ESUTIL_API esGetTime ( void );
+
+//
+/// \brief Call func over [0, count) split into contiguous subranges that run on separate
+///        threads, and return once all of them are done.  func must be safe to run concurrently.
+/// \param count Number of items
+/// \param minRange Smallest subrange worth a thread of its own
+/// \param func Work function
+/// \param userData Passed to func
+//
+void ESUTIL_API esParallelFor ( int count, int minRange, ESParallelForFunc func, void *userData );
+
+//
+/// \brief Generate per-vertex tangents for an indexed triangle mesh, following the MikkTSpace
+///        conventions: the xyz of each tangent is orthogonal to the vertex normal and the w holds the
+///        handedness, so the bitangent is w * cross ( normal, tangent.xyz ).  Vertices must already be
+///        split on texture coordinate seams, as in the esGen* outputs.
+/// \param numVertices Number of vertices
+/// \param positions Array of float3 positions
+/// \param normals Array of float3 unit normals
+/// \param texCoords Array of float2 texCoords
+/// \param numIndices Number of indices, 3 per triangle
+/// \param indices Triangle list indices
+/// \param tangents Array of numVertices float4 that receives the tangents, left unchanged when
+///        there are no complete triangles
+/// \return GL_TRUE on success, GL_FALSE if memory could not be allocated
+//
+GLboolean ESUTIL_API esGenTangents ( int numVertices, const GLfloat *positions, const GLfloat *normals,
+                                     const GLfloat *texCoords, int numIndices, const GLuint *indices,
+                                     GLfloat *tangents );
+
+//
+/// \brief Build a bounding volume hierarchy over a triangle list for ray queries.  The build
+///        runs on all cores.  The positions are copied, so the arrays can be freed afterwards.
+/// \param positions Array of float3 positions
+/// \param indices Triangle list indices
+/// \param numTriangles Number of triangles
+/// \return The new hierarchy, NULL on failure
+//
+ESBvh *ESUTIL_API esCreateBvh ( const GLfloat *positions, const GLuint *indices, int numTriangles );
+
+//
+/// \brief Find the closest triangle hit by a ray or segment
+/// \param bvh Hierarchy created by esCreateBvh
+/// \param origin Ray origin
+/// \param direction Ray direction, need not be normalized
+/// \param maxDistance Ignore hits farther than this, in units of the direction's length.  Pass 1 with
+///        direction = end - origin to test a segment
+/// \param hit Returns the closest hit
+/// \return GL_TRUE if a triangle was hit
+//
+GLboolean ESUTIL_API esBvhIntersect ( const ESBvh *bvh, const GLfloat origin[3], const GLfloat direction[3],
+                                      GLfloat maxDistance, ESRayHit *hit );
+
+//
+/// \brief Free a hierarchy created by esCreateBvh
+/// \param bvh Hierarchy
+//
+void ESUTIL_API esDeleteBvh ( ESBvh *bvh );
+
+//
+/// \brief Return the largest size esEncodeVertexBuffer can produce
+/// \param numVertices Number of vertices
+/// \param vertexSize Size of one vertex in bytes, at most 256
+//
+int ESUTIL_API esEncodeVertexBufferBound ( int numVertices, int vertexSize );
+
+//
+/// \brief Compress an interleaved vertex buffer.  Each byte of the vertex is delta coded against
+///        the previous vertex, so vertices ordered for locality (as in the esGen* outputs)
+///        compress best.  Decoding is exact.
+/// \param dst Receives the encoded data
+/// \param dstSize Size of dst in bytes; esEncodeVertexBufferBound is always enough
+/// \param vertices Vertex data
+/// \param numVertices Number of vertices
+/// \param vertexSize Size of one vertex in bytes, at most 256
+/// \return Size of the encoded data, 0 if dst is too small
+//
+int ESUTIL_API esEncodeVertexBuffer ( GLubyte *dst, int dstSize, const void *vertices, int numVertices, int vertexSize );
+
+//
+/// \brief Decompress a vertex buffer encoded by esEncodeVertexBuffer
+/// \param vertices Receives numVertices * vertexSize bytes
+/// \param numVertices Number of vertices, as passed to the encoder
+/// \param vertexSize Size of one vertex in bytes, as passed to the encoder
+/// \param src Encoded data
+/// \param srcSize Size of the encoded data in bytes
+/// \return GL_TRUE on success, GL_FALSE if the data is malformed or truncated
+//
+GLboolean ESUTIL_API esDecodeVertexBuffer ( void *vertices, int numVertices, int vertexSize, const GLubyte *src, int srcSize );
+
+//
+/// \brief Return the largest size esEncodeIndexBuffer can produce
+/// \param numIndices Number of indices
+//
+int ESUTIL_API esEncodeIndexBufferBound ( int numIndices );
+
+//
+/// \brief Compress an index buffer as deltas between consecutive indices, coded one byte lane
+///        at a time like esEncodeVertexBuffer
+/// \param dst Receives the encoded data
+/// \param dstSize Size of dst in bytes; esEncodeIndexBufferBound is always enough
+/// \param indices Index data
+/// \param numIndices Number of indices
+/// \return Size of the encoded data, 0 if dst is too small
+//
+int ESUTIL_API esEncodeIndexBuffer ( GLubyte *dst, int dstSize, const GLuint *indices, int numIndices );
+
+//
+/// \brief Decompress an index buffer encoded by esEncodeIndexBuffer
+/// \param indices Receives numIndices indices
+/// \param numIndices Number of indices, as passed to the encoder
+/// \param src Encoded data
+/// \param srcSize Size of the encoded data in bytes
+/// \return GL_TRUE on success, GL_FALSE if the data is malformed or truncated
+//
+GLboolean ESUTIL_API esDecodeIndexBuffer ( GLuint *indices, int numIndices, const GLubyte *src, int srcSize );
+
+//
+/// \brief Store a mesh in the disk cache, its vertices and indices compressed with
+///        esEncodeVertexBuffer and esEncodeIndexBuffer
+/// \param cacheDir Directory of the cache, NULL to store nothing
+/// \param name Name of what produced the mesh
+/// \param key Hash of everything the mesh depends on
+/// \param vertices Interleaved vertex data
+/// \param numVertices Number of vertices
+/// \param vertexSize Size of one vertex in bytes, at most 256
+/// \param indices Index data
+/// \param numIndices Number of indices
+/// \return GL_TRUE if the mesh was stored
+//
+GLboolean ESUTIL_API esCacheStoreMesh ( const char *cacheDir, const char *name, GLuint64 key, const void *vertices,
+                                        int numVertices, int vertexSize, const GLuint *indices, int numIndices );
+
+//
+/// \brief Load and decode a mesh stored by esCacheStoreMesh
+/// \param cacheDir Directory of the cache, NULL to always miss
+/// \param name Name of what produced the mesh
+/// \param key Hash of everything the mesh depends on
+/// \param vertexSize Size of one vertex in bytes; a mesh stored with another size is a miss
+/// \param vertices Returns the vertex data, to free with free
+/// \param numVertices Returns the number of vertices
+/// \param indices Returns the index data, to free with free
+/// \param numIndices Returns the number of indices
+/// \return GL_TRUE if the mesh was cached and decoded
+//
+GLboolean ESUTIL_API esCacheLoadMesh ( const char *cacheDir, const char *name, GLuint64 key, int vertexSize,
+                                       void **vertices, int *numVertices, GLuint **indices, int *numIndices );
 
 //
 /// \brief Multiply matrix specified by result with a scaling matrix and return new matrix in result
@@ -145,6 +145,7 @@ void android_main ( struct android_app *pApp )
    memset ( &esContext, 0, sizeof ( ESContext ) );
 
    esContext.platformData = ( void * ) pApp->activity->assetManager;
+   esContext.cacheDir = pApp->activity->internalDataPath;
 
    pApp->onAppCmd = HandleCommand;
    pApp->userData = &esContext;
@@ -186,6 +187,9 @@ void android_main ( struct android_app *pApp )
          esContext.updateFunc ( &esContext, deltaTime );
       }
 
+      // Send this frame's share of the scheduled uploads
+      esUpdateUploadScheduler ( esContext.uploadScheduler );
+
       if ( esContext.drawFunc != NULL )
       {
          esContext.drawFunc ( &esContext );
@@ -173,6 +173,7 @@ void WinLoop ( ESContext *esContext )
 
         if (esContext->updateFunc != NULL)
             esContext->updateFunc(esContext, deltatime);
+        esUpdateUploadScheduler(esContext->uploadScheduler);
         if (esContext->drawFunc != NULL)
             esContext->drawFunc(esContext);
 
@@ -197,6 +198,9 @@ int main ( int argc, char *argv[] )
    
    memset ( &esContext, 0, sizeof( esContext ) );
 
+   // Cached files go in a subdirectory of the sample's data files, created on first use
+   esContext.cacheDir = "cache";
+
 
    if ( esMain ( &esContext ) != GL_TRUE )
       return 1;   
@@ -72,6 +72,8 @@ LRESULT WINAPI ESWindowProc ( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam
 
          if ( esContext && esContext->drawFunc )
          {
+            // Send this frame's share of the scheduled uploads
+            esUpdateUploadScheduler ( esContext->uploadScheduler );
             esContext->drawFunc ( esContext );
             eglSwapBuffers ( esContext->eglDisplay, esContext->eglSurface );
          }
@@ -244,6 +246,9 @@ int main ( int argc, char *argv[] )
 
    memset ( &esContext, 0, sizeof ( ESContext ) );
 
+   // Cached files go in a subdirectory of the sample's data files, created on first use
+   esContext.cacheDir = "cache";
+
    if ( esMain ( &esContext ) != GL_TRUE )
    {
       return 1;
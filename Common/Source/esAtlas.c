@@ -0,0 +1,495 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESAtlas.c
+//
+//    Packs many small images into the layers of one 2D array texture so
+//    they can be drawn with a single bind.  Images are placed with a
+//    skyline bottom-left packer, a new layer being started when an image
+//    fits in none of the existing ones.
+//
+//    To keep mip levels from mixing neighbouring images, every image is
+//    surrounded by a copy of its edge texels and aligned so that no 2x2
+//    block of the padded levels straddles two images.  Padding n levels
+//    takes a border and an alignment of 2^(n-1) texels, which leaves one
+//    texel of border around each image at the last padded level, enough
+//    for bilinear filtering.
+//
+//    Only the first ATLAS_PADDED_LEVELS levels are padded.  Padding all
+//    of them would make a 16x16 image take a 384x384 slot in an 8 level
+//    atlas; instead the smaller levels, where an image covers a few
+//    texels at most, blend neighbouring images at their edges.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+//  Macros
+//
+#define ATLAS_PADDED_LEVELS   4
+
+///
+//  Types
+//
+typedef struct
+{
+   int x;
+   int y;
+   int width;
+} SkylineNode;
+
+typedef struct
+{
+   // Top edge of the packed images, left to right
+   SkylineNode *nodes;
+   int          numNodes;
+   GLubyte     *pixels;
+} AtlasLayer;
+
+struct ESAtlas
+{
+   int          width;
+   int          height;
+   int          components;
+   int          numLevels;
+   int          border;
+
+   AtlasLayer  *layers;
+   int          numLayers;
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// AlignUp()
+//
+static int AlignUp ( int value, int alignment )
+{
+   return ( value + alignment - 1 ) / alignment * alignment;
+}
+
+///
+// AddLayer()
+//
+static AtlasLayer *AddLayer ( ESAtlas *atlas )
+{
+   AtlasLayer *layers = realloc ( atlas->layers, sizeof ( AtlasLayer ) * ( atlas->numLayers + 1 ) );
+   AtlasLayer *layer;
+
+   if ( layers == NULL )
+   {
+      return NULL;
+   }
+
+   atlas->layers = layers;
+   layer = &layers[atlas->numLayers];
+
+   // Nodes are at least one alignment unit wide
+   layer->nodes = malloc ( sizeof ( SkylineNode ) * ( atlas->width / atlas->border + 1 ) );
+   layer->pixels = calloc ( ( size_t ) atlas->width * atlas->height, atlas->components );
+
+   if ( layer->nodes == NULL || layer->pixels == NULL )
+   {
+      free ( layer->nodes );
+      free ( layer->pixels );
+      return NULL;
+   }
+
+   layer->nodes[0].x = 0;
+   layer->nodes[0].y = 0;
+   layer->nodes[0].width = atlas->width;
+   layer->numNodes = 1;
+
+   atlas->numLayers++;
+   return layer;
+}
+
+///
+// FitSkyline()
+//
+//    Lowest y at which a width x height rectangle starting at node i rests
+//    on the skyline, -1 if it does not fit
+//
+static int FitSkyline ( const ESAtlas *atlas, const AtlasLayer *layer, int i, int width, int height )
+{
+   int y = 0;
+   int remaining = width;
+
+   if ( layer->nodes[i].x + width > atlas->width )
+   {
+      return -1;
+   }
+
+   for ( ; remaining > 0; i++ )
+   {
+      y = layer->nodes[i].y > y ? layer->nodes[i].y : y;
+
+      if ( y + height > atlas->height )
+      {
+         return -1;
+      }
+
+      remaining -= layer->nodes[i].width;
+   }
+
+   return y;
+}
+
+///
+// FindPosition()
+//
+//    Bottom-left rule: the lowest position, then the leftmost
+//
+static int FindPosition ( const ESAtlas *atlas, const AtlasLayer *layer, int width, int height, int *x, int *y )
+{
+   int best = -1;
+   int i;
+
+   for ( i = 0; i < layer->numNodes; i++ )
+   {
+      int fit = FitSkyline ( atlas, layer, i, width, height );
+
+      if ( fit >= 0 && ( best < 0 || fit < *y ) )
+      {
+         best = i;
+         *x = layer->nodes[i].x;
+         *y = fit;
+      }
+   }
+
+   return best;
+}
+
+///
+// AddSkylineLevel()
+//
+//    Raise the skyline over a rectangle placed at node i
+//
+static void AddSkylineLevel ( AtlasLayer *layer, int i, int x, int y, int width, int height )
+{
+   int j;
+
+   memmove ( &layer->nodes[i + 1], &layer->nodes[i], sizeof ( SkylineNode ) * ( layer->numNodes - i ) );
+   layer->nodes[i].x = x;
+   layer->nodes[i].y = y + height;
+   layer->nodes[i].width = width;
+   layer->numNodes++;
+
+   // Shrink or remove the nodes the rectangle covers
+   for ( j = i + 1; j < layer->numNodes; )
+   {
+      int shrink = x + width - layer->nodes[j].x;
+
+      if ( shrink <= 0 )
+      {
+         break;
+      }
+
+      if ( shrink < layer->nodes[j].width )
+      {
+         layer->nodes[j].x += shrink;
+         layer->nodes[j].width -= shrink;
+         break;
+      }
+
+      memmove ( &layer->nodes[j], &layer->nodes[j + 1], sizeof ( SkylineNode ) * ( layer->numNodes - j - 1 ) );
+      layer->numNodes--;
+   }
+
+   // Merge neighbours at the same height
+   for ( j = 0; j + 1 < layer->numNodes; )
+   {
+      if ( layer->nodes[j].y == layer->nodes[j + 1].y )
+      {
+         layer->nodes[j].width += layer->nodes[j + 1].width;
+         memmove ( &layer->nodes[j + 1], &layer->nodes[j + 2], sizeof ( SkylineNode ) * ( layer->numNodes - j - 2 ) );
+         layer->numNodes--;
+      }
+      else
+      {
+         j++;
+      }
+   }
+}
+
+///
+// CopyWithBorder()
+//
+//    Copy an image into its slot of a layer and repeat its edge texels
+//    over the rest of the slot: the border, and the space rounding the
+//    slot up to the alignment
+//
+static void CopyWithBorder ( const ESAtlas *atlas, GLubyte *layer, const GLubyte *pixels, int slotX, int slotY,
+                             int slotWidth, int slotHeight, int width, int height )
+{
+   int      c = atlas->components;
+   int      b = atlas->border;
+   size_t   pitch = ( size_t ) atlas->width * c;
+   GLubyte *slot = layer + slotY * pitch + ( size_t ) slotX * c;
+   int      row, i;
+
+   for ( row = 0; row < height; row++ )
+   {
+      GLubyte *dst = slot + ( b + row ) * pitch;
+
+      memcpy ( dst + b * c, pixels + ( size_t ) row * width * c, ( size_t ) width * c );
+
+      for ( i = 0; i < b; i++ )
+      {
+         memcpy ( dst + i * c, dst + b * c, c );
+      }
+
+      for ( i = b + width; i < slotWidth; i++ )
+      {
+         memcpy ( dst + i * c, dst + ( b + width - 1 ) * c, c );
+      }
+   }
+
+   for ( row = 0; row < b; row++ )
+   {
+      memcpy ( slot + row * pitch, slot + b * pitch, ( size_t ) slotWidth * c );
+   }
+
+   for ( row = b + height; row < slotHeight; row++ )
+   {
+      memcpy ( slot + row * pitch, slot + ( b + height - 1 ) * pitch, ( size_t ) slotWidth * c );
+   }
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateAtlas()
+//
+ESAtlas *ESUTIL_API esCreateAtlas ( int width, int height, int components, int numLevels )
+{
+   ESAtlas *atlas;
+
+   if ( components < 1 || components > 4 || numLevels < 1 || numLevels > 16 ||
+        width % ( 1 << ( numLevels - 1 ) ) != 0 || height % ( 1 << ( numLevels - 1 ) ) != 0 )
+   {
+      esLogMessage ( "esCreateAtlas: layer size must be a multiple of 2^(numLevels-1)\n" );
+      return NULL;
+   }
+
+   atlas = calloc ( 1, sizeof ( ESAtlas ) );
+
+   if ( atlas != NULL )
+   {
+      atlas->width = width;
+      atlas->height = height;
+      atlas->components = components;
+      atlas->numLevels = numLevels;
+      atlas->border = 1 << ( ( numLevels < ATLAS_PADDED_LEVELS ? numLevels : ATLAS_PADDED_LEVELS ) - 1 );
+   }
+
+   return atlas;
+}
+
+///
+// esAtlasAdd()
+//
+GLboolean ESUTIL_API esAtlasAdd ( ESAtlas *atlas, const GLubyte *pixels, int width, int height, ESAtlasRegion *region )
+{
+   int         slotWidth = AlignUp ( width + 2 * atlas->border, atlas->border );
+   int         slotHeight = AlignUp ( height + 2 * atlas->border, atlas->border );
+   AtlasLayer *layer = NULL;
+   int         node = -1;
+   int         x = 0, y = 0;
+   int         i;
+
+   if ( width < 1 || height < 1 || slotWidth > atlas->width || slotHeight > atlas->height )
+   {
+      esLogMessage ( "esAtlasAdd: a %dx%d image does not fit in a %dx%d layer\n", width, height, atlas->width, atlas->height );
+      return GL_FALSE;
+   }
+
+   for ( i = 0; i < atlas->numLayers && node < 0; i++ )
+   {
+      layer = &atlas->layers[i];
+      node = FindPosition ( atlas, layer, slotWidth, slotHeight, &x, &y );
+   }
+
+   if ( node < 0 )
+   {
+      layer = AddLayer ( atlas );
+
+      if ( layer == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      node = FindPosition ( atlas, layer, slotWidth, slotHeight, &x, &y );
+   }
+
+   AddSkylineLevel ( layer, node, x, y, slotWidth, slotHeight );
+   CopyWithBorder ( atlas, layer->pixels, pixels, x, y, slotWidth, slotHeight, width, height );
+
+   region->layer = ( int ) ( layer - atlas->layers );
+   region->x = x + atlas->border;
+   region->y = y + atlas->border;
+   region->width = width;
+   region->height = height;
+   region->scale[0] = ( GLfloat ) width / atlas->width;
+   region->scale[1] = ( GLfloat ) height / atlas->height;
+   region->offset[0] = ( GLfloat ) region->x / atlas->width;
+   region->offset[1] = ( GLfloat ) region->y / atlas->height;
+
+   return GL_TRUE;
+}
+
+///
+// esAtlasRemapTexCoords()
+//
+void ESUTIL_API esAtlasRemapTexCoords ( const ESAtlasRegion *region, GLfloat *texCoords, int count, int stride )
+{
+   int i;
+
+   stride = stride > 0 ? stride : 2;
+
+   for ( i = 0; i < count; i++, texCoords += stride )
+   {
+      texCoords[0] = texCoords[0] * region->scale[0] + region->offset[0];
+      texCoords[1] = texCoords[1] * region->scale[1] + region->offset[1];
+   }
+}
+
+///
+// esCreateAtlasTexture()
+//
+GLuint ESUTIL_API esCreateAtlasTexture ( ESAtlas *atlas, int *numLayers )
+{
+   static const GLenum internalFormats[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+   static const GLenum formats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+   GLenum    internalFormat = internalFormats[atlas->components - 1];
+   GLenum    format = formats[atlas->components - 1];
+   GLubyte  *chain = NULL;
+   GLboolean ok = GL_TRUE;
+   GLuint    texture;
+   GLint     alignment;
+   int       i, level;
+
+   if ( atlas->numLayers == 0 )
+   {
+      return 0;
+   }
+
+   if ( atlas->numLevels > 1 )
+   {
+      chain = malloc ( esMipChainSize ( atlas->width, atlas->height, atlas->components, NULL ) );
+
+      if ( chain == NULL )
+      {
+         return 0;
+      }
+   }
+
+   glGenTextures ( 1, &texture );
+   glBindTexture ( GL_TEXTURE_2D_ARRAY, texture );
+   glTexStorage3D ( GL_TEXTURE_2D_ARRAY, atlas->numLevels, internalFormat, atlas->width, atlas->height, atlas->numLayers );
+
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, 1 );
+
+   for ( i = 0; i < atlas->numLayers && ok; i++ )
+   {
+      const GLubyte *image = chain;
+
+      glTexSubImage3D ( GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, atlas->width, atlas->height, 1, format, GL_UNSIGNED_BYTE,
+                        atlas->layers[i].pixels );
+
+      // Images are aligned to the border, so each box filtered texel of
+      // the padded levels comes from a single image
+      ok = chain == NULL || esGenMipChain ( atlas->layers[i].pixels, atlas->width, atlas->height, atlas->components,
+                                            ES_MIP_FILTER_BOX, GL_FALSE, chain );
+
+      for ( level = 1; level < atlas->numLevels && ok; level++ )
+      {
+         int width = atlas->width >> level;
+         int height = atlas->height >> level;
+
+         glTexSubImage3D ( GL_TEXTURE_2D_ARRAY, level, 0, 0, i, width, height, 1, format, GL_UNSIGNED_BYTE, image );
+         image += ( size_t ) width * height * atlas->components;
+      }
+   }
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+   free ( chain );
+
+   if ( !ok )
+   {
+      glDeleteTextures ( 1, &texture );
+      return 0;
+   }
+
+   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                     atlas->numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+   glTexParameteri ( GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+   if ( numLayers != NULL )
+   {
+      *numLayers = atlas->numLayers;
+   }
+
+   return texture;
+}
+
+///
+// esDeleteAtlas()
+//
+void ESUTIL_API esDeleteAtlas ( ESAtlas *atlas )
+{
+   int i;
+
+   for ( i = 0; i < atlas->numLayers; i++ )
+   {
+      free ( atlas->layers[i].nodes );
+      free ( atlas->layers[i].pixels );
+   }
+
+   free ( atlas->layers );
+   free ( atlas );
+}
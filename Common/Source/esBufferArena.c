@@ -0,0 +1,481 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESBufferArena.c
+//
+//    Packs many static meshes that share a vertex layout into a few large
+//    vertex and index buffer objects.  Space inside each buffer is handed
+//    out by a buddy allocator, so meshes can be added and released in any
+//    order while different meshes in the same page can be drawn without
+//    rebinding any buffers.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+// Defines
+//
+
+// Allocation granularity, in vertices or indices
+#define ARENA_UNIT_SIZE    64
+
+///
+// Types
+//
+
+// Buddy allocator over 2^(numOrders-1) units, one free list per block order
+typedef struct
+{
+   int          numOrders;
+   int         *freeHead;    // first free block of each order, -1 if none
+   int         *next;        // free list links, indexed by block start unit
+   int         *prev;
+   signed char *freeOrder;   // order of the free block starting at a unit, -1 otherwise
+} BuddyAllocator;
+
+typedef struct
+{
+   GLuint         vertexBuffer;
+   GLuint         indexBuffer;
+   BuddyAllocator vertexAlloc;
+   BuddyAllocator indexAlloc;
+} ArenaPage;
+
+struct ESBufferArena
+{
+   GLsizei    vertexStride;
+   int        vertexPageOrder;
+   int        indexPageOrder;
+   ArenaPage *pages;
+   int        numPages;
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// OrderForUnits()
+//
+//    Smallest order whose block holds numUnits units
+//
+static int OrderForUnits ( int numUnits )
+{
+   int order = 0;
+
+   while ( ( 1 << order ) < numUnits )
+   {
+      order++;
+   }
+
+   return order;
+}
+
+static void BuddyPush ( BuddyAllocator *buddy, int block, int order )
+{
+   buddy->prev[block] = -1;
+   buddy->next[block] = buddy->freeHead[order];
+
+   if ( buddy->freeHead[order] >= 0 )
+   {
+      buddy->prev[buddy->freeHead[order]] = block;
+   }
+
+   buddy->freeHead[order] = block;
+   buddy->freeOrder[block] = ( signed char ) order;
+}
+
+static void BuddyRemove ( BuddyAllocator *buddy, int block, int order )
+{
+   if ( buddy->prev[block] >= 0 )
+   {
+      buddy->next[buddy->prev[block]] = buddy->next[block];
+   }
+   else
+   {
+      buddy->freeHead[order] = buddy->next[block];
+   }
+
+   if ( buddy->next[block] >= 0 )
+   {
+      buddy->prev[buddy->next[block]] = buddy->prev[block];
+   }
+
+   buddy->freeOrder[block] = -1;
+}
+
+static GLboolean BuddyInit ( BuddyAllocator *buddy, int maxOrder )
+{
+   int numUnits = 1 << maxOrder;
+   int i;
+
+   buddy->numOrders = maxOrder + 1;
+   buddy->freeHead = malloc ( sizeof ( int ) * buddy->numOrders );
+   buddy->next = malloc ( sizeof ( int ) * numUnits );
+   buddy->prev = malloc ( sizeof ( int ) * numUnits );
+   buddy->freeOrder = malloc ( numUnits );
+
+   if ( !buddy->freeHead || !buddy->next || !buddy->prev || !buddy->freeOrder )
+   {
+      return GL_FALSE;
+   }
+
+   for ( i = 0; i < buddy->numOrders; i++ )
+   {
+      buddy->freeHead[i] = -1;
+   }
+
+   memset ( buddy->freeOrder, -1, numUnits );
+   BuddyPush ( buddy, 0, maxOrder );
+
+   return GL_TRUE;
+}
+
+static void BuddyDestroy ( BuddyAllocator *buddy )
+{
+   free ( buddy->freeHead );
+   free ( buddy->next );
+   free ( buddy->prev );
+   free ( buddy->freeOrder );
+}
+
+///
+// BuddyAlloc()
+//
+//    Returns the first unit of a free block of the given order, -1 if full
+//
+static int BuddyAlloc ( BuddyAllocator *buddy, int order )
+{
+   int found = order;
+   int block;
+
+   while ( found < buddy->numOrders && buddy->freeHead[found] < 0 )
+   {
+      found++;
+   }
+
+   if ( found >= buddy->numOrders )
+   {
+      return -1;
+   }
+
+   block = buddy->freeHead[found];
+   BuddyRemove ( buddy, block, found );
+
+   // Split the block, returning the upper halves to the free lists
+   while ( found > order )
+   {
+      found--;
+      BuddyPush ( buddy, block + ( 1 << found ), found );
+   }
+
+   return block;
+}
+
+static void BuddyFree ( BuddyAllocator *buddy, int block, int order )
+{
+   // Merge with the buddy block for as long as it is free
+   while ( order < buddy->numOrders - 1 )
+   {
+      int buddyBlock = block ^ ( 1 << order );
+
+      if ( buddy->freeOrder[buddyBlock] != order )
+      {
+         break;
+      }
+
+      BuddyRemove ( buddy, buddyBlock, order );
+
+      if ( buddyBlock < block )
+      {
+         block = buddyBlock;
+      }
+
+      order++;
+   }
+
+   BuddyPush ( buddy, block, order );
+}
+
+///
+// CreatePage()
+//
+//    Add a page with room for at least the requested number of units
+//
+static ArenaPage *CreatePage ( ESBufferArena *arena, int vertexOrder, int indexOrder )
+{
+   ArenaPage *pages;
+   ArenaPage *page;
+   GLint      copyBuffer;
+
+   if ( vertexOrder < arena->vertexPageOrder )
+   {
+      vertexOrder = arena->vertexPageOrder;
+   }
+
+   if ( indexOrder < arena->indexPageOrder )
+   {
+      indexOrder = arena->indexPageOrder;
+   }
+
+   pages = realloc ( arena->pages, sizeof ( ArenaPage ) * ( arena->numPages + 1 ) );
+
+   if ( pages == NULL )
+   {
+      return NULL;
+   }
+
+   arena->pages = pages;
+   page = &arena->pages[arena->numPages];
+   memset ( page, 0, sizeof ( ArenaPage ) );
+
+   if ( !BuddyInit ( &page->vertexAlloc, vertexOrder ) ||
+         !BuddyInit ( &page->indexAlloc, indexOrder ) )
+   {
+      BuddyDestroy ( &page->vertexAlloc );
+      BuddyDestroy ( &page->indexAlloc );
+      return NULL;
+   }
+
+   // Errors raised before this call must not be taken for allocation errors
+   while ( glGetError () != GL_NO_ERROR )
+   {
+   }
+
+   // Allocate through GL_COPY_WRITE_BUFFER, which leaves the application's
+   // array buffer and the bound vertex array's index buffer alone
+   glGetIntegerv ( GL_COPY_WRITE_BUFFER_BINDING, &copyBuffer );
+
+   glGenBuffers ( 1, &page->vertexBuffer );
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, page->vertexBuffer );
+   glBufferData ( GL_COPY_WRITE_BUFFER, ( GLsizeiptr ) arena->vertexStride * ARENA_UNIT_SIZE << vertexOrder,
+                  NULL, GL_STATIC_DRAW );
+
+   glGenBuffers ( 1, &page->indexBuffer );
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, page->indexBuffer );
+   glBufferData ( GL_COPY_WRITE_BUFFER, ( GLsizeiptr ) sizeof ( GLuint ) * ARENA_UNIT_SIZE << indexOrder,
+                  NULL, GL_STATIC_DRAW );
+
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, copyBuffer );
+
+   if ( glGetError () != GL_NO_ERROR )
+   {
+      glDeleteBuffers ( 1, &page->vertexBuffer );
+      glDeleteBuffers ( 1, &page->indexBuffer );
+      BuddyDestroy ( &page->vertexAlloc );
+      BuddyDestroy ( &page->indexAlloc );
+      return NULL;
+   }
+
+   arena->numPages++;
+   return page;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+//
+/// \brief Create a buffer arena for meshes that share a vertex layout
+/// \param vertexStride Size of one vertex in bytes
+/// \param verticesPerPage Minimum number of vertices in each vertex buffer
+/// \param indicesPerPage Minimum number of indices in each index buffer
+/// \return The new arena, NULL on failure
+//
+ESBufferArena *ESUTIL_API esCreateBufferArena ( GLsizei vertexStride, GLsizei verticesPerPage, GLsizei indicesPerPage )
+{
+   ESBufferArena *arena = calloc ( 1, sizeof ( ESBufferArena ) );
+
+   if ( arena == NULL )
+   {
+      return NULL;
+   }
+
+   arena->vertexStride = vertexStride;
+   arena->vertexPageOrder = OrderForUnits ( ( verticesPerPage + ARENA_UNIT_SIZE - 1 ) / ARENA_UNIT_SIZE );
+   arena->indexPageOrder = OrderForUnits ( ( indicesPerPage + ARENA_UNIT_SIZE - 1 ) / ARENA_UNIT_SIZE );
+
+   return arena;
+}
+
+//
+/// \brief Copy a mesh into the arena.  The indices are rebased by the mesh's base vertex
+///        on upload, so the mesh is drawn with
+///        glDrawElements ( mode, mesh->numIndices, GL_UNSIGNED_INT, ( const void * ) ( mesh->firstIndex * sizeof ( GLuint ) ) )
+///        with mesh->vertexBuffer and mesh->indexBuffer bound.
+/// \param arena Buffer arena
+/// \param vertices Vertex data, numVertices * vertexStride bytes
+/// \param numVertices Number of vertices
+/// \param indices Indices relative to the first vertex of the mesh
+/// \param numIndices Number of indices
+/// \param mesh Returns the location of the mesh in the arena
+/// \return GL_TRUE on success, GL_FALSE on failure
+//
+GLboolean ESUTIL_API esBufferArenaAlloc ( ESBufferArena *arena, const void *vertices, GLsizei numVertices,
+                                          const GLuint *indices, GLsizei numIndices, ESMeshHandle *mesh )
+{
+   int vertexOrder = OrderForUnits ( ( numVertices + ARENA_UNIT_SIZE - 1 ) / ARENA_UNIT_SIZE );
+   int indexOrder = OrderForUnits ( ( numIndices + ARENA_UNIT_SIZE - 1 ) / ARENA_UNIT_SIZE );
+   ArenaPage *page = NULL;
+   int vertexBlock = -1;
+   int indexBlock = -1;
+   GLuint *rebased;
+   GLint copyBuffer;
+   int i;
+
+   // First fit over the existing pages, adding a page if none has room
+   for ( i = 0; i <= arena->numPages; i++ )
+   {
+      if ( i == arena->numPages && CreatePage ( arena, vertexOrder, indexOrder ) == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      page = &arena->pages[i];
+
+      if ( vertexOrder >= page->vertexAlloc.numOrders || indexOrder >= page->indexAlloc.numOrders )
+      {
+         continue;
+      }
+
+      vertexBlock = BuddyAlloc ( &page->vertexAlloc, vertexOrder );
+
+      if ( vertexBlock < 0 )
+      {
+         continue;
+      }
+
+      indexBlock = BuddyAlloc ( &page->indexAlloc, indexOrder );
+
+      if ( indexBlock >= 0 )
+      {
+         break;
+      }
+
+      BuddyFree ( &page->vertexAlloc, vertexBlock, vertexOrder );
+   }
+
+   mesh->vertexBuffer = page->vertexBuffer;
+   mesh->indexBuffer = page->indexBuffer;
+   mesh->baseVertex = vertexBlock * ARENA_UNIT_SIZE;
+   mesh->firstIndex = indexBlock * ARENA_UNIT_SIZE;
+   mesh->numVertices = numVertices;
+   mesh->numIndices = numIndices;
+   mesh->page = i;
+   mesh->vertexOrder = vertexOrder;
+   mesh->indexOrder = indexOrder;
+
+   // OpenGL ES 3.0 has no base vertex draw calls, so add the base vertex to the indices
+   rebased = malloc ( sizeof ( GLuint ) * numIndices );
+
+   if ( rebased == NULL )
+   {
+      esBufferArenaFree ( arena, mesh );
+      return GL_FALSE;
+   }
+
+   for ( i = 0; i < numIndices; i++ )
+   {
+      rebased[i] = indices[i] + mesh->baseVertex;
+   }
+
+   // Upload through GL_COPY_WRITE_BUFFER, as CreatePage allocates
+   glGetIntegerv ( GL_COPY_WRITE_BUFFER_BINDING, &copyBuffer );
+
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, mesh->vertexBuffer );
+   glBufferSubData ( GL_COPY_WRITE_BUFFER, ( GLintptr ) mesh->baseVertex * arena->vertexStride,
+                     ( GLsizeiptr ) numVertices * arena->vertexStride, vertices );
+
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, mesh->indexBuffer );
+   glBufferSubData ( GL_COPY_WRITE_BUFFER, ( GLintptr ) mesh->firstIndex * sizeof ( GLuint ),
+                     ( GLsizeiptr ) numIndices * sizeof ( GLuint ), rebased );
+
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, copyBuffer );
+
+   free ( rebased );
+   return GL_TRUE;
+}
+
+//
+/// \brief Return the space used by a mesh to the arena
+/// \param arena Buffer arena
+/// \param mesh Mesh returned by esBufferArenaAlloc
+//
+void ESUTIL_API esBufferArenaFree ( ESBufferArena *arena, ESMeshHandle *mesh )
+{
+   ArenaPage *page;
+
+   if ( mesh->page < 0 || mesh->page >= arena->numPages )
+   {
+      return;
+   }
+
+   page = &arena->pages[mesh->page];
+   BuddyFree ( &page->vertexAlloc, mesh->baseVertex / ARENA_UNIT_SIZE, mesh->vertexOrder );
+   BuddyFree ( &page->indexAlloc, mesh->firstIndex / ARENA_UNIT_SIZE, mesh->indexOrder );
+
+   memset ( mesh, 0, sizeof ( ESMeshHandle ) );
+   mesh->page = -1;
+}
+
+//
+/// \brief Delete the buffer objects owned by the arena and free the arena
+/// \param arena Buffer arena
+//
+void ESUTIL_API esDeleteBufferArena ( ESBufferArena *arena )
+{
+   int i;
+
+   if ( arena == NULL )
+   {
+      return;
+   }
+
+   for ( i = 0; i < arena->numPages; i++ )
+   {
+      glDeleteBuffers ( 1, &arena->pages[i].vertexBuffer );
+      glDeleteBuffers ( 1, &arena->pages[i].indexBuffer );
+      BuddyDestroy ( &arena->pages[i].vertexAlloc );
+      BuddyDestroy ( &arena->pages[i].indexAlloc );
+   }
+
+   free ( arena->pages );
+   free ( arena );
+}
@@ -0,0 +1,968 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESBvh.c
+//
+//    Bounding volume hierarchy over triangle meshes for CPU ray queries
+//    such as picking.  A binary tree is built with binned SAH splits and
+//    then collapsed into a four wide tree whose child boxes are stored as
+//    structure of arrays, so a ray is tested against all four with a few
+//    SSE instructions.
+//
+//    Every interior node of the binary tree splits its triangle range at
+//    a boundary no other node uses, so nodes are stored at the index of
+//    that boundary.  Disjoint subtrees therefore never write to the same
+//    slot and are built on separate threads without any locking.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ES_BVH_SSE
+#endif
+
+///
+// Defines
+//
+// Small ranges use one bin per triangle instead
+#define BVH_NUM_BINS        16
+#define BVH_MAX_LEAF_SIZE   8
+
+// Below this depth splits are by SAH, below it by object median, which
+// bounds the depth of the tree and so the traversal stack
+#define BVH_MAX_SAH_DEPTH   48
+#define BVH_STACK_SIZE      256
+
+// Ranges up to this size are handed to worker threads as a whole
+#define BVH_MIN_TASK_SIZE   4096
+
+// Leaves are encoded in a child reference as -1 - ( first * 16 + count )
+#define BVH_LEAF_REF(first, count)  ( -1 - ( ( first ) * 16 + ( count ) ) )
+#define BVH_LEAF_FIRST(ref)         ( ( -1 - ( ref ) ) >> 4 )
+#define BVH_LEAF_COUNT(ref)         ( ( -1 - ( ref ) ) & 15 )
+
+///
+// Types
+//
+typedef struct
+{
+   float min[3];
+   float max[3];
+} Bounds;
+
+// Triangle bounds, sorted into tree order during the build
+typedef struct
+{
+   Bounds bounds;
+   int    triangle;
+} PrimRef;
+
+// Binary tree node, stored at the index of its split boundary
+typedef struct
+{
+   Bounds bounds[2];
+   int    child[2];
+} BinaryNode;
+
+// Children are packed at the front, numChildren of them are valid
+typedef struct
+{
+   float min[3][4];
+   float max[3][4];
+   int   child[4];
+   int   numChildren;
+} Bvh4Node;
+
+struct ESBvh
+{
+   Bvh4Node *nodes;
+   int       numNodes;
+   int       nodeCapacity;
+   int       rootRef;
+   Bounds    rootBounds;
+
+   // Triangles in leaf order: v0, v1 - v0, v2 - v0
+   float    *triangles;
+   int      *triangleIds;
+};
+
+// Range of triangles still to be split, and where to store its reference
+typedef struct
+{
+   int  first;
+   int  end;
+   int  depth;
+   int *ref;
+   Bounds *bounds;
+} BuildItem;
+
+typedef struct
+{
+   int         numTriangles;
+   PrimRef    *prims;
+   BinaryNode *nodes;
+
+   // Ranges of at most taskSize triangles deferred to esParallelFor
+   BuildItem  *tasks;
+   int         numTasks;
+   int         taskCapacity;
+   int         taskSize;
+
+   const GLfloat *positions;
+   const GLuint  *indices;
+} BuildContext;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+static void BoundsEmpty ( Bounds *b )
+{
+   b->min[0] = b->min[1] = b->min[2] = FLT_MAX;
+   b->max[0] = b->max[1] = b->max[2] = -FLT_MAX;
+}
+
+static void BoundsGrow ( Bounds *b, const Bounds *other )
+{
+   int i;
+
+   for ( i = 0; i < 3; i++ )
+   {
+      b->min[i] = other->min[i] < b->min[i] ? other->min[i] : b->min[i];
+      b->max[i] = other->max[i] > b->max[i] ? other->max[i] : b->max[i];
+   }
+}
+
+static float BoundsHalfArea ( const Bounds *b )
+{
+   float dx = b->max[0] - b->min[0];
+   float dy = b->max[1] - b->min[1];
+   float dz = b->max[2] - b->min[2];
+
+   if ( dx < 0.0f )
+   {
+      return 0.0f;
+   }
+
+   return dx * dy + dy * dz + dz * dx;
+}
+
+///
+// PrepareTriangles()
+//
+//    esParallelFor callback computing each triangle's bounds and centroid
+//
+static void ESCALLBACK PrepareTriangles ( void *userData, int begin, int end )
+{
+   BuildContext *ctx = userData;
+   int           t;
+   int           i;
+   int           k;
+
+   for ( t = begin; t < end; t++ )
+   {
+      Bounds *b = &ctx->prims[t].bounds;
+
+      BoundsEmpty ( b );
+
+      for ( k = 0; k < 3; k++ )
+      {
+         const GLfloat *p = &ctx->positions[3 * ctx->indices[3 * t + k]];
+
+         for ( i = 0; i < 3; i++ )
+         {
+            b->min[i] = p[i] < b->min[i] ? p[i] : b->min[i];
+            b->max[i] = p[i] > b->max[i] ? p[i] : b->max[i];
+         }
+      }
+
+      ctx->prims[t].triangle = t;
+   }
+}
+
+///
+// Centroid()
+//
+//    Centroid of a triangle's bounds along one axis, times two
+//
+static float Centroid ( const PrimRef *prim, int axis )
+{
+   return prim->bounds.min[axis] + prim->bounds.max[axis];
+}
+
+static void RangeBounds ( BuildContext *ctx, int first, int end, Bounds *bounds )
+{
+   int i;
+
+   BoundsEmpty ( bounds );
+
+   for ( i = first; i < end; i++ )
+   {
+      BoundsGrow ( bounds, &ctx->prims[i].bounds );
+   }
+}
+
+///
+// FindSplit()
+//
+//    Bin the centroids of [first, end) along each axis and return the
+//    boundary with the lowest surface area heuristic cost, or -1 if the
+//    range is better off as a leaf.  Past BVH_MAX_SAH_DEPTH, or when all
+//    centroids coincide, the range is split in half instead.  The bounds
+//    of both halves are returned in left and right.
+//
+static int FindSplit ( BuildContext *ctx, int first, int end, int depth, const Bounds *bounds,
+                       Bounds *left, Bounds *right )
+{
+   Bounds centroidBounds;
+   Bounds binBounds[3][BVH_NUM_BINS];
+   int    binCount[3][BVH_NUM_BINS];
+   Bounds rightBounds[BVH_NUM_BINS];
+   int    rightCount[BVH_NUM_BINS];
+   float  scale[3];
+   float  bestCost = FLT_MAX;
+   int    bestAxis = -1;
+   int    bestBin = 0;
+   int    count = end - first;
+   int    numBins = count < BVH_NUM_BINS ? count : BVH_NUM_BINS;
+   int    axis;
+   int    i;
+   int    b;
+   int    mid;
+
+   BoundsEmpty ( &centroidBounds );
+
+   for ( i = first; i < end; i++ )
+   {
+      for ( axis = 0; axis < 3; axis++ )
+      {
+         float c = Centroid ( &ctx->prims[i], axis );
+
+         centroidBounds.min[axis] = c < centroidBounds.min[axis] ? c : centroidBounds.min[axis];
+         centroidBounds.max[axis] = c > centroidBounds.max[axis] ? c : centroidBounds.max[axis];
+      }
+   }
+
+   for ( axis = 0; axis < 3; axis++ )
+   {
+      float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+
+      scale[axis] = extent > 0.0f ? numBins * ( 1.0f - 1e-6f ) / extent : 0.0f;
+
+      for ( b = 0; b < numBins; b++ )
+      {
+         BoundsEmpty ( &binBounds[axis][b] );
+         binCount[axis][b] = 0;
+      }
+   }
+
+   if ( depth < BVH_MAX_SAH_DEPTH && ( scale[0] > 0.0f || scale[1] > 0.0f || scale[2] > 0.0f ) )
+   {
+      for ( i = first; i < end; i++ )
+      {
+         const PrimRef *prim = &ctx->prims[i];
+
+         for ( axis = 0; axis < 3; axis++ )
+         {
+            b = ( int ) ( ( Centroid ( prim, axis ) - centroidBounds.min[axis] ) * scale[axis] );
+            BoundsGrow ( &binBounds[axis][b], &prim->bounds );
+            binCount[axis][b]++;
+         }
+      }
+
+      for ( axis = 0; axis < 3; axis++ )
+      {
+         Bounds acc;
+         int    accCount = 0;
+
+         if ( scale[axis] == 0.0f )
+         {
+            continue;
+         }
+
+         // Sweep right to left, then left to right evaluating each boundary
+         BoundsEmpty ( &acc );
+
+         for ( b = numBins - 1; b > 0; b-- )
+         {
+            BoundsGrow ( &acc, &binBounds[axis][b] );
+            accCount += binCount[axis][b];
+            rightBounds[b] = acc;
+            rightCount[b] = accCount;
+         }
+
+         BoundsEmpty ( &acc );
+         accCount = 0;
+
+         for ( b = 1; b < numBins; b++ )
+         {
+            float cost;
+
+            BoundsGrow ( &acc, &binBounds[axis][b - 1] );
+            accCount += binCount[axis][b - 1];
+
+            if ( accCount == 0 || rightCount[b] == 0 )
+            {
+               continue;
+            }
+
+            cost = BoundsHalfArea ( &acc ) * accCount + BoundsHalfArea ( &rightBounds[b] ) * rightCount[b];
+
+            if ( cost < bestCost )
+            {
+               bestCost = cost;
+               bestAxis = axis;
+               bestBin = b;
+               *left = acc;
+               *right = rightBounds[b];
+            }
+         }
+      }
+   }
+
+   if ( bestAxis >= 0 )
+   {
+      // A leaf tests every triangle, a split adds one node test on top of its children
+      if ( count <= BVH_MAX_LEAF_SIZE && BoundsHalfArea ( bounds ) * count <= BoundsHalfArea ( bounds ) + bestCost )
+      {
+         return -1;
+      }
+
+      // Partition the range around the chosen boundary
+      {
+         int lo = first;
+         int hi = end - 1;
+
+         while ( lo <= hi )
+         {
+            b = ( int ) ( ( Centroid ( &ctx->prims[lo], bestAxis ) - centroidBounds.min[bestAxis] ) * scale[bestAxis] );
+
+            if ( b < bestBin )
+            {
+               lo++;
+            }
+            else
+            {
+               PrimRef prim = ctx->prims[lo];
+               ctx->prims[lo] = ctx->prims[hi];
+               ctx->prims[hi--] = prim;
+            }
+         }
+
+         return lo;
+      }
+   }
+
+   if ( count <= BVH_MAX_LEAF_SIZE )
+   {
+      return -1;
+   }
+
+   // No useful SAH split, halve the range along the widest centroid axis
+   axis = 0;
+
+   for ( i = 1; i < 3; i++ )
+   {
+      if ( centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis] )
+      {
+         axis = i;
+      }
+   }
+
+   mid = first + count / 2;
+
+   // Quickselect so that [first, mid) holds the smaller centroids
+   {
+      int lo = first;
+      int hi = end - 1;
+
+      while ( lo < hi )
+      {
+         float pivot = Centroid ( &ctx->prims[( lo + hi ) / 2], axis );
+         int   l = lo;
+         int   h = hi;
+
+         while ( l <= h )
+         {
+            while ( Centroid ( &ctx->prims[l], axis ) < pivot ) l++;
+            while ( Centroid ( &ctx->prims[h], axis ) > pivot ) h--;
+
+            if ( l <= h )
+            {
+               PrimRef prim = ctx->prims[l];
+               ctx->prims[l++] = ctx->prims[h];
+               ctx->prims[h--] = prim;
+            }
+         }
+
+         if ( mid <= h )
+         {
+            hi = h;
+         }
+         else if ( mid >= l )
+         {
+            lo = l;
+         }
+         else
+         {
+            break;
+         }
+      }
+   }
+
+   RangeBounds ( ctx, first, mid, left );
+   RangeBounds ( ctx, mid, end, right );
+
+   return mid;
+}
+
+///
+// BuildRange()
+//
+//    Build the subtree for one range with an explicit stack.  When
+//    deferTasks is set, ranges small enough to be built by one thread are
+//    queued in ctx->tasks instead of being split.  Returns GL_FALSE if the
+//    task queue could not be grown.
+//
+static GLboolean BuildRange ( BuildContext *ctx, BuildItem root, int deferTasks )
+{
+   BuildItem stack[2 * ( BVH_MAX_SAH_DEPTH + 32 )];
+   int       sp = 0;
+
+   stack[sp++] = root;
+
+   while ( sp > 0 )
+   {
+      BuildItem   item = stack[--sp];
+      Bounds      left;
+      Bounds      right;
+      int         split;
+      BinaryNode *node;
+
+      if ( deferTasks && item.end - item.first <= ctx->taskSize )
+      {
+         if ( ctx->numTasks == ctx->taskCapacity )
+         {
+            BuildItem *tasks = realloc ( ctx->tasks, sizeof ( BuildItem ) * ctx->taskCapacity * 2 );
+
+            if ( tasks == NULL )
+            {
+               return GL_FALSE;
+            }
+
+            ctx->tasks = tasks;
+            ctx->taskCapacity *= 2;
+         }
+
+         ctx->tasks[ctx->numTasks++] = item;
+         continue;
+      }
+
+      split = FindSplit ( ctx, item.first, item.end, item.depth, item.bounds, &left, &right );
+
+      if ( split < 0 )
+      {
+         *item.ref = BVH_LEAF_REF ( item.first, item.end - item.first );
+         continue;
+      }
+
+      node = &ctx->nodes[split - 1];
+      *item.ref = split - 1;
+
+      node->bounds[0] = left;
+      node->bounds[1] = right;
+
+      stack[sp].first = item.first;
+      stack[sp].end = split;
+      stack[sp].depth = item.depth + 1;
+      stack[sp].ref = &node->child[0];
+      stack[sp++].bounds = &node->bounds[0];
+
+      stack[sp].first = split;
+      stack[sp].end = item.end;
+      stack[sp].depth = item.depth + 1;
+      stack[sp].ref = &node->child[1];
+      stack[sp++].bounds = &node->bounds[1];
+   }
+
+   return GL_TRUE;
+}
+
+static void ESCALLBACK BuildTasks ( void *userData, int begin, int end )
+{
+   BuildContext *ctx = userData;
+   int           i;
+
+   for ( i = begin; i < end; i++ )
+   {
+      BuildRange ( ctx, ctx->tasks[i], GL_FALSE );
+   }
+}
+
+///
+// Collapse()
+//
+//    Emit the four wide node for binary node ref by repeatedly opening
+//    the interior child with the largest surface area, then recurse.
+//    The node index is returned in nodeIndex.  Returns GL_FALSE if the
+//    node array could not be grown.
+//
+static GLboolean Collapse ( ESBvh *bvh, const BinaryNode *binary, int ref, int *nodeIndex )
+{
+   Bounds bounds[4];
+   int    refs[4];
+   int    count = 2;
+   int    index;
+   int    i;
+   int    axis;
+
+   if ( bvh->numNodes == bvh->nodeCapacity )
+   {
+      Bvh4Node *nodes = realloc ( bvh->nodes, sizeof ( Bvh4Node ) * bvh->nodeCapacity * 2 );
+
+      if ( nodes == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      bvh->nodes = nodes;
+      bvh->nodeCapacity *= 2;
+   }
+
+   index = bvh->numNodes++;
+
+   bounds[0] = binary[ref].bounds[0];
+   bounds[1] = binary[ref].bounds[1];
+   refs[0] = binary[ref].child[0];
+   refs[1] = binary[ref].child[1];
+
+   while ( count < 4 )
+   {
+      int   open = -1;
+      float area = -1.0f;
+
+      for ( i = 0; i < count; i++ )
+      {
+         if ( refs[i] >= 0 && BoundsHalfArea ( &bounds[i] ) > area )
+         {
+            area = BoundsHalfArea ( &bounds[i] );
+            open = i;
+         }
+      }
+
+      if ( open < 0 )
+      {
+         break;
+      }
+
+      bounds[count] = binary[refs[open]].bounds[1];
+      refs[count] = binary[refs[open]].child[1];
+      bounds[open] = binary[refs[open]].bounds[0];
+      refs[open] = binary[refs[open]].child[0];
+      count++;
+   }
+
+   for ( i = 0; i < 4; i++ )
+   {
+      int child = -1;
+
+      if ( i < count )
+      {
+         child = refs[i];
+
+         if ( child >= 0 && !Collapse ( bvh, binary, child, &child ) )
+         {
+            return GL_FALSE;
+         }
+      }
+      else
+      {
+         BoundsEmpty ( &bounds[i] );
+      }
+
+      for ( axis = 0; axis < 3; axis++ )
+      {
+         bvh->nodes[index].min[axis][i] = bounds[i].min[axis];
+         bvh->nodes[index].max[axis][i] = bounds[i].max[axis];
+      }
+
+      bvh->nodes[index].child[i] = child;
+   }
+
+   bvh->nodes[index].numChildren = count;
+
+   *nodeIndex = index;
+   return GL_TRUE;
+}
+
+///
+// IntersectLeaf()
+//
+//    Moller-Trumbore against each triangle of a leaf
+//
+static void IntersectLeaf ( const ESBvh *bvh, int ref, const GLfloat *origin, const GLfloat *dir, ESRayHit *hit )
+{
+   int first = BVH_LEAF_FIRST ( ref );
+   int end = first + BVH_LEAF_COUNT ( ref );
+   int i;
+
+   for ( i = first; i < end; i++ )
+   {
+      const float *tri = &bvh->triangles[9 * i];
+      const float *e1 = tri + 3;
+      const float *e2 = tri + 6;
+      float p[3], s[3], q[3];
+      float det, inv, u, v, t;
+
+      p[0] = dir[1] * e2[2] - dir[2] * e2[1];
+      p[1] = dir[2] * e2[0] - dir[0] * e2[2];
+      p[2] = dir[0] * e2[1] - dir[1] * e2[0];
+      det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+
+      if ( det == 0.0f )
+      {
+         continue;
+      }
+
+      inv = 1.0f / det;
+      s[0] = origin[0] - tri[0];
+      s[1] = origin[1] - tri[1];
+      s[2] = origin[2] - tri[2];
+      u = ( s[0] * p[0] + s[1] * p[1] + s[2] * p[2] ) * inv;
+
+      if ( u < 0.0f || u > 1.0f )
+      {
+         continue;
+      }
+
+      q[0] = s[1] * e1[2] - s[2] * e1[1];
+      q[1] = s[2] * e1[0] - s[0] * e1[2];
+      q[2] = s[0] * e1[1] - s[1] * e1[0];
+      v = ( dir[0] * q[0] + dir[1] * q[1] + dir[2] * q[2] ) * inv;
+
+      if ( v < 0.0f || u + v > 1.0f )
+      {
+         continue;
+      }
+
+      t = ( e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2] ) * inv;
+
+      if ( t >= 0.0f && t < hit->t )
+      {
+         hit->t = t;
+         hit->u = u;
+         hit->v = v;
+         hit->triangle = bvh->triangleIds[i];
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateBvh()
+//
+ESBvh *ESUTIL_API esCreateBvh ( const GLfloat *positions, const GLuint *indices, int numTriangles )
+{
+   BuildContext ctx;
+   ESBvh       *bvh = calloc ( 1, sizeof ( ESBvh ) );
+   int          rootRef = 0;
+   BuildItem    root;
+   GLboolean    built;
+   int          i;
+   int          k;
+
+   if ( bvh == NULL || numTriangles <= 0 || numTriangles >= ( 1 << 27 ) )
+   {
+      free ( bvh );
+      return NULL;
+   }
+
+   memset ( &ctx, 0, sizeof ( ctx ) );
+   ctx.numTriangles = numTriangles;
+   ctx.positions = positions;
+   ctx.indices = indices;
+   ctx.prims = malloc ( sizeof ( PrimRef ) * numTriangles );
+   ctx.nodes = malloc ( sizeof ( BinaryNode ) * numTriangles );
+
+   // Enough tasks to keep every core busy even when their sizes vary
+   ctx.taskSize = numTriangles / ( 4 * esGetNumCores () );
+   ctx.taskSize = ctx.taskSize < BVH_MIN_TASK_SIZE ? BVH_MIN_TASK_SIZE : ctx.taskSize;
+   ctx.taskCapacity = 64;
+   ctx.tasks = malloc ( sizeof ( BuildItem ) * ctx.taskCapacity );
+
+   bvh->nodeCapacity = numTriangles / 4 + 1;
+   bvh->nodes = malloc ( sizeof ( Bvh4Node ) * bvh->nodeCapacity );
+   bvh->triangles = malloc ( sizeof ( float ) * 9 * numTriangles );
+   bvh->triangleIds = malloc ( sizeof ( int ) * numTriangles );
+
+   if ( ctx.prims == NULL || ctx.nodes == NULL ||
+        ctx.tasks == NULL || bvh->nodes == NULL || bvh->triangles == NULL || bvh->triangleIds == NULL )
+   {
+      free ( ctx.prims );
+      free ( ctx.nodes );
+      free ( ctx.tasks );
+      esDeleteBvh ( bvh );
+      return NULL;
+   }
+
+   esParallelFor ( numTriangles, BVH_MIN_TASK_SIZE, PrepareTriangles, &ctx );
+
+   RangeBounds ( &ctx, 0, numTriangles, &bvh->rootBounds );
+
+   // Split the top of the tree on this thread, then build the queued
+   // subtrees in parallel
+   root.first = 0;
+   root.end = numTriangles;
+   root.depth = 0;
+   root.ref = &rootRef;
+   root.bounds = &bvh->rootBounds;
+
+   if ( numTriangles > ctx.taskSize )
+   {
+      built = BuildRange ( &ctx, root, GL_TRUE );
+
+      if ( built )
+      {
+         esParallelFor ( ctx.numTasks, 1, BuildTasks, &ctx );
+      }
+   }
+   else
+   {
+      built = BuildRange ( &ctx, root, GL_FALSE );
+   }
+
+   bvh->rootRef = rootRef;
+
+   if ( built && rootRef >= 0 )
+   {
+      built = Collapse ( bvh, ctx.nodes, rootRef, &bvh->rootRef );
+   }
+
+   if ( !built )
+   {
+      free ( ctx.prims );
+      free ( ctx.nodes );
+      free ( ctx.tasks );
+      esDeleteBvh ( bvh );
+      return NULL;
+   }
+
+   // Store the triangles in leaf order for the intersection tests
+   for ( i = 0; i < numTriangles; i++ )
+   {
+      int            t = ctx.prims[i].triangle;
+      const GLfloat *v0 = &positions[3 * indices[3 * t]];
+      const GLfloat *v1 = &positions[3 * indices[3 * t + 1]];
+      const GLfloat *v2 = &positions[3 * indices[3 * t + 2]];
+
+      for ( k = 0; k < 3; k++ )
+      {
+         bvh->triangles[9 * i + k] = v0[k];
+         bvh->triangles[9 * i + 3 + k] = v1[k] - v0[k];
+         bvh->triangles[9 * i + 6 + k] = v2[k] - v0[k];
+      }
+
+      bvh->triangleIds[i] = t;
+   }
+
+   free ( ctx.prims );
+   free ( ctx.nodes );
+   free ( ctx.tasks );
+
+   return bvh;
+}
+
+///
+// esBvhIntersect()
+//
+//    Closest-first traversal.  Each node's four boxes are slab tested at
+//    once, hit children are pushed farthest first so the nearest is
+//    visited next, and entries farther than the current hit are skipped
+//    when they are popped.
+//
+GLboolean ESUTIL_API esBvhIntersect ( const ESBvh *bvh, const GLfloat origin[3], const GLfloat direction[3],
+                                      GLfloat maxDistance, ESRayHit *hit )
+{
+   int   stackRef[BVH_STACK_SIZE];
+   float stackDist[BVH_STACK_SIZE];
+   float invDir[3];
+   int   sp = 0;
+   int   i;
+
+   hit->t = maxDistance;
+   hit->u = 0.0f;
+   hit->v = 0.0f;
+   hit->triangle = -1;
+
+   for ( i = 0; i < 3; i++ )
+   {
+      // Avoid 0 * inf in the slab test for axis aligned rays
+      float d = fabsf ( direction[i] ) > 1e-30f ? direction[i] : ( direction[i] < 0.0f ? -1e-30f : 1e-30f );
+      invDir[i] = 1.0f / d;
+   }
+
+   if ( bvh->rootRef < 0 )
+   {
+      IntersectLeaf ( bvh, bvh->rootRef, origin, direction, hit );
+      return hit->triangle >= 0;
+   }
+
+   stackRef[sp] = bvh->rootRef;
+   stackDist[sp++] = 0.0f;
+
+   while ( sp > 0 )
+   {
+      const Bvh4Node *node;
+      float           tNear[4];
+      int             hitMask;
+      int             order[4];
+      int             numHits = 0;
+      int             ref;
+
+      sp--;
+
+      if ( stackDist[sp] > hit->t )
+      {
+         continue;
+      }
+
+      ref = stackRef[sp];
+
+      if ( ref < 0 )
+      {
+         IntersectLeaf ( bvh, ref, origin, direction, hit );
+         continue;
+      }
+
+      node = &bvh->nodes[ref];
+
+#ifdef ES_BVH_SSE
+      {
+         __m128 tMin = _mm_setzero_ps ();
+         __m128 tMax = _mm_set1_ps ( hit->t );
+         int    axis;
+
+         for ( axis = 0; axis < 3; axis++ )
+         {
+            __m128 o = _mm_set1_ps ( origin[axis] );
+            __m128 inv = _mm_set1_ps ( invDir[axis] );
+            __m128 t0 = _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( node->min[axis] ), o ), inv );
+            __m128 t1 = _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( node->max[axis] ), o ), inv );
+
+            tMin = _mm_max_ps ( tMin, _mm_min_ps ( t0, t1 ) );
+            tMax = _mm_min_ps ( tMax, _mm_max_ps ( t0, t1 ) );
+         }
+
+         hitMask = _mm_movemask_ps ( _mm_cmple_ps ( tMin, tMax ) ) & ( ( 1 << node->numChildren ) - 1 );
+         _mm_storeu_ps ( tNear, tMin );
+      }
+#else
+      {
+         int lane;
+         int axis;
+
+         hitMask = 0;
+
+         for ( lane = 0; lane < node->numChildren; lane++ )
+         {
+            float tMin = 0.0f;
+            float tMax = hit->t;
+
+            for ( axis = 0; axis < 3; axis++ )
+            {
+               float t0 = ( node->min[axis][lane] - origin[axis] ) * invDir[axis];
+               float t1 = ( node->max[axis][lane] - origin[axis] ) * invDir[axis];
+
+               tMin = ( t0 < t1 ? t0 : t1 ) > tMin ? ( t0 < t1 ? t0 : t1 ) : tMin;
+               tMax = ( t0 > t1 ? t0 : t1 ) < tMax ? ( t0 > t1 ? t0 : t1 ) : tMax;
+            }
+
+            hitMask |= ( tMin <= tMax ) << lane;
+            tNear[lane] = tMin;
+         }
+      }
+#endif
+
+      // Sort the hit children by entry distance, farthest first
+      for ( i = 0; i < 4; i++ )
+      {
+         if ( hitMask & ( 1 << i ) )
+         {
+            int j = numHits++;
+
+            while ( j > 0 && tNear[order[j - 1]] < tNear[i] )
+            {
+               order[j] = order[j - 1];
+               j--;
+            }
+
+            order[j] = i;
+         }
+      }
+
+      for ( i = 0; i < numHits; i++ )
+      {
+         stackRef[sp] = node->child[order[i]];
+         stackDist[sp++] = tNear[order[i]];
+      }
+   }
+
+   return hit->triangle >= 0;
+}
+
+///
+// esDeleteBvh()
+//
+void ESUTIL_API esDeleteBvh ( ESBvh *bvh )
+{
+   if ( bvh != NULL )
+   {
+      free ( bvh->nodes );
+      free ( bvh->triangles );
+      free ( bvh->triangleIds );
+      free ( bvh );
+   }
+}
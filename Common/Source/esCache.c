@@ -0,0 +1,276 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESCache.c
+//
+//    Content-addressed disk cache.  Results of expensive processing are
+//    stored in files named after what produced them and a 64-bit hash of
+//    the inputs they depend on, so a changed input simply misses.  The
+//    hash cannot see the producer's code: producers put a version number
+//    in their inputs and increment it when their output changes.  Each
+//    file starts with a short header; the payload follows at a 32 byte
+//    offset and is used straight from the mapped file.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined ( _WIN32 )
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+///
+// Macros
+//
+#define CACHE_MAGIC          0x41435345u   // "ESCA"
+#define CACHE_HEADER_SIZE    32
+#define MAX_PATH_LENGTH      1024
+
+///
+// Types
+//
+
+// CACHE_HEADER_SIZE bytes, with no padding
+typedef struct
+{
+   GLuint   magic;
+   GLuint   headerSize;
+   GLuint64 key;
+   GLuint64 size;
+   GLuint64 reserved;
+} CacheHeader;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// CachePath()
+//
+static GLboolean CachePath ( char *path, const char *cacheDir, const char *name, GLuint64 key, const char *suffix )
+{
+   int length = snprintf ( path, MAX_PATH_LENGTH, "%s/%s-%08x%08x%s", cacheDir, name,
+                           ( unsigned int ) ( key >> 32 ), ( unsigned int ) key, suffix );
+
+   return length > 0 && length < MAX_PATH_LENGTH;
+}
+
+///
+// CreateCacheDir()
+//
+//    Create the cache directory on first use.  Only the last component is
+//    created, its parent must exist.
+//
+static GLboolean CreateCacheDir ( const char *cacheDir )
+{
+#if defined ( _WIN32 )
+   int result = _mkdir ( cacheDir );
+#else
+   int result = mkdir ( cacheDir, 0755 );
+#endif
+
+   if ( result != 0 && errno != EEXIST )
+   {
+      esLogMessage ( "esCacheStore: cannot create %s\n", cacheDir );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esHash64()
+//
+GLuint64 ESUTIL_API esHash64 ( GLuint64 hash, const void *data, size_t size )
+{
+   const GLubyte *bytes = ( const GLubyte * ) data;
+
+   // Eight bytes at a time, then FNV-1a over the rest
+   for ( ; size >= 8; size -= 8, bytes += 8 )
+   {
+      GLuint64 word;
+
+      memcpy ( &word, bytes, 8 );
+      hash = ( hash ^ word ) * 0x9e3779b97f4a7c15ull;
+      hash ^= hash >> 32;
+   }
+
+   for ( ; size > 0; size--, bytes++ )
+   {
+      hash = ( hash ^ *bytes ) * 0x100000001b3ull;
+   }
+
+   return hash;
+}
+
+///
+// esCacheLoad()
+//
+const void *ESUTIL_API esCacheLoad ( const char *cacheDir, const char *name, GLuint64 key,
+                                     ESFileMapping *mapping, size_t *size )
+{
+   char        path[MAX_PATH_LENGTH];
+   CacheHeader header;
+
+   memset ( mapping, 0, sizeof ( ESFileMapping ) );
+
+   if ( cacheDir == NULL || !CachePath ( path, cacheDir, name, key, ".bin" ) ||
+        !esMapFile ( NULL, path, mapping ) )
+   {
+      return NULL;
+   }
+
+   if ( mapping->size >= CACHE_HEADER_SIZE )
+   {
+      memcpy ( &header, mapping->data, sizeof ( CacheHeader ) );
+
+      // A file cut short by a crash is ignored and written again
+      if ( header.magic == CACHE_MAGIC && header.headerSize == CACHE_HEADER_SIZE && header.key == key &&
+           header.size == ( GLuint64 ) ( mapping->size - CACHE_HEADER_SIZE ) )
+      {
+         *size = ( size_t ) header.size;
+         return ( const GLubyte * ) mapping->data + CACHE_HEADER_SIZE;
+      }
+   }
+
+   esUnmapFile ( mapping );
+   return NULL;
+}
+
+///
+// esCacheStore()
+//
+GLboolean ESUTIL_API esCacheStore ( const char *cacheDir, const char *name, GLuint64 key,
+                                    const void *data, size_t size )
+{
+   char        path[MAX_PATH_LENGTH];
+   char        tempPath[MAX_PATH_LENGTH];
+   CacheHeader header;
+   FILE       *fp;
+   GLboolean   written;
+
+   if ( cacheDir == NULL || !CachePath ( path, cacheDir, name, key, ".bin" ) ||
+        !CachePath ( tempPath, cacheDir, name, key, ".tmp" ) ||
+        !CreateCacheDir ( cacheDir ) )
+   {
+      return GL_FALSE;
+   }
+
+   fp = fopen ( tempPath, "wb" );
+
+   if ( fp == NULL )
+   {
+      esLogMessage ( "esCacheStore: cannot write %s\n", tempPath );
+      return GL_FALSE;
+   }
+
+   memset ( &header, 0, sizeof ( CacheHeader ) );
+   header.magic = CACHE_MAGIC;
+   header.headerSize = CACHE_HEADER_SIZE;
+   header.key = key;
+   header.size = size;
+
+   written = fwrite ( &header, 1, sizeof ( CacheHeader ), fp ) == sizeof ( CacheHeader ) &&
+             fwrite ( data, 1, size, fp ) == size;
+   written = fclose ( fp ) == 0 && written;
+
+   // Readers only ever see complete files
+#ifdef _WIN32
+   remove ( path );
+#endif
+
+   if ( !written || rename ( tempPath, path ) != 0 )
+   {
+      remove ( tempPath );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+///
+// esCacheGenerate()
+//
+const void *ESUTIL_API esCacheGenerate ( const char *cacheDir, const char *name, const void *params, size_t paramsSize,
+                                         size_t size, ESGenerateFunc generate, void *userData,
+                                         ESFileMapping *mapping )
+{
+   GLuint64    size64 = size;
+   GLuint64    key = esHash64 ( esHash64 ( ES_HASH_SEED, &size64, sizeof ( size64 ) ), params, paramsSize );
+   size_t      cachedSize;
+   const void *data = esCacheLoad ( cacheDir, name, key, mapping, &cachedSize );
+
+   if ( data != NULL )
+   {
+      if ( cachedSize == size )
+      {
+         return data;
+      }
+
+      esUnmapFile ( mapping );
+   }
+
+   // Generated data is released with esUnmapFile like a heap copy of a file
+   mapping->buffer = malloc ( size > 0 ? size : 1 );
+
+   if ( mapping->buffer == NULL )
+   {
+      return NULL;
+   }
+
+   mapping->data = mapping->buffer;
+   mapping->size = ( int ) size;
+
+   if ( !generate ( userData, mapping->buffer, size ) )
+   {
+      esUnmapFile ( mapping );
+      return NULL;
+   }
+
+   esCacheStore ( cacheDir, name, key, mapping->buffer, size );
+   return mapping->buffer;
+}
@@ -0,0 +1,1102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESCubemap.c
+//
+//    Builds image based lighting cubemaps from an environment image:
+//    a specular cubemap whose levels are prefiltered with the GGX
+//    distribution for increasing roughness, and a small irradiance
+//    cubemap for diffuse lighting.
+//
+//    The environment is first resampled into a linear radiance cubemap
+//    and box filtered down to 1x1.  Each specular texel then integrates
+//    GGX importance samples around its direction, reading each sample
+//    from the radiance level whose texels cover the sample's solid angle
+//    (filtered importance sampling), which keeps the sample count low.
+//    Irradiance is evaluated from the order 2 spherical harmonics of the
+//    radiance.  Both are computed in parallel over the rows of the faces.
+//
+//    The results are stored as half floats in the disk cache, keyed by a
+//    hash of the source image and the parameters, and later runs upload
+//    them straight from the cache file.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+///
+// Macros
+//
+#define MAX_SPECULAR_LEVELS   6
+#define SPECULAR_SAMPLES      128
+#define IRRADIANCE_SIZE       32
+#define CACHE_VERSION         1
+
+#define PI                    3.14159265358979f
+
+///
+// Types
+//
+
+// Six faces of RGB floats, +X, -X, +Y, -Y, +Z, -Z
+typedef struct
+{
+   int      size;
+   GLfloat *texels;
+} CubeLevel;
+
+// GGX sample in the frame of the reflected direction
+typedef struct
+{
+   GLfloat x[SPECULAR_SAMPLES];
+   GLfloat y[SPECULAR_SAMPLES];
+   GLfloat z[SPECULAR_SAMPLES];
+   GLfloat lod[SPECULAR_SAMPLES];
+   int     count;
+} SampleSet;
+
+typedef struct
+{
+   const GLubyte *pixels;
+   int            width;
+   int            height;
+   int            components;
+   int            layout;
+   const GLfloat *srgbToLinear;
+
+   // Source faces converted to floats, for ES_CUBEMAP_FACES
+   CubeLevel      source;
+
+   CubeLevel     *radiance;
+   int            numRadianceLevels;
+
+   CubeLevel     *dest;
+   const SampleSet *samples;
+
+   GLfloat        sh[6][9][3];
+   GLfloat        shWeight[6];
+   int            shLevel;
+} FilterJob;
+
+typedef struct
+{
+   GLuint version;
+   GLuint faceSize;
+   GLuint numLevels;
+   GLuint irradianceSize;
+} CubemapHeader;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// FaceDirection()
+//
+//    Direction through a point of a face, s and t in [-1, 1], following
+//    the cube map face selection of the OpenGL ES specification
+//
+static void FaceDirection ( int face, GLfloat s, GLfloat t, GLfloat dir[3] )
+{
+   GLfloat length;
+
+   switch ( face )
+   {
+      case 0:  dir[0] =  1.0f; dir[1] = -t;    dir[2] = -s;    break;
+      case 1:  dir[0] = -1.0f; dir[1] = -t;    dir[2] =  s;    break;
+      case 2:  dir[0] =  s;    dir[1] =  1.0f; dir[2] =  t;    break;
+      case 3:  dir[0] =  s;    dir[1] = -1.0f; dir[2] = -t;    break;
+      case 4:  dir[0] =  s;    dir[1] = -t;    dir[2] =  1.0f; break;
+      default: dir[0] = -s;    dir[1] = -t;    dir[2] = -1.0f; break;
+   }
+
+   length = sqrtf ( dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2] );
+   dir[0] /= length;
+   dir[1] /= length;
+   dir[2] /= length;
+}
+
+#ifdef USE_SSE2
+///
+// Select()
+//
+static __m128 Select ( __m128 mask, __m128 a, __m128 b )
+{
+   return _mm_or_ps ( _mm_and_ps ( mask, a ), _mm_andnot_ps ( mask, b ) );
+}
+#endif
+
+///
+// ProjectToCube()
+//
+//    Face and [0, 1] face coordinates of directions
+//
+static void ProjectToCube ( const GLfloat *x, const GLfloat *y, const GLfloat *z, int count,
+                            int *face, GLfloat *s, GLfloat *t )
+{
+   int i = 0;
+
+#ifdef USE_SSE2
+   const __m128 signMask = _mm_castsi128_ps ( _mm_set1_epi32 ( 0x7fffffff ) );
+   const __m128 half = _mm_set1_ps ( 0.5f );
+   const __m128 zero = _mm_setzero_ps ();
+
+   for ( ; i + 4 <= count; i += 4 )
+   {
+      __m128 vx = _mm_loadu_ps ( x + i );
+      __m128 vy = _mm_loadu_ps ( y + i );
+      __m128 vz = _mm_loadu_ps ( z + i );
+      __m128 ax = _mm_and_ps ( vx, signMask );
+      __m128 ay = _mm_and_ps ( vy, signMask );
+      __m128 az = _mm_and_ps ( vz, signMask );
+
+      // Major axis masks, X winning ties over Y and Z, Y over Z
+      __m128 isX = _mm_and_ps ( _mm_cmpge_ps ( ax, ay ), _mm_cmpge_ps ( ax, az ) );
+      __m128 isY = _mm_cmpge_ps ( ay, az );
+      __m128 negX = _mm_cmplt_ps ( vx, zero );
+      __m128 negY = _mm_cmplt_ps ( vy, zero );
+      __m128 negZ = _mm_cmplt_ps ( vz, zero );
+      __m128 ma, sc, tc, faceIndex;
+
+      ma = Select ( isX, ax, Select ( isY, ay, az ) );
+      sc = Select ( isX, Select ( negX, vz, _mm_sub_ps ( zero, vz ) ),
+                    Select ( isY, vx, Select ( negZ, _mm_sub_ps ( zero, vx ), vx ) ) );
+      tc = Select ( isY, Select ( negY, _mm_sub_ps ( zero, vz ), vz ), _mm_sub_ps ( zero, vy ) );
+      tc = Select ( isX, _mm_sub_ps ( zero, vy ), tc );
+      faceIndex = Select ( isX, Select ( negX, _mm_set1_ps ( 1.0f ), zero ),
+                           Select ( isY, Select ( negY, _mm_set1_ps ( 3.0f ), _mm_set1_ps ( 2.0f ) ),
+                                    Select ( negZ, _mm_set1_ps ( 5.0f ), _mm_set1_ps ( 4.0f ) ) ) );
+
+      ma = _mm_div_ps ( half, ma );
+      _mm_storeu_ps ( s + i, _mm_add_ps ( _mm_mul_ps ( sc, ma ), half ) );
+      _mm_storeu_ps ( t + i, _mm_add_ps ( _mm_mul_ps ( tc, ma ), half ) );
+      _mm_storeu_si128 ( ( __m128i * ) ( face + i ), _mm_cvttps_epi32 ( faceIndex ) );
+   }
+#endif
+
+   for ( ; i < count; i++ )
+   {
+      GLfloat ax = fabsf ( x[i] ), ay = fabsf ( y[i] ), az = fabsf ( z[i] );
+      GLfloat ma, sc, tc;
+
+      if ( ax >= ay && ax >= az )
+      {
+         face[i] = x[i] < 0.0f ? 1 : 0;
+         ma = ax;
+         sc = x[i] < 0.0f ? z[i] : -z[i];
+         tc = -y[i];
+      }
+      else if ( ay >= az )
+      {
+         face[i] = y[i] < 0.0f ? 3 : 2;
+         ma = ay;
+         sc = x[i];
+         tc = y[i] < 0.0f ? -z[i] : z[i];
+      }
+      else
+      {
+         face[i] = z[i] < 0.0f ? 5 : 4;
+         ma = az;
+         sc = z[i] < 0.0f ? -x[i] : x[i];
+         tc = -y[i];
+      }
+
+      s[i] = 0.5f * sc / ma + 0.5f;
+      t[i] = 0.5f * tc / ma + 0.5f;
+   }
+}
+
+///
+// FetchFace()
+//
+//    Bilinear lookup in a face of a cube level, clamped to the face
+//
+static void FetchFace ( const CubeLevel *level, int face, GLfloat s, GLfloat t, GLfloat weight, GLfloat rgb[3] )
+{
+   int            size = level->size;
+   const GLfloat *texels = level->texels + ( size_t ) face * size * size * 3;
+   GLfloat        u = s * size - 0.5f;
+   GLfloat        v = t * size - 0.5f;
+   int            x0, y0, x1, y1, c;
+   GLfloat        fx, fy;
+
+   u = u < 0.0f ? 0.0f : ( u > size - 1 ? ( GLfloat ) ( size - 1 ) : u );
+   v = v < 0.0f ? 0.0f : ( v > size - 1 ? ( GLfloat ) ( size - 1 ) : v );
+   x0 = ( int ) u;
+   y0 = ( int ) v;
+   x1 = x0 + 1 < size ? x0 + 1 : x0;
+   y1 = y0 + 1 < size ? y0 + 1 : y0;
+   fx = u - x0;
+   fy = v - y0;
+
+   for ( c = 0; c < 3; c++ )
+   {
+      GLfloat top = texels[( y0 * size + x0 ) * 3 + c] + ( texels[( y0 * size + x1 ) * 3 + c] - texels[( y0 * size + x0 ) * 3 + c] ) * fx;
+      GLfloat bottom = texels[( y1 * size + x0 ) * 3 + c] + ( texels[( y1 * size + x1 ) * 3 + c] - texels[( y1 * size + x0 ) * 3 + c] ) * fx;
+
+      rgb[c] += weight * ( top + ( bottom - top ) * fy );
+   }
+}
+
+///
+// FetchEquirect()
+//
+//    Bilinear lookup in an equirectangular image: longitude across,
+//    starting behind -Z, and the +Y pole on the first row
+//
+static void FetchEquirect ( const FilterJob *job, const GLfloat dir[3], GLfloat rgb[3] )
+{
+   const GLubyte *pixels = job->pixels;
+   int            width = job->width;
+   int            height = job->height;
+   int            components = job->components;
+   GLfloat        u = ( 0.5f + atan2f ( dir[0], -dir[2] ) / ( 2.0f * PI ) ) * width - 0.5f;
+   GLfloat        v = acosf ( dir[1] < -1.0f ? -1.0f : ( dir[1] > 1.0f ? 1.0f : dir[1] ) ) / PI * height - 0.5f;
+   int            x0, y0, x1, y1, c;
+   GLfloat        fx, fy;
+
+   v = v < 0.0f ? 0.0f : ( v > height - 1 ? ( GLfloat ) ( height - 1 ) : v );
+   x0 = ( int ) floorf ( u );
+   y0 = ( int ) v;
+   fx = u - x0;
+   fy = v - y0;
+   x0 = ( x0 % width + width ) % width;
+   x1 = ( x0 + 1 ) % width;
+   y1 = y0 + 1 < height ? y0 + 1 : y0;
+
+   for ( c = 0; c < 3; c++ )
+   {
+      int     channel = components < 3 ? 0 : c;
+      GLfloat p00 = job->srgbToLinear[pixels[( ( size_t ) y0 * width + x0 ) * components + channel]];
+      GLfloat p10 = job->srgbToLinear[pixels[( ( size_t ) y0 * width + x1 ) * components + channel]];
+      GLfloat p01 = job->srgbToLinear[pixels[( ( size_t ) y1 * width + x0 ) * components + channel]];
+      GLfloat p11 = job->srgbToLinear[pixels[( ( size_t ) y1 * width + x1 ) * components + channel]];
+      GLfloat top = p00 + ( p10 - p00 ) * fx;
+      GLfloat bottom = p01 + ( p11 - p01 ) * fx;
+
+      rgb[c] = top + ( bottom - top ) * fy;
+   }
+}
+
+///
+// ConvertSource()
+//
+//    Convert rows of the source faces to linear floats
+//
+static void ESCALLBACK ConvertSource ( void *userData, int begin, int end )
+{
+   FilterJob *job = userData;
+   int        components = job->components;
+   int        row, x, c;
+
+   for ( row = begin; row < end; row++ )
+   {
+      const GLubyte *src = job->pixels + ( size_t ) row * job->width * components;
+      GLfloat       *dst = job->source.texels + ( size_t ) row * job->width * 3;
+
+      for ( x = 0; x < job->width; x++ )
+      {
+         for ( c = 0; c < 3; c++ )
+         {
+            dst[x * 3 + c] = job->srgbToLinear[src[x * components + ( components < 3 ? 0 : c )]];
+         }
+      }
+   }
+}
+
+///
+// Resample()
+//
+//    Build rows of the base radiance level from the source image
+//
+static void ESCALLBACK Resample ( void *userData, int begin, int end )
+{
+   FilterJob *job = userData;
+   CubeLevel *level = &job->radiance[0];
+   int        size = level->size;
+   int        row, x;
+
+   for ( row = begin; row < end; row++ )
+   {
+      int      face = row / size;
+      int      y = row % size;
+      GLfloat *dst = level->texels + ( size_t ) row * size * 3;
+
+      for ( x = 0; x < size; x++ )
+      {
+         GLfloat dir[3];
+
+         FaceDirection ( face, ( 2.0f * x + 1.0f ) / size - 1.0f, ( 2.0f * y + 1.0f ) / size - 1.0f, dir );
+
+         if ( job->layout == ES_CUBEMAP_EQUIRECT )
+         {
+            FetchEquirect ( job, dir, &dst[x * 3] );
+         }
+         else
+         {
+            int     srcFace;
+            GLfloat s, t;
+
+            dst[x * 3] = dst[x * 3 + 1] = dst[x * 3 + 2] = 0.0f;
+            ProjectToCube ( &dir[0], &dir[1], &dir[2], 1, &srcFace, &s, &t );
+            FetchFace ( &job->source, srcFace, s, t, 1.0f, &dst[x * 3] );
+         }
+      }
+   }
+}
+
+///
+// Downsample()
+//
+//    Average 2x2 blocks of a radiance level into the next one
+//
+static void Downsample ( const CubeLevel *src, CubeLevel *dst )
+{
+   int    size = dst->size;
+   size_t srcPitch = ( size_t ) src->size * 3;
+   int    face, x, y, c;
+
+   for ( face = 0; face < 6; face++ )
+   {
+      const GLfloat *srcFace = src->texels + ( size_t ) face * src->size * src->size * 3;
+      GLfloat       *dstFace = dst->texels + ( size_t ) face * size * size * 3;
+
+      for ( y = 0; y < size; y++ )
+      {
+         for ( x = 0; x < size; x++ )
+         {
+            const GLfloat *p = srcFace + ( size_t ) y * 2 * srcPitch + x * 2 * 3;
+
+            for ( c = 0; c < 3; c++ )
+            {
+               dstFace[( y * size + x ) * 3 + c] = 0.25f * ( p[c] + p[3 + c] + p[srcPitch + c] + p[srcPitch + 3 + c] );
+            }
+         }
+      }
+   }
+}
+
+///
+// RadicalInverse()
+//
+static GLfloat RadicalInverse ( GLuint bits )
+{
+   bits = ( bits << 16 ) | ( bits >> 16 );
+   bits = ( ( bits & 0x55555555u ) << 1 ) | ( ( bits & 0xaaaaaaaau ) >> 1 );
+   bits = ( ( bits & 0x33333333u ) << 2 ) | ( ( bits & 0xccccccccu ) >> 2 );
+   bits = ( ( bits & 0x0f0f0f0fu ) << 4 ) | ( ( bits & 0xf0f0f0f0u ) >> 4 );
+   bits = ( ( bits & 0x00ff00ffu ) << 8 ) | ( ( bits & 0xff00ff00u ) >> 8 );
+   return bits * 2.3283064365386963e-10f;
+}
+
+///
+// BuildSamples()
+//
+//    GGX importance samples of the light direction for a roughness, with
+//    the view and normal along z.  Each sample is read from the radiance
+//    level whose texels have the solid angle the sample stands for.
+//
+static void BuildSamples ( GLfloat roughness, int baseSize, int numRadianceLevels, SampleSet *samples )
+{
+   GLfloat alpha = roughness * roughness;
+   GLfloat alpha2 = alpha * alpha;
+   GLfloat texelSolidAngle = 4.0f * PI / ( 6.0f * baseSize * baseSize );
+   int     i;
+
+   samples->count = 0;
+
+   for ( i = 0; i < SPECULAR_SAMPLES; i++ )
+   {
+      GLfloat phi = 2.0f * PI * ( i + 0.5f ) / SPECULAR_SAMPLES;
+      GLfloat xi = RadicalInverse ( i );
+      GLfloat cosTheta = sqrtf ( ( 1.0f - xi ) / ( 1.0f + ( alpha2 - 1.0f ) * xi ) );
+      GLfloat sinTheta = sqrtf ( 1.0f - cosTheta * cosTheta );
+      GLfloat lz = 2.0f * cosTheta * cosTheta - 1.0f;
+      GLfloat d, pdf, sampleSolidAngle, lod;
+      int     n = samples->count;
+
+      if ( lz <= 0.0f )
+      {
+         continue;
+      }
+
+      // pdf of the light direction is D(h) (n.h) / (4 v.h), and n = v
+      d = ( cosTheta * cosTheta * ( alpha2 - 1.0f ) + 1.0f );
+      d = alpha2 / ( PI * d * d );
+      pdf = d * 0.25f;
+      sampleSolidAngle = 1.0f / ( SPECULAR_SAMPLES * pdf );
+      lod = 0.5f * log2f ( sampleSolidAngle / texelSolidAngle ) + 1.0f;
+
+      samples->x[n] = 2.0f * cosTheta * sinTheta * cosf ( phi );
+      samples->y[n] = 2.0f * cosTheta * sinTheta * sinf ( phi );
+      samples->z[n] = lz;
+      samples->lod[n] = lod < 0.0f ? 0.0f : ( lod > numRadianceLevels - 1 ? ( GLfloat ) ( numRadianceLevels - 1 ) : lod );
+      samples->count++;
+   }
+}
+
+///
+// Prefilter()
+//
+//    Integrate the GGX lobe around the direction of rows of a specular
+//    level
+//
+static void ESCALLBACK Prefilter ( void *userData, int begin, int end )
+{
+   FilterJob       *job = userData;
+   const SampleSet *samples = job->samples;
+   int              size = job->dest->size;
+   GLfloat          lx[SPECULAR_SAMPLES], ly[SPECULAR_SAMPLES], lz[SPECULAR_SAMPLES];
+   GLfloat          s[SPECULAR_SAMPLES], t[SPECULAR_SAMPLES];
+   int              face[SPECULAR_SAMPLES];
+   int              row, x, i;
+
+   for ( row = begin; row < end; row++ )
+   {
+      int      faceIndex = row / size;
+      int      y = row % size;
+      GLfloat *dst = job->dest->texels + ( size_t ) row * size * 3;
+
+      for ( x = 0; x < size; x++ )
+      {
+         GLfloat n[3], tangent[3], bitangent[3];
+         GLfloat rgb[3] = { 0.0f, 0.0f, 0.0f };
+         GLfloat totalWeight = 0.0f;
+         GLfloat length;
+
+         FaceDirection ( faceIndex, ( 2.0f * x + 1.0f ) / size - 1.0f, ( 2.0f * y + 1.0f ) / size - 1.0f, n );
+
+         // Tangent frame around the normal
+         if ( fabsf ( n[2] ) < 0.999f )
+         {
+            tangent[0] = -n[1];
+            tangent[1] = n[0];
+            tangent[2] = 0.0f;
+         }
+         else
+         {
+            tangent[0] = 0.0f;
+            tangent[1] = -n[2];
+            tangent[2] = n[1];
+         }
+
+         length = sqrtf ( tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2] );
+         tangent[0] /= length;
+         tangent[1] /= length;
+         tangent[2] /= length;
+         bitangent[0] = n[1] * tangent[2] - n[2] * tangent[1];
+         bitangent[1] = n[2] * tangent[0] - n[0] * tangent[2];
+         bitangent[2] = n[0] * tangent[1] - n[1] * tangent[0];
+
+         for ( i = 0; i < samples->count; i++ )
+         {
+            lx[i] = tangent[0] * samples->x[i] + bitangent[0] * samples->y[i] + n[0] * samples->z[i];
+            ly[i] = tangent[1] * samples->x[i] + bitangent[1] * samples->y[i] + n[1] * samples->z[i];
+            lz[i] = tangent[2] * samples->x[i] + bitangent[2] * samples->y[i] + n[2] * samples->z[i];
+         }
+
+         ProjectToCube ( lx, ly, lz, samples->count, face, s, t );
+
+         // Trilinear lookups weighted by n.l
+         for ( i = 0; i < samples->count; i++ )
+         {
+            GLfloat weight = samples->z[i];
+            int     level = ( int ) samples->lod[i];
+            GLfloat fraction = samples->lod[i] - level;
+
+            FetchFace ( &job->radiance[level], face[i], s[i], t[i], weight * ( 1.0f - fraction ), rgb );
+
+            if ( fraction > 0.0f )
+            {
+               FetchFace ( &job->radiance[level + 1], face[i], s[i], t[i], weight * fraction, rgb );
+            }
+
+            totalWeight += weight;
+         }
+
+         dst[x * 3 + 0] = rgb[0] / totalWeight;
+         dst[x * 3 + 1] = rgb[1] / totalWeight;
+         dst[x * 3 + 2] = rgb[2] / totalWeight;
+      }
+   }
+}
+
+///
+// ProjectSH()
+//
+//    Order 2 spherical harmonics of faces of a radiance level, each
+//    texel weighted by its solid angle
+//
+static void ESCALLBACK ProjectSH ( void *userData, int begin, int end )
+{
+   FilterJob       *job = userData;
+   const CubeLevel *level = &job->radiance[job->shLevel];
+   int              size = level->size;
+   int              face, x, y, k, c;
+
+   for ( face = begin; face < end; face++ )
+   {
+      const GLfloat *texels = level->texels + ( size_t ) face * size * size * 3;
+
+      memset ( job->sh[face], 0, sizeof ( job->sh[face] ) );
+      job->shWeight[face] = 0.0f;
+
+      for ( y = 0; y < size; y++ )
+      {
+         for ( x = 0; x < size; x++ )
+         {
+            GLfloat s = ( 2.0f * x + 1.0f ) / size - 1.0f;
+            GLfloat t = ( 2.0f * y + 1.0f ) / size - 1.0f;
+            GLfloat r2 = 1.0f + s * s + t * t;
+            GLfloat weight = 1.0f / ( r2 * sqrtf ( r2 ) );
+            GLfloat d[3], basis[9];
+
+            FaceDirection ( face, s, t, d );
+            basis[0] = 0.282095f;
+            basis[1] = 0.488603f * d[1];
+            basis[2] = 0.488603f * d[2];
+            basis[3] = 0.488603f * d[0];
+            basis[4] = 1.092548f * d[0] * d[1];
+            basis[5] = 1.092548f * d[1] * d[2];
+            basis[6] = 0.315392f * ( 3.0f * d[2] * d[2] - 1.0f );
+            basis[7] = 1.092548f * d[0] * d[2];
+            basis[8] = 0.546274f * ( d[0] * d[0] - d[1] * d[1] );
+
+            for ( k = 0; k < 9; k++ )
+            {
+               for ( c = 0; c < 3; c++ )
+               {
+                  job->sh[face][k][c] += weight * basis[k] * texels[( y * size + x ) * 3 + c];
+               }
+            }
+
+            job->shWeight[face] += weight;
+         }
+      }
+   }
+}
+
+///
+// EvaluateIrradiance()
+//
+//    Irradiance over pi of rows of the irradiance cubemap from the
+//    harmonics summed in job->sh[0]; the Lambert reflectance of a
+//    surface is its albedo times this value
+//
+static void ESCALLBACK EvaluateIrradiance ( void *userData, int begin, int end )
+{
+   static const GLfloat band[9] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+   FilterJob *job = userData;
+   int        size = job->dest->size;
+   int        row, x, k, c;
+
+   for ( row = begin; row < end; row++ )
+   {
+      GLfloat *dst = job->dest->texels + ( size_t ) row * size * 3;
+
+      for ( x = 0; x < size; x++ )
+      {
+         GLfloat d[3], basis[9];
+
+         FaceDirection ( row / size, ( 2.0f * x + 1.0f ) / size - 1.0f, ( 2.0f * ( row % size ) + 1.0f ) / size - 1.0f, d );
+         basis[0] = 0.282095f;
+         basis[1] = 0.488603f * d[1];
+         basis[2] = 0.488603f * d[2];
+         basis[3] = 0.488603f * d[0];
+         basis[4] = 1.092548f * d[0] * d[1];
+         basis[5] = 1.092548f * d[1] * d[2];
+         basis[6] = 0.315392f * ( 3.0f * d[2] * d[2] - 1.0f );
+         basis[7] = 1.092548f * d[0] * d[2];
+         basis[8] = 0.546274f * ( d[0] * d[0] - d[1] * d[1] );
+
+         for ( c = 0; c < 3; c++ )
+         {
+            GLfloat e = 0.0f;
+
+            for ( k = 0; k < 9; k++ )
+            {
+               e += band[k] * job->sh[0][k][c] * basis[k];
+            }
+
+            dst[x * 3 + c] = e > 0.0f ? e : 0.0f;
+         }
+      }
+   }
+}
+
+///
+// FloatToHalf()
+//
+static GLushort FloatToHalf ( GLfloat value )
+{
+   GLuint bits, sign, exponent, mantissa;
+
+   memcpy ( &bits, &value, 4 );
+   sign = ( bits >> 16 ) & 0x8000u;
+   exponent = ( bits >> 23 ) & 0xffu;
+   mantissa = bits & 0x7fffffu;
+
+   if ( exponent == 0xffu )
+   {
+      return ( GLushort ) ( sign | 0x7c00u | ( mantissa ? 0x200u : 0u ) );
+   }
+
+   if ( exponent > 142 )
+   {
+      // Too large, clamp to the largest half
+      return ( GLushort ) ( sign | 0x7bffu );
+   }
+
+   if ( exponent < 113 )
+   {
+      // Denormal or zero
+      if ( exponent < 103 )
+      {
+         return ( GLushort ) sign;
+      }
+
+      mantissa |= 0x800000u;
+      return ( GLushort ) ( sign | ( ( mantissa + ( 1u << ( 125 - exponent ) ) ) >> ( 126 - exponent ) ) );
+   }
+
+   // Round to nearest; a carry out of the mantissa bumps the exponent
+   return ( GLushort ) ( sign | ( ( ( ( exponent - 112 ) << 10 ) | ( mantissa >> 13 ) ) + ( ( mantissa >> 12 ) & 1u ) ) );
+}
+
+///
+// PackHalf()
+//
+static GLushort *PackHalf ( GLushort *dst, const CubeLevel *level )
+{
+   size_t count = ( size_t ) level->size * level->size * 6 * 3;
+   size_t i;
+
+   for ( i = 0; i < count; i++ )
+   {
+      dst[i] = FloatToHalf ( level->texels[i] );
+   }
+
+   return dst + count;
+}
+
+///
+// UploadCubemap()
+//
+//    Create an RGB16F cubemap from packed half float faces, level by
+//    level
+//
+static GLuint UploadCubemap ( const GLushort *texels, int size, int numLevels )
+{
+   GLuint texture;
+   int    level, face;
+
+   glGenTextures ( 1, &texture );
+   glBindTexture ( GL_TEXTURE_CUBE_MAP, texture );
+   glTexStorage2D ( GL_TEXTURE_CUBE_MAP, numLevels, GL_RGB16F, size, size );
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      int levelSize = size >> level > 0 ? size >> level : 1;
+
+      for ( face = 0; face < 6; face++ )
+      {
+         glTexSubImage2D ( GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, 0, 0, levelSize, levelSize,
+                           GL_RGB, GL_HALF_FLOAT, texels );
+         texels += ( size_t ) levelSize * levelSize * 3;
+      }
+   }
+
+   glTexParameteri ( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+   glTexParameteri ( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+
+   return texture;
+}
+
+///
+// UploadFiltered()
+//
+//    Create both cubemaps from a cache blob
+//
+static GLuint UploadFiltered ( const void *blob, size_t size, GLuint *irradiance, int *numLevels )
+{
+   CubemapHeader   header;
+   const GLushort *texels = ( const GLushort * ) ( ( const GLubyte * ) blob + sizeof ( CubemapHeader ) );
+   size_t          expected = 0;
+   GLint           alignment;
+   GLuint          texture;
+   GLuint          level;
+
+   if ( size < sizeof ( CubemapHeader ) )
+   {
+      return 0;
+   }
+
+   memcpy ( &header, blob, sizeof ( CubemapHeader ) );
+
+   for ( level = 0; level < header.numLevels; level++ )
+   {
+      size_t levelSize = header.faceSize >> level > 0 ? header.faceSize >> level : 1;
+      expected += levelSize * levelSize * 6 * 3 * sizeof ( GLushort );
+   }
+
+   expected += ( size_t ) header.irradianceSize * header.irradianceSize * 6 * 3 * sizeof ( GLushort );
+
+   if ( header.version != CACHE_VERSION || header.numLevels < 1 || header.numLevels > MAX_SPECULAR_LEVELS ||
+        size != sizeof ( CubemapHeader ) + expected )
+   {
+      return 0;
+   }
+
+   // Rows of RGB half floats are a multiple of 2 bytes
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, 2 );
+
+   *irradiance = UploadCubemap ( texels + ( expected / sizeof ( GLushort ) -
+                                            ( size_t ) header.irradianceSize * header.irradianceSize * 6 * 3 ),
+                                 header.irradianceSize, 1 );
+   texture = UploadCubemap ( texels, header.faceSize, header.numLevels );
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+
+   *numLevels = header.numLevels;
+   return texture;
+}
+
+///
+// FreeLevels()
+//
+static void FreeLevels ( CubeLevel *levels, int numLevels )
+{
+   int i;
+
+   if ( levels == NULL )
+   {
+      return;
+   }
+
+   for ( i = 0; i < numLevels; i++ )
+   {
+      free ( levels[i].texels );
+   }
+
+   free ( levels );
+}
+
+///
+// AllocLevels()
+//
+static CubeLevel *AllocLevels ( int size, int numLevels )
+{
+   CubeLevel *levels = calloc ( numLevels, sizeof ( CubeLevel ) );
+   int        i;
+
+   if ( levels == NULL )
+   {
+      return NULL;
+   }
+
+   for ( i = 0; i < numLevels; i++ )
+   {
+      levels[i].size = size >> i > 0 ? size >> i : 1;
+      levels[i].texels = malloc ( sizeof ( GLfloat ) * levels[i].size * levels[i].size * 6 * 3 );
+
+      if ( levels[i].texels == NULL )
+      {
+         FreeLevels ( levels, numLevels );
+         return NULL;
+      }
+   }
+
+   return levels;
+}
+
+///
+// Filter()
+//
+//    Compute the specular levels and the irradiance cubemap into a blob
+//    of half floats laid out as UploadFiltered reads it
+//
+static void *Filter ( FilterJob *job, int faceSize, int numLevels, size_t *blobSize )
+{
+   CubeLevel    *specular = NULL;
+   CubeLevel    *irradiance = NULL;
+   SampleSet    *samples = NULL;
+   GLubyte      *blob = NULL;
+   CubemapHeader header;
+   GLushort     *texels;
+   size_t        size;
+   int           level, i, k, c;
+
+   job->numRadianceLevels = 1;
+
+   while ( ( faceSize >> job->numRadianceLevels ) > 0 )
+   {
+      job->numRadianceLevels++;
+   }
+
+   // Level 0 is the radiance itself, a mirror; specular[i] holds level
+   // i + 1, blurred for roughness ( i + 1 ) / ( numLevels - 1 )
+   job->radiance = AllocLevels ( faceSize, job->numRadianceLevels );
+   specular = numLevels > 1 ? AllocLevels ( faceSize / 2, numLevels - 1 ) : NULL;
+   irradiance = AllocLevels ( IRRADIANCE_SIZE, 1 );
+   samples = malloc ( sizeof ( SampleSet ) );
+
+   if ( job->radiance == NULL || ( specular == NULL && numLevels > 1 ) || irradiance == NULL || samples == NULL )
+   {
+      goto done;
+   }
+
+   // Linear radiance and its box filtered levels
+   esParallelFor ( 6 * faceSize, 4, Resample, job );
+
+   for ( level = 1; level < job->numRadianceLevels; level++ )
+   {
+      Downsample ( &job->radiance[level - 1], &job->radiance[level] );
+   }
+
+   for ( level = 1; level < numLevels; level++ )
+   {
+      BuildSamples ( ( GLfloat ) level / ( numLevels - 1 ), faceSize, job->numRadianceLevels, samples );
+      job->samples = samples;
+      job->dest = &specular[level - 1];
+      esParallelFor ( 6 * job->dest->size, 1, Prefilter, job );
+   }
+
+   // Project a level of at most 64x64 on the harmonics, convolve with
+   // the cosine lobe and evaluate the irradiance
+   job->shLevel = 0;
+
+   while ( job->radiance[job->shLevel].size > 64 )
+   {
+      job->shLevel++;
+   }
+
+   esParallelFor ( 6, 1, ProjectSH, job );
+
+   for ( i = 1; i < 6; i++ )
+   {
+      for ( k = 0; k < 9; k++ )
+      {
+         for ( c = 0; c < 3; c++ )
+         {
+            job->sh[0][k][c] += job->sh[i][k][c];
+         }
+      }
+
+      job->shWeight[0] += job->shWeight[i];
+   }
+
+   for ( k = 0; k < 9; k++ )
+   {
+      for ( c = 0; c < 3; c++ )
+      {
+         job->sh[0][k][c] *= 4.0f * PI / job->shWeight[0];
+      }
+   }
+
+   job->dest = &irradiance[0];
+   esParallelFor ( 6 * IRRADIANCE_SIZE, 4, EvaluateIrradiance, job );
+
+   // Pack everything as half floats
+   size = sizeof ( CubemapHeader );
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      size += ( size_t ) job->radiance[level].size * job->radiance[level].size * 6 * 3 * sizeof ( GLushort );
+   }
+
+   size += ( size_t ) IRRADIANCE_SIZE * IRRADIANCE_SIZE * 6 * 3 * sizeof ( GLushort );
+   blob = malloc ( size );
+
+   if ( blob == NULL )
+   {
+      goto done;
+   }
+
+   header.version = CACHE_VERSION;
+   header.faceSize = faceSize;
+   header.numLevels = numLevels;
+   header.irradianceSize = IRRADIANCE_SIZE;
+   memcpy ( blob, &header, sizeof ( CubemapHeader ) );
+
+   texels = ( GLushort * ) ( blob + sizeof ( CubemapHeader ) );
+   texels = PackHalf ( texels, &job->radiance[0] );
+
+   for ( level = 1; level < numLevels; level++ )
+   {
+      texels = PackHalf ( texels, &specular[level - 1] );
+   }
+
+   PackHalf ( texels, &irradiance[0] );
+   *blobSize = size;
+
+done:
+   FreeLevels ( job->radiance, job->numRadianceLevels );
+   FreeLevels ( specular, numLevels - 1 );
+   FreeLevels ( irradiance, 1 );
+   free ( samples );
+
+   return blob;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateFilteredCubemap()
+//
+GLuint ESUTIL_API esCreateFilteredCubemap ( const GLubyte *pixels, int width, int height, int components, int layout,
+                                            GLboolean srgb, int faceSize, const char *cacheDir,
+                                            GLuint *irradiance, int *numLevels )
+{
+   FilterJob     job;
+   GLfloat       srgbToLinear[256];
+   ESFileMapping mapping;
+   const void   *cached;
+   void         *blob;
+   size_t        blobSize = 0;
+   GLuint64      key;
+   GLint         params[7];
+   GLuint        texture = 0;
+   int           levels;
+   int           i;
+
+   if ( components < 1 || components > 4 || width < 1 || height < 1 ||
+        ( layout == ES_CUBEMAP_FACES && height != width * 6 ) ||
+        ( layout == ES_CUBEMAP_EQUIRECT && width != height * 2 ) )
+   {
+      esLogMessage ( "esCreateFilteredCubemap: unsupported %dx%d source\n", width, height );
+      return 0;
+   }
+
+   if ( faceSize <= 0 )
+   {
+      faceSize = layout == ES_CUBEMAP_FACES ? width : height / 2;
+   }
+
+   // Power of two faces so that the radiance levels average exact blocks
+   i = 1;
+
+   while ( i < faceSize )
+   {
+      i <<= 1;
+   }
+
+   faceSize = i;
+   levels = 1;
+
+   while ( levels < MAX_SPECULAR_LEVELS && ( faceSize >> levels ) > 0 )
+   {
+      levels++;
+   }
+
+   // Look the result up by the source and everything it is built with
+   params[0] = CACHE_VERSION;
+   params[1] = width;
+   params[2] = height;
+   params[3] = components;
+   params[4] = layout;
+   params[5] = srgb;
+   params[6] = faceSize;
+   key = esHash64 ( ES_HASH_SEED, params, sizeof ( params ) );
+   key = esHash64 ( key, pixels, ( size_t ) width * height * components );
+
+   cached = esCacheLoad ( cacheDir, "cubemap", key, &mapping, &blobSize );
+
+   if ( cached != NULL )
+   {
+      texture = UploadFiltered ( cached, blobSize, irradiance, numLevels );
+      esUnmapFile ( &mapping );
+
+      if ( texture != 0 )
+      {
+         return texture;
+      }
+   }
+
+   for ( i = 0; i < 256; i++ )
+   {
+      GLfloat c = i / 255.0f;
+      srgbToLinear[i] = srgb ? ( c <= 0.04045f ? c / 12.92f : powf ( ( c + 0.055f ) / 1.055f, 2.4f ) ) : c;
+   }
+
+   memset ( &job, 0, sizeof ( FilterJob ) );
+   job.pixels = pixels;
+   job.width = width;
+   job.height = height;
+   job.components = components;
+   job.layout = layout;
+   job.srgbToLinear = srgbToLinear;
+
+   if ( layout == ES_CUBEMAP_FACES )
+   {
+      job.source.size = width;
+      job.source.texels = malloc ( sizeof ( GLfloat ) * width * height * 3 );
+
+      if ( job.source.texels == NULL )
+      {
+         return 0;
+      }
+
+      esParallelFor ( height, 16, ConvertSource, &job );
+   }
+
+   blob = Filter ( &job, faceSize, levels, &blobSize );
+   free ( job.source.texels );
+
+   if ( blob == NULL )
+   {
+      return 0;
+   }
+
+   esCacheStore ( cacheDir, "cubemap", key, blob, blobSize );
+   texture = UploadFiltered ( blob, blobSize, irradiance, numLevels );
+   free ( blob );
+
+   return texture;
+}
@@ -0,0 +1,212 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESDirtyRange.c
+//
+//    Tracks which elements of a dynamic buffer were modified since the
+//    last upload, so that sparse updates only transfer the bytes that
+//    actually changed instead of rewriting the whole buffer.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <string.h>
+
+///
+// Public Functions
+//
+
+///
+// esInitDirtyRanges()
+//
+//    Start with nothing dirty
+//
+void ESUTIL_API esInitDirtyRanges ( ESDirtyRanges *dirty, GLsizeiptr elementSize )
+{
+   dirty->elementSize = elementSize;
+   dirty->numRanges = 0;
+}
+
+///
+// esMarkDirty()
+//
+//    Insert [first, first + count) into the sorted range list, absorbing
+//    every range it overlaps or touches.  If that leaves one range too
+//    many, the two ranges with the smallest gap between them are joined,
+//    which uploads a few clean elements rather than dropping dirty ones.
+//
+void ESUTIL_API esMarkDirty ( ESDirtyRanges *dirty, GLint first, GLsizei count )
+{
+   GLint   starts[ES_MAX_DIRTY_RANGES + 1];
+   GLint   ends[ES_MAX_DIRTY_RANGES + 1];
+   GLint   lo = first;
+   GLint   hi = first + count;
+   int     inserted = GL_FALSE;
+   int     numRanges = 0;
+   int     i;
+
+   if ( count <= 0 )
+   {
+      return;
+   }
+
+   for ( i = 0; i < dirty->numRanges; i++ )
+   {
+      GLint start = dirty->first[i];
+      GLint end = start + dirty->count[i];
+
+      if ( end < lo )
+      {
+         starts[numRanges] = start;
+         ends[numRanges++] = end;
+      }
+      else if ( start > hi )
+      {
+         if ( !inserted )
+         {
+            starts[numRanges] = lo;
+            ends[numRanges++] = hi;
+            inserted = GL_TRUE;
+         }
+
+         starts[numRanges] = start;
+         ends[numRanges++] = end;
+      }
+      else
+      {
+         // Overlapping or adjacent, grow the new range to cover it
+         lo = start < lo ? start : lo;
+         hi = end > hi ? end : hi;
+      }
+   }
+
+   if ( !inserted )
+   {
+      starts[numRanges] = lo;
+      ends[numRanges++] = hi;
+   }
+
+   if ( numRanges > ES_MAX_DIRTY_RANGES )
+   {
+      int closest = 0;
+
+      for ( i = 1; i < numRanges - 1; i++ )
+      {
+         if ( starts[i + 1] - ends[i] < starts[closest + 1] - ends[closest] )
+         {
+            closest = i;
+         }
+      }
+
+      ends[closest] = ends[closest + 1];
+
+      for ( i = closest + 1; i < numRanges - 1; i++ )
+      {
+         starts[i] = starts[i + 1];
+         ends[i] = ends[i + 1];
+      }
+
+      numRanges--;
+   }
+
+   for ( i = 0; i < numRanges; i++ )
+   {
+      dirty->first[i] = starts[i];
+      dirty->count[i] = ends[i] - starts[i];
+   }
+
+   dirty->numRanges = numRanges;
+}
+
+///
+// esFlushDirtyRanges()
+//
+//    Copy each dirty range from the CPU copy into the buffer bound to
+//    target.  The mapped path maps only the span between the first and
+//    last dirty element, and without GL_MAP_INVALIDATE_RANGE_BIT, since the
+//    clean elements inside the span must keep their contents.
+//
+GLsizeiptr ESUTIL_API esFlushDirtyRanges ( ESDirtyRanges *dirty, GLenum target, const void *data, GLenum method )
+{
+   const GLubyte *src = data;
+   GLsizeiptr     elementSize = dirty->elementSize;
+   GLsizeiptr     uploaded = 0;
+   GLubyte       *mapped = NULL;
+   GLintptr       spanOffset = 0;
+   int            i;
+
+   if ( dirty->numRanges == 0 )
+   {
+      return 0;
+   }
+
+   if ( method == ES_FLUSH_MAP_EXPLICIT )
+   {
+      int        last = dirty->numRanges - 1;
+      GLsizeiptr spanSize;
+
+      spanOffset = dirty->first[0] * elementSize;
+      spanSize = ( dirty->first[last] + dirty->count[last] ) * elementSize - spanOffset;
+
+      // Fall back to glBufferSubData if the map fails
+      mapped = glMapBufferRange ( target, spanOffset, spanSize,
+                                  GL_MAP_WRITE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT );
+   }
+
+   for ( i = 0; i < dirty->numRanges; i++ )
+   {
+      GLintptr   offset = dirty->first[i] * elementSize;
+      GLsizeiptr size = dirty->count[i] * elementSize;
+
+      if ( mapped != NULL )
+      {
+         memcpy ( mapped + offset - spanOffset, src + offset, size );
+         glFlushMappedBufferRange ( target, offset - spanOffset, size );
+      }
+      else
+      {
+         glBufferSubData ( target, offset, size, src + offset );
+      }
+
+      uploaded += size;
+   }
+
+   if ( mapped != NULL )
+   {
+      glUnmapBuffer ( target );
+   }
+
+   dirty->numRanges = 0;
+
+   return uploaded;
+}
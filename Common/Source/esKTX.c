@@ -0,0 +1,960 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESKTX.c
+//
+//    Loader for KTX (version 1) and KTX2 texture files.  Every mip level,
+//    array layer and cube face stored in the file is uploaded into
+//    immutable texture storage, compressed formats such as ETC2 and EAC
+//    with glCompressedTexSubImage*, so nothing is decoded or generated at
+//    load time.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <string.h>
+
+///
+//  Macros
+//
+#define KTX_HEADER_SIZE          64
+#define KTX2_HEADER_SIZE         80
+#define KTX2_LEVEL_INDEX_SIZE    24
+#define KTX_MAX_LEVELS           32
+
+// Value of the endianness field when the file matches the host
+#define KTX_ENDIAN_REF           0x04030201
+#define KTX_ENDIAN_REF_REV       0x01020304
+
+///
+//  Types
+//
+typedef struct
+{
+   // Upload target and format; format and type are GL_NONE when the
+   // internal format is compressed
+   GLenum  target;
+   GLenum  internalFormat;
+   GLenum  format;
+   GLenum  type;
+
+   // Size of the base level; depth is the number of slices of a 3D texture
+   // or of layers of an array, 1 otherwise
+   int     width;
+   int     height;
+   int     depth;
+
+   // Stored levels, 0 if the mip chain is to be generated from level 0
+   int     numLevels;
+   int     rowAlignment;
+} KTXInfo;
+
+typedef struct
+{
+   const GLubyte *data;
+
+   // Bytes of one upload, and the distance between cube faces
+   GLsizei        imageSize;
+   GLsizei        faceStride;
+} KTXLevel;
+
+typedef struct
+{
+   GLenum internalFormat;
+   int    blockBytes;
+} CompressedFormat;
+
+typedef struct
+{
+   GLuint vkFormat;
+   GLenum internalFormat;
+   GLenum format;
+   GLenum type;
+} VkFormatInfo;
+
+///
+//  Tables
+//
+static const GLubyte ktxIdentifier[12] =
+{
+   0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+static const GLubyte ktx2Identifier[12] =
+{
+   0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+// 4x4 block formats of OpenGL ES 3.0
+static const CompressedFormat compressedFormats[] =
+{
+   { GL_COMPRESSED_R11_EAC,                         8 },
+   { GL_COMPRESSED_SIGNED_R11_EAC,                  8 },
+   { GL_COMPRESSED_RG11_EAC,                       16 },
+   { GL_COMPRESSED_SIGNED_RG11_EAC,                16 },
+   { GL_COMPRESSED_RGB8_ETC2,                       8 },
+   { GL_COMPRESSED_SRGB8_ETC2,                      8 },
+   { GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,   8 },
+   { GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,  8 },
+   { GL_COMPRESSED_RGBA8_ETC2_EAC,                 16 },
+   { GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,          16 },
+};
+
+// Vulkan formats of KTX2 files that have an OpenGL ES 3.0 equivalent
+static const VkFormatInfo vkFormats[] =
+{
+   {   9, GL_R8,                                          GL_RED,  GL_UNSIGNED_BYTE },
+   {  16, GL_RG8,                                         GL_RG,   GL_UNSIGNED_BYTE },
+   {  23, GL_RGB8,                                        GL_RGB,  GL_UNSIGNED_BYTE },
+   {  29, GL_SRGB8,                                       GL_RGB,  GL_UNSIGNED_BYTE },
+   {  37, GL_RGBA8,                                       GL_RGBA, GL_UNSIGNED_BYTE },
+   {  43, GL_SRGB8_ALPHA8,                                GL_RGBA, GL_UNSIGNED_BYTE },
+   {  76, GL_R16F,                                        GL_RED,  GL_HALF_FLOAT },
+   {  83, GL_RG16F,                                       GL_RG,   GL_HALF_FLOAT },
+   {  97, GL_RGBA16F,                                     GL_RGBA, GL_HALF_FLOAT },
+   { 109, GL_RGBA32F,                                     GL_RGBA, GL_FLOAT },
+   { 122, GL_R11F_G11F_B10F,                              GL_RGB,  GL_UNSIGNED_INT_10F_11F_11F_REV },
+   { 147, GL_COMPRESSED_RGB8_ETC2,                        GL_NONE, GL_NONE },
+   { 148, GL_COMPRESSED_SRGB8_ETC2,                       GL_NONE, GL_NONE },
+   { 149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,    GL_NONE, GL_NONE },
+   { 150, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,   GL_NONE, GL_NONE },
+   { 151, GL_COMPRESSED_RGBA8_ETC2_EAC,                   GL_NONE, GL_NONE },
+   { 152, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,            GL_NONE, GL_NONE },
+   { 153, GL_COMPRESSED_R11_EAC,                          GL_NONE, GL_NONE },
+   { 154, GL_COMPRESSED_SIGNED_R11_EAC,                   GL_NONE, GL_NONE },
+   { 155, GL_COMPRESSED_RG11_EAC,                         GL_NONE, GL_NONE },
+   { 156, GL_COMPRESSED_SIGNED_RG11_EAC,                  GL_NONE, GL_NONE },
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// ReadUint32()
+//
+static GLuint ReadUint32 ( const GLubyte *p, GLboolean swap )
+{
+   if ( swap )
+   {
+      return ( ( GLuint ) p[0] << 24 ) | ( p[1] << 16 ) | ( p[2] << 8 ) | p[3];
+   }
+
+   return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( ( GLuint ) p[3] << 24 );
+}
+
+///
+// ReadSize64()
+//
+//    Read a 64-bit little endian size, saturated to what fits in an int
+//
+static GLsizeiptr ReadSize64 ( const GLubyte *p )
+{
+   if ( ReadUint32 ( p + 4, GL_FALSE ) != 0 || ReadUint32 ( p, GL_FALSE ) > 0x7FFFFFFF )
+   {
+      return 0x7FFFFFFF;
+   }
+
+   return ReadUint32 ( p, GL_FALSE );
+}
+
+///
+// BlockBytes()
+//
+//    Bytes per 4x4 block of a compressed format, 0 if the format is not known
+//
+static int BlockBytes ( GLenum internalFormat )
+{
+   int i;
+
+   for ( i = 0; i < ( int ) ( sizeof ( compressedFormats ) / sizeof ( compressedFormats[0] ) ); i++ )
+   {
+      if ( compressedFormats[i].internalFormat == internalFormat )
+      {
+         return compressedFormats[i].blockBytes;
+      }
+   }
+
+   return 0;
+}
+
+///
+// PixelBytes()
+//
+//    Bytes per pixel of an uncompressed format, 0 if not supported
+//
+static int PixelBytes ( GLenum format, GLenum type )
+{
+   int components;
+
+   switch ( format )
+   {
+      case GL_RED:
+      case GL_RED_INTEGER:
+      case GL_ALPHA:
+      case GL_LUMINANCE:
+         components = 1;
+         break;
+
+      case GL_RG:
+      case GL_RG_INTEGER:
+      case GL_LUMINANCE_ALPHA:
+         components = 2;
+         break;
+
+      case GL_RGB:
+      case GL_RGB_INTEGER:
+         components = 3;
+         break;
+
+      case GL_RGBA:
+      case GL_RGBA_INTEGER:
+         components = 4;
+         break;
+
+      default:
+         return 0;
+   }
+
+   switch ( type )
+   {
+      case GL_UNSIGNED_BYTE:
+      case GL_BYTE:
+         return components;
+
+      case GL_UNSIGNED_SHORT:
+      case GL_SHORT:
+      case GL_HALF_FLOAT:
+         return components * 2;
+
+      case GL_UNSIGNED_INT:
+      case GL_INT:
+      case GL_FLOAT:
+         return components * 4;
+
+      case GL_UNSIGNED_SHORT_5_6_5:
+      case GL_UNSIGNED_SHORT_4_4_4_4:
+      case GL_UNSIGNED_SHORT_5_5_5_1:
+         return 2;
+
+      case GL_UNSIGNED_INT_2_10_10_10_REV:
+      case GL_UNSIGNED_INT_10F_11F_11F_REV:
+      case GL_UNSIGNED_INT_5_9_9_9_REV:
+         return 4;
+   }
+
+   return 0;
+}
+
+///
+// SizedInternalFormat()
+//
+//    glTexStorage needs a sized internal format; KTX files written for
+//    OpenGL ES 2.0 may store the unsized one
+//
+static GLenum SizedInternalFormat ( GLenum internalFormat, GLenum type )
+{
+   if ( type != GL_UNSIGNED_BYTE )
+   {
+      return internalFormat;
+   }
+
+   switch ( internalFormat )
+   {
+      case GL_RED:
+         return GL_R8;
+
+      case GL_RG:
+         return GL_RG8;
+
+      case GL_RGB:
+         return GL_RGB8;
+
+      case GL_RGBA:
+         return GL_RGBA8;
+   }
+
+   return internalFormat;
+}
+
+///
+// ImageBytes()
+//
+//    Smallest size of one upload of a width x height x depth level, 0 if
+//    the format is unknown and the size must be left to GL to check
+//
+static GLsizeiptr ImageBytes ( const KTXInfo *info, int width, int height, int depth )
+{
+   if ( info->format == GL_NONE )
+   {
+      return ( GLsizeiptr ) ( ( width + 3 ) / 4 ) * ( ( height + 3 ) / 4 ) * depth * BlockBytes ( info->internalFormat );
+   }
+   else
+   {
+      int rowBytes = width * PixelBytes ( info->format, info->type );
+
+      rowBytes = ( rowBytes + info->rowAlignment - 1 ) / info->rowAlignment * info->rowAlignment;
+
+      return ( GLsizeiptr ) rowBytes * height * depth;
+   }
+}
+
+///
+// SelectTarget()
+//
+//    Pick the texture target for the dimensions of the file.  Cube map
+//    arrays and arrays of 3D textures do not exist in OpenGL ES 3.0.
+//
+static GLboolean SelectTarget ( KTXInfo *info, int pixelHeight, int pixelDepth, int numLayers, int numFaces )
+{
+   info->height = pixelHeight > 0 ? pixelHeight : 1;
+   info->depth = 1;
+
+   if ( numFaces == 6 && numLayers == 0 && pixelDepth == 0 )
+   {
+      info->target = GL_TEXTURE_CUBE_MAP;
+   }
+   else if ( numFaces != 1 )
+   {
+      return GL_FALSE;
+   }
+   else if ( pixelDepth > 0 && numLayers == 0 )
+   {
+      info->target = GL_TEXTURE_3D;
+      info->depth = pixelDepth;
+   }
+   else if ( pixelDepth > 0 )
+   {
+      return GL_FALSE;
+   }
+   else if ( numLayers > 0 )
+   {
+      info->target = GL_TEXTURE_2D_ARRAY;
+      info->depth = numLayers;
+   }
+   else
+   {
+      info->target = GL_TEXTURE_2D;
+   }
+
+   return info->width > 0;
+}
+
+///
+// ParseKTX()
+//
+//    Read the header of a KTX version 1 file and locate its levels
+//
+static GLboolean ParseKTX ( const GLubyte *data, int size, KTXInfo *info, KTXLevel *levels )
+{
+   const GLubyte *end = data + size;
+   const GLubyte *p;
+   GLboolean      swap;
+   GLuint         typeSize;
+   int            numLevels;
+   int            level;
+
+   if ( size < KTX_HEADER_SIZE )
+   {
+      return GL_FALSE;
+   }
+
+   if ( ReadUint32 ( &data[12], GL_FALSE ) == KTX_ENDIAN_REF )
+   {
+      swap = GL_FALSE;
+   }
+   else if ( ReadUint32 ( &data[12], GL_FALSE ) == KTX_ENDIAN_REF_REV )
+   {
+      swap = GL_TRUE;
+   }
+   else
+   {
+      return GL_FALSE;
+   }
+
+   info->type = ReadUint32 ( &data[16], swap );
+   typeSize = ReadUint32 ( &data[20], swap );
+   info->format = ReadUint32 ( &data[24], swap );
+   info->internalFormat = SizedInternalFormat ( ReadUint32 ( &data[28], swap ), info->type );
+   info->width = ReadUint32 ( &data[36], swap );
+   info->numLevels = ReadUint32 ( &data[56], swap );
+   info->rowAlignment = 4;
+
+   // Pixel data would need its bytes swapped as well
+   if ( swap && typeSize > 1 )
+   {
+      esLogMessage ( "esLoadKTX: files of the other endianness are only supported for byte formats\n" );
+      return GL_FALSE;
+   }
+
+   if ( !SelectTarget ( info, ReadUint32 ( &data[40], swap ), ReadUint32 ( &data[44], swap ),
+                        ReadUint32 ( &data[48], swap ), ReadUint32 ( &data[52], swap ) ) ||
+         info->numLevels > KTX_MAX_LEVELS )
+   {
+      return GL_FALSE;
+   }
+
+   // Skip the key/value data
+   if ( ReadUint32 ( &data[60], swap ) > ( GLuint ) ( size - KTX_HEADER_SIZE ) )
+   {
+      return GL_FALSE;
+   }
+
+   p = data + KTX_HEADER_SIZE + ReadUint32 ( &data[60], swap );
+   numLevels = info->numLevels > 0 ? info->numLevels : 1;
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      GLuint imageSize;
+      GLuint levelSize;
+
+      if ( end - p < 4 )
+      {
+         return GL_FALSE;
+      }
+
+      imageSize = ReadUint32 ( p, swap );
+      p += 4;
+
+      if ( imageSize > 0x7FFFFFF0 / 6 )
+      {
+         return GL_FALSE;
+      }
+
+      // For cube maps the size is that of one face, each padded to 4 bytes
+      levels[level].data = p;
+      levels[level].imageSize = imageSize;
+      levels[level].faceStride = info->target == GL_TEXTURE_CUBE_MAP ? ( imageSize + 3 ) & ~3 : 0;
+      levelSize = 5 * levels[level].faceStride + imageSize;
+
+      if ( ( GLuint ) ( end - p ) < levelSize )
+      {
+         return GL_FALSE;
+      }
+
+      // Skip the level and its padding, which may be missing after the last
+      levelSize = ( levelSize + 3 ) & ~3;
+      p += levelSize < ( GLuint ) ( end - p ) ? levelSize : ( GLuint ) ( end - p );
+   }
+
+   return GL_TRUE;
+}
+
+///
+// ParseKTX2()
+//
+//    Read the header of a KTX2 file and locate its levels
+//
+static GLboolean ParseKTX2 ( const GLubyte *data, int size, KTXInfo *info, KTXLevel *levels )
+{
+   GLuint vkFormat;
+   int    numLevels;
+   int    level;
+   int    i;
+
+   if ( size < KTX2_HEADER_SIZE )
+   {
+      return GL_FALSE;
+   }
+
+   vkFormat = ReadUint32 ( &data[12], GL_FALSE );
+   info->internalFormat = GL_NONE;
+
+   for ( i = 0; i < ( int ) ( sizeof ( vkFormats ) / sizeof ( vkFormats[0] ) ); i++ )
+   {
+      if ( vkFormats[i].vkFormat == vkFormat )
+      {
+         info->internalFormat = vkFormats[i].internalFormat;
+         info->format = vkFormats[i].format;
+         info->type = vkFormats[i].type;
+      }
+   }
+
+   if ( info->internalFormat == GL_NONE )
+   {
+      esLogMessage ( "esLoadKTX: unsupported VkFormat %u\n", vkFormat );
+      return GL_FALSE;
+   }
+
+   // Supercompressed files would have to be inflated first
+   if ( ReadUint32 ( &data[44], GL_FALSE ) != 0 )
+   {
+      esLogMessage ( "esLoadKTX: supercompressed KTX2 files are not supported\n" );
+      return GL_FALSE;
+   }
+
+   info->width = ReadUint32 ( &data[20], GL_FALSE );
+   info->numLevels = ReadUint32 ( &data[40], GL_FALSE );
+   info->rowAlignment = 1;
+
+   if ( !SelectTarget ( info, ReadUint32 ( &data[24], GL_FALSE ), ReadUint32 ( &data[28], GL_FALSE ),
+                        ReadUint32 ( &data[32], GL_FALSE ), ReadUint32 ( &data[36], GL_FALSE ) ) ||
+         info->numLevels > KTX_MAX_LEVELS )
+   {
+      return GL_FALSE;
+   }
+
+   numLevels = info->numLevels > 0 ? info->numLevels : 1;
+
+   if ( size < KTX2_HEADER_SIZE + numLevels * KTX2_LEVEL_INDEX_SIZE )
+   {
+      return GL_FALSE;
+   }
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      const GLubyte *index = &data[KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE];
+      GLsizeiptr     offset = ReadSize64 ( index );
+      GLsizeiptr     length = ReadSize64 ( index + 8 );
+
+      if ( offset > size || length > size - offset )
+      {
+         return GL_FALSE;
+      }
+
+      levels[level].data = data + offset;
+
+      // Cube faces follow each other without padding
+      if ( info->target == GL_TEXTURE_CUBE_MAP )
+      {
+         levels[level].imageSize = ( GLsizei ) ( length / 6 );
+         levels[level].faceStride = levels[level].imageSize;
+      }
+      else
+      {
+         levels[level].imageSize = ( GLsizei ) length;
+         levels[level].faceStride = 0;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+///
+// TexSubImage()
+//
+//    Upload one image of a level, compressed or not
+//
+static void TexSubImage ( const KTXInfo *info, GLenum target, int level, int width, int height, int depth,
+                          const void *data, GLsizei imageSize )
+{
+   if ( target == GL_TEXTURE_3D || target == GL_TEXTURE_2D_ARRAY )
+   {
+      if ( info->format == GL_NONE )
+      {
+         glCompressedTexSubImage3D ( target, level, 0, 0, 0, width, height, depth,
+                                     info->internalFormat, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage3D ( target, level, 0, 0, 0, width, height, depth, info->format, info->type, data );
+      }
+   }
+   else
+   {
+      if ( info->format == GL_NONE )
+      {
+         glCompressedTexSubImage2D ( target, level, 0, 0, width, height, info->internalFormat, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage2D ( target, level, 0, 0, width, height, info->format, info->type, data );
+      }
+   }
+}
+
+///
+// AllocateStorage()
+//
+//    Allocate immutable storage for the texture bound to info->target, the
+//    whole chain if it is to be generated.  Returns the number of stored
+//    levels to upload, and whether glGenerateMipmap must follow.
+//
+static int AllocateStorage ( const KTXInfo *info, GLboolean *generate )
+{
+   int numLevels = info->numLevels;
+
+   // glGenerateMipmap cannot compress, so compressed files without levels
+   // get the base level only
+   *generate = numLevels == 0 && info->format != GL_NONE;
+
+   if ( numLevels == 0 && !*generate )
+   {
+      esLogMessage ( "esLoadKTX: no mip levels stored for compressed format 0x%x, using the base level only\n",
+                     info->internalFormat );
+      numLevels = 1;
+   }
+
+   // Allocate the whole chain if it is generated
+   if ( *generate )
+   {
+      int size = info->width > info->height ? info->width : info->height;
+
+      if ( info->target == GL_TEXTURE_3D && info->depth > size )
+      {
+         size = info->depth;
+      }
+
+      for ( numLevels = 1; size > 1; size >>= 1 )
+      {
+         numLevels++;
+      }
+   }
+
+   if ( info->target == GL_TEXTURE_3D || info->target == GL_TEXTURE_2D_ARRAY )
+   {
+      glTexStorage3D ( info->target, numLevels, info->internalFormat, info->width, info->height, info->depth );
+   }
+   else
+   {
+      glTexStorage2D ( info->target, numLevels, info->internalFormat, info->width, info->height );
+   }
+
+   return info->numLevels > 0 ? info->numLevels : 1;
+}
+
+///
+// LevelSize()
+//
+//    Size of a stored level.  Returns GL_FALSE if the file holds fewer
+//    bytes than GL reads for it.
+//
+static GLboolean LevelSize ( const KTXInfo *info, const KTXLevel *levels, int level,
+                             int *width, int *height, int *depth )
+{
+   GLsizeiptr minSize;
+
+   *width = info->width >> level > 1 ? info->width >> level : 1;
+   *height = info->height >> level > 1 ? info->height >> level : 1;
+   *depth = info->depth;
+
+   if ( info->target == GL_TEXTURE_3D )
+   {
+      *depth = info->depth >> level > 1 ? info->depth >> level : 1;
+   }
+
+   minSize = ImageBytes ( info, *width, *height, *depth );
+
+   if ( levels[level].imageSize < minSize || ( info->format != GL_NONE && minSize == 0 ) )
+   {
+      esLogMessage ( "esLoadKTX: level %d is truncated\n", level );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+///
+// UploadLevels()
+//
+//    Allocate immutable storage for the texture bound to info->target and
+//    upload every stored level
+//
+static GLboolean UploadLevels ( const KTXInfo *info, const KTXLevel *levels )
+{
+   GLboolean generate;
+   int       numLevels = AllocateStorage ( info, &generate );
+   int       level;
+   GLint     alignment;
+
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, info->rowAlignment );
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      int width, height, depth;
+
+      if ( !LevelSize ( info, levels, level, &width, &height, &depth ) )
+      {
+         glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+         return GL_FALSE;
+      }
+
+      if ( info->target == GL_TEXTURE_CUBE_MAP )
+      {
+         int face;
+
+         for ( face = 0; face < 6; face++ )
+         {
+            TexSubImage ( info, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, width, height, 1,
+                          levels[level].data + face * levels[level].faceStride, levels[level].imageSize );
+         }
+      }
+      else
+      {
+         TexSubImage ( info, info->target, level, width, height, depth, levels[level].data, levels[level].imageSize );
+      }
+   }
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+
+   if ( generate )
+   {
+      glGenerateMipmap ( info->target );
+   }
+
+   return GL_TRUE;
+}
+
+///
+// ParseFile()
+//
+//    Read the header of a KTX or KTX2 file
+//
+static GLboolean ParseFile ( const void *data, int size, KTXInfo *info, KTXLevel *levels )
+{
+   GLboolean parsed = GL_FALSE;
+
+   memset ( info, 0, sizeof ( *info ) );
+
+   if ( size >= ( int ) sizeof ( ktxIdentifier ) && memcmp ( data, ktxIdentifier, sizeof ( ktxIdentifier ) ) == 0 )
+   {
+      parsed = ParseKTX ( data, size, info, levels );
+   }
+   else if ( size >= ( int ) sizeof ( ktx2Identifier ) && memcmp ( data, ktx2Identifier, sizeof ( ktx2Identifier ) ) == 0 )
+   {
+      parsed = ParseKTX2 ( data, size, info, levels );
+   }
+
+   if ( !parsed )
+   {
+      esLogMessage ( "esLoadKTX: not a valid KTX file, or one without an OpenGL ES 3.0 equivalent\n" );
+   }
+
+   return parsed;
+}
+
+///
+// UploadTexture()
+//
+//    Upload every level into the texture bound to info->target and check
+//    for errors
+//
+static GLboolean UploadTexture ( const KTXInfo *info, const KTXLevel *levels )
+{
+   if ( !UploadLevels ( info, levels ) || glGetError () != GL_NO_ERROR )
+   {
+      esLogMessage ( "esLoadKTX: upload of format 0x%04X failed\n", info->internalFormat );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateTextureKTX()
+//
+GLuint ESUTIL_API esCreateTextureKTX ( const void *data, int size, GLenum *target )
+{
+   KTXInfo  info;
+   KTXLevel levels[KTX_MAX_LEVELS];
+   GLuint   texture;
+
+   if ( !ParseFile ( data, size, &info, levels ) )
+   {
+      return 0;
+   }
+
+   // Errors raised before this call must not be taken for upload errors
+   while ( glGetError () != GL_NO_ERROR )
+   {
+   }
+
+   glGenTextures ( 1, &texture );
+   glBindTexture ( info.target, texture );
+
+   if ( !UploadTexture ( &info, levels ) )
+   {
+      glDeleteTextures ( 1, &texture );
+      return 0;
+   }
+
+   if ( target != NULL )
+   {
+      *target = info.target;
+   }
+
+   return texture;
+}
+
+///
+// esUploadTextureKTX()
+//
+GLboolean ESUTIL_API esUploadTextureKTX ( const void *data, int size, GLenum target )
+{
+   KTXInfo  info;
+   KTXLevel levels[KTX_MAX_LEVELS];
+
+   if ( !ParseFile ( data, size, &info, levels ) )
+   {
+      return GL_FALSE;
+   }
+
+   if ( info.target != target )
+   {
+      esLogMessage ( "esLoadKTX: file holds a texture of target 0x%04X, not 0x%04X\n", info.target, target );
+      return GL_FALSE;
+   }
+
+   while ( glGetError () != GL_NO_ERROR )
+   {
+   }
+
+   return UploadTexture ( &info, levels );
+}
+
+///
+// esScheduleTextureKTX()
+//
+GLuint ESUTIL_API esScheduleTextureKTX ( ESUploadScheduler *scheduler, const void *data, int size, GLenum *target,
+                                         ESUploadDoneFunc done, void *userData, int *numUploads )
+{
+   KTXInfo   info;
+   KTXLevel  levels[KTX_MAX_LEVELS];
+   GLuint    texture;
+   GLboolean generate;
+   int       numLevels, level, count = 0;
+
+   if ( numUploads != NULL )
+   {
+      *numUploads = 0;
+   }
+
+   if ( scheduler == NULL || !ParseFile ( data, size, &info, levels ) )
+   {
+      return 0;
+   }
+
+   // The scheduler reads rows tightly packed, and cannot generate mip levels
+   if ( info.format != GL_NONE &&
+         ( info.numLevels == 0 || ( info.width * PixelBytes ( info.format, info.type ) ) % info.rowAlignment != 0 ) )
+   {
+      esLogMessage ( "esScheduleTextureKTX: padded rows or generated levels must be uploaded at once\n" );
+      return 0;
+   }
+
+   while ( glGetError () != GL_NO_ERROR )
+   {
+   }
+
+   glGenTextures ( 1, &texture );
+   glBindTexture ( info.target, texture );
+   numLevels = AllocateStorage ( &info, &generate );
+
+   for ( level = 0; level < numLevels && glGetError () == GL_NO_ERROR; level++ )
+   {
+      int width, height, depth, face, numFaces = info.target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+
+      // Narrower levels of a padded format may have padded rows too
+      if ( !LevelSize ( &info, levels, level, &width, &height, &depth ) ||
+            ( info.format != GL_NONE && ( width * PixelBytes ( info.format, info.type ) ) % info.rowAlignment != 0 ) )
+      {
+         break;
+      }
+
+      for ( face = 0; face < numFaces; face++ )
+      {
+         GLenum         faceTarget = numFaces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : info.target;
+         const GLubyte *image = levels[level].data + face * levels[level].faceStride;
+         GLboolean      scheduled;
+
+         if ( info.format == GL_NONE )
+         {
+            scheduled = esScheduleCompressedTextureUpload ( scheduler, texture, faceTarget, level, 0, 0, 0,
+                                                            width, height, depth, info.internalFormat,
+                                                            ( GLsizei ) ImageBytes ( &info, width, height, depth ),
+                                                            image, done, userData );
+         }
+         else
+         {
+            scheduled = esScheduleTextureUpload ( scheduler, texture, faceTarget, level, 0, 0, 0,
+                                                  width, height, depth, info.format, info.type,
+                                                  image, done, userData );
+         }
+
+         if ( scheduled )
+         {
+            count++;
+         }
+      }
+   }
+
+   // Uploads already scheduled find the texture deleted and are dropped
+   if ( level < numLevels || count < numLevels * ( info.target == GL_TEXTURE_CUBE_MAP ? 6 : 1 ) )
+   {
+      esLogMessage ( "esScheduleTextureKTX: scheduling format 0x%04X failed\n", info.internalFormat );
+      glDeleteTextures ( 1, &texture );
+      texture = 0;
+   }
+   else if ( target != NULL )
+   {
+      *target = info.target;
+   }
+
+   if ( numUploads != NULL )
+   {
+      *numUploads = count;
+   }
+
+   return texture;
+}
+
+///
+// esLoadKTX()
+//
+GLuint ESUTIL_API esLoadKTX ( void *ioContext, const char *fileName, GLenum *target )
+{
+   ESFileMapping file;
+   GLuint        texture = 0;
+
+   if ( esMapFile ( ioContext, fileName, &file ) )
+   {
+      texture = esCreateTextureKTX ( file.data, file.size, target );
+      esUnmapFile ( &file );
+   }
+
+   if ( texture == 0 )
+   {
+      esLogMessage ( "esLoadKTX FAILED to load : { %s }\n", fileName );
+   }
+
+   return texture;
+}
@@ -0,0 +1,850 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESMeshCodec.c
+//
+//    Compression for vertex and index buffers stored on disk.
+//
+//    Vertex streams are coded one byte lane at a time: for each byte of
+//    the vertex, the difference from the same byte of the previous vertex
+//    is zigzag coded so small changes in either direction become small
+//    numbers, and every group of 16 values is stored with 0, 2, 4 or 8
+//    bits each, chosen by a 2-bit header.  Neighbouring vertices of real
+//    meshes differ mostly in their low order bytes, so most lanes shrink
+//    to a few bits per vertex.  The decoder expands a group with a handful
+//    of SSE2 instructions.
+//
+//    Index streams code the zigzag coded difference of each index from
+//    the previous one the same way, as four byte lanes of a 32-bit value.
+//    The upper lanes of the small steps typical of generated and optimized
+//    meshes are mostly zero and cost next to nothing.  The decoder joins
+//    the lanes and sums the differences four indices at a time.
+//
+//    On one core of an SSE2 x86-64 server the vertex decoder runs at
+//    about 2 to 3 GB/s on a 32 byte position, normal and texture
+//    coordinate vertex, short of the several GB/s of SSSE3 decoders that
+//    expand groups with a byte shuffle.  Fusing the running sum into the
+//    expansion and interleaving 16 lanes at a time were both measured no
+//    faster there.  Indices decode at 3 to 4 GB/s.
+//
+//    esCacheStoreMesh and esCacheLoadMesh keep meshes compressed in the
+//    disk cache.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ES_CODEC_SSE
+#endif
+
+///
+// Defines
+//
+#define VERTEX_CODEC_HEADER   0xA1
+#define INDEX_CODEC_HEADER    0xE2
+
+// Vertices per block; each byte lane of a block is coded on its own
+#define VERTEX_BLOCK_SIZE     256
+#define VERTEX_GROUP_SIZE     16
+#define VERTEX_MAX_SIZE       256
+
+///
+// Types
+//
+
+// Header of a mesh in the disk cache, followed by the encoded vertices
+// and indices
+typedef struct
+{
+   int numVertices;
+   int vertexSize;
+   int numIndices;
+   int vertexDataSize;
+   int indexDataSize;
+} MeshHeader;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// EncodeLane()
+//
+//    Write the header and the packed groups for one byte lane of a block.
+//    Returns the new write position or NULL if dst is too small.
+//
+static GLubyte *EncodeLane ( GLubyte *dst, const GLubyte *dstEnd, const GLubyte *zigzag, int numGroups )
+{
+   GLubyte *header = dst;
+   int      numHeaderBytes = ( numGroups + 3 ) / 4;
+   int      g;
+   int      i;
+
+   if ( dstEnd - dst < numHeaderBytes )
+   {
+      return NULL;
+   }
+
+   memset ( header, 0, numHeaderBytes );
+   dst += numHeaderBytes;
+
+   for ( g = 0; g < numGroups; g++ )
+   {
+      const GLubyte *values = &zigzag[g * VERTEX_GROUP_SIZE];
+      GLubyte        maxValue = 0;
+      int            mode;
+
+      for ( i = 0; i < VERTEX_GROUP_SIZE; i++ )
+      {
+         maxValue = values[i] > maxValue ? values[i] : maxValue;
+      }
+
+      // 0: all zero, 1: 2 bits, 2: 4 bits, 3: 8 bits
+      mode = maxValue == 0 ? 0 : maxValue < 4 ? 1 : maxValue < 16 ? 2 : 3;
+      header[g / 4] |= mode << ( 2 * ( g % 4 ) );
+
+      if ( dstEnd - dst < ( 2 << mode ) )
+      {
+         return NULL;
+      }
+
+      switch ( mode )
+      {
+         case 1:
+            for ( i = 0; i < VERTEX_GROUP_SIZE; i += 4 )
+            {
+               *dst++ = ( GLubyte ) ( ( values[i] << 6 ) | ( values[i + 1] << 4 ) |
+                                      ( values[i + 2] << 2 ) | values[i + 3] );
+            }
+            break;
+
+         case 2:
+            for ( i = 0; i < VERTEX_GROUP_SIZE; i += 2 )
+            {
+               *dst++ = ( GLubyte ) ( ( values[i] << 4 ) | values[i + 1] );
+            }
+            break;
+
+         case 3:
+            memcpy ( dst, values, VERTEX_GROUP_SIZE );
+            dst += VERTEX_GROUP_SIZE;
+            break;
+      }
+   }
+
+   return dst;
+}
+
+///
+// DecodeGroup()
+//
+//    Expand one group of 16 values and, if zigzag is set, undo the zigzag
+//    coding.  Returns the new read position.
+//
+static const GLubyte *DecodeGroup ( const GLubyte *src, int mode, GLboolean zigzag, GLubyte *deltas )
+{
+#ifdef ES_CODEC_SSE
+   __m128i mask2 = _mm_set1_epi8 ( 3 );
+   __m128i mask4 = _mm_set1_epi8 ( 15 );
+   __m128i one = _mm_set1_epi8 ( 1 );
+   __m128i mask7 = _mm_set1_epi8 ( 127 );
+   __m128i z;
+
+   switch ( mode )
+   {
+      case 0:
+         z = _mm_setzero_si128 ();
+         break;
+
+      case 1:
+      {
+         __m128i packed = _mm_cvtsi32_si128 ( src[0] | ( src[1] << 8 ) | ( src[2] << 16 ) | ( ( unsigned ) src[3] << 24 ) );
+         __m128i a = _mm_and_si128 ( _mm_srli_epi16 ( packed, 6 ), mask2 );
+         __m128i b = _mm_and_si128 ( _mm_srli_epi16 ( packed, 4 ), mask2 );
+         __m128i c = _mm_and_si128 ( _mm_srli_epi16 ( packed, 2 ), mask2 );
+         __m128i d = _mm_and_si128 ( packed, mask2 );
+
+         z = _mm_unpacklo_epi16 ( _mm_unpacklo_epi8 ( a, b ), _mm_unpacklo_epi8 ( c, d ) );
+         src += 4;
+         break;
+      }
+
+      case 2:
+      {
+         __m128i packed = _mm_loadl_epi64 ( ( const __m128i * ) src );
+         __m128i hi = _mm_and_si128 ( _mm_srli_epi16 ( packed, 4 ), mask4 );
+         __m128i lo = _mm_and_si128 ( packed, mask4 );
+
+         z = _mm_unpacklo_epi8 ( hi, lo );
+         src += 8;
+         break;
+      }
+
+      default:
+         z = _mm_loadu_si128 ( ( const __m128i * ) src );
+         src += 16;
+         break;
+   }
+
+   // ( z >> 1 ) ^ -( z & 1 )
+   if ( zigzag )
+   {
+      z = _mm_xor_si128 ( _mm_and_si128 ( _mm_srli_epi16 ( z, 1 ), mask7 ),
+                          _mm_sub_epi8 ( _mm_setzero_si128 (), _mm_and_si128 ( z, one ) ) );
+   }
+
+   _mm_storeu_si128 ( ( __m128i * ) deltas, z );
+#else
+   int i;
+
+   switch ( mode )
+   {
+      case 0:
+         memset ( deltas, 0, VERTEX_GROUP_SIZE );
+         break;
+
+      case 1:
+         for ( i = 0; i < VERTEX_GROUP_SIZE; i++ )
+         {
+            deltas[i] = ( src[i / 4] >> ( 6 - 2 * ( i % 4 ) ) ) & 3;
+         }
+
+         src += 4;
+         break;
+
+      case 2:
+         for ( i = 0; i < VERTEX_GROUP_SIZE; i++ )
+         {
+            deltas[i] = ( src[i / 2] >> ( i % 2 ? 0 : 4 ) ) & 15;
+         }
+
+         src += 8;
+         break;
+
+      default:
+         memcpy ( deltas, src, VERTEX_GROUP_SIZE );
+         src += 16;
+         break;
+   }
+
+   for ( i = 0; zigzag && i < VERTEX_GROUP_SIZE; i++ )
+   {
+      deltas[i] = ( GLubyte ) ( ( deltas[i] >> 1 ) ^ ( 0 - ( deltas[i] & 1 ) ) );
+   }
+#endif
+
+   return src;
+}
+
+///
+// DecodeLane()
+//
+//    Read the header and the packed groups of one byte lane of a block.
+//    Returns the new read position or NULL if the data is truncated.
+//
+static const GLubyte *DecodeLane ( const GLubyte *src, const GLubyte *srcEnd, int numGroups, GLboolean zigzag,
+                                   GLubyte *deltas )
+{
+   const GLubyte *header = src;
+   int            numHeaderBytes = ( numGroups + 3 ) / 4;
+   GLboolean      safe;
+   int            g;
+
+   if ( srcEnd - src < numHeaderBytes )
+   {
+      return NULL;
+   }
+
+   src += numHeaderBytes;
+
+   // Lanes that never change, such as the upper bytes of most index
+   // deltas, have headers of all zero
+   g = 0;
+
+   while ( g < numHeaderBytes && header[g] == 0 )
+   {
+      g++;
+   }
+
+   if ( g == numHeaderBytes )
+   {
+      memset ( deltas, 0, numGroups * VERTEX_GROUP_SIZE );
+      return src;
+   }
+
+   // Bounds are only checked per group near the end of the data
+   safe = srcEnd - src >= numGroups * VERTEX_GROUP_SIZE;
+
+   for ( g = 0; g < numGroups; g++ )
+   {
+      int mode = ( header[g / 4] >> ( 2 * ( g % 4 ) ) ) & 3;
+
+      // Each mode reads 0, 4, 8 or 16 bytes
+      if ( !safe && srcEnd - src < ( mode ? 2 << mode : 0 ) )
+      {
+         return NULL;
+      }
+
+      src = DecodeGroup ( src, mode, zigzag, &deltas[g * VERTEX_GROUP_SIZE] );
+   }
+
+   return src;
+}
+
+///
+// PrefixSumLane()
+//
+//    Replace the deltas of one lane by their running sum, starting from
+//    the lane's value in the previous vertex.  Returns the last value.
+//
+static GLubyte PrefixSumLane ( GLubyte *deltas, int count, GLubyte last )
+{
+   int i;
+
+#ifdef ES_CODEC_SSE
+   __m128i carry = _mm_set1_epi8 ( ( char ) last );
+
+   for ( i = 0; i < count; i += VERTEX_GROUP_SIZE )
+   {
+      __m128i x = _mm_loadu_si128 ( ( const __m128i * ) &deltas[i] );
+
+      x = _mm_add_epi8 ( x, _mm_slli_si128 ( x, 1 ) );
+      x = _mm_add_epi8 ( x, _mm_slli_si128 ( x, 2 ) );
+      x = _mm_add_epi8 ( x, _mm_slli_si128 ( x, 4 ) );
+      x = _mm_add_epi8 ( x, _mm_slli_si128 ( x, 8 ) );
+      x = _mm_add_epi8 ( x, carry );
+      _mm_storeu_si128 ( ( __m128i * ) &deltas[i], x );
+
+      // Broadcast the last byte as the carry into the next group
+      x = _mm_unpackhi_epi8 ( x, x );
+      x = _mm_unpackhi_epi16 ( x, x );
+      carry = _mm_shuffle_epi32 ( x, 0xFF );
+   }
+#else
+   for ( i = 0; i < count; i++ )
+   {
+      last = ( GLubyte ) ( last + deltas[i] );
+      deltas[i] = last;
+   }
+#endif
+
+   return deltas[count - 1];
+}
+
+#ifdef ES_CODEC_SSE
+///
+// StoreWords()
+//
+//    Store the four 32-bit elements of v to consecutive vertices
+//
+static void StoreWords ( GLubyte *dst, int vertexSize, __m128i v )
+{
+   int words[4];
+
+   words[0] = _mm_cvtsi128_si32 ( v );
+   words[1] = _mm_cvtsi128_si32 ( _mm_shuffle_epi32 ( v, 0x55 ) );
+   words[2] = _mm_cvtsi128_si32 ( _mm_shuffle_epi32 ( v, 0xAA ) );
+   words[3] = _mm_cvtsi128_si32 ( _mm_shuffle_epi32 ( v, 0xFF ) );
+
+   memcpy ( dst, &words[0], 4 );
+   memcpy ( dst + vertexSize, &words[1], 4 );
+   memcpy ( dst + 2 * vertexSize, &words[2], 4 );
+   memcpy ( dst + 3 * vertexSize, &words[3], 4 );
+}
+#endif
+
+///
+// InterleaveLanes()
+//
+//    Write numLanes decoded lanes to consecutive bytes of count vertices
+//
+static void InterleaveLanes ( GLubyte lanes[4][VERTEX_BLOCK_SIZE], int numLanes, int count, GLubyte *dst, int vertexSize )
+{
+   int i;
+   int k;
+
+#ifdef ES_CODEC_SSE
+   if ( numLanes == 4 )
+   {
+      for ( i = 0; i < count; i += VERTEX_GROUP_SIZE )
+      {
+         __m128i l0 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[0][i] );
+         __m128i l1 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[1][i] );
+         __m128i l2 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[2][i] );
+         __m128i l3 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[3][i] );
+         __m128i lo01 = _mm_unpacklo_epi8 ( l0, l1 );
+         __m128i hi01 = _mm_unpackhi_epi8 ( l0, l1 );
+         __m128i lo23 = _mm_unpacklo_epi8 ( l2, l3 );
+         __m128i hi23 = _mm_unpackhi_epi8 ( l2, l3 );
+         __m128i w0 = _mm_unpacklo_epi16 ( lo01, lo23 );
+         __m128i w1 = _mm_unpackhi_epi16 ( lo01, lo23 );
+         __m128i w2 = _mm_unpacklo_epi16 ( hi01, hi23 );
+         __m128i w3 = _mm_unpackhi_epi16 ( hi01, hi23 );
+         GLubyte *out = &dst[i * vertexSize];
+
+         // Each 32-bit element now holds the four bytes of one vertex
+         if ( count - i >= VERTEX_GROUP_SIZE )
+         {
+            StoreWords ( out, vertexSize, w0 );
+            StoreWords ( out + 4 * vertexSize, vertexSize, w1 );
+            StoreWords ( out + 8 * vertexSize, vertexSize, w2 );
+            StoreWords ( out + 12 * vertexSize, vertexSize, w3 );
+         }
+         else
+         {
+            GLubyte words[4 * VERTEX_GROUP_SIZE];
+            int     j;
+
+            _mm_storeu_si128 ( ( __m128i * ) &words[0], w0 );
+            _mm_storeu_si128 ( ( __m128i * ) &words[16], w1 );
+            _mm_storeu_si128 ( ( __m128i * ) &words[32], w2 );
+            _mm_storeu_si128 ( ( __m128i * ) &words[48], w3 );
+
+            for ( j = 0; j < count - i; j++ )
+            {
+               memcpy ( &out[j * vertexSize], &words[4 * j], 4 );
+            }
+         }
+      }
+
+      return;
+   }
+#endif
+
+   for ( i = 0; i < count; i++ )
+   {
+      for ( k = 0; k < numLanes; k++ )
+      {
+         dst[i * vertexSize + k] = lanes[k][i];
+      }
+   }
+}
+
+///
+// PrefixSumIndices()
+//
+//    Reassemble the zigzag deltas of count indices from their four byte
+//    lanes, undo the zigzag coding and replace them by their running sum,
+//    starting from the previous index.  Returns the last index.
+//
+static GLuint PrefixSumIndices ( GLubyte lanes[4][VERTEX_BLOCK_SIZE], int count, GLuint last, GLuint *indices )
+{
+   int i;
+
+#ifdef ES_CODEC_SSE
+   __m128i one = _mm_set1_epi32 ( 1 );
+   __m128i carry = _mm_set1_epi32 ( ( int ) last );
+
+   for ( i = 0; i < count; i += VERTEX_GROUP_SIZE )
+   {
+      __m128i l0 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[0][i] );
+      __m128i l1 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[1][i] );
+      __m128i l2 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[2][i] );
+      __m128i l3 = _mm_loadu_si128 ( ( const __m128i * ) &lanes[3][i] );
+      __m128i lo01 = _mm_unpacklo_epi8 ( l0, l1 );
+      __m128i hi01 = _mm_unpackhi_epi8 ( l0, l1 );
+      __m128i lo23 = _mm_unpacklo_epi8 ( l2, l3 );
+      __m128i hi23 = _mm_unpackhi_epi8 ( l2, l3 );
+      __m128i z[4];
+      GLuint  words[VERTEX_GROUP_SIZE];
+      GLuint *out = count - i >= VERTEX_GROUP_SIZE ? &indices[i] : words;
+      int     j;
+
+      // Each 32-bit element now holds the four bytes of one delta
+      z[0] = _mm_unpacklo_epi16 ( lo01, lo23 );
+      z[1] = _mm_unpackhi_epi16 ( lo01, lo23 );
+      z[2] = _mm_unpacklo_epi16 ( hi01, hi23 );
+      z[3] = _mm_unpackhi_epi16 ( hi01, hi23 );
+
+      for ( j = 0; j < 4; j++ )
+      {
+         // ( z >> 1 ) ^ -( z & 1 )
+         __m128i x = _mm_xor_si128 ( _mm_srli_epi32 ( z[j], 1 ),
+                                     _mm_sub_epi32 ( _mm_setzero_si128 (), _mm_and_si128 ( z[j], one ) ) );
+
+         x = _mm_add_epi32 ( x, _mm_slli_si128 ( x, 4 ) );
+         x = _mm_add_epi32 ( x, _mm_slli_si128 ( x, 8 ) );
+         x = _mm_add_epi32 ( x, carry );
+         _mm_storeu_si128 ( ( __m128i * ) &out[4 * j], x );
+         carry = _mm_shuffle_epi32 ( x, 0xFF );
+      }
+
+      if ( out == words )
+      {
+         memcpy ( &indices[i], words, ( count - i ) * sizeof ( GLuint ) );
+      }
+   }
+#else
+   for ( i = 0; i < count; i++ )
+   {
+      GLuint zigzag = lanes[0][i] | ( lanes[1][i] << 8 ) | ( lanes[2][i] << 16 ) | ( ( GLuint ) lanes[3][i] << 24 );
+
+      last += ( zigzag >> 1 ) ^ ( 0u - ( zigzag & 1 ) );
+      indices[i] = last;
+   }
+#endif
+
+   return indices[count - 1];
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esEncodeVertexBufferBound()
+//
+int ESUTIL_API esEncodeVertexBufferBound ( int numVertices, int vertexSize )
+{
+   int numBlocks = ( numVertices + VERTEX_BLOCK_SIZE - 1 ) / VERTEX_BLOCK_SIZE;
+   int numGroups = ( numVertices + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE + numBlocks;
+
+   // Every group stored raw plus one header byte per 4 groups
+   return 1 + vertexSize * ( numGroups * VERTEX_GROUP_SIZE + numGroups / 4 + numBlocks );
+}
+
+///
+// esEncodeVertexBuffer()
+//
+int ESUTIL_API esEncodeVertexBuffer ( GLubyte *dst, int dstSize, const void *vertices, int numVertices, int vertexSize )
+{
+   const GLubyte *src = vertices;
+   const GLubyte *dstEnd = dst + dstSize;
+   GLubyte       *out = dst;
+   GLubyte        last[VERTEX_MAX_SIZE];
+   GLubyte        zigzag[VERTEX_BLOCK_SIZE];
+   int            start;
+   int            k;
+   int            i;
+
+   if ( vertexSize <= 0 || vertexSize > VERTEX_MAX_SIZE || dstSize < 1 )
+   {
+      return 0;
+   }
+
+   *out++ = VERTEX_CODEC_HEADER;
+   memset ( last, 0, sizeof ( last ) );
+
+   for ( start = 0; start < numVertices; start += VERTEX_BLOCK_SIZE )
+   {
+      int count = numVertices - start < VERTEX_BLOCK_SIZE ? numVertices - start : VERTEX_BLOCK_SIZE;
+      int numGroups = ( count + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE;
+
+      for ( k = 0; k < vertexSize; k++ )
+      {
+         GLubyte previous = last[k];
+
+         memset ( zigzag, 0, sizeof ( zigzag ) );
+
+         for ( i = 0; i < count; i++ )
+         {
+            GLubyte value = src[( start + i ) * vertexSize + k];
+            GLubyte delta = ( GLubyte ) ( value - previous );
+
+            zigzag[i] = ( GLubyte ) ( ( delta << 1 ) ^ ( ( signed char ) delta >> 7 ) );
+            previous = value;
+         }
+
+         out = EncodeLane ( out, dstEnd, zigzag, numGroups );
+
+         if ( out == NULL )
+         {
+            return 0;
+         }
+      }
+
+      memcpy ( last, &src[( start + count - 1 ) * vertexSize], vertexSize );
+   }
+
+   return ( int ) ( out - dst );
+}
+
+///
+// esDecodeVertexBuffer()
+//
+GLboolean ESUTIL_API esDecodeVertexBuffer ( void *vertices, int numVertices, int vertexSize, const GLubyte *src, int srcSize )
+{
+   GLubyte       *dst = vertices;
+   const GLubyte *srcEnd = src + srcSize;
+   GLubyte        last[VERTEX_MAX_SIZE];
+   GLubyte        lanes[4][VERTEX_BLOCK_SIZE];
+   int            start;
+   int            k;
+
+   if ( vertexSize <= 0 || vertexSize > VERTEX_MAX_SIZE || srcSize < 1 || *src++ != VERTEX_CODEC_HEADER )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( last, 0, sizeof ( last ) );
+
+   for ( start = 0; start < numVertices; start += VERTEX_BLOCK_SIZE )
+   {
+      int count = numVertices - start < VERTEX_BLOCK_SIZE ? numVertices - start : VERTEX_BLOCK_SIZE;
+      int numGroups = ( count + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE;
+
+      for ( k = 0; k < vertexSize; k++ )
+      {
+         GLubyte *deltas = lanes[k % 4];
+
+         src = DecodeLane ( src, srcEnd, numGroups, GL_TRUE, deltas );
+
+         if ( src == NULL )
+         {
+            return GL_FALSE;
+         }
+
+         last[k] = PrefixSumLane ( deltas, count, last[k] );
+
+         // Lanes are written out four at a time
+         if ( k % 4 == 3 || k == vertexSize - 1 )
+         {
+            InterleaveLanes ( lanes, k % 4 + 1, count, &dst[start * vertexSize + k - k % 4], vertexSize );
+         }
+      }
+   }
+
+   return src == srcEnd;
+}
+
+///
+// esEncodeIndexBufferBound()
+//
+int ESUTIL_API esEncodeIndexBufferBound ( int numIndices )
+{
+   int numBlocks = ( numIndices + VERTEX_BLOCK_SIZE - 1 ) / VERTEX_BLOCK_SIZE;
+   int numGroups = ( numIndices + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE + numBlocks;
+
+   // Every group of the four lanes stored raw plus one header byte per 4 groups
+   return 1 + 4 * ( numGroups * VERTEX_GROUP_SIZE + numGroups / 4 + numBlocks );
+}
+
+///
+// esEncodeIndexBuffer()
+//
+int ESUTIL_API esEncodeIndexBuffer ( GLubyte *dst, int dstSize, const GLuint *indices, int numIndices )
+{
+   const GLubyte *dstEnd = dst + dstSize;
+   GLubyte       *out = dst;
+   GLuint         last = 0;
+   GLubyte        zigzag[VERTEX_BLOCK_SIZE];
+   int            start;
+   int            k;
+   int            i;
+
+   if ( dstSize < 1 )
+   {
+      return 0;
+   }
+
+   *out++ = INDEX_CODEC_HEADER;
+
+   for ( start = 0; start < numIndices; start += VERTEX_BLOCK_SIZE )
+   {
+      int count = numIndices - start < VERTEX_BLOCK_SIZE ? numIndices - start : VERTEX_BLOCK_SIZE;
+      int numGroups = ( count + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE;
+
+      // The 32-bit zigzag deltas are stored one byte lane at a time, so the
+      // upper lanes of small steps cost nothing
+      for ( k = 0; k < 4; k++ )
+      {
+         GLuint previous = last;
+
+         memset ( zigzag, 0, sizeof ( zigzag ) );
+
+         for ( i = 0; i < count; i++ )
+         {
+            GLuint delta = indices[start + i] - previous;
+
+            zigzag[i] = ( GLubyte ) ( ( ( delta << 1 ) ^ ( GLuint ) ( ( GLint ) delta >> 31 ) ) >> ( 8 * k ) );
+            previous = indices[start + i];
+         }
+
+         out = EncodeLane ( out, dstEnd, zigzag, numGroups );
+
+         if ( out == NULL )
+         {
+            return 0;
+         }
+      }
+
+      last = indices[start + count - 1];
+   }
+
+   return ( int ) ( out - dst );
+}
+
+///
+// esDecodeIndexBuffer()
+//
+GLboolean ESUTIL_API esDecodeIndexBuffer ( GLuint *indices, int numIndices, const GLubyte *src, int srcSize )
+{
+   const GLubyte *srcEnd = src + srcSize;
+   GLuint         last = 0;
+   GLubyte        lanes[4][VERTEX_BLOCK_SIZE];
+   int            start;
+   int            k;
+
+   if ( srcSize < 1 || *src++ != INDEX_CODEC_HEADER )
+   {
+      return GL_FALSE;
+   }
+
+   for ( start = 0; start < numIndices; start += VERTEX_BLOCK_SIZE )
+   {
+      int count = numIndices - start < VERTEX_BLOCK_SIZE ? numIndices - start : VERTEX_BLOCK_SIZE;
+      int numGroups = ( count + VERTEX_GROUP_SIZE - 1 ) / VERTEX_GROUP_SIZE;
+
+      for ( k = 0; k < 4; k++ )
+      {
+         src = DecodeLane ( src, srcEnd, numGroups, GL_FALSE, lanes[k] );
+
+         if ( src == NULL )
+         {
+            return GL_FALSE;
+         }
+      }
+
+      last = PrefixSumIndices ( lanes, count, last, &indices[start] );
+   }
+
+   return src == srcEnd;
+}
+
+///
+// esCacheStoreMesh()
+//
+GLboolean ESUTIL_API esCacheStoreMesh ( const char *cacheDir, const char *name, GLuint64 key, const void *vertices,
+                                        int numVertices, int vertexSize, const GLuint *indices, int numIndices )
+{
+   MeshHeader header;
+   GLubyte   *data;
+   GLboolean  stored = GL_FALSE;
+   int        vertexBound = esEncodeVertexBufferBound ( numVertices, vertexSize );
+   int        indexBound = esEncodeIndexBufferBound ( numIndices );
+
+   if ( cacheDir == NULL || numVertices < 0 || numIndices < 0 )
+   {
+      return GL_FALSE;
+   }
+
+   data = malloc ( sizeof ( MeshHeader ) + vertexBound + indexBound );
+
+   if ( data == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   header.numVertices = numVertices;
+   header.vertexSize = vertexSize;
+   header.numIndices = numIndices;
+   header.vertexDataSize = esEncodeVertexBuffer ( data + sizeof ( MeshHeader ), vertexBound, vertices,
+                                                  numVertices, vertexSize );
+   header.indexDataSize = esEncodeIndexBuffer ( data + sizeof ( MeshHeader ) + header.vertexDataSize, indexBound,
+                                                indices, numIndices );
+
+   if ( header.vertexDataSize > 0 && header.indexDataSize > 0 )
+   {
+      memcpy ( data, &header, sizeof ( MeshHeader ) );
+      stored = esCacheStore ( cacheDir, name, key, data,
+                              sizeof ( MeshHeader ) + header.vertexDataSize + header.indexDataSize );
+   }
+
+   free ( data );
+   return stored;
+}
+
+///
+// esCacheLoadMesh()
+//
+GLboolean ESUTIL_API esCacheLoadMesh ( const char *cacheDir, const char *name, GLuint64 key, int vertexSize,
+                                       void **vertices, int *numVertices, GLuint **indices, int *numIndices )
+{
+   ESFileMapping  mapping;
+   MeshHeader     header;
+   const GLubyte *data;
+   size_t         size;
+   GLboolean      decoded = GL_FALSE;
+
+   *vertices = NULL;
+   *indices = NULL;
+   data = esCacheLoad ( cacheDir, name, key, &mapping, &size );
+
+   if ( data == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   if ( size >= sizeof ( MeshHeader ) )
+   {
+      memcpy ( &header, data, sizeof ( MeshHeader ) );
+
+      if ( header.vertexSize == vertexSize && header.numVertices >= 0 && header.numIndices >= 0 &&
+           header.vertexDataSize > 0 && header.indexDataSize > 0 &&
+           size - sizeof ( MeshHeader ) == ( size_t ) header.vertexDataSize + header.indexDataSize )
+      {
+         // At least one byte each, as malloc ( 0 ) may return NULL
+         *vertices = malloc ( ( size_t ) header.numVertices * vertexSize + 1 );
+         *indices = malloc ( ( size_t ) header.numIndices * sizeof ( GLuint ) + 1 );
+
+         decoded = *vertices != NULL && *indices != NULL &&
+                   esDecodeVertexBuffer ( *vertices, header.numVertices, vertexSize,
+                                          data + sizeof ( MeshHeader ), header.vertexDataSize ) &&
+                   esDecodeIndexBuffer ( *indices, header.numIndices,
+                                         data + sizeof ( MeshHeader ) + header.vertexDataSize, header.indexDataSize );
+      }
+   }
+
+   esUnmapFile ( &mapping );
+
+   if ( !decoded )
+   {
+      free ( *vertices );
+      free ( *indices );
+      *vertices = NULL;
+      *indices = NULL;
+      return GL_FALSE;
+   }
+
+   *numVertices = header.numVertices;
+   *numIndices = header.numIndices;
+   return GL_TRUE;
+}
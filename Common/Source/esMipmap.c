@@ -0,0 +1,653 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESMipmap.c
+//
+//    Mip chain generation for 8-bit images with one to four channels.
+//    Each level is resampled from the previous one by a separable filter:
+//    a box filter weighted by the area each source texel covers, so odd
+//    sizes lose no rows or columns, or a Kaiser or Lanczos windowed sinc
+//    for sharper results.  Color channels of sRGB images are averaged in
+//    linear space.  Rows of a level are spread over the available cores.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ES_MIPMAP_SSE2
+#endif
+
+///
+//  Macros
+//
+#define KAISER_ALPHA        4.0
+#define FILTER_RADIUS       3.0
+#define SRGB_ENCODE_SIZE    4096
+
+///
+//  Types
+//
+typedef struct
+{
+   // Source texel indices and weights of every destination texel, taps of
+   // them each
+   int     taps;
+   int    *index;
+   float  *weight;
+} Filter;
+
+typedef struct
+{
+   const GLubyte *src;
+   int            srcWidth;
+   GLubyte       *dst;
+   int            dstWidth;
+   int            components;
+   GLboolean      srgb;
+   const Filter  *columns;
+   const Filter  *rows;
+
+   // Set by a worker that could not allocate its rows
+   GLboolean      failed;
+} MipLevelJob;
+
+///
+//  Tables
+//
+static float   srgbToLinear[256];
+static GLubyte linearToSrgb[SRGB_ENCODE_SIZE + 1];
+
+#ifdef _WIN32
+static INIT_ONCE      srgbTablesOnce = INIT_ONCE_STATIC_INIT;
+#else
+static pthread_once_t srgbTablesOnce = PTHREAD_ONCE_INIT;
+#endif
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// BuildSrgbTables()
+//
+#ifdef _WIN32
+static BOOL CALLBACK BuildSrgbTables ( PINIT_ONCE once, PVOID param, PVOID *context )
+#else
+static void BuildSrgbTables ( void )
+#endif
+{
+   int i;
+
+   for ( i = 0; i <= SRGB_ENCODE_SIZE; i++ )
+   {
+      double linear = ( double ) i / SRGB_ENCODE_SIZE;
+      double srgb = linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow ( linear, 1.0 / 2.4 ) - 0.055;
+
+      linearToSrgb[i] = ( GLubyte ) ( srgb * 255.0 + 0.5 );
+   }
+
+   for ( i = 0; i < 256; i++ )
+   {
+      double srgb = i / 255.0;
+
+      srgbToLinear[i] = ( float ) ( srgb <= 0.04045 ? srgb / 12.92 : pow ( ( srgb + 0.055 ) / 1.055, 2.4 ) );
+   }
+
+#ifdef _WIN32
+   return TRUE;
+#endif
+}
+
+///
+// InitSrgbTables()
+//
+//    Build the tables the first time, once even if several threads
+//    generate mip chains at the same time
+//
+static void InitSrgbTables ( void )
+{
+#ifdef _WIN32
+   InitOnceExecuteOnce ( &srgbTablesOnce, BuildSrgbTables, NULL, NULL );
+#else
+   pthread_once ( &srgbTablesOnce, BuildSrgbTables );
+#endif
+}
+
+///
+// Sinc()
+//
+static double Sinc ( double x )
+{
+   const double pi = 3.14159265358979323846;
+
+   return fabs ( x ) < 1e-6 ? 1.0 : sin ( pi * x ) / ( pi * x );
+}
+
+///
+// BesselI0()
+//
+//    Modified Bessel function of the first kind, for the Kaiser window
+//
+static double BesselI0 ( double x )
+{
+   double sum = 1.0;
+   double term = 1.0;
+   int    k;
+
+   for ( k = 1; k < 32 && term > sum * 1e-12; k++ )
+   {
+      term *= ( x / ( 2.0 * k ) ) * ( x / ( 2.0 * k ) );
+      sum += term;
+   }
+
+   return sum;
+}
+
+///
+// Kernel()
+//
+//    Weight of a texel at distance x, in destination texels, from the
+//    center of a destination texel
+//
+static double Kernel ( int filter, double x )
+{
+   if ( fabs ( x ) >= FILTER_RADIUS )
+   {
+      return 0.0;
+   }
+
+   if ( filter == ES_MIP_FILTER_LANCZOS )
+   {
+      return Sinc ( x ) * Sinc ( x / FILTER_RADIUS );
+   }
+
+   return Sinc ( x ) * BesselI0 ( KAISER_ALPHA * sqrt ( 1.0 - ( x / FILTER_RADIUS ) * ( x / FILTER_RADIUS ) ) ) /
+          BesselI0 ( KAISER_ALPHA );
+}
+
+///
+// InitFilter()
+//
+//    Taps that resample srcSize texels to dstSize.  Indices past the edges
+//    are clamped and the weights of every destination texel add up to 1.
+//
+static GLboolean InitFilter ( Filter *f, int filter, int srcSize, int dstSize )
+{
+   double scale = ( double ) srcSize / dstSize;
+   double radius = filter == ES_MIP_FILTER_BOX ? 0.5 * scale : FILTER_RADIUS * scale;
+   int    x, t;
+
+   f->taps = ( int ) ceil ( 2.0 * radius ) + 1;
+   f->index = malloc ( sizeof ( int ) * dstSize * f->taps );
+   f->weight = malloc ( sizeof ( float ) * dstSize * f->taps );
+
+   if ( f->index == NULL || f->weight == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   for ( x = 0; x < dstSize; x++ )
+   {
+      double center = ( x + 0.5 ) * scale;
+      int    first = ( int ) floor ( center - radius );
+      double sum = 0.0;
+
+      for ( t = 0; t < f->taps; t++ )
+      {
+         int    i = first + t;
+         double w;
+
+         if ( filter == ES_MIP_FILTER_BOX )
+         {
+            double lo = i > center - radius ? i : center - radius;
+            double hi = i + 1 < center + radius ? i + 1 : center + radius;
+
+            w = hi > lo ? hi - lo : 0.0;
+         }
+         else
+         {
+            w = Kernel ( filter, ( i + 0.5 - center ) / scale );
+         }
+
+         f->index[x * f->taps + t] = i < 0 ? 0 : i >= srcSize ? srcSize - 1 : i;
+         f->weight[x * f->taps + t] = ( float ) w;
+         sum += w;
+      }
+
+      for ( t = 0; t < f->taps; t++ )
+      {
+         f->weight[x * f->taps + t] = ( float ) ( f->weight[x * f->taps + t] / sum );
+      }
+   }
+
+   return GL_TRUE;
+}
+
+///
+// FreeFilter()
+//
+static void FreeFilter ( Filter *f )
+{
+   free ( f->index );
+   free ( f->weight );
+}
+
+///
+// AccumulateRow()
+//
+//    acc += weight * row, one float per byte of the row
+//
+static void AccumulateRow ( float *acc, const GLubyte *row, int count, float weight )
+{
+   int i = 0;
+
+#ifdef ES_MIPMAP_SSE2
+   __m128  w = _mm_set1_ps ( weight );
+   __m128i zero = _mm_setzero_si128 ();
+
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      __m128i bytes = _mm_loadu_si128 ( ( const __m128i * ) ( row + i ) );
+      __m128i lo = _mm_unpacklo_epi8 ( bytes, zero );
+      __m128i hi = _mm_unpackhi_epi8 ( bytes, zero );
+
+      _mm_storeu_ps ( acc + i, _mm_add_ps ( _mm_loadu_ps ( acc + i ),
+                      _mm_mul_ps ( w, _mm_cvtepi32_ps ( _mm_unpacklo_epi16 ( lo, zero ) ) ) ) );
+      _mm_storeu_ps ( acc + i + 4, _mm_add_ps ( _mm_loadu_ps ( acc + i + 4 ),
+                      _mm_mul_ps ( w, _mm_cvtepi32_ps ( _mm_unpackhi_epi16 ( lo, zero ) ) ) ) );
+      _mm_storeu_ps ( acc + i + 8, _mm_add_ps ( _mm_loadu_ps ( acc + i + 8 ),
+                      _mm_mul_ps ( w, _mm_cvtepi32_ps ( _mm_unpacklo_epi16 ( hi, zero ) ) ) ) );
+      _mm_storeu_ps ( acc + i + 12, _mm_add_ps ( _mm_loadu_ps ( acc + i + 12 ),
+                      _mm_mul_ps ( w, _mm_cvtepi32_ps ( _mm_unpackhi_epi16 ( hi, zero ) ) ) ) );
+   }
+#endif
+
+   for ( ; i < count; i++ )
+   {
+      acc[i] += weight * row[i];
+   }
+}
+
+///
+// AccumulateRowSrgb()
+//
+//    acc += weight * row with the color channels decoded from sRGB; the
+//    fourth channel is alpha and stays linear
+//
+static void AccumulateRowSrgb ( float *acc, const GLubyte *row, int count, int components, float weight )
+{
+   float alphaWeight = weight * ( 1.0f / 255.0f );
+   int   i;
+
+   for ( i = 0; i < count; i++ )
+   {
+      acc[i] += ( i & 3 ) == 3 && components == 4 ? alphaWeight * row[i] : weight * srgbToLinear[row[i]];
+   }
+}
+
+///
+// FilterColumns()
+//
+//    Horizontal pass of one row: dst = sum of weight * acc over the taps
+//
+static void FilterColumns ( float *dst, const float *acc, const Filter *columns, int dstWidth, int components )
+{
+   int x, t, c;
+
+#ifdef ES_MIPMAP_SSE2
+   if ( components == 4 )
+   {
+      for ( x = 0; x < dstWidth; x++ )
+      {
+         const int   *index = columns->index + x * columns->taps;
+         const float *weight = columns->weight + x * columns->taps;
+         __m128       sum = _mm_setzero_ps ();
+
+         for ( t = 0; t < columns->taps; t++ )
+         {
+            sum = _mm_add_ps ( sum, _mm_mul_ps ( _mm_set1_ps ( weight[t] ), _mm_loadu_ps ( acc + index[t] * 4 ) ) );
+         }
+
+         _mm_storeu_ps ( dst + x * 4, sum );
+      }
+
+      return;
+   }
+#endif
+
+   for ( x = 0; x < dstWidth; x++ )
+   {
+      const int   *index = columns->index + x * columns->taps;
+      const float *weight = columns->weight + x * columns->taps;
+
+      for ( c = 0; c < components; c++ )
+      {
+         float sum = 0.0f;
+
+         for ( t = 0; t < columns->taps; t++ )
+         {
+            sum += weight[t] * acc[index[t] * components + c];
+         }
+
+         dst[x * components + c] = sum;
+      }
+   }
+}
+
+///
+// StoreRow()
+//
+//    Round and clamp filtered values back to bytes
+//
+static void StoreRow ( GLubyte *dst, const float *values, int count, int components, GLboolean srgb )
+{
+   int i = 0;
+
+   if ( srgb )
+   {
+      for ( i = 0; i < count; i++ )
+      {
+         float v = values[i];
+
+         if ( ( i & 3 ) == 3 && components == 4 )
+         {
+            v = v * 255.0f + 0.5f;
+            dst[i] = ( GLubyte ) ( v <= 0.0f ? 0.0f : v >= 255.0f ? 255.0f : v );
+         }
+         else
+         {
+            v = v * SRGB_ENCODE_SIZE + 0.5f;
+            dst[i] = linearToSrgb[( int ) ( v <= 0.0f ? 0.0f : v >= SRGB_ENCODE_SIZE ? SRGB_ENCODE_SIZE : v )];
+         }
+      }
+
+      return;
+   }
+
+#ifdef ES_MIPMAP_SSE2
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      // Rounded as the scalar loop does; the packs saturate to [0, 255]
+      __m128  half = _mm_set1_ps ( 0.5f );
+      __m128i a = _mm_cvttps_epi32 ( _mm_add_ps ( _mm_loadu_ps ( values + i ), half ) );
+      __m128i b = _mm_cvttps_epi32 ( _mm_add_ps ( _mm_loadu_ps ( values + i + 4 ), half ) );
+      __m128i c = _mm_cvttps_epi32 ( _mm_add_ps ( _mm_loadu_ps ( values + i + 8 ), half ) );
+      __m128i d = _mm_cvttps_epi32 ( _mm_add_ps ( _mm_loadu_ps ( values + i + 12 ), half ) );
+
+      _mm_storeu_si128 ( ( __m128i * ) ( dst + i ), _mm_packus_epi16 ( _mm_packs_epi32 ( a, b ), _mm_packs_epi32 ( c, d ) ) );
+   }
+#endif
+
+   for ( ; i < count; i++ )
+   {
+      float v = values[i] + 0.5f;
+
+      dst[i] = ( GLubyte ) ( v <= 0.0f ? 0.0f : v >= 255.0f ? 255.0f : v );
+   }
+}
+
+///
+// GenLevelRows()
+//
+//    esParallelFor work function: destination rows [begin, end) of a level.
+//    Rows are filtered vertically first, into one float row of source
+//    width, so no intermediate image is needed.
+//
+static void ESCALLBACK GenLevelRows ( void *userData, int begin, int end )
+{
+   MipLevelJob       *job = userData;
+   int                srcCount = job->srcWidth * job->components;
+   int                dstCount = job->dstWidth * job->components;
+   float             *acc = malloc ( sizeof ( float ) * ( srcCount + dstCount ) );
+   float             *filtered = acc + srcCount;
+   int                y, t;
+
+   if ( acc == NULL )
+   {
+      job->failed = GL_TRUE;
+      return;
+   }
+
+   for ( y = begin; y < end; y++ )
+   {
+      const int   *index = job->rows->index + y * job->rows->taps;
+      const float *weight = job->rows->weight + y * job->rows->taps;
+
+      memset ( acc, 0, sizeof ( float ) * srcCount );
+
+      for ( t = 0; t < job->rows->taps; t++ )
+      {
+         const GLubyte *row = job->src + ( size_t ) index[t] * srcCount;
+
+         if ( weight[t] == 0.0f )
+         {
+            continue;
+         }
+
+         if ( job->srgb )
+         {
+            AccumulateRowSrgb ( acc, row, srcCount, job->components, weight[t] );
+         }
+         else
+         {
+            AccumulateRow ( acc, row, srcCount, weight[t] );
+         }
+      }
+
+      FilterColumns ( filtered, acc, job->columns, job->dstWidth, job->components );
+      StoreRow ( job->dst + ( size_t ) y * dstCount, filtered, dstCount, job->components, job->srgb );
+   }
+
+   free ( acc );
+}
+
+///
+// HalveRows()
+//
+//    esParallelFor work function for the common case of a box filter on
+//    even sizes: every destination texel is the rounded average of 2x2
+//    source texels, computed on integers
+//
+static void ESCALLBACK HalveRows ( void *userData, int begin, int end )
+{
+   const MipLevelJob *job = userData;
+   int                c = job->components;
+   int                srcPitch = job->srcWidth * c;
+   int                y, x, k;
+
+   for ( y = begin; y < end; y++ )
+   {
+      const GLubyte *row0 = job->src + ( size_t ) 2 * y * srcPitch;
+      const GLubyte *row1 = row0 + srcPitch;
+      GLubyte       *dst = job->dst + ( size_t ) y * job->dstWidth * c;
+
+      x = 0;
+
+#ifdef ES_MIPMAP_SSE2
+      if ( c == 4 )
+      {
+         __m128i zero = _mm_setzero_si128 ();
+         __m128i two = _mm_set1_epi16 ( 2 );
+
+         // Four source texels of each row give two destination texels
+         for ( ; x + 2 <= job->dstWidth; x += 2 )
+         {
+            __m128i a = _mm_loadu_si128 ( ( const __m128i * ) ( row0 + x * 8 ) );
+            __m128i b = _mm_loadu_si128 ( ( const __m128i * ) ( row1 + x * 8 ) );
+            __m128i lo = _mm_add_epi16 ( _mm_unpacklo_epi8 ( a, zero ), _mm_unpacklo_epi8 ( b, zero ) );
+            __m128i hi = _mm_add_epi16 ( _mm_unpackhi_epi8 ( a, zero ), _mm_unpackhi_epi8 ( b, zero ) );
+            __m128i sum;
+
+            lo = _mm_add_epi16 ( lo, _mm_srli_si128 ( lo, 8 ) );
+            hi = _mm_add_epi16 ( hi, _mm_srli_si128 ( hi, 8 ) );
+            sum = _mm_srli_epi16 ( _mm_add_epi16 ( _mm_unpacklo_epi64 ( lo, hi ), two ), 2 );
+            _mm_storel_epi64 ( ( __m128i * ) ( dst + x * 4 ), _mm_packus_epi16 ( sum, zero ) );
+         }
+      }
+#endif
+
+      for ( ; x < job->dstWidth; x++ )
+      {
+         for ( k = 0; k < c; k++ )
+         {
+            dst[x * c + k] = ( GLubyte ) ( ( row0[2 * x * c + k] + row0[( 2 * x + 1 ) * c + k] +
+                                             row1[2 * x * c + k] + row1[( 2 * x + 1 ) * c + k] + 2 ) >> 2 );
+         }
+      }
+   }
+}
+
+///
+// GenLevel()
+//
+static GLboolean GenLevel ( const GLubyte *src, int width, int height, int components, int filter,
+                            GLboolean srgb, GLubyte *dst )
+{
+   MipLevelJob job;
+   Filter      columns;
+   Filter      rows;
+   GLboolean   ok;
+
+   job.src = src;
+   job.srcWidth = width;
+   job.dst = dst;
+   job.dstWidth = width > 1 ? width / 2 : 1;
+   job.components = components;
+   job.srgb = srgb;
+   job.columns = &columns;
+   job.rows = &rows;
+   job.failed = GL_FALSE;
+
+   if ( filter == ES_MIP_FILTER_BOX && !srgb && width % 2 == 0 && height % 2 == 0 )
+   {
+      esParallelFor ( height / 2, 1 + 16384 / ( width * components * 2 ), HalveRows, &job );
+      return GL_TRUE;
+   }
+
+   memset ( &columns, 0, sizeof ( columns ) );
+   memset ( &rows, 0, sizeof ( rows ) );
+
+   ok = InitFilter ( &columns, filter, width, job.dstWidth ) &&
+        InitFilter ( &rows, filter, height, height > 1 ? height / 2 : 1 );
+
+   if ( ok )
+   {
+      // Keep at least 16K source bytes of work per thread
+      esParallelFor ( height > 1 ? height / 2 : 1, 1 + 16384 / ( width * components * rows.taps ),
+                      GenLevelRows, &job );
+      ok = !job.failed;
+   }
+
+   FreeFilter ( &columns );
+   FreeFilter ( &rows );
+   return ok;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esMipChainSize()
+//
+GLsizeiptr ESUTIL_API esMipChainSize ( int width, int height, int components, int *numLevels )
+{
+   GLsizeiptr size = 0;
+   int        levels = 1;
+
+   while ( width > 1 || height > 1 )
+   {
+      width = width > 1 ? width / 2 : 1;
+      height = height > 1 ? height / 2 : 1;
+      size += ( GLsizeiptr ) width * height * components;
+      levels++;
+   }
+
+   if ( numLevels != NULL )
+   {
+      *numLevels = levels;
+   }
+
+   return size;
+}
+
+///
+// esGenMipChain()
+//
+GLboolean ESUTIL_API esGenMipChain ( const GLubyte *pixels, int width, int height, int components, int filter,
+                                     GLboolean srgb, GLubyte *chain )
+{
+   const GLubyte *src = pixels;
+
+   if ( width < 1 || height < 1 || components < 1 || components > 4 ||
+        ( filter != ES_MIP_FILTER_BOX && filter != ES_MIP_FILTER_KAISER && filter != ES_MIP_FILTER_LANCZOS ) )
+   {
+      return GL_FALSE;
+   }
+
+   // Before the workers read them
+   if ( srgb )
+   {
+      InitSrgbTables ();
+   }
+
+   while ( width > 1 || height > 1 )
+   {
+      if ( !GenLevel ( src, width, height, components, filter, srgb, chain ) )
+      {
+         return GL_FALSE;
+      }
+
+      width = width > 1 ? width / 2 : 1;
+      height = height > 1 ? height / 2 : 1;
+      src = chain;
+      chain += ( size_t ) width * height * components;
+   }
+
+   return GL_TRUE;
+}
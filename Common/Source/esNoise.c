@@ -0,0 +1,1002 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESNoise.c
+//
+//    Gradient noise volumes for 3D noise textures.  The lattice hashing
+//    is the one of the book's Noise3D sample: a 256 entry permutation
+//    table picks one of 256 random unit gradients for each lattice point,
+//    and the gradients are blended with a quintic fade.
+//
+//    Noise is computed a row at a time: the y and z lattice lookups are
+//    shared by the row, and eight texels along x are blended together,
+//    with SSE2 when available.  Slices are spread over all cores.
+//    Octaves of increasing frequency can be summed (fBm), and in tileable
+//    mode the lattice wraps so that the volume repeats seamlessly.
+//
+//    Volumes can also be rendered on the GPU a slice at a time, twice so
+//    that they are stretched over their range too, and are kept in the
+//    disk cache so that later runs only upload them.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define USE_SSE2
+#endif
+
+///
+// Macros
+//
+#define NOISE_TABLE_SIZE   256
+#define NOISE_TABLE_MASK   255
+#define NOISE_LANES        8
+
+// Largest magnitude of one octave of gradient noise with unit gradients
+#define NOISE_BOUND        0.8660254f
+
+#define PI                 3.14159265358979f
+
+// Version of the generated noise in its disk cache key, to increment
+// whenever the generator changes its output
+#define CACHE_VERSION      1
+
+///
+// Types
+//
+typedef struct
+{
+   int      size;
+   GLfloat  frequency;
+   int      octaves;
+   int      period;
+
+   GLfloat  gradients[NOISE_TABLE_SIZE * 3];
+
+   GLfloat *values;
+   GLfloat *sliceMin;
+   GLfloat *sliceMax;
+
+   GLfloat  bias;
+   GLfloat  scale;
+   GLubyte *volume;
+} NoiseJob;
+
+// Parameters of a volume and version of the generator, hashed for the
+// disk cache
+typedef struct
+{
+   int      version;
+   int      size;
+   GLfloat  frequency;
+   int      octaves;
+   int      tileable;
+   int      render;
+} NoiseParams;
+
+typedef struct
+{
+   NoiseParams params;
+   GLboolean   render;
+
+   // Texture the volume was rendered to, if it was
+   GLuint      textureId;
+} NoiseRequest;
+
+// One octave along a row, and the lines of its last cell
+typedef struct
+{
+   int      period;
+   int      hash[4];
+   GLfloat  offset[4][2];
+   GLfloat  weight[4];
+
+   int      cell;
+   GLfloat  line[4];
+} NoiseOctave;
+
+///
+// Tables
+//
+
+// Random permutation of the values 0 to 255
+static const GLubyte permTable[NOISE_TABLE_SIZE] =
+{
+   0xE1, 0x9B, 0xD2, 0x6C, 0xAF, 0xC7, 0xDD, 0x90, 0xCB, 0x74, 0x46, 0xD5, 0x45, 0x9E, 0x21, 0xFC,
+   0x05, 0x52, 0xAD, 0x85, 0xDE, 0x8B, 0xAE, 0x1B, 0x09, 0x47, 0x5A, 0xF6, 0x4B, 0x82, 0x5B, 0xBF,
+   0xA9, 0x8A, 0x02, 0x97, 0xC2, 0xEB, 0x51, 0x07, 0x19, 0x71, 0xE4, 0x9F, 0xCD, 0xFD, 0x86, 0x8E,
+   0xF8, 0x41, 0xE0, 0xD9, 0x16, 0x79, 0xE5, 0x3F, 0x59, 0x67, 0x60, 0x68, 0x9C, 0x11, 0xC9, 0x81,
+   0x24, 0x08, 0xA5, 0x6E, 0xED, 0x75, 0xE7, 0x38, 0x84, 0xD3, 0x98, 0x14, 0xB5, 0x6F, 0xEF, 0xDA,
+   0xAA, 0xA3, 0x33, 0xAC, 0x9D, 0x2F, 0x50, 0xD4, 0xB0, 0xFA, 0x57, 0x31, 0x63, 0xF2, 0x88, 0xBD,
+   0xA2, 0x73, 0x2C, 0x2B, 0x7C, 0x5E, 0x96, 0x10, 0x8D, 0xF7, 0x20, 0x0A, 0xC6, 0xDF, 0xFF, 0x48,
+   0x35, 0x83, 0x54, 0x39, 0xDC, 0xC5, 0x3A, 0x32, 0xD0, 0x0B, 0xF1, 0x1C, 0x03, 0xC0, 0x3E, 0xCA,
+   0x12, 0xD7, 0x99, 0x18, 0x4C, 0x29, 0x0F, 0xB3, 0x27, 0x2E, 0x37, 0x06, 0x80, 0xA7, 0x17, 0xBC,
+   0x6A, 0x22, 0xBB, 0x8C, 0xA4, 0x49, 0x70, 0xB6, 0xF4, 0xC3, 0xE3, 0x0D, 0x23, 0x4D, 0xC4, 0xB9,
+   0x1A, 0xC8, 0xE2, 0x77, 0x1F, 0x7B, 0xA8, 0x7D, 0xF9, 0x44, 0xB7, 0xE6, 0xB1, 0x87, 0xA0, 0xB4,
+   0x0C, 0x01, 0xF3, 0x94, 0x66, 0xA6, 0x26, 0xEE, 0xFB, 0x25, 0xF0, 0x7E, 0x40, 0x4A, 0xA1, 0x28,
+   0xB8, 0x95, 0xAB, 0xB2, 0x65, 0x42, 0x1D, 0x3B, 0x92, 0x3D, 0xFE, 0x6B, 0x2A, 0x56, 0x9A, 0x04,
+   0xEC, 0xE8, 0x78, 0x15, 0xE9, 0xD1, 0x2D, 0x62, 0xC1, 0x72, 0x4E, 0x13, 0xCE, 0x0E, 0x76, 0x7F,
+   0x30, 0x4F, 0x93, 0x55, 0x1E, 0xCF, 0xDB, 0x36, 0x58, 0xEA, 0xBE, 0x7A, 0x5F, 0x43, 0x8F, 0x6D,
+   0x89, 0xD6, 0x91, 0x5D, 0x5C, 0x64, 0xF5, 0x00, 0xD8, 0xBA, 0x3C, 0x53, 0x69, 0x61, 0xCC, 0x34,
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// InitGradients()
+//
+//    Random unit gradients, from a fixed linear congruential sequence so
+//    that the noise is the same on every platform
+//
+static void InitGradients ( GLfloat *gradients )
+{
+   GLuint seed = 0;
+   int    i;
+
+   for ( i = 0; i < NOISE_TABLE_SIZE; i++ )
+   {
+      GLfloat z, r, theta;
+
+      seed = seed * 1664525u + 1013904223u;
+      z = 1.0f - 2.0f * ( ( seed >> 16 ) & 0x7fff ) / 32768.0f;
+      seed = seed * 1664525u + 1013904223u;
+      theta = 2.0f * PI * ( ( seed >> 16 ) & 0x7fff ) / 32768.0f;
+      r = sqrtf ( 1.0f - z * z );
+
+      gradients[i * 3 + 0] = r * cosf ( theta );
+      gradients[i * 3 + 1] = r * sinf ( theta );
+      gradients[i * 3 + 2] = z;
+   }
+}
+
+///
+// Wrap()
+//
+//    Lattice coordinate modulo the period of the noise
+//
+static int Wrap ( int i, int period )
+{
+   i %= period;
+   return i < 0 ? i + period : i;
+}
+
+///
+// NoisePeriod()
+//
+//    Lattice period of a tileable volume
+//
+static int NoisePeriod ( GLfloat frequency )
+{
+   int period = ( int ) ( frequency + 0.5f );
+
+   return period > 0 ? period : 1;
+}
+
+///
+// NoiseBound()
+//
+//    Largest magnitude of the sum of the octaves
+//
+static GLfloat NoiseBound ( int octaves )
+{
+   return NOISE_BOUND * ( 2.0f - 1.0f / ( 1 << ( octaves - 1 ) ) );
+}
+
+///
+// CellLines()
+//
+//    With y and z fixed, the blend of a cell's eight corners is linear in
+//    x on each of its two x faces: v0 = p0 + q0 * fx and
+//    v1 = p1 + q1 * ( fx - 1 ).  Texels then only blend the two lines with
+//    the fade of fx, so these are computed once per cell of a row.
+//
+static void CellLines ( NoiseOctave *octave, const GLfloat *gradients, int ix )
+{
+   int ix0 = Wrap ( ix, octave->period ), ix1 = Wrap ( ix + 1, octave->period );
+   int k;
+
+   memset ( octave->line, 0, sizeof ( octave->line ) );
+   octave->cell = ix;
+
+   for ( k = 0; k < 4; k++ )
+   {
+      const GLfloat *g0 = &gradients[( ( ix0 + octave->hash[k] ) & NOISE_TABLE_MASK ) * 3];
+      const GLfloat *g1 = &gradients[( ( ix1 + octave->hash[k] ) & NOISE_TABLE_MASK ) * 3];
+      GLfloat        weight = octave->weight[k];
+
+      octave->line[0] += weight * ( g0[1] * octave->offset[k][0] + g0[2] * octave->offset[k][1] );
+      octave->line[1] += weight * g0[0];
+      octave->line[2] += weight * ( g1[1] * octave->offset[k][0] + g1[2] * octave->offset[k][1] );
+      octave->line[3] += weight * g1[0];
+   }
+}
+
+///
+// NoiseRow()
+//
+//    Sum the octaves of the noise along a row of the volume
+//
+static void NoiseRow ( const NoiseJob *job, int y, int z, GLfloat *out )
+{
+   GLfloat amplitude = 1.0f;
+   int     octaveIndex, x0, k;
+
+   memset ( out, 0, sizeof ( GLfloat ) * job->size );
+
+   for ( octaveIndex = 0; octaveIndex < job->octaves; octaveIndex++, amplitude *= 0.5f )
+   {
+      NoiseOctave octave;
+      GLfloat     step = job->frequency * ( 1 << octaveIndex ) / job->size;
+      GLfloat     py = y * step, pz = z * step;
+      int         iy = ( int ) py, iz = ( int ) pz;
+      GLfloat     fy = py - iy, fz = pz - iz;
+      GLfloat     wy = fy * fy * fy * ( fy * ( fy * 6.0f - 15.0f ) + 10.0f );
+      GLfloat     wz = fz * fz * fz * ( fz * ( fz * 6.0f - 15.0f ) + 10.0f );
+      int         hz0, hz1, iy0, iy1;
+
+      octave.period = job->period > 0 ? job->period << octaveIndex : NOISE_TABLE_SIZE;
+      octave.cell = -1;
+      hz0 = permTable[Wrap ( iz, octave.period ) & NOISE_TABLE_MASK];
+      hz1 = permTable[Wrap ( iz + 1, octave.period ) & NOISE_TABLE_MASK];
+      iy0 = Wrap ( iy, octave.period );
+      iy1 = Wrap ( iy + 1, octave.period );
+
+      // Edges along x of the row's cells: (y0, z0), (y1, z0), (y0, z1), (y1, z1)
+      octave.hash[0] = permTable[( iy0 + hz0 ) & NOISE_TABLE_MASK];
+      octave.hash[1] = permTable[( iy1 + hz0 ) & NOISE_TABLE_MASK];
+      octave.hash[2] = permTable[( iy0 + hz1 ) & NOISE_TABLE_MASK];
+      octave.hash[3] = permTable[( iy1 + hz1 ) & NOISE_TABLE_MASK];
+
+      for ( k = 0; k < 4; k++ )
+      {
+         octave.offset[k][0] = k & 1 ? fy - 1.0f : fy;
+         octave.offset[k][1] = k & 2 ? fz - 1.0f : fz;
+         octave.weight[k] = ( k & 1 ? wy : 1.0f - wy ) * ( k & 2 ? wz : 1.0f - wz );
+      }
+
+      for ( x0 = 0; x0 < job->size; x0 += NOISE_LANES )
+      {
+         GLfloat value[NOISE_LANES];
+         int     lanes = job->size - x0 < NOISE_LANES ? job->size - x0 : NOISE_LANES;
+         int     lane;
+
+#ifdef USE_SSE2
+         for ( lane = 0; lane < NOISE_LANES; lane += 4 )
+         {
+            __m128  px = _mm_mul_ps ( _mm_add_ps ( _mm_set1_ps ( ( GLfloat ) ( x0 + lane ) ),
+                                                   _mm_set_ps ( 3.0f, 2.0f, 1.0f, 0.0f ) ),
+                                      _mm_set1_ps ( step ) );
+            __m128i ix = _mm_cvttps_epi32 ( px );
+            __m128  fx0 = _mm_sub_ps ( px, _mm_cvtepi32_ps ( ix ) );
+            __m128  fx1 = _mm_sub_ps ( fx0, _mm_set1_ps ( 1.0f ) );
+            __m128  wx = _mm_mul_ps ( _mm_mul_ps ( fx0, _mm_mul_ps ( fx0, fx0 ) ),
+                                      _mm_add_ps ( _mm_mul_ps ( fx0, _mm_sub_ps ( _mm_mul_ps ( fx0, _mm_set1_ps ( 6.0f ) ),
+                                                                                  _mm_set1_ps ( 15.0f ) ) ),
+                                                   _mm_set1_ps ( 10.0f ) ) );
+            __m128  p0, q0, p1, q1, v0, v1;
+            int     cells[4];
+
+            _mm_storeu_si128 ( ( __m128i * ) cells, ix );
+
+            // Four texels are usually in the same cell
+            if ( cells[0] == cells[3] )
+            {
+               if ( cells[0] != octave.cell )
+               {
+                  CellLines ( &octave, job->gradients, cells[0] );
+               }
+
+               p0 = _mm_set1_ps ( octave.line[0] );
+               q0 = _mm_set1_ps ( octave.line[1] );
+               p1 = _mm_set1_ps ( octave.line[2] );
+               q1 = _mm_set1_ps ( octave.line[3] );
+            }
+            else
+            {
+               GLfloat line[4][4];
+
+               for ( k = 0; k < 4; k++ )
+               {
+                  int c;
+
+                  if ( cells[k] != octave.cell )
+                  {
+                     CellLines ( &octave, job->gradients, cells[k] );
+                  }
+
+                  for ( c = 0; c < 4; c++ )
+                  {
+                     line[c][k] = octave.line[c];
+                  }
+               }
+
+               p0 = _mm_loadu_ps ( line[0] );
+               q0 = _mm_loadu_ps ( line[1] );
+               p1 = _mm_loadu_ps ( line[2] );
+               q1 = _mm_loadu_ps ( line[3] );
+            }
+
+            v0 = _mm_add_ps ( p0, _mm_mul_ps ( q0, fx0 ) );
+            v1 = _mm_add_ps ( p1, _mm_mul_ps ( q1, fx1 ) );
+            _mm_storeu_ps ( &value[lane], _mm_add_ps ( v0, _mm_mul_ps ( wx, _mm_sub_ps ( v1, v0 ) ) ) );
+         }
+#else
+         for ( lane = 0; lane < NOISE_LANES; lane++ )
+         {
+            GLfloat px = ( x0 + lane ) * step;
+            int     ix = ( int ) px;
+            GLfloat fx = px - ix;
+            GLfloat wx = fx * fx * fx * ( fx * ( fx * 6.0f - 15.0f ) + 10.0f );
+            GLfloat v0, v1;
+
+            if ( ix != octave.cell )
+            {
+               CellLines ( &octave, job->gradients, ix );
+            }
+
+            v0 = octave.line[0] + octave.line[1] * fx;
+            v1 = octave.line[2] + octave.line[3] * ( fx - 1.0f );
+            value[lane] = v0 + wx * ( v1 - v0 );
+         }
+#endif
+
+         for ( lane = 0; lane < lanes; lane++ )
+         {
+            out[x0 + lane] += amplitude * value[lane];
+         }
+      }
+   }
+}
+
+///
+// NoiseSlices()
+//
+//    Compute slices of the volume and their range
+//
+static void ESCALLBACK NoiseSlices ( void *userData, int begin, int end )
+{
+   NoiseJob *job = userData;
+   size_t    sliceSize = ( size_t ) job->size * job->size;
+   int       z, y, i;
+
+   for ( z = begin; z < end; z++ )
+   {
+      GLfloat *slice = job->values + z * sliceSize;
+      GLfloat  low, high;
+
+      for ( y = 0; y < job->size; y++ )
+      {
+         NoiseRow ( job, y, z, slice + ( size_t ) y * job->size );
+      }
+
+      low = high = slice[0];
+      i = 0;
+
+#ifdef USE_SSE2
+      {
+         __m128 low4 = _mm_set1_ps ( low );
+         __m128 high4 = low4;
+         GLfloat range[8];
+
+         for ( ; i + 4 <= ( int ) sliceSize; i += 4 )
+         {
+            __m128 v = _mm_loadu_ps ( &slice[i] );
+
+            low4 = _mm_min_ps ( low4, v );
+            high4 = _mm_max_ps ( high4, v );
+         }
+
+         _mm_storeu_ps ( &range[0], low4 );
+         _mm_storeu_ps ( &range[4], high4 );
+
+         for ( y = 0; y < 4; y++ )
+         {
+            low = range[y] < low ? range[y] : low;
+            high = range[y + 4] > high ? range[y + 4] : high;
+         }
+      }
+#endif
+
+      for ( ; i < ( int ) sliceSize; i++ )
+      {
+         low = slice[i] < low ? slice[i] : low;
+         high = slice[i] > high ? slice[i] : high;
+      }
+
+      job->sliceMin[z] = low;
+      job->sliceMax[z] = high;
+   }
+}
+
+///
+// QuantizeSlices()
+//
+//    Map slices of the volume from its range to [0, 255]
+//
+static void ESCALLBACK QuantizeSlices ( void *userData, int begin, int end )
+{
+   NoiseJob *job = userData;
+   size_t    sliceSize = ( size_t ) job->size * job->size;
+   size_t    i = begin * sliceSize;
+
+#ifdef USE_SSE2
+   __m128    bias = _mm_set1_ps ( job->bias );
+   __m128    scale = _mm_set1_ps ( job->scale );
+
+   for ( ; i + 16 <= end * sliceSize; i += 16 )
+   {
+      __m128i a = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( &job->values[i] ), bias ), scale ) );
+      __m128i b = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( &job->values[i + 4] ), bias ), scale ) );
+      __m128i c = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( &job->values[i + 8] ), bias ), scale ) );
+      __m128i d = _mm_cvttps_epi32 ( _mm_mul_ps ( _mm_sub_ps ( _mm_loadu_ps ( &job->values[i + 12] ), bias ), scale ) );
+
+      _mm_storeu_si128 ( ( __m128i * ) &job->volume[i],
+                         _mm_packus_epi16 ( _mm_packs_epi32 ( a, b ), _mm_packs_epi32 ( c, d ) ) );
+   }
+#endif
+
+   for ( ; i < end * sliceSize; i++ )
+   {
+      GLfloat value = ( job->values[i] - job->bias ) * job->scale;
+
+      job->volume[i] = ( GLubyte ) ( value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value );
+   }
+}
+
+///
+// GenNoise()
+//
+//    Fill the volume with noise, mapped from its own range
+//
+static GLboolean GenNoise ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLubyte *volume )
+{
+   NoiseJob job;
+   GLfloat  low, high;
+   int      z;
+
+   if ( size < 1 || octaves < 1 || octaves > 16 || frequency <= 0.0f )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( &job, 0, sizeof ( NoiseJob ) );
+   job.size = size;
+   job.frequency = frequency;
+   job.octaves = octaves;
+   job.volume = volume;
+
+   // A whole number of lattice cells across the volume makes it repeat
+   if ( tileable )
+   {
+      job.period = NoisePeriod ( frequency );
+      job.frequency = ( GLfloat ) job.period;
+   }
+
+   InitGradients ( job.gradients );
+
+   job.values = malloc ( sizeof ( GLfloat ) * size * size * size );
+   job.sliceMin = malloc ( sizeof ( GLfloat ) * size );
+   job.sliceMax = malloc ( sizeof ( GLfloat ) * size );
+
+   if ( job.values == NULL || job.sliceMin == NULL || job.sliceMax == NULL )
+   {
+      free ( job.values );
+      free ( job.sliceMin );
+      free ( job.sliceMax );
+      return GL_FALSE;
+   }
+
+   esParallelFor ( size, 1, NoiseSlices, &job );
+
+   // Stretch the range of the noise over the whole [0, 255]
+   low = job.sliceMin[0];
+   high = job.sliceMax[0];
+
+   for ( z = 1; z < size; z++ )
+   {
+      low = job.sliceMin[z] < low ? job.sliceMin[z] : low;
+      high = job.sliceMax[z] > high ? job.sliceMax[z] : high;
+   }
+
+   job.bias = low;
+   job.scale = high > low ? 255.0f / ( high - low ) : 0.0f;
+
+   esParallelFor ( size, 1, QuantizeSlices, &job );
+
+   free ( job.values );
+   free ( job.sliceMin );
+   free ( job.sliceMax );
+
+   return GL_TRUE;
+}
+
+///
+// CreateNoiseTexture()
+//
+//    Allocate the 3D texture, and fill it if volume is not NULL
+//
+static GLuint CreateNoiseTexture ( int size, GLboolean tileable, const GLubyte *volume )
+{
+   GLenum wrap = tileable ? GL_REPEAT : GL_MIRRORED_REPEAT;
+   GLuint textureId = esCreateTexture3D ( volume, size, size, size, 1, 1 );
+
+   if ( textureId == 0 )
+   {
+      return 0;
+   }
+
+   glTexParameteri ( GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+   glTexParameteri ( GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, wrap );
+   glTexParameteri ( GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, wrap );
+   glTexParameteri ( GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, wrap );
+
+   return textureId;
+}
+
+///
+// LoadNoiseProgram()
+//
+//    The fragment shader is a per-texel copy of NoiseRow, reading the
+//    gradients and the permutation from the rgb and a of a 256x1 texture
+//
+static GLuint LoadNoiseProgram ( void )
+{
+   const char vShaderStr[] =
+      "#version 300 es                                                     \n"
+      "void main()                                                         \n"
+      "{                                                                   \n"
+      "   // One triangle covering the viewport                           \n"
+      "   gl_Position = vec4( gl_VertexID == 1 ? 3.0 : -1.0,               \n"
+      "                       gl_VertexID == 2 ? 3.0 : -1.0, 0.0, 1.0 );   \n"
+      "}                                                                   \n";
+
+   const char fShaderStr[] =
+      "#version 300 es                                                     \n"
+      "precision highp float;                                              \n"
+      "precision highp int;                                                \n"
+      "uniform highp sampler2D s_tables;                                   \n"
+      "uniform int   u_size;                                               \n"
+      "uniform int   u_slice;                                              \n"
+      "uniform float u_frequency;                                          \n"
+      "uniform int   u_octaves;                                            \n"
+      "uniform int   u_period;                                             \n"
+      "uniform float u_scale;                                              \n"
+      "uniform float u_bias;                                               \n"
+      "layout(location = 0) out vec4 outColor;                             \n"
+      "vec4 lattice( int i )                                               \n"
+      "{                                                                   \n"
+      "   return texelFetch( s_tables, ivec2( i & 255, 0 ), 0 );           \n"
+      "}                                                                   \n"
+      "float edge( int ix0, int ix1, int hash, vec3 f, float wx )          \n"
+      "{                                                                   \n"
+      "   float v0 = dot( lattice( ix0 + hash ).rgb, f );                  \n"
+      "   float v1 = dot( lattice( ix1 + hash ).rgb, f - vec3( 1, 0, 0 ) );\n"
+      "   return v0 + wx * ( v1 - v0 );                                    \n"
+      "}                                                                   \n"
+      "float noise( vec3 p, int period )                                   \n"
+      "{                                                                   \n"
+      "   ivec3 i = ivec3( p );                                            \n"
+      "   vec3  f = p - vec3( i );                                         \n"
+      "   vec3  w = f * f * f * ( f * ( f * 6.0 - 15.0 ) + 10.0 );         \n"
+      "   ivec3 i0 = i % period;                                           \n"
+      "   ivec3 i1 = ( i + 1 ) % period;                                   \n"
+      "   int   hz0 = int( lattice( i0.z ).a );                            \n"
+      "   int   hz1 = int( lattice( i1.z ).a );                            \n"
+      "   float e00 = edge( i0.x, i1.x, int( lattice( i0.y + hz0 ).a ),    \n"
+      "                     f, w.x );                                      \n"
+      "   float e10 = edge( i0.x, i1.x, int( lattice( i1.y + hz0 ).a ),    \n"
+      "                     f - vec3( 0, 1, 0 ), w.x );                    \n"
+      "   float e01 = edge( i0.x, i1.x, int( lattice( i0.y + hz1 ).a ),    \n"
+      "                     f - vec3( 0, 0, 1 ), w.x );                    \n"
+      "   float e11 = edge( i0.x, i1.x, int( lattice( i1.y + hz1 ).a ),    \n"
+      "                     f - vec3( 0, 1, 1 ), w.x );                    \n"
+      "   float a = e00 + w.y * ( e10 - e00 );                             \n"
+      "   float b = e01 + w.y * ( e11 - e01 );                             \n"
+      "   return a + w.z * ( b - a );                                      \n"
+      "}                                                                   \n"
+      "void main()                                                         \n"
+      "{                                                                   \n"
+      "   vec3  texel = vec3( ivec3( ivec2( gl_FragCoord.xy ), u_slice ) );\n"
+      "   float amplitude = 1.0;                                           \n"
+      "   float value = 0.0;                                               \n"
+      "   for ( int octave = 0; octave < u_octaves; octave++ )             \n"
+      "   {                                                                \n"
+      "      float step = u_frequency * float( 1 << octave ) /             \n"
+      "                   float( u_size );                                 \n"
+      "      int   period = u_period > 0 ? u_period << octave : 256;       \n"
+      "      value += amplitude * noise( texel * step, period );           \n"
+      "      amplitude *= 0.5;                                             \n"
+      "   }                                                                \n"
+      "   outColor = vec4( value * u_scale + u_bias );                     \n"
+      "}                                                                   \n";
+
+   return esLoadProgram ( vShaderStr, fShaderStr );
+}
+
+///
+// RenderNoise()
+//
+//    Draw each slice of the texture into its layer, mapping the noise
+//    with value * scale + bias.  The table texture
+//    is bound to unit 0, the unit s_tables reads.  GL state touched is put
+//    back afterwards, and the new texture is left bound to GL_TEXTURE_3D
+//    of the active unit.
+//
+static GLuint RenderNoise ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLfloat scale,
+                            GLfloat bias )
+{
+   GLfloat   tables[NOISE_TABLE_SIZE * 4];
+   GLfloat   gradients[NOISE_TABLE_SIZE * 3];
+   GLuint    programObject, tableTexture, textureId = 0, framebuffer, vertexArray;
+   GLint     framebufferBinding, activeTexture, textureBinding, texture3DBinding, programBinding;
+   GLint     vertexArrayBinding, viewport[4];
+   GLint     sliceLoc;
+   GLboolean colorMask[4];
+   GLboolean enabled[5];
+   GLenum    status = GL_FRAMEBUFFER_COMPLETE;
+   int       i, z;
+
+   // Disabled for the draws, then restored
+   static const GLenum capabilities[5] =
+   {
+      GL_BLEND, GL_CULL_FACE, GL_DITHER, GL_RASTERIZER_DISCARD, GL_SCISSOR_TEST
+   };
+
+   programObject = LoadNoiseProgram ();
+
+   if ( programObject == 0 )
+   {
+      return 0;
+   }
+
+   InitGradients ( gradients );
+
+   for ( i = 0; i < NOISE_TABLE_SIZE; i++ )
+   {
+      tables[i * 4 + 0] = gradients[i * 3 + 0];
+      tables[i * 4 + 1] = gradients[i * 3 + 1];
+      tables[i * 4 + 2] = gradients[i * 3 + 2];
+      tables[i * 4 + 3] = ( GLfloat ) permTable[i];
+   }
+
+   glGetIntegerv ( GL_DRAW_FRAMEBUFFER_BINDING, &framebufferBinding );
+   glGetIntegerv ( GL_ACTIVE_TEXTURE, &activeTexture );
+   glActiveTexture ( GL_TEXTURE0 );
+   glGetIntegerv ( GL_TEXTURE_BINDING_2D, &textureBinding );
+   glGetIntegerv ( GL_TEXTURE_BINDING_3D, &texture3DBinding );
+   glGetIntegerv ( GL_CURRENT_PROGRAM, &programBinding );
+   glGetIntegerv ( GL_VERTEX_ARRAY_BINDING, &vertexArrayBinding );
+   glGetIntegerv ( GL_VIEWPORT, viewport );
+   glGetBooleanv ( GL_COLOR_WRITEMASK, colorMask );
+
+   for ( i = 0; i < 5; i++ )
+   {
+      enabled[i] = glIsEnabled ( capabilities[i] );
+      glDisable ( capabilities[i] );
+   }
+
+   glGenTextures ( 1, &tableTexture );
+   glBindTexture ( GL_TEXTURE_2D, tableTexture );
+   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGBA32F, NOISE_TABLE_SIZE, 1, 0, GL_RGBA, GL_FLOAT, tables );
+   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+   glTexParameteri ( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+
+   textureId = CreateNoiseTexture ( size, tileable, NULL );
+
+   // An empty vertex array, so that no enabled client array is read
+   glGenVertexArrays ( 1, &vertexArray );
+   glBindVertexArray ( vertexArray );
+
+   glGenFramebuffers ( 1, &framebuffer );
+   glBindFramebuffer ( GL_DRAW_FRAMEBUFFER, framebuffer );
+   glViewport ( 0, 0, size, size );
+   glColorMask ( GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE );
+
+   glUseProgram ( programObject );
+   glUniform1i ( glGetUniformLocation ( programObject, "s_tables" ), 0 );
+   glUniform1i ( glGetUniformLocation ( programObject, "u_size" ), size );
+   glUniform1f ( glGetUniformLocation ( programObject, "u_frequency" ),
+                 tileable ? ( GLfloat ) NoisePeriod ( frequency ) : frequency );
+   glUniform1i ( glGetUniformLocation ( programObject, "u_octaves" ), octaves );
+   glUniform1i ( glGetUniformLocation ( programObject, "u_period" ), tileable ? NoisePeriod ( frequency ) : 0 );
+   glUniform1f ( glGetUniformLocation ( programObject, "u_scale" ), scale );
+   glUniform1f ( glGetUniformLocation ( programObject, "u_bias" ), bias );
+
+   sliceLoc = glGetUniformLocation ( programObject, "u_slice" );
+
+   for ( z = 0; z < size; z++ )
+   {
+      glFramebufferTextureLayer ( GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0, z );
+
+      if ( z == 0 && ( status = glCheckFramebufferStatus ( GL_DRAW_FRAMEBUFFER ) ) != GL_FRAMEBUFFER_COMPLETE )
+      {
+         break;
+      }
+
+      glUniform1i ( sliceLoc, z );
+      glDrawArrays ( GL_TRIANGLES, 0, 3 );
+   }
+
+   glBindFramebuffer ( GL_DRAW_FRAMEBUFFER, framebufferBinding );
+   glDeleteFramebuffers ( 1, &framebuffer );
+   glBindVertexArray ( vertexArrayBinding );
+   glDeleteVertexArrays ( 1, &vertexArray );
+   glBindTexture ( GL_TEXTURE_2D, textureBinding );
+   glDeleteTextures ( 1, &tableTexture );
+   glBindTexture ( GL_TEXTURE_3D, texture3DBinding );
+   glActiveTexture ( activeTexture );
+   glBindTexture ( GL_TEXTURE_3D, textureId );
+   glUseProgram ( programBinding );
+   glDeleteProgram ( programObject );
+   glViewport ( viewport[0], viewport[1], viewport[2], viewport[3] );
+   glColorMask ( colorMask[0], colorMask[1], colorMask[2], colorMask[3] );
+
+   for ( i = 0; i < 5; i++ )
+   {
+      if ( enabled[i] )
+      {
+         glEnable ( capabilities[i] );
+      }
+   }
+
+   if ( status != GL_FRAMEBUFFER_COMPLETE )
+   {
+      glDeleteTextures ( 1, &textureId );
+      return 0;
+   }
+
+   return textureId;
+}
+
+///
+// ReadNoise()
+//
+//    Read a rendered volume back, a slice at a time
+//
+static GLboolean ReadNoise ( GLuint textureId, int size, GLubyte *volume )
+{
+   size_t   sliceSize = ( size_t ) size * size;
+   GLubyte *slice = malloc ( sliceSize * 4 );
+   GLint    framebufferBinding, packBuffer;
+   GLuint   framebuffer;
+   size_t   i;
+   int      z;
+
+   if ( slice == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   glGetIntegerv ( GL_READ_FRAMEBUFFER_BINDING, &framebufferBinding );
+   glGetIntegerv ( GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer );
+   glBindBuffer ( GL_PIXEL_PACK_BUFFER, 0 );
+   glGenFramebuffers ( 1, &framebuffer );
+   glBindFramebuffer ( GL_READ_FRAMEBUFFER, framebuffer );
+
+   // GL_RGBA is the one format glReadPixels always supports
+   for ( z = 0; z < size; z++ )
+   {
+      glFramebufferTextureLayer ( GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, textureId, 0, z );
+      glReadPixels ( 0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, slice );
+
+      for ( i = 0; i < sliceSize; i++ )
+      {
+         volume[z * sliceSize + i] = slice[i * 4];
+      }
+   }
+
+   glBindFramebuffer ( GL_READ_FRAMEBUFFER, framebufferBinding );
+   glDeleteFramebuffers ( 1, &framebuffer );
+   glBindBuffer ( GL_PIXEL_PACK_BUFFER, packBuffer );
+
+   free ( slice );
+   return GL_TRUE;
+}
+
+///
+// StretchNoise()
+//
+//    The range of the noise is only known once it is computed, so render
+//    it mapped from its bounds, read it back into volume to find its
+//    range, and render it again stretched over [0, 1].  The range read
+//    back is widened by one step of the first rendering so that no texel
+//    is clamped.
+//
+static GLuint StretchNoise ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLubyte *volume )
+{
+   size_t  volumeSize = ( size_t ) size * size * size;
+   size_t  i;
+   GLfloat bound = NoiseBound ( octaves );
+   GLfloat low, high;
+   GLuint  textureId;
+   int     lowest = 255, highest = 0;
+
+   textureId = RenderNoise ( size, frequency, octaves, tileable, 0.5f / bound, 0.5f );
+
+   if ( textureId == 0 )
+   {
+      return 0;
+   }
+
+   if ( !ReadNoise ( textureId, size, volume ) )
+   {
+      glDeleteTextures ( 1, &textureId );
+      return 0;
+   }
+
+   glDeleteTextures ( 1, &textureId );
+
+   for ( i = 0; i < volumeSize; i++ )
+   {
+      lowest = volume[i] < lowest ? volume[i] : lowest;
+      highest = volume[i] > highest ? volume[i] : highest;
+   }
+
+   low = ( ( lowest - 1 ) / 255.0f - 0.5f ) * 2.0f * bound;
+   high = ( ( highest + 1 ) / 255.0f - 0.5f ) * 2.0f * bound;
+
+   return RenderNoise ( size, frequency, octaves, tileable, 1.0f / ( high - low ), -low / ( high - low ) );
+}
+
+///
+// GenerateNoise()
+//
+//    esCacheGenerate callback: render the volume and read it back, or
+//    generate it on the CPU
+//
+static GLboolean ESCALLBACK GenerateNoise ( void *userData, void *data, size_t size )
+{
+   NoiseRequest      *request = userData;
+   const NoiseParams *params = &request->params;
+
+   // One byte per texel
+   if ( size != ( size_t ) params->size * params->size * params->size )
+   {
+      return GL_FALSE;
+   }
+
+   if ( request->render )
+   {
+      request->textureId = StretchNoise ( params->size, params->frequency, params->octaves, params->tileable, data );
+
+      if ( request->textureId != 0 )
+      {
+         return ReadNoise ( request->textureId, params->size, data );
+      }
+
+      esLogMessage ( "esRenderNoiseTexture3D: rendering failed, generating the noise on the CPU\n" );
+   }
+
+   return GenNoise ( params->size, params->frequency, params->octaves, params->tileable, data );
+}
+
+///
+// CreateNoise()
+//
+//    Create the texture of a volume, from the disk cache when it is there
+//
+static GLuint CreateNoise ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLboolean render,
+                            const char *cacheDir )
+{
+   NoiseRequest   request;
+   ESFileMapping  mapping;
+   const GLubyte *volume;
+   GLuint         textureId;
+
+   if ( size < 1 || octaves < 1 || octaves > 16 || frequency <= 0.0f )
+   {
+      return 0;
+   }
+
+   // The parameters are the cache key, so they have no padding
+   memset ( &request, 0, sizeof ( NoiseRequest ) );
+   request.params.version = CACHE_VERSION;
+   request.params.size = size;
+   request.params.frequency = frequency;
+   request.params.octaves = octaves;
+   request.params.tileable = tileable;
+   request.params.render = render;
+   request.render = render;
+
+   // Without a cache the volume is only read back for its range
+   if ( render && cacheDir == NULL )
+   {
+      GLubyte *scratch = malloc ( ( size_t ) size * size * size );
+
+      textureId = scratch != NULL ? StretchNoise ( size, frequency, octaves, tileable, scratch ) : 0;
+      free ( scratch );
+
+      if ( textureId != 0 )
+      {
+         return textureId;
+      }
+
+      esLogMessage ( "esRenderNoiseTexture3D: rendering failed, generating the noise on the CPU\n" );
+      request.render = GL_FALSE;
+   }
+
+   volume = esCacheGenerate ( cacheDir, "noise3d", &request.params, sizeof ( NoiseParams ),
+                              ( size_t ) size * size * size, GenerateNoise, &request, &mapping );
+
+   if ( volume == NULL )
+   {
+      return 0;
+   }
+
+   textureId = request.textureId != 0 ? request.textureId : CreateNoiseTexture ( size, tileable, volume );
+
+   esUnmapFile ( &mapping );
+   return textureId;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esGenNoise3D()
+//
+GLboolean ESUTIL_API esGenNoise3D ( int size, GLfloat frequency, int octaves, GLboolean tileable, GLubyte *volume )
+{
+   return GenNoise ( size, frequency, octaves, tileable, volume );
+}
+
+///
+// esCreateNoiseTexture3D()
+//
+GLuint ESUTIL_API esCreateNoiseTexture3D ( int size, GLfloat frequency, int octaves, GLboolean tileable,
+                                           const char *cacheDir )
+{
+   return CreateNoise ( size, frequency, octaves, tileable, GL_FALSE, cacheDir );
+}
+
+///
+// esRenderNoiseTexture3D()
+//
+GLuint ESUTIL_API esRenderNoiseTexture3D ( int size, GLfloat frequency, int octaves, GLboolean tileable,
+                                           const char *cacheDir )
+{
+   return CreateNoise ( size, frequency, octaves, tileable, GL_TRUE, cacheDir );
+}
@@ -0,0 +1,1180 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESPVR.c
+//
+//    Loader for PowerVR texture files, versions 2 and 3.  Mip levels, cube
+//    faces, array layers and 3D slices are uploaded as they are stored;
+//    the vertical flip flag of version 2 files is not applied.  PVRTC
+//    data is uploaded compressed when the GPU supports it and is otherwise
+//    transcoded to RGBA8 on the CPU, spread over the available cores.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+//  Macros
+//
+#define PVR_HEADER_SIZE          52
+#define PVR_MAX_LEVELS           32
+
+// Identification of the two versions
+#define PVR3_VERSION             0x03525650
+#define PVR2_TAG                 0x21525650
+
+// Version 2 header flags
+#define PVR2_FLAG_TWIDDLE        0x00000200
+#define PVR2_FLAG_CUBEMAP        0x00001000
+#define PVR2_FLAG_VOLUME         0x00004000
+#define PVR2_FLAG_ALPHA          0x00008000
+
+// Version 3 channel types and colour space
+#define PVR_UBYTE_NORM           0
+#define PVR_SBYTE_NORM           1
+#define PVR_UBYTE                2
+#define PVR_USHORT_NORM          4
+#define PVR_USHORT               6
+#define PVR_FLOAT                12
+#define PVR_SRGB                 1
+
+// Version 3 pixel format: channel names in the low 32 bits, bits per
+// channel in the high 32 bits
+#define PVR_FORMAT( c0, c1, c2, c3, b0, b1, b2, b3 ) \
+   ( ( GLuint64 ) ( ( c0 ) | ( c1 ) << 8 | ( c2 ) << 16 | ( GLuint ) ( c3 ) << 24 ) | \
+     ( GLuint64 ) ( ( b0 ) | ( b1 ) << 8 | ( b2 ) << 16 | ( GLuint ) ( b3 ) << 24 ) << 32 )
+
+#ifndef GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG
+#define GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG    0x8C00
+#define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG    0x8C01
+#define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG   0x8C02
+#define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG   0x8C03
+#endif
+
+///
+//  Types
+//
+typedef struct
+{
+   GLuint64 pixelFormat;
+   GLuint   channelType;
+   GLenum   internalFormat;
+   GLenum   format;
+   GLenum   type;
+   int      pixelBytes;
+
+   // Texture swizzle for the channels OpenGL ES 3.0 has no format for,
+   // GL_NONE when the channels map directly
+   GLenum   swizzle[4];
+} PixelFormat;
+
+typedef struct
+{
+   GLuint   pixelType;
+   GLuint64 pixelFormat;
+   GLuint   channelType;
+} PVR2Format;
+
+typedef struct
+{
+   // Upload target and format; format and type are GL_NONE when the
+   // internal format is compressed
+   GLenum             target;
+   GLenum             internalFormat;
+   GLenum             format;
+   GLenum             type;
+   const GLenum      *swizzle;
+
+   // Size of the base level; depth is the number of slices of a 3D texture
+   // or of layers of an array, 1 otherwise
+   int                width;
+   int                height;
+   int                depth;
+   int                numLevels;
+
+   // Bytes per pixel, bytes per 4x4 block of ETC2 / EAC, or bits per pixel
+   // of PVRTC; only one of them is set
+   int                pixelBytes;
+   int                blockBytes;
+   int                pvrtcBpp;
+   GLboolean          srgb;
+
+   // Version 2 files store the whole mip chain of each cube face in turn,
+   // version 3 files all faces, layers or slices of each level in turn
+   GLboolean          facesFirst;
+
+   const GLubyte     *data;
+   long long          dataSize;
+} PVRInfo;
+
+// One PVRTC image being transcoded
+typedef struct
+{
+   const GLubyte     *words;
+   int                bpp;
+   int                wordWidth;
+   int                wordsX;
+   int                wordsY;
+   int                width;
+   int                height;
+
+   // Colors A and B of every word in row order, 5-bit RGB and 4-bit alpha
+   int              (*colors)[8];
+   GLubyte           *rgba;
+} PVRTCImage;
+
+///
+//  Tables
+//
+static const GLenum swizzleBGRA[4] = { GL_BLUE, GL_GREEN, GL_RED, GL_ALPHA };
+static const GLenum swizzleL[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+static const GLenum swizzleLA[4] = { GL_RED, GL_RED, GL_RED, GL_GREEN };
+static const GLenum swizzleA[4] = { GL_ZERO, GL_ZERO, GL_ZERO, GL_RED };
+
+// Uncompressed formats with an OpenGL ES 3.0 equivalent.  The first entry of
+// the swizzle picks one of the tables above; GL_NONE, which is also
+// GL_ZERO, keeps the channels as they are.
+static const PixelFormat pixelFormats[] =
+{
+   { PVR_FORMAT ( 'r', 'g', 'b', 'a', 8, 8, 8, 8 ), PVR_UBYTE_NORM, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 0, 8, 8, 8, 0 ), PVR_UBYTE_NORM, GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 0, 0, 8, 8, 0, 0 ), PVR_UBYTE_NORM, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 0, 0, 0, 8, 0, 0, 0 ), PVR_UBYTE_NORM, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, { GL_NONE } },
+   { PVR_FORMAT ( 'b', 'g', 'r', 'a', 8, 8, 8, 8 ), PVR_UBYTE_NORM, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, { GL_BLUE } },
+   { PVR_FORMAT ( 'l', 0, 0, 0, 8, 0, 0, 0 ), PVR_UBYTE_NORM, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, { GL_RED, GL_RED } },
+   { PVR_FORMAT ( 'l', 'a', 0, 0, 8, 8, 0, 0 ), PVR_UBYTE_NORM, GL_RG8, GL_RG, GL_UNSIGNED_BYTE, 2, { GL_RED, GL_GREEN } },
+   { PVR_FORMAT ( 'a', 0, 0, 0, 8, 0, 0, 0 ), PVR_UBYTE_NORM, GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, { GL_ALPHA } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 'a', 4, 4, 4, 4 ), PVR_USHORT_NORM, GL_RGBA4, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, 2, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 'a', 5, 5, 5, 1 ), PVR_USHORT_NORM, GL_RGB5_A1, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, 2, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 0, 5, 6, 5, 0 ), PVR_USHORT_NORM, GL_RGB565, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, 2, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 0, 0, 0, 16, 0, 0, 0 ), PVR_FLOAT, GL_R16F, GL_RED, GL_HALF_FLOAT, 2, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 0, 0, 16, 16, 0, 0 ), PVR_FLOAT, GL_RG16F, GL_RG, GL_HALF_FLOAT, 4, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 'a', 16, 16, 16, 16 ), PVR_FLOAT, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 0, 0, 0, 32, 0, 0, 0 ), PVR_FLOAT, GL_R32F, GL_RED, GL_FLOAT, 4, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 0, 0, 32, 32, 0, 0 ), PVR_FLOAT, GL_RG32F, GL_RG, GL_FLOAT, 8, { GL_NONE } },
+   { PVR_FORMAT ( 'r', 'g', 'b', 'a', 32, 32, 32, 32 ), PVR_FLOAT, GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, { GL_NONE } },
+};
+
+// Uncompressed pixel types of version 2 files, as version 3 formats
+static const PVR2Format pvr2Formats[] =
+{
+   { 0x10, PVR_FORMAT ( 'r', 'g', 'b', 'a', 4, 4, 4, 4 ), PVR_USHORT_NORM },
+   { 0x11, PVR_FORMAT ( 'r', 'g', 'b', 'a', 5, 5, 5, 1 ), PVR_USHORT_NORM },
+   { 0x12, PVR_FORMAT ( 'r', 'g', 'b', 'a', 8, 8, 8, 8 ), PVR_UBYTE_NORM },
+   { 0x13, PVR_FORMAT ( 'r', 'g', 'b', 0, 5, 6, 5, 0 ), PVR_USHORT_NORM },
+   { 0x15, PVR_FORMAT ( 'r', 'g', 'b', 0, 8, 8, 8, 0 ), PVR_UBYTE_NORM },
+   { 0x16, PVR_FORMAT ( 'l', 0, 0, 0, 8, 0, 0, 0 ), PVR_UBYTE_NORM },
+   { 0x17, PVR_FORMAT ( 'l', 'a', 0, 0, 8, 8, 0, 0 ), PVR_UBYTE_NORM },
+   { 0x1A, PVR_FORMAT ( 'b', 'g', 'r', 'a', 8, 8, 8, 8 ), PVR_UBYTE_NORM },
+   { 0x1B, PVR_FORMAT ( 'a', 0, 0, 0, 8, 0, 0, 0 ), PVR_UBYTE_NORM },
+};
+
+// PVRTC modulation weights, out of 8
+static const int pvrtcWeights[4] = { 0, 3, 5, 8 };
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// ReadUint32()
+//
+static GLuint ReadUint32 ( const GLubyte *p )
+{
+   return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( ( GLuint ) p[3] << 24 );
+}
+
+///
+// SetPixelFormat()
+//
+//    Select the uncompressed format matching a version 3 pixel format
+//
+static GLboolean SetPixelFormat ( PVRInfo *info, GLuint64 pixelFormat, GLuint channelType )
+{
+   int i;
+
+   // Unsigned integer channels are read as normalized, as PVRTexTool intends
+   if ( channelType == PVR_UBYTE || channelType == PVR_USHORT )
+   {
+      channelType -= 2;
+   }
+
+   for ( i = 0; i < ( int ) ( sizeof ( pixelFormats ) / sizeof ( pixelFormats[0] ) ); i++ )
+   {
+      const PixelFormat *pf = &pixelFormats[i];
+
+      if ( pf->pixelFormat == pixelFormat && pf->channelType == channelType )
+      {
+         info->internalFormat = pf->internalFormat;
+         info->format = pf->format;
+         info->type = pf->type;
+         info->pixelBytes = pf->pixelBytes;
+
+         switch ( pf->swizzle[0] )
+         {
+            case GL_BLUE:
+               info->swizzle = swizzleBGRA;
+               break;
+
+            case GL_RED:
+               info->swizzle = pf->swizzle[1] == GL_GREEN ? swizzleLA : swizzleL;
+               break;
+
+            case GL_ALPHA:
+               info->swizzle = swizzleA;
+               break;
+         }
+
+         if ( info->srgb && info->internalFormat == GL_RGBA8 )
+         {
+            info->internalFormat = GL_SRGB8_ALPHA8;
+         }
+         else if ( info->srgb && info->internalFormat == GL_RGB8 )
+         {
+            info->internalFormat = GL_SRGB8;
+         }
+
+         return GL_TRUE;
+      }
+   }
+
+   return GL_FALSE;
+}
+
+///
+// SetCompressedFormat()
+//
+//    Select the format of a version 3 compressed pixel format
+//
+static GLboolean SetCompressedFormat ( PVRInfo *info, GLuint id, GLuint channelType )
+{
+   GLboolean isSigned = channelType == PVR_SBYTE_NORM;
+
+   info->format = GL_NONE;
+   info->type = GL_NONE;
+
+   switch ( id )
+   {
+      case 0:
+      case 1:
+         info->pvrtcBpp = 2;
+         info->internalFormat = id == 0 ? GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG : GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG;
+         return GL_TRUE;
+
+      case 2:
+      case 3:
+         info->pvrtcBpp = 4;
+         info->internalFormat = id == 2 ? GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG : GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG;
+         return GL_TRUE;
+
+      // ETC1 is a subset of ETC2
+      case 6:
+      case 22:
+         info->blockBytes = 8;
+         info->internalFormat = info->srgb ? GL_COMPRESSED_SRGB8_ETC2 : GL_COMPRESSED_RGB8_ETC2;
+         return GL_TRUE;
+
+      case 23:
+         info->blockBytes = 16;
+         info->internalFormat = info->srgb ? GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC : GL_COMPRESSED_RGBA8_ETC2_EAC;
+         return GL_TRUE;
+
+      case 24:
+         info->blockBytes = 8;
+         info->internalFormat = info->srgb ? GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 :
+                                             GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2;
+         return GL_TRUE;
+
+      case 25:
+         info->blockBytes = 8;
+         info->internalFormat = isSigned ? GL_COMPRESSED_SIGNED_R11_EAC : GL_COMPRESSED_R11_EAC;
+         return GL_TRUE;
+
+      case 26:
+         info->blockBytes = 16;
+         info->internalFormat = isSigned ? GL_COMPRESSED_SIGNED_RG11_EAC : GL_COMPRESSED_RG11_EAC;
+         return GL_TRUE;
+   }
+
+   return GL_FALSE;
+}
+
+///
+// SelectTarget()
+//
+//    Pick the texture target for the dimensions of the file.  Cube map
+//    arrays and arrays of 3D textures do not exist in OpenGL ES 3.0.
+//
+static GLboolean SelectTarget ( PVRInfo *info, int depth, int numSurfaces, int numFaces )
+{
+   info->depth = 1;
+
+   if ( numFaces == 6 && numSurfaces == 1 && depth == 1 )
+   {
+      info->target = GL_TEXTURE_CUBE_MAP;
+   }
+   else if ( numFaces != 1 || numSurfaces < 1 || depth < 1 || ( numSurfaces > 1 && depth > 1 ) )
+   {
+      return GL_FALSE;
+   }
+   else if ( depth > 1 )
+   {
+      info->target = GL_TEXTURE_3D;
+      info->depth = depth;
+   }
+   else if ( numSurfaces > 1 )
+   {
+      info->target = GL_TEXTURE_2D_ARRAY;
+      info->depth = numSurfaces;
+   }
+   else
+   {
+      info->target = GL_TEXTURE_2D;
+   }
+
+   // PVRTC blocks are laid out for power of two sizes only
+   if ( info->pvrtcBpp != 0 &&
+        ( ( info->width & ( info->width - 1 ) ) != 0 || ( info->height & ( info->height - 1 ) ) != 0 ) )
+   {
+      esLogMessage ( "esLoadPVR: PVRTC textures must have power of two sizes\n" );
+      return GL_FALSE;
+   }
+
+   return info->width > 0 && info->height > 0 && info->width <= 65536 && info->height <= 65536 &&
+          info->depth <= 65536 && info->numLevels >= 1 && info->numLevels <= PVR_MAX_LEVELS;
+}
+
+///
+// ParsePVR3()
+//
+//    Read the header of a version 3 file
+//
+static GLboolean ParsePVR3 ( const GLubyte *data, int size, PVRInfo *info )
+{
+   GLuint formatLow = ReadUint32 ( &data[8] );
+   GLuint formatHigh = ReadUint32 ( &data[12] );
+   GLuint channelType = ReadUint32 ( &data[20] );
+   GLuint metaDataSize = ReadUint32 ( &data[48] );
+
+   info->srgb = ReadUint32 ( &data[16] ) == PVR_SRGB;
+
+   if ( formatHigh == 0 ? !SetCompressedFormat ( info, formatLow, channelType ) :
+                          !SetPixelFormat ( info, ( GLuint64 ) formatHigh << 32 | formatLow, channelType ) )
+   {
+      esLogMessage ( "esLoadPVR: unsupported pixel format 0x%08X%08X\n", formatHigh, formatLow );
+      return GL_FALSE;
+   }
+
+   info->height = ( int ) ReadUint32 ( &data[24] );
+   info->width = ( int ) ReadUint32 ( &data[28] );
+   info->numLevels = ( int ) ReadUint32 ( &data[44] );
+   info->facesFirst = GL_FALSE;
+
+   if ( !SelectTarget ( info, ( int ) ReadUint32 ( &data[32] ), ( int ) ReadUint32 ( &data[36] ),
+                        ( int ) ReadUint32 ( &data[40] ) ) ||
+        metaDataSize > ( GLuint ) ( size - PVR_HEADER_SIZE ) )
+   {
+      return GL_FALSE;
+   }
+
+   info->data = data + PVR_HEADER_SIZE + metaDataSize;
+   info->dataSize = size - PVR_HEADER_SIZE - metaDataSize;
+   return GL_TRUE;
+}
+
+///
+// ParsePVR2()
+//
+//    Read the header of a version 2 file, which holds 2D textures and
+//    cube maps only
+//
+static GLboolean ParsePVR2 ( const GLubyte *data, int size, PVRInfo *info )
+{
+   GLuint    flags = ReadUint32 ( &data[16] );
+   GLuint    pixelType = flags & 0xFF;
+   GLboolean alpha = ( flags & PVR2_FLAG_ALPHA ) != 0 || ReadUint32 ( &data[40] ) != 0;
+   int       i;
+
+   switch ( pixelType )
+   {
+      case 0x0C:
+      case 0x18:
+         info->pvrtcBpp = 2;
+         info->internalFormat = alpha ? GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG : GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG;
+         break;
+
+      case 0x0D:
+      case 0x19:
+         info->pvrtcBpp = 4;
+         info->internalFormat = alpha ? GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG : GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG;
+         break;
+
+      case 0x36:
+         info->blockBytes = 8;
+         info->internalFormat = GL_COMPRESSED_RGB8_ETC2;
+         break;
+
+      default:
+         for ( i = 0; i < ( int ) ( sizeof ( pvr2Formats ) / sizeof ( pvr2Formats[0] ) ); i++ )
+         {
+            if ( pvr2Formats[i].pixelType == pixelType )
+            {
+               SetPixelFormat ( info, pvr2Formats[i].pixelFormat, pvr2Formats[i].channelType );
+            }
+         }
+         break;
+   }
+
+   if ( info->internalFormat == GL_NONE || ( flags & PVR2_FLAG_VOLUME ) ||
+        ( info->pixelBytes != 0 && ( flags & PVR2_FLAG_TWIDDLE ) ) )
+   {
+      esLogMessage ( "esLoadPVR: unsupported version 2 pixel type 0x%02X, flags 0x%X\n", pixelType, flags );
+      return GL_FALSE;
+   }
+
+   if ( info->pvrtcBpp != 0 || info->blockBytes != 0 )
+   {
+      info->format = GL_NONE;
+      info->type = GL_NONE;
+   }
+
+   // The count excludes the base level
+   info->height = ( int ) ReadUint32 ( &data[4] );
+   info->width = ( int ) ReadUint32 ( &data[8] );
+   info->numLevels = ( int ) ( ReadUint32 ( &data[12] ) + 1 );
+   info->facesFirst = GL_TRUE;
+
+   if ( !SelectTarget ( info, 1, 1, ( flags & PVR2_FLAG_CUBEMAP ) ? 6 : 1 ) )
+   {
+      return GL_FALSE;
+   }
+
+   info->data = data + PVR_HEADER_SIZE;
+   info->dataSize = size - PVR_HEADER_SIZE;
+   return GL_TRUE;
+}
+
+///
+// ImageBytes()
+//
+//    Bytes of one face, layer or slice of a level.  PVRTC images are at
+//    least 2x2 blocks.
+//
+static long long ImageBytes ( const PVRInfo *info, int level )
+{
+   int w = info->width >> level > 1 ? info->width >> level : 1;
+   int h = info->height >> level > 1 ? info->height >> level : 1;
+
+   if ( info->pvrtcBpp == 4 )
+   {
+      return ( long long ) ( w > 8 ? w : 8 ) * ( h > 8 ? h : 8 ) / 2;
+   }
+   else if ( info->pvrtcBpp == 2 )
+   {
+      return ( long long ) ( w > 16 ? w : 16 ) * ( h > 8 ? h : 8 ) / 4;
+   }
+   else if ( info->blockBytes != 0 )
+   {
+      return ( long long ) ( ( w + 3 ) / 4 ) * ( ( h + 3 ) / 4 ) * info->blockBytes;
+   }
+
+   return ( long long ) w * h * info->pixelBytes;
+}
+
+///
+// NumImages()
+//
+//    Faces, layers or slices of a level
+//
+static int NumImages ( const PVRInfo *info, int level )
+{
+   if ( info->target == GL_TEXTURE_CUBE_MAP )
+   {
+      return 6;
+   }
+   else if ( info->target == GL_TEXTURE_3D )
+   {
+      return info->depth >> level > 1 ? info->depth >> level : 1;
+   }
+
+   return info->depth;
+}
+
+///
+// ImageOffset()
+//
+//    Offset of one image of a level in the texture data; the offset of
+//    image 0 of level numLevels is the size of all the data
+//
+static long long ImageOffset ( const PVRInfo *info, int level, int image )
+{
+   long long offset = 0;
+   int       l;
+
+   if ( info->facesFirst )
+   {
+      long long chain = 0;
+
+      for ( l = 0; l < info->numLevels; l++ )
+      {
+         chain += ImageBytes ( info, l );
+         offset += l < level ? ImageBytes ( info, l ) : 0;
+      }
+
+      return level == info->numLevels ? chain * NumImages ( info, 0 ) : offset + image * chain;
+   }
+
+   for ( l = 0; l < level; l++ )
+   {
+      offset += ImageBytes ( info, l ) * NumImages ( info, l );
+   }
+
+   return offset + image * ImageBytes ( info, level );
+}
+
+///
+// PVRTCWordIndex()
+//
+//    PVRTC words are stored in Morton order, y in the lowest bit, with
+//    the remaining bits of the longer side above
+//
+static int PVRTCWordIndex ( const PVRTCImage *image, int x, int y )
+{
+   int minWords = image->wordsX < image->wordsY ? image->wordsX : image->wordsY;
+   int index = 0;
+   int shift = 0;
+   int bit;
+
+   for ( bit = 1; bit < minWords; bit <<= 1, shift++ )
+   {
+      index |= ( ( y & bit ) != 0 ) << ( 2 * shift );
+      index |= ( ( x & bit ) != 0 ) << ( 2 * shift + 1 );
+   }
+
+   return index | ( ( image->wordsX > image->wordsY ? x : y ) >> shift ) << ( 2 * shift );
+}
+
+///
+// Expand4To5()
+//
+static int Expand4To5 ( int value )
+{
+   return ( value << 1 ) | ( value >> 3 );
+}
+
+///
+// UnpackPVRTCColors()
+//
+//    Colors A and B of a word as 5-bit RGB and 4-bit alpha.  Each color is
+//    either opaque RGB555 (RGB554 for A) or ARGB3444 (ARGB3443 for A).
+//
+static void UnpackPVRTCColors ( GLuint color, int colors[8] )
+{
+   if ( color & 0x8000 )
+   {
+      colors[0] = ( color >> 10 ) & 31;
+      colors[1] = ( color >> 5 ) & 31;
+      colors[2] = Expand4To5 ( ( color >> 1 ) & 15 );
+      colors[3] = 15;
+   }
+   else
+   {
+      colors[0] = Expand4To5 ( ( color >> 8 ) & 15 );
+      colors[1] = Expand4To5 ( ( color >> 4 ) & 15 );
+      colors[2] = ( ( color >> 1 ) & 7 ) << 2 | ( ( color >> 2 ) & 1 );
+      colors[3] = ( ( color >> 12 ) & 7 ) << 1;
+   }
+
+   if ( color & 0x80000000 )
+   {
+      colors[4] = ( color >> 26 ) & 31;
+      colors[5] = ( color >> 21 ) & 31;
+      colors[6] = ( color >> 16 ) & 31;
+      colors[7] = 15;
+   }
+   else
+   {
+      colors[4] = Expand4To5 ( ( color >> 24 ) & 15 );
+      colors[5] = Expand4To5 ( ( color >> 20 ) & 15 );
+      colors[6] = Expand4To5 ( ( color >> 16 ) & 15 );
+      colors[7] = ( ( color >> 28 ) & 7 ) << 1;
+   }
+}
+
+///
+// StoredModulation2()
+//
+//    Modulation weight a 2 bpp word stores for a pixel, -1 for the pixels
+//    its interpolated modes leave out.  mode returns 1 if those pixels
+//    average all four neighbours, 2 the horizontal and 3 the vertical ones.
+//
+static int StoredModulation2 ( const PVRTCImage *image, int x, int y, int *mode )
+{
+   const GLubyte *word;
+   GLuint         modulation;
+   int            lx, ly;
+
+   x = ( x + image->wordsX * 8 ) % ( image->wordsX * 8 );
+   y = ( y + image->wordsY * 4 ) % ( image->wordsY * 4 );
+   lx = x & 7;
+   ly = y & 3;
+   word = image->words + PVRTCWordIndex ( image, x / 8, y / 4 ) * 8;
+   modulation = ReadUint32 ( word );
+
+   // One bit per pixel
+   if ( ( word[4] & 1 ) == 0 )
+   {
+      *mode = 0;
+      return ( ( modulation >> ( ly * 8 + lx ) ) & 1 ) ? 8 : 0;
+   }
+
+   // Two bits for every other pixel, the flags borrowing bits 0 and 20
+   *mode = ( modulation & 1 ) == 0 ? 1 : ( modulation & ( 1 << 20 ) ) ? 3 : 2;
+
+   if ( ( lx ^ ly ) & 1 )
+   {
+      return -1;
+   }
+
+   if ( modulation & 1 )
+   {
+      modulation = ( modulation & ~( 1u << 20 ) ) | ( ( modulation >> 1 ) & ( 1u << 20 ) );
+   }
+
+   modulation = ( modulation & ~1u ) | ( ( modulation >> 1 ) & 1 );
+
+   return pvrtcWeights[( modulation >> ( 2 * ( ly * 4 + lx / 2 ) ) ) & 3];
+}
+
+///
+// PVRTCModulation()
+//
+//    Weight of color B for a pixel, out of 8.  punchThrough is set for the
+//    pixels of 4 bpp words that are transparent.
+//
+static int PVRTCModulation ( const PVRTCImage *image, int x, int y, GLboolean *punchThrough )
+{
+   *punchThrough = GL_FALSE;
+
+   if ( image->bpp == 4 )
+   {
+      const GLubyte *word = image->words + PVRTCWordIndex ( image, x / 4, y / 4 ) * 8;
+      int            value = ( ReadUint32 ( word ) >> ( 2 * ( ( y & 3 ) * 4 + ( x & 3 ) ) ) ) & 3;
+
+      if ( ( word[4] & 1 ) == 0 )
+      {
+         return pvrtcWeights[value];
+      }
+
+      *punchThrough = value == 2;
+      return value == 0 ? 0 : value == 3 ? 8 : 4;
+   }
+   else
+   {
+      int mode;
+      int neighbourMode;
+      int value = StoredModulation2 ( image, x, y, &mode );
+
+      if ( value >= 0 )
+      {
+         return value;
+      }
+
+      if ( mode == 2 )
+      {
+         return ( StoredModulation2 ( image, x - 1, y, &neighbourMode ) +
+                  StoredModulation2 ( image, x + 1, y, &neighbourMode ) + 1 ) / 2;
+      }
+      else if ( mode == 3 )
+      {
+         return ( StoredModulation2 ( image, x, y - 1, &neighbourMode ) +
+                  StoredModulation2 ( image, x, y + 1, &neighbourMode ) + 1 ) / 2;
+      }
+
+      return ( StoredModulation2 ( image, x - 1, y, &neighbourMode ) +
+               StoredModulation2 ( image, x + 1, y, &neighbourMode ) +
+               StoredModulation2 ( image, x, y - 1, &neighbourMode ) +
+               StoredModulation2 ( image, x, y + 1, &neighbourMode ) + 2 ) / 4;
+   }
+}
+
+///
+// DecodePVRTCRows()
+//
+//    esParallelFor work function.  Colors A and B are interpolated
+//    bilinearly between the centers of the four nearest words, wrapping
+//    around the image, then blended by the pixel's modulation weight.
+//
+static void ESCALLBACK DecodePVRTCRows ( void *userData, int begin, int end )
+{
+   const PVRTCImage *image = userData;
+   int               w = image->wordWidth;
+   int               fullWidth = image->wordsX * w;
+   int               fullHeight = image->wordsY * 4;
+   int               x, y, c;
+
+   for ( y = begin; y < end; y++ )
+   {
+      int  gy = ( y + fullHeight - 2 ) % fullHeight;
+      int  y0 = gy / 4;
+      int  y1 = ( y0 + 1 ) % image->wordsY;
+      int  fy = gy % 4;
+
+      for ( x = 0; x < image->width; x++ )
+      {
+         int        gx = ( x + fullWidth - w / 2 ) % fullWidth;
+         int        x0 = gx / w;
+         int        x1 = ( x0 + 1 ) % image->wordsX;
+         int        fx = gx % w;
+         const int *p = image->colors[y0 * image->wordsX + x0];
+         const int *q = image->colors[y0 * image->wordsX + x1];
+         const int *r = image->colors[y1 * image->wordsX + x0];
+         const int *s = image->colors[y1 * image->wordsX + x1];
+         GLubyte   *out = image->rgba + ( ( size_t ) y * image->width + x ) * 4;
+         GLboolean  punchThrough;
+         int        modulation = PVRTCModulation ( image, x, y, &punchThrough );
+
+         for ( c = 0; c < 4; c++ )
+         {
+            // Sums weighted out of 16 for 4 bpp and 32 for 2 bpp, widened to
+            // 8 bits by replicating the high bits
+            int a = p[c] * ( w - fx ) * ( 4 - fy ) + q[c] * fx * ( 4 - fy ) + r[c] * ( w - fx ) * fy + s[c] * fx * fy;
+            int b = p[c + 4] * ( w - fx ) * ( 4 - fy ) + q[c + 4] * fx * ( 4 - fy ) + r[c + 4] * ( w - fx ) * fy + s[c + 4] * fx * fy;
+
+            if ( w == 4 )
+            {
+               a = c < 3 ? ( a >> 6 ) + ( a >> 1 ) : ( a >> 4 ) + a;
+               b = c < 3 ? ( b >> 6 ) + ( b >> 1 ) : ( b >> 4 ) + b;
+            }
+            else
+            {
+               a = c < 3 ? ( a >> 7 ) + ( a >> 2 ) : ( a >> 5 ) + ( a >> 1 );
+               b = c < 3 ? ( b >> 7 ) + ( b >> 2 ) : ( b >> 5 ) + ( b >> 1 );
+            }
+
+            out[c] = ( GLubyte ) ( ( a * ( 8 - modulation ) + b * modulation ) / 8 );
+         }
+
+         if ( punchThrough )
+         {
+            out[3] = 0;
+         }
+      }
+   }
+}
+
+///
+// DecodePVRTC()
+//
+//    Transcode one PVRTC image to RGBA8.  Images smaller than 2x2 words
+//    are decoded as the corner of a 2x2 word image.
+//
+static GLboolean DecodePVRTC ( const GLubyte *words, int width, int height, int bpp, GLubyte *rgba )
+{
+   PVRTCImage image;
+   int        i;
+
+   image.words = words;
+   image.bpp = bpp;
+   image.wordWidth = bpp == 4 ? 4 : 8;
+   image.wordsX = width / image.wordWidth > 2 ? width / image.wordWidth : 2;
+   image.wordsY = height / 4 > 2 ? height / 4 : 2;
+   image.width = width;
+   image.height = height;
+   image.rgba = rgba;
+   image.colors = malloc ( sizeof ( *image.colors ) * image.wordsX * image.wordsY );
+
+   if ( image.colors == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   for ( i = 0; i < image.wordsX * image.wordsY; i++ )
+   {
+      int x = i % image.wordsX;
+      int y = i / image.wordsX;
+
+      UnpackPVRTCColors ( ReadUint32 ( words + PVRTCWordIndex ( &image, x, y ) * 8 + 4 ), image.colors[i] );
+   }
+
+   esParallelFor ( height, 64, DecodePVRTCRows, &image );
+
+   free ( image.colors );
+   return GL_TRUE;
+}
+
+///
+// HasNativePVRTC()
+//
+static GLboolean HasNativePVRTC ( void )
+{
+   static const char name[] = "GL_IMG_texture_compression_pvrtc";
+   const char       *extensions = ( const char * ) glGetString ( GL_EXTENSIONS );
+   const char       *found = extensions;
+
+   while ( found != NULL && ( found = strstr ( found, name ) ) != NULL )
+   {
+      // Not GL_IMG_texture_compression_pvrtc2
+      if ( found[sizeof ( name ) - 1] == ' ' || found[sizeof ( name ) - 1] == '\0' )
+      {
+         return GL_TRUE;
+      }
+
+      found += sizeof ( name ) - 1;
+   }
+
+   return GL_FALSE;
+}
+
+///
+// TexSubImage()
+//
+//    Upload one face, layer or slice of a level
+//
+static void TexSubImage ( const PVRInfo *info, GLenum internalFormat, GLenum format, GLenum type, int level, int image,
+                          int width, int height, const void *data, GLsizei imageSize )
+{
+   if ( info->target == GL_TEXTURE_3D || info->target == GL_TEXTURE_2D_ARRAY )
+   {
+      if ( format == GL_NONE )
+      {
+         glCompressedTexSubImage3D ( info->target, level, 0, 0, image, width, height, 1, internalFormat, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage3D ( info->target, level, 0, 0, image, width, height, 1, format, type, data );
+      }
+   }
+   else
+   {
+      GLenum target = info->target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + image : info->target;
+
+      if ( format == GL_NONE )
+      {
+         glCompressedTexSubImage2D ( target, level, 0, 0, width, height, internalFormat, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage2D ( target, level, 0, 0, width, height, format, type, data );
+      }
+   }
+}
+
+///
+// UploadLevels()
+//
+//    Upload every level into the texture bound to info->target.  PVRTC is
+//    only a 2D and cube map format and has no sRGB variant in the
+//    extension, so other PVRTC textures are transcoded as well.
+//
+static GLboolean UploadLevels ( const PVRInfo *info )
+{
+   GLboolean native = info->pvrtcBpp != 0 && !info->srgb && HasNativePVRTC () &&
+                      ( info->target == GL_TEXTURE_2D || info->target == GL_TEXTURE_CUBE_MAP );
+   GLboolean transcode = info->pvrtcBpp != 0 && !native;
+   GLenum    internalFormat = info->internalFormat;
+   GLenum    format = info->format;
+   GLenum    type = info->type;
+   GLubyte  *rgba = NULL;
+   GLboolean ok = GL_TRUE;
+   GLint     alignment;
+   int       level, image;
+
+   if ( transcode )
+   {
+      internalFormat = info->srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+      format = GL_RGBA;
+      type = GL_UNSIGNED_BYTE;
+      rgba = malloc ( ( size_t ) info->width * info->height * 4 );
+
+      if ( rgba == NULL )
+      {
+         return GL_FALSE;
+      }
+   }
+
+   if ( native )
+   {
+      glTexParameteri ( info->target, GL_TEXTURE_MAX_LEVEL, info->numLevels - 1 );
+   }
+   else if ( info->target == GL_TEXTURE_3D || info->target == GL_TEXTURE_2D_ARRAY )
+   {
+      glTexStorage3D ( info->target, info->numLevels, internalFormat, info->width, info->height, info->depth );
+   }
+   else
+   {
+      glTexStorage2D ( info->target, info->numLevels, internalFormat, info->width, info->height );
+   }
+
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, 1 );
+
+   for ( level = 0; level < info->numLevels && ok; level++ )
+   {
+      int     width = info->width >> level > 1 ? info->width >> level : 1;
+      int     height = info->height >> level > 1 ? info->height >> level : 1;
+      GLsizei imageSize = ( GLsizei ) ImageBytes ( info, level );
+
+      for ( image = 0; image < NumImages ( info, level ) && ok; image++ )
+      {
+         const GLubyte *data = info->data + ImageOffset ( info, level, image );
+
+         if ( native )
+         {
+            GLenum target = info->target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + image : info->target;
+
+            glCompressedTexImage2D ( target, level, internalFormat, width, height, 0, imageSize, data );
+         }
+         else if ( transcode )
+         {
+            ok = DecodePVRTC ( data, width, height, info->pvrtcBpp, rgba );
+            TexSubImage ( info, internalFormat, format, type, level, image, width, height, rgba, 0 );
+         }
+         else
+         {
+            TexSubImage ( info, internalFormat, format, type, level, image, width, height, data, imageSize );
+         }
+      }
+   }
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+
+   if ( info->swizzle != NULL )
+   {
+      glTexParameteri ( info->target, GL_TEXTURE_SWIZZLE_R, info->swizzle[0] );
+      glTexParameteri ( info->target, GL_TEXTURE_SWIZZLE_G, info->swizzle[1] );
+      glTexParameteri ( info->target, GL_TEXTURE_SWIZZLE_B, info->swizzle[2] );
+      glTexParameteri ( info->target, GL_TEXTURE_SWIZZLE_A, info->swizzle[3] );
+   }
+
+   free ( rgba );
+   return ok;
+}
+
+///
+// ParseFile()
+//
+//    Read the header of a version 2 or 3 file and check that the data of
+//    every level is present
+//
+static GLboolean ParseFile ( const void *data, int size, PVRInfo *info )
+{
+   GLboolean parsed = GL_FALSE;
+
+   memset ( info, 0, sizeof ( *info ) );
+
+   if ( size >= PVR_HEADER_SIZE && ReadUint32 ( data ) == PVR3_VERSION )
+   {
+      parsed = ParsePVR3 ( data, size, info );
+   }
+   else if ( size >= PVR_HEADER_SIZE && ReadUint32 ( data ) == PVR_HEADER_SIZE &&
+             ReadUint32 ( ( const GLubyte * ) data + 44 ) == PVR2_TAG )
+   {
+      parsed = ParsePVR2 ( data, size, info );
+   }
+
+   if ( !parsed )
+   {
+      esLogMessage ( "esLoadPVR: not a valid PVR file, or one without an OpenGL ES 3.0 equivalent\n" );
+      return GL_FALSE;
+   }
+
+   if ( ImageOffset ( info, info->numLevels, 0 ) > info->dataSize )
+   {
+      esLogMessage ( "esLoadPVR: texture data is truncated\n" );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+///
+// ExpandImage()
+//
+//    Convert one image of 8-bit channels to RGBA8, applying the swizzle
+//    the texture would be sampled with
+//
+static void ExpandImage ( const PVRInfo *info, const GLubyte *src, size_t count, GLubyte *rgba )
+{
+   size_t i;
+   int    c;
+
+   for ( i = 0; i < count; i++, src += info->pixelBytes, rgba += 4 )
+   {
+      GLubyte texel[4] = { 0, 0, 0, 255 };
+
+      memcpy ( texel, src, info->pixelBytes );
+
+      for ( c = 0; c < 4; c++ )
+      {
+         GLenum swizzle = info->swizzle != NULL ? info->swizzle[c] : GL_RED + c;
+
+         // GL_RED, GL_GREEN, GL_BLUE and GL_ALPHA are consecutive
+         rgba[c] = swizzle == GL_ZERO ? 0 : swizzle == GL_ONE ? 255 : texel[swizzle - GL_RED];
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esDecodePVR()
+//
+GLubyte *ESUTIL_API esDecodePVR ( const void *data, int size, int *width, int *height, int *numImages,
+                                  GLboolean *srgb )
+{
+   PVRInfo   info;
+   GLubyte  *rgba;
+   size_t    imagePixels;
+   int       image;
+   GLboolean ok = GL_TRUE;
+
+   if ( !ParseFile ( data, size, &info ) )
+   {
+      return NULL;
+   }
+
+   // Only 8-bit channels and PVRTC have an RGBA8 equivalent
+   if ( info.target == GL_TEXTURE_3D || ( info.pvrtcBpp == 0 && info.type != GL_UNSIGNED_BYTE ) ||
+         info.blockBytes != 0 )
+   {
+      esLogMessage ( "esDecodePVR: format 0x%04X cannot be decoded to RGBA8\n", info.internalFormat );
+      return NULL;
+   }
+
+   imagePixels = ( size_t ) info.width * info.height;
+   rgba = malloc ( imagePixels * 4 * NumImages ( &info, 0 ) );
+
+   if ( rgba == NULL )
+   {
+      return NULL;
+   }
+
+   for ( image = 0; image < NumImages ( &info, 0 ) && ok; image++ )
+   {
+      const GLubyte *src = info.data + ImageOffset ( &info, 0, image );
+      GLubyte       *dst = rgba + imagePixels * 4 * image;
+
+      if ( info.pvrtcBpp != 0 )
+      {
+         ok = DecodePVRTC ( src, info.width, info.height, info.pvrtcBpp, dst );
+      }
+      else
+      {
+         ExpandImage ( &info, src, imagePixels, dst );
+      }
+   }
+
+   if ( !ok )
+   {
+      free ( rgba );
+      return NULL;
+   }
+
+   *width = info.width;
+   *height = info.height;
+   *numImages = NumImages ( &info, 0 );
+
+   if ( srgb != NULL )
+   {
+      *srgb = info.srgb;
+   }
+
+   return rgba;
+}
+
+///
+// esCreateTexturePVR()
+//
+GLuint ESUTIL_API esCreateTexturePVR ( const void *data, int size, GLenum *target )
+{
+   PVRInfo info;
+   GLuint  texture;
+
+   if ( !ParseFile ( data, size, &info ) )
+   {
+      return 0;
+   }
+
+   // Errors raised before this call must not be taken for upload errors
+   while ( glGetError () != GL_NO_ERROR )
+   {
+   }
+
+   glGenTextures ( 1, &texture );
+   glBindTexture ( info.target, texture );
+
+   if ( !UploadLevels ( &info ) || glGetError () != GL_NO_ERROR )
+   {
+      esLogMessage ( "esLoadPVR: upload of format 0x%04X failed\n", info.internalFormat );
+      glDeleteTextures ( 1, &texture );
+      return 0;
+   }
+
+   if ( target != NULL )
+   {
+      *target = info.target;
+   }
+
+   return texture;
+}
+
+///
+// esLoadPVR()
+//
+GLuint ESUTIL_API esLoadPVR ( void *ioContext, const char *fileName, GLenum *target )
+{
+   ESFileMapping file;
+   GLuint        texture = 0;
+
+   if ( esMapFile ( ioContext, fileName, &file ) )
+   {
+      texture = esCreateTexturePVR ( file.data, file.size, target );
+      esUnmapFile ( &file );
+   }
+
+   if ( texture == 0 )
+   {
+      esLogMessage ( "esLoadPVR FAILED to load : { %s }\n", fileName );
+   }
+
+   return texture;
+}
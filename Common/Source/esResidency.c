@@ -0,0 +1,723 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESResidency.c
+//
+//    Keeps the memory used by textures under a budget.  Each texture's
+//    levels are accounted for from its format and size; when the total
+//    goes over the budget, the largest level of the least recently used
+//    texture is dropped: GL_TEXTURE_BASE_LEVEL is raised past it and its
+//    storage released by respecifying it as an empty image.  Textures
+//    used again get their levels back one per frame, through a callback
+//    that uploads a level again.
+//
+//    Immutable storage cannot release a level, so immutable textures are
+//    deleted and created again under the same name with fewer levels, all
+//    of which are uploaded again through the callback.  Textures with no
+//    way to restore a level are accounted for but never dropped.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+// Macros
+//
+#ifndef GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG
+#define GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG    0x8C00
+#define GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG    0x8C01
+#define GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG   0x8C02
+#define GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG   0x8C03
+#endif
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES                      0x8D64
+#endif
+
+///
+// Types
+//
+typedef struct
+{
+   GLenum internalFormat;
+   // Format and type accepted with the internal format, 0 if compressed
+   GLenum format;
+   GLenum type;
+   // Size of a block in texels and in bytes, and the size small levels
+   // are padded to
+   int    blockWidth;
+   int    blockHeight;
+   int    blockBytes;
+   int    minWidth;
+   int    minHeight;
+} TextureFormat;
+
+typedef struct
+{
+   GLuint               texture;
+   GLenum               target;
+   const TextureFormat *format;
+   int                  width;
+   int                  height;
+   int                  depth;
+   int                  numLevels;
+
+   // First level with storage, and how far it may be raised
+   int                  baseLevel;
+   int                  maxBaseLevel;
+
+   // Level of the full chain that level 0 of an immutable texture holds
+   GLboolean            immutable;
+   int                  firstLevel;
+
+   // Bytes of the levels from baseLevel on
+   GLsizeiptr           residentBytes;
+
+   // Frame the texture was last used in
+   unsigned int         lastUse;
+
+   ESRestoreLevelFunc   restore;
+   void                *userData;
+} ResidentTexture;
+
+struct ESResidency
+{
+   GLsizeiptr       budget;
+   GLsizeiptr       residentBytes;
+   unsigned int     frame;
+
+   // Sorted by texture name
+   ResidentTexture *textures;
+   int              numTextures;
+   int              capacity;
+};
+
+///
+// Tables
+//
+
+// Parameters kept when an immutable texture is created again
+static const GLenum textureParams[] =
+{
+   GL_TEXTURE_MIN_FILTER,
+   GL_TEXTURE_MAG_FILTER,
+   GL_TEXTURE_WRAP_S,
+   GL_TEXTURE_WRAP_T,
+   GL_TEXTURE_WRAP_R,
+   GL_TEXTURE_COMPARE_MODE,
+   GL_TEXTURE_COMPARE_FUNC,
+   GL_TEXTURE_SWIZZLE_R,
+   GL_TEXTURE_SWIZZLE_G,
+   GL_TEXTURE_SWIZZLE_B,
+   GL_TEXTURE_SWIZZLE_A,
+};
+
+#define NUM_TEXTURE_PARAMS    ( sizeof ( textureParams ) / sizeof ( textureParams[0] ) )
+static const TextureFormat textureFormats[] =
+{
+   { GL_R8,                   GL_RED,             GL_UNSIGNED_BYTE,                 1, 1, 1,  1, 1 },
+   { GL_RG8,                  GL_RG,              GL_UNSIGNED_BYTE,                 1, 1, 2,  1, 1 },
+   { GL_RGB8,                 GL_RGB,             GL_UNSIGNED_BYTE,                 1, 1, 3,  1, 1 },
+   { GL_RGBA8,                GL_RGBA,            GL_UNSIGNED_BYTE,                 1, 1, 4,  1, 1 },
+   { GL_SRGB8,                GL_RGB,             GL_UNSIGNED_BYTE,                 1, 1, 3,  1, 1 },
+   { GL_SRGB8_ALPHA8,         GL_RGBA,            GL_UNSIGNED_BYTE,                 1, 1, 4,  1, 1 },
+   { GL_RGB565,               GL_RGB,             GL_UNSIGNED_SHORT_5_6_5,          1, 1, 2,  1, 1 },
+   { GL_RGBA4,                GL_RGBA,            GL_UNSIGNED_SHORT_4_4_4_4,        1, 1, 2,  1, 1 },
+   { GL_RGB5_A1,              GL_RGBA,            GL_UNSIGNED_SHORT_5_5_5_1,        1, 1, 2,  1, 1 },
+   { GL_R16F,                 GL_RED,             GL_HALF_FLOAT,                    1, 1, 2,  1, 1 },
+   { GL_RGBA16F,              GL_RGBA,            GL_HALF_FLOAT,                    1, 1, 8,  1, 1 },
+   { GL_R32F,                 GL_RED,             GL_FLOAT,                         1, 1, 4,  1, 1 },
+   { GL_RGBA32F,              GL_RGBA,            GL_FLOAT,                         1, 1, 16, 1, 1 },
+   { GL_R11F_G11F_B10F,       GL_RGB,             GL_UNSIGNED_INT_10F_11F_11F_REV,  1, 1, 4,  1, 1 },
+   { GL_ALPHA,                GL_ALPHA,           GL_UNSIGNED_BYTE,                 1, 1, 1,  1, 1 },
+   { GL_LUMINANCE,            GL_LUMINANCE,       GL_UNSIGNED_BYTE,                 1, 1, 1,  1, 1 },
+   { GL_LUMINANCE_ALPHA,      GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,                 1, 1, 2,  1, 1 },
+   { GL_RGB,                  GL_RGB,             GL_UNSIGNED_BYTE,                 1, 1, 3,  1, 1 },
+   { GL_RGBA,                 GL_RGBA,            GL_UNSIGNED_BYTE,                 1, 1, 4,  1, 1 },
+
+   { GL_ETC1_RGB8_OES,                            0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_RGB8_ETC2,                     0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_SRGB8_ETC2,                    0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2, 0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2,0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_R11_EAC,                       0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_SIGNED_R11_EAC,                0, 0, 4, 4, 8,  1,  1 },
+   { GL_COMPRESSED_RGBA8_ETC2_EAC,                0, 0, 4, 4, 16, 1,  1 },
+   { GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,         0, 0, 4, 4, 16, 1,  1 },
+   { GL_COMPRESSED_RG11_EAC,                      0, 0, 4, 4, 16, 1,  1 },
+   { GL_COMPRESSED_SIGNED_RG11_EAC,               0, 0, 4, 4, 16, 1,  1 },
+   { GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG,          0, 0, 4, 4, 8,  8,  8 },
+   { GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG,         0, 0, 4, 4, 8,  8,  8 },
+   { GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG,          0, 0, 8, 4, 8,  16, 8 },
+   { GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG,         0, 0, 8, 4, 8,  16, 8 },
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// FindFormat()
+//
+static const TextureFormat *FindFormat ( GLenum internalFormat )
+{
+   size_t i;
+
+   for ( i = 0; i < sizeof ( textureFormats ) / sizeof ( textureFormats[0] ); i++ )
+   {
+      if ( textureFormats[i].internalFormat == internalFormat )
+      {
+         return &textureFormats[i];
+      }
+   }
+
+   return NULL;
+}
+
+///
+// LevelBytes()
+//
+//    Size of a level of a texture, all faces included.  The layers of
+//    array textures do not shrink with the level.
+//
+static GLsizeiptr LevelBytes ( const ResidentTexture *tex, int level )
+{
+   const TextureFormat *format = tex->format;
+   int        width = tex->width >> level > 0 ? tex->width >> level : 1;
+   int        height = tex->height >> level > 0 ? tex->height >> level : 1;
+   int        depth = tex->depth;
+   GLsizeiptr blocks;
+
+   if ( tex->target == GL_TEXTURE_3D )
+   {
+      depth = tex->depth >> level > 0 ? tex->depth >> level : 1;
+   }
+
+   width = width > format->minWidth ? width : format->minWidth;
+   height = height > format->minHeight ? height : format->minHeight;
+
+   blocks = ( GLsizeiptr ) ( ( width + format->blockWidth - 1 ) / format->blockWidth ) *
+            ( ( height + format->blockHeight - 1 ) / format->blockHeight ) * depth;
+
+   return blocks * format->blockBytes * ( tex->target == GL_TEXTURE_CUBE_MAP ? 6 : 1 );
+}
+
+///
+// FindTexture()
+//
+//    Index of the texture, or minus one minus the index it would be
+//    inserted at
+//
+static int FindTexture ( const ESResidency *residency, GLuint texture )
+{
+   int low = 0;
+   int high = residency->numTextures - 1;
+
+   while ( low <= high )
+   {
+      int    middle = ( low + high ) / 2;
+      GLuint name = residency->textures[middle].texture;
+
+      if ( name == texture )
+      {
+         return middle;
+      }
+
+      if ( name < texture )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle - 1;
+      }
+   }
+
+   return -low - 1;
+}
+
+///
+// BindingQuery()
+//
+static GLenum BindingQuery ( GLenum target )
+{
+   switch ( target )
+   {
+      case GL_TEXTURE_3D:
+         return GL_TEXTURE_BINDING_3D;
+
+      case GL_TEXTURE_2D_ARRAY:
+         return GL_TEXTURE_BINDING_2D_ARRAY;
+
+      case GL_TEXTURE_CUBE_MAP:
+         return GL_TEXTURE_BINDING_CUBE_MAP;
+
+      default:
+         return GL_TEXTURE_BINDING_2D;
+   }
+}
+
+///
+// ReleaseLevel()
+//
+//    Free the storage of a level by making it an empty image
+//
+static void ReleaseLevel ( const ResidentTexture *tex, int level )
+{
+   const TextureFormat *format = tex->format;
+   GLenum target = tex->target;
+   int    numFaces = 1;
+   int    face;
+
+   if ( tex->target == GL_TEXTURE_CUBE_MAP )
+   {
+      target = GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+      numFaces = 6;
+   }
+
+   for ( face = 0; face < numFaces; face++ )
+   {
+      if ( tex->target == GL_TEXTURE_3D || tex->target == GL_TEXTURE_2D_ARRAY )
+      {
+         if ( format->format == 0 )
+         {
+            glCompressedTexImage3D ( target, level, format->internalFormat, 0, 0, 0, 0, 0, NULL );
+         }
+         else
+         {
+            glTexImage3D ( target, level, format->internalFormat, 0, 0, 0, 0, format->format, format->type, NULL );
+         }
+      }
+      else if ( format->format == 0 )
+      {
+         glCompressedTexImage2D ( target + face, level, format->internalFormat, 0, 0, 0, 0, NULL );
+      }
+      else
+      {
+         glTexImage2D ( target + face, level, format->internalFormat, 0, 0, 0, format->format, format->type, NULL );
+      }
+   }
+}
+
+///
+// RecreateTexture()
+//
+//    Give an immutable texture the levels of the full chain from baseLevel
+//    on, uploaded through the restore callback.  The texture is bound.
+//
+static GLboolean RecreateTexture ( ResidentTexture *tex, int baseLevel )
+{
+   GLint     values[NUM_TEXTURE_PARAMS];
+   GLfloat   minLod;
+   GLfloat   maxLod;
+   GLint     maxLevel;
+   GLboolean restored = GL_TRUE;
+   int       width = tex->width >> baseLevel > 0 ? tex->width >> baseLevel : 1;
+   int       height = tex->height >> baseLevel > 0 ? tex->height >> baseLevel : 1;
+   int       depth = tex->depth;
+   int       level;
+   size_t    i;
+
+   for ( i = 0; i < NUM_TEXTURE_PARAMS; i++ )
+   {
+      glGetTexParameteriv ( tex->target, textureParams[i], &values[i] );
+   }
+
+   glGetTexParameterfv ( tex->target, GL_TEXTURE_MIN_LOD, &minLod );
+   glGetTexParameterfv ( tex->target, GL_TEXTURE_MAX_LOD, &maxLod );
+   glGetTexParameteriv ( tex->target, GL_TEXTURE_MAX_LEVEL, &maxLevel );
+
+   // Binding the name of the deleted texture creates a new one
+   glDeleteTextures ( 1, &tex->texture );
+   glBindTexture ( tex->target, tex->texture );
+
+   if ( tex->target == GL_TEXTURE_3D )
+   {
+      depth = tex->depth >> baseLevel > 0 ? tex->depth >> baseLevel : 1;
+   }
+
+   if ( tex->target == GL_TEXTURE_3D || tex->target == GL_TEXTURE_2D_ARRAY )
+   {
+      glTexStorage3D ( tex->target, tex->numLevels - baseLevel, tex->format->internalFormat, width, height, depth );
+   }
+   else
+   {
+      glTexStorage2D ( tex->target, tex->numLevels - baseLevel, tex->format->internalFormat, width, height );
+   }
+
+   for ( level = baseLevel; level < tex->numLevels; level++ )
+   {
+      restored = tex->restore ( tex->userData, tex->texture, tex->target, level, level - baseLevel ) && restored;
+   }
+
+   for ( i = 0; i < NUM_TEXTURE_PARAMS; i++ )
+   {
+      glTexParameteri ( tex->target, textureParams[i], values[i] );
+   }
+
+   // The maximum level counts from the new level 0
+   maxLevel += tex->firstLevel - baseLevel;
+   tex->firstLevel = baseLevel;
+   glTexParameterf ( tex->target, GL_TEXTURE_MIN_LOD, minLod );
+   glTexParameterf ( tex->target, GL_TEXTURE_MAX_LOD, maxLod );
+   glTexParameteri ( tex->target, GL_TEXTURE_MAX_LEVEL, maxLevel > 0 ? maxLevel : 0 );
+
+   if ( !restored )
+   {
+      esLogMessage ( "esUpdateResidency: cannot upload the levels of texture %u again\n", tex->texture );
+   }
+
+   return restored;
+}
+
+///
+// DropLevel()
+//
+//    Drop the largest level of a texture
+//
+static void DropLevel ( ESResidency *residency, ResidentTexture *tex )
+{
+   GLsizeiptr bytes = LevelBytes ( tex, tex->baseLevel );
+
+   glBindTexture ( tex->target, tex->texture );
+
+   if ( tex->immutable )
+   {
+      RecreateTexture ( tex, tex->baseLevel + 1 );
+   }
+   else
+   {
+      glTexParameteri ( tex->target, GL_TEXTURE_BASE_LEVEL, tex->baseLevel + 1 );
+      ReleaseLevel ( tex, tex->baseLevel );
+   }
+
+   tex->baseLevel++;
+   tex->residentBytes -= bytes;
+   residency->residentBytes -= bytes;
+}
+
+///
+// RestoreLevel()
+//
+//    Upload the level above the base level of a texture again
+//
+static void RestoreLevel ( ESResidency *residency, ResidentTexture *tex )
+{
+   int        level = tex->baseLevel - 1;
+   GLsizeiptr bytes = LevelBytes ( tex, level );
+
+   glBindTexture ( tex->target, tex->texture );
+
+   if ( tex->immutable )
+   {
+      if ( !RecreateTexture ( tex, level ) )
+      {
+         // Go back to the levels that were resident
+         RecreateTexture ( tex, tex->baseLevel );
+         return;
+      }
+   }
+   else
+   {
+      if ( !tex->restore ( tex->userData, tex->texture, tex->target, level, level ) )
+      {
+         // Leave the level empty and keep sampling the smaller ones
+         ReleaseLevel ( tex, level );
+         return;
+      }
+
+      glTexParameteri ( tex->target, GL_TEXTURE_BASE_LEVEL, level );
+   }
+
+   tex->baseLevel = level;
+   tex->residentBytes += bytes;
+   residency->residentBytes += bytes;
+}
+
+///
+// LeastRecentlyUsed()
+//
+//    Of the textures not used in this frame that still have a level to
+//    drop, the one used the longest ago, with the most bytes if several
+//    were last used in the same frame
+//
+static ResidentTexture *LeastRecentlyUsed ( ESResidency *residency )
+{
+   ResidentTexture *best = NULL;
+   int              i;
+
+   for ( i = 0; i < residency->numTextures; i++ )
+   {
+      ResidentTexture *tex = &residency->textures[i];
+
+      if ( tex->lastUse == residency->frame || tex->baseLevel >= tex->maxBaseLevel )
+      {
+         continue;
+      }
+
+      if ( best == NULL || tex->lastUse < best->lastUse ||
+           ( tex->lastUse == best->lastUse && tex->residentBytes > best->residentBytes ) )
+      {
+         best = tex;
+      }
+   }
+
+   return best;
+}
+
+///
+// MakeRoom()
+//
+//    Drop levels until the resident bytes plus extraBytes fit in the
+//    budget
+//
+static GLboolean MakeRoom ( ESResidency *residency, GLsizeiptr extraBytes )
+{
+   while ( residency->residentBytes + extraBytes > residency->budget )
+   {
+      ResidentTexture *tex = LeastRecentlyUsed ( residency );
+
+      if ( tex == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      DropLevel ( residency, tex );
+   }
+
+   return GL_TRUE;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateResidency()
+//
+ESResidency *ESUTIL_API esCreateResidency ( GLsizeiptr budget )
+{
+   ESResidency *residency = calloc ( 1, sizeof ( ESResidency ) );
+
+   if ( residency != NULL )
+   {
+      residency->budget = budget;
+   }
+
+   return residency;
+}
+
+///
+// esResidencyAddTexture()
+//
+GLboolean ESUTIL_API esResidencyAddTexture ( ESResidency *residency, GLuint texture, GLenum target,
+                                             GLenum internalFormat, int width, int height, int depth,
+                                             int numLevels, ESRestoreLevelFunc restore, void *userData )
+{
+   const TextureFormat *format = FindFormat ( internalFormat );
+   ResidentTexture     *tex;
+   GLint                binding = 0;
+   GLint                immutable = GL_FALSE;
+   int                  index = FindTexture ( residency, texture );
+   int                  level;
+
+   if ( format == NULL || index >= 0 || width < 1 || height < 1 || numLevels < 1 )
+   {
+      esLogMessage ( "esResidencyAddTexture: cannot track texture %u (format 0x%04x)\n", texture, internalFormat );
+      return GL_FALSE;
+   }
+
+   if ( residency->numTextures == residency->capacity )
+   {
+      int              capacity = residency->capacity ? residency->capacity * 2 : 64;
+      ResidentTexture *textures = realloc ( residency->textures, sizeof ( ResidentTexture ) * capacity );
+
+      if ( textures == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      residency->textures = textures;
+      residency->capacity = capacity;
+   }
+
+   index = -index - 1;
+   memmove ( &residency->textures[index + 1], &residency->textures[index],
+             sizeof ( ResidentTexture ) * ( residency->numTextures - index ) );
+   residency->numTextures++;
+
+   tex = &residency->textures[index];
+   memset ( tex, 0, sizeof ( ResidentTexture ) );
+   tex->texture = texture;
+   tex->target = target;
+   tex->format = format;
+   tex->width = width;
+   tex->height = height;
+   tex->depth = ( target == GL_TEXTURE_3D || target == GL_TEXTURE_2D_ARRAY ) && depth > 1 ? depth : 1;
+   tex->numLevels = numLevels;
+   tex->lastUse = residency->frame;
+   tex->restore = restore;
+   tex->userData = userData;
+
+   // Immutable textures are created again to release a level
+   glGetIntegerv ( BindingQuery ( target ), &binding );
+   glBindTexture ( target, texture );
+   glGetTexParameteriv ( target, GL_TEXTURE_IMMUTABLE_FORMAT, &immutable );
+   glBindTexture ( target, binding );
+
+   tex->immutable = immutable ? GL_TRUE : GL_FALSE;
+   tex->maxBaseLevel = restore != NULL ? numLevels - 1 : 0;
+
+   for ( level = 0; level < numLevels; level++ )
+   {
+      tex->residentBytes += LevelBytes ( tex, level );
+   }
+
+   residency->residentBytes += tex->residentBytes;
+   return GL_TRUE;
+}
+
+///
+// esResidencyRemoveTexture()
+//
+void ESUTIL_API esResidencyRemoveTexture ( ESResidency *residency, GLuint texture )
+{
+   int index = FindTexture ( residency, texture );
+
+   if ( index < 0 )
+   {
+      return;
+   }
+
+   residency->residentBytes -= residency->textures[index].residentBytes;
+   residency->numTextures--;
+   memmove ( &residency->textures[index], &residency->textures[index + 1],
+             sizeof ( ResidentTexture ) * ( residency->numTextures - index ) );
+}
+
+///
+// esResidencyTouch()
+//
+void ESUTIL_API esResidencyTouch ( ESResidency *residency, GLuint texture )
+{
+   int index = FindTexture ( residency, texture );
+
+   if ( index >= 0 )
+   {
+      residency->textures[index].lastUse = residency->frame;
+   }
+}
+
+///
+// esUpdateResidency()
+//
+GLsizeiptr ESUTIL_API esUpdateResidency ( ESResidency *residency )
+{
+   GLint bindings[4];
+   int   i;
+
+   glGetIntegerv ( GL_TEXTURE_BINDING_2D, &bindings[0] );
+   glGetIntegerv ( GL_TEXTURE_BINDING_3D, &bindings[1] );
+   glGetIntegerv ( GL_TEXTURE_BINDING_2D_ARRAY, &bindings[2] );
+   glGetIntegerv ( GL_TEXTURE_BINDING_CUBE_MAP, &bindings[3] );
+
+   MakeRoom ( residency, 0 );
+
+   // Bring back one level of each texture used in this frame, if room can
+   // be made without dropping a level of another texture in use
+   for ( i = 0; i < residency->numTextures; i++ )
+   {
+      ResidentTexture *tex = &residency->textures[i];
+
+      if ( tex->lastUse == residency->frame && tex->baseLevel > 0 &&
+           MakeRoom ( residency, LevelBytes ( tex, tex->baseLevel - 1 ) ) )
+      {
+         RestoreLevel ( residency, tex );
+      }
+   }
+
+   glBindTexture ( GL_TEXTURE_2D, bindings[0] );
+   glBindTexture ( GL_TEXTURE_3D, bindings[1] );
+   glBindTexture ( GL_TEXTURE_2D_ARRAY, bindings[2] );
+   glBindTexture ( GL_TEXTURE_CUBE_MAP, bindings[3] );
+
+   residency->frame++;
+   return residency->residentBytes;
+}
+
+///
+// esResidencyBytes()
+//
+GLsizeiptr ESUTIL_API esResidencyBytes ( ESResidency *residency, GLuint texture, int *baseLevel )
+{
+   int index;
+
+   if ( texture == 0 )
+   {
+      return residency->residentBytes;
+   }
+
+   index = FindTexture ( residency, texture );
+
+   if ( index < 0 )
+   {
+      return 0;
+   }
+
+   if ( baseLevel != NULL )
+   {
+      *baseLevel = residency->textures[index].baseLevel;
+   }
+
+   return residency->textures[index].residentBytes;
+}
+
+///
+// esDeleteResidency()
+//
+void ESUTIL_API esDeleteResidency ( ESResidency *residency )
+{
+   if ( residency == NULL )
+   {
+      return;
+   }
+
+   free ( residency->textures );
+   free ( residency );
+}
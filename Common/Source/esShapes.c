@@ -53,6 +53,163 @@
 //
 //
 
+///
+// IcosphereMidpoint()
+//
+//    Return the vertex halfway along edge (a, b), pushed out onto the unit
+//    sphere.  Both faces sharing an edge ask for its midpoint, so the
+//    vertex is created once and looked up in an open addressing table the
+//    second time.
+//
+static GLuint IcosphereMidpoint ( GLuint a, GLuint b, GLfloat *positions, int *numVertices,
+                                  GLuint *cacheKeys, GLuint *cacheValues, GLuint cacheMask )
+{
+   GLuint lo = a < b ? a : b;
+   GLuint hi = a < b ? b : a;
+   GLuint slot = ( lo * 2654435761u ^ hi * 40503u ) & cacheMask;
+   GLfloat *p;
+   float length;
+   int i;
+
+   while ( cacheKeys[2 * slot] != 0xFFFFFFFFu )
+   {
+      if ( cacheKeys[2 * slot] == lo && cacheKeys[2 * slot + 1] == hi )
+      {
+         return cacheValues[slot];
+      }
+
+      slot = ( slot + 1 ) & cacheMask;
+   }
+
+   p = &positions[3 * *numVertices];
+
+   for ( i = 0; i < 3; i++ )
+   {
+      p[i] = 0.5f * ( positions[3 * a + i] + positions[3 * b + i] );
+   }
+
+   length = sqrtf ( p[0] * p[0] + p[1] * p[1] + p[2] * p[2] );
+   p[0] /= length;
+   p[1] /= length;
+   p[2] /= length;
+
+   cacheKeys[2 * slot] = lo;
+   cacheKeys[2 * slot + 1] = hi;
+   cacheValues[slot] = ( GLuint ) *numVertices;
+
+   return ( GLuint ) ( *numVertices )++;
+}
+
+///
+// IcosphereCopyVertex()
+//
+//    Append a copy of vertex v with different texture coordinates, growing
+//    the arrays as needed.  Returns the index of the copy.
+//
+static GLuint IcosphereCopyVertex ( GLuint v, GLfloat u, GLfloat **positions, GLfloat **uvs,
+                                    int *numVertices, int *capacity )
+{
+   int n = *numVertices;
+
+   if ( n == *capacity )
+   {
+      *capacity *= 2;
+      *positions = realloc ( *positions, sizeof ( GLfloat ) * 3 * *capacity );
+      *uvs = realloc ( *uvs, sizeof ( GLfloat ) * 2 * *capacity );
+   }
+
+   memcpy ( &( *positions ) [3 * n], &( *positions ) [3 * v], sizeof ( GLfloat ) * 3 );
+   ( *uvs ) [2 * n + 0] = u;
+   ( *uvs ) [2 * n + 1] = ( *uvs ) [2 * v + 1];
+
+   *numVertices = n + 1;
+
+   return ( GLuint ) n;
+}
+
+///
+// IcosphereTexCoords()
+//
+//    Spherical texture coordinates for the unit sphere positions.  A shared
+//    vertex can only hold one u, so triangles that straddle the u = 0/1 seam
+//    get copies of their low-u vertices shifted by 1, and each triangle
+//    touching a pole gets its own copy of the pole with u taken from the
+//    triangle's other corners.
+//
+static GLfloat *IcosphereTexCoords ( GLfloat **positions, int *numVertices, int *capacity,
+                                     GLuint *faces, int numFaces )
+{
+   int      numShared = *numVertices;
+   GLfloat *uvs = malloc ( sizeof ( GLfloat ) * 2 * *capacity );
+   GLuint  *seamCopy = malloc ( sizeof ( GLuint ) * numShared );
+   int      i;
+   int      j;
+
+   for ( i = 0; i < numShared; i++ )
+   {
+      GLfloat *p = &( *positions ) [3 * i];
+      float    u = atan2f ( p[0], p[2] ) / ( 2.0f * ES_PI );
+
+      uvs[2 * i + 0] = u < 0.0f ? u + 1.0f : u;
+      uvs[2 * i + 1] = acosf ( p[1] < -1.0f ? -1.0f : p[1] > 1.0f ? 1.0f : p[1] ) / ES_PI;
+      seamCopy[i] = 0xFFFFFFFFu;
+   }
+
+   for ( i = 0; i < numFaces; i++ )
+   {
+      GLuint *face = &faces[3 * i];
+      int     pole = -1;
+      float   minU = 1.0f;
+      float   maxU = 0.0f;
+      float   sumU = 0.0f;
+
+      for ( j = 0; j < 3; j++ )
+      {
+         GLfloat *p = &( *positions ) [3 * face[j]];
+
+         if ( p[0] * p[0] + p[2] * p[2] < 1e-10f )
+         {
+            pole = j;
+         }
+         else
+         {
+            minU = uvs[2 * face[j]] < minU ? uvs[2 * face[j]] : minU;
+            maxU = uvs[2 * face[j]] > maxU ? uvs[2 * face[j]] : maxU;
+         }
+      }
+
+      for ( j = 0; j < 3; j++ )
+      {
+         if ( j == pole )
+         {
+            continue;
+         }
+
+         if ( maxU - minU > 0.5f && uvs[2 * face[j]] < 0.5f )
+         {
+            if ( seamCopy[face[j]] == 0xFFFFFFFFu )
+            {
+               seamCopy[face[j]] = IcosphereCopyVertex ( face[j], uvs[2 * face[j]] + 1.0f,
+                                                         positions, &uvs, numVertices, capacity );
+            }
+
+            face[j] = seamCopy[face[j]];
+         }
+
+         sumU += uvs[2 * face[j]];
+      }
+
+      if ( pole >= 0 )
+      {
+         face[pole] = IcosphereCopyVertex ( face[pole], 0.5f * sumU, positions, &uvs, numVertices, capacity );
+      }
+   }
+
+   free ( seamCopy );
+
+   return uvs;
+}
+
 
 
 //////////////////////////////////////////////////////////////////
@@ -365,3 +522,144 @@ int ESUTIL_API esGenSquareGrid ( int size, GLfloat **vertices, GLuint **indices
 
    return numIndices;
 }
+
+//
+/// \brief Generates geometry for a geodesic sphere by subdividing an icosahedron.  Allocates memory
+///        for the vertex data and stores the results in the arrays.  Generate index list for TRIANGLES
+/// \param subdivisions Number of times each triangle is split into four, 0 to 10
+/// \param radius Radius of the sphere
+/// \param vertices If not NULL, will contain array of float3 positions
+/// \param normals If not NULL, will contain array of float3 normals
+/// \param texCoords If not NULL, will contain array of float2 texCoords
+/// \param indices If not NULL, will contain the array of indices for the triangles
+/// \param numVertices If not NULL, returns the number of vertices in the arrays
+/// \return The number of indices required for rendering the buffers (the number of indices stored in the indices array
+///         if it is not NULL ) as GL_TRIANGLES
+//
+int ESUTIL_API esGenIcosphere ( int subdivisions, float radius, GLfloat **vertices, GLfloat **normals,
+                                GLfloat **texCoords, GLuint **indices, int *numVertices )
+{
+   // Golden ratio, normalized below
+   const float t = 1.61803399f;
+   const float s = 1.0f / sqrtf ( 1.0f + t * t );
+   const GLfloat icoVerts[12][3] =
+   {
+      { -1,  t,  0 }, {  1,  t,  0 }, { -1, -t,  0 }, {  1, -t,  0 },
+      {  0, -1,  t }, {  0,  1,  t }, {  0, -1, -t }, {  0,  1, -t },
+      {  t,  0, -1 }, {  t,  0,  1 }, { -t,  0, -1 }, { -t,  0,  1 },
+   };
+   static const GLuint icoFaces[20][3] =
+   {
+      { 0, 11,  5 }, { 0,  5,  1 }, {  0,  1,  7 }, {  0,  7, 10 }, { 0, 10, 11 },
+      { 1,  5,  9 }, { 5, 11,  4 }, { 11, 10,  2 }, { 10,  7,  6 }, { 7,  1,  8 },
+      { 3,  9,  4 }, { 3,  4,  2 }, {  3,  2,  6 }, {  3,  6,  8 }, { 3,  8,  9 },
+      { 4,  9,  5 }, { 2,  4, 11 }, {  6,  2, 10 }, {  8,  6,  7 }, { 9,  8,  1 },
+   };
+   GLfloat *positions;
+   GLfloat *uvs = NULL;
+   GLuint  *faces;
+   int      numFaces = 20;
+   int      vertexCount = 12;
+   int      capacity;
+   int      level;
+   int      i;
+
+   subdivisions = subdivisions < 0 ? 0 : subdivisions > 10 ? 10 : subdivisions;
+
+   // V = 10 * 4^n + 2 shared vertices and F = 20 * 4^n faces
+   capacity = 10 * ( 1 << ( 2 * subdivisions ) ) + 2;
+   positions = malloc ( sizeof ( GLfloat ) * 3 * capacity );
+   faces = malloc ( sizeof ( GLuint ) * 3 * ( 20 << ( 2 * subdivisions ) ) );
+
+   for ( i = 0; i < 12; i++ )
+   {
+      positions[3 * i + 0] = icoVerts[i][0] * s;
+      positions[3 * i + 1] = icoVerts[i][1] * s;
+      positions[3 * i + 2] = icoVerts[i][2] * s;
+   }
+
+   memcpy ( faces, icoFaces, sizeof ( icoFaces ) );
+
+   for ( level = 0; level < subdivisions; level++ )
+   {
+      // Each level has 3F/2 edges; keep the table at most half full
+      GLuint  cacheSize = 1;
+      GLuint *cacheKeys;
+      GLuint *cacheValues;
+      GLuint *split = malloc ( sizeof ( GLuint ) * 3 * 4 * numFaces );
+
+      while ( cacheSize < ( GLuint ) ( 3 * numFaces ) )
+      {
+         cacheSize *= 2;
+      }
+
+      cacheKeys = malloc ( sizeof ( GLuint ) * 2 * cacheSize );
+      cacheValues = malloc ( sizeof ( GLuint ) * cacheSize );
+      memset ( cacheKeys, 0xFF, sizeof ( GLuint ) * 2 * cacheSize );
+
+      for ( i = 0; i < numFaces; i++ )
+      {
+         GLuint a = faces[3 * i + 0];
+         GLuint b = faces[3 * i + 1];
+         GLuint c = faces[3 * i + 2];
+         GLuint ab = IcosphereMidpoint ( a, b, positions, &vertexCount, cacheKeys, cacheValues, cacheSize - 1 );
+         GLuint bc = IcosphereMidpoint ( b, c, positions, &vertexCount, cacheKeys, cacheValues, cacheSize - 1 );
+         GLuint ca = IcosphereMidpoint ( c, a, positions, &vertexCount, cacheKeys, cacheValues, cacheSize - 1 );
+         GLuint *out = &split[12 * i];
+
+         out[0] = a;  out[1]  = ab; out[2]  = ca;
+         out[3] = b;  out[4]  = bc; out[5]  = ab;
+         out[6] = c;  out[7]  = ca; out[8]  = bc;
+         out[9] = ab; out[10] = bc; out[11] = ca;
+      }
+
+      free ( cacheKeys );
+      free ( cacheValues );
+      free ( faces );
+
+      faces = split;
+      numFaces *= 4;
+   }
+
+   if ( texCoords != NULL )
+   {
+      uvs = IcosphereTexCoords ( &positions, &vertexCount, &capacity, faces, numFaces );
+      *texCoords = uvs;
+   }
+
+   if ( normals != NULL )
+   {
+      *normals = malloc ( sizeof ( GLfloat ) * 3 * vertexCount );
+      memcpy ( *normals, positions, sizeof ( GLfloat ) * 3 * vertexCount );
+   }
+
+   if ( vertices != NULL )
+   {
+      for ( i = 0; i < 3 * vertexCount; i++ )
+      {
+         positions[i] *= radius;
+      }
+
+      *vertices = positions;
+   }
+   else
+   {
+      free ( positions );
+   }
+
+   if ( indices != NULL )
+   {
+      *indices = faces;
+   }
+   else
+   {
+      free ( faces );
+   }
+
+   if ( numVertices != NULL )
+   {
+      *numVertices = vertexCount;
+   }
+
+   return 3 * numFaces;
+}
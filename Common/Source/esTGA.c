@@ -0,0 +1,688 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESTGA.c
+//
+//    Decoder for Truevision TGA images: uncompressed and run-length
+//    encoded true-color, grayscale and color-mapped files.
+//
+//    Pixels are converted from the file's BGR(A) order to RGB(A) and the
+//    rows are stored bottom to top, the order glTexImage2D expects,
+//    whatever the origin recorded in the file.  Both happen while the
+//    pixels are copied out of the file, so an uncompressed image is
+//    touched once.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ES_TGA_SSE
+#endif
+
+///
+//  Macros
+//
+#define TGA_HEADER_SIZE          18
+
+// Image types; the run-length encoded variants add TGA_RLE_BIT
+#define TGA_COLOR_MAPPED         1
+#define TGA_TRUE_COLOR           2
+#define TGA_GRAYSCALE            3
+#define TGA_RLE_BIT              8
+
+// Descriptor bits
+#define TGA_RIGHT_TO_LEFT_BIT    ( 1 << 4 )
+#define TGA_TOP_TO_BOTTOM_BIT    ( 1 << 5 )
+
+///
+//  Types
+//
+typedef struct
+{
+   int             type;
+   int             width;
+   int             height;
+   int             descriptor;
+
+   // Bytes per pixel in the file and in the decoded image
+   int             srcBytes;
+   int             components;
+
+   // Color map as stored in the file, and expanded to the decoded format
+   int             paletteStart;
+   int             paletteSize;
+   int             paletteDepth;
+   GLubyte        *palette;
+
+   // Pixel data that follows the header, ID field and color map
+   const GLubyte  *data;
+   const GLubyte  *dataEnd;
+
+   // Decoded image and the position of the next pixel in file order
+   GLubyte        *pixels;
+   int             x;
+   int             y;
+} TGAImage;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// ReadShort()
+//
+static int ReadShort ( const GLubyte *p )
+{
+   return p[0] | ( p[1] << 8 );
+}
+
+///
+// SwizzleBGR()
+//
+//    Convert count 24-bit BGR pixels to RGB
+//
+static void SwizzleBGR ( GLubyte *dst, const GLubyte *src, int count )
+{
+   int n = count * 3;
+   int i = 0;
+
+#ifdef ES_TGA_SSE
+   // Byte p of the output comes from byte p + 2, p or p - 2 of the input
+   // depending on p % 3.  48 bytes hold whole pixels, so three masks cover
+   // every phase.  The first pixel is done below so src - 2 stays in range.
+   if ( n >= 3 + 48 + 2 )
+   {
+      __m128i fromNext[3];
+      __m128i fromSame[3];
+      __m128i fromPrev[3];
+      GLubyte mask[3][48];
+      int     v;
+
+      for ( i = 0; i < 48; i++ )
+      {
+         mask[0][i] = i % 3 == 0 ? 0xFF : 0;
+         mask[1][i] = i % 3 == 1 ? 0xFF : 0;
+         mask[2][i] = i % 3 == 2 ? 0xFF : 0;
+      }
+
+      for ( v = 0; v < 3; v++ )
+      {
+         fromNext[v] = _mm_loadu_si128 ( ( const __m128i * ) &mask[0][16 * v] );
+         fromSame[v] = _mm_loadu_si128 ( ( const __m128i * ) &mask[1][16 * v] );
+         fromPrev[v] = _mm_loadu_si128 ( ( const __m128i * ) &mask[2][16 * v] );
+      }
+
+      dst[0] = src[2];
+      dst[1] = src[1];
+      dst[2] = src[0];
+
+      for ( i = 3; i + 48 + 2 <= n; i += 48 )
+      {
+         for ( v = 0; v < 3; v++ )
+         {
+            const GLubyte *s = &src[i + 16 * v];
+            __m128i        next = _mm_and_si128 ( _mm_loadu_si128 ( ( const __m128i * ) ( s + 2 ) ), fromNext[v] );
+            __m128i        same = _mm_and_si128 ( _mm_loadu_si128 ( ( const __m128i * ) s ), fromSame[v] );
+            __m128i        prev = _mm_and_si128 ( _mm_loadu_si128 ( ( const __m128i * ) ( s - 2 ) ), fromPrev[v] );
+
+            _mm_storeu_si128 ( ( __m128i * ) &dst[i + 16 * v], _mm_or_si128 ( _mm_or_si128 ( next, same ), prev ) );
+         }
+      }
+   }
+#endif
+
+   for ( ; i < n; i += 3 )
+   {
+      GLubyte b = src[i];
+
+      dst[i] = src[i + 2];
+      dst[i + 1] = src[i + 1];
+      dst[i + 2] = b;
+   }
+}
+
+///
+// SwizzleBGRA()
+//
+//    Convert count 32-bit BGRA pixels to RGBA
+//
+static void SwizzleBGRA ( GLubyte *dst, const GLubyte *src, int count )
+{
+   int i = 0;
+
+#ifdef ES_TGA_SSE
+   __m128i maskGA = _mm_set1_epi32 ( ( int ) 0xFF00FF00 );
+   __m128i maskRB = _mm_set1_epi32 ( 0x00FF00FF );
+
+   for ( ; i + 4 <= count; i += 4 )
+   {
+      __m128i x = _mm_loadu_si128 ( ( const __m128i * ) &src[4 * i] );
+      __m128i rb = _mm_and_si128 ( x, maskRB );
+
+      // Swap bytes 0 and 2 of every pixel
+      rb = _mm_or_si128 ( _mm_slli_epi32 ( rb, 16 ), _mm_srli_epi32 ( rb, 16 ) );
+      _mm_storeu_si128 ( ( __m128i * ) &dst[4 * i], _mm_or_si128 ( _mm_and_si128 ( x, maskGA ), rb ) );
+   }
+#endif
+
+   for ( ; i < count; i++ )
+   {
+      GLubyte b = src[4 * i];
+
+      dst[4 * i] = src[4 * i + 2];
+      dst[4 * i + 1] = src[4 * i + 1];
+      dst[4 * i + 2] = b;
+      dst[4 * i + 3] = src[4 * i + 3];
+   }
+}
+
+///
+// Expand555()
+//
+//    Convert count 16-bit ARRRRRGGGGGBBBBB pixels to 24-bit RGB
+//
+static void Expand555 ( GLubyte *dst, const GLubyte *src, int count )
+{
+   int i;
+
+   for ( i = 0; i < count; i++ )
+   {
+      int pixel = ReadShort ( &src[2 * i] );
+      int r = ( pixel >> 10 ) & 31;
+      int g = ( pixel >> 5 ) & 31;
+      int b = pixel & 31;
+
+      dst[3 * i] = ( GLubyte ) ( ( r << 3 ) | ( r >> 2 ) );
+      dst[3 * i + 1] = ( GLubyte ) ( ( g << 3 ) | ( g >> 2 ) );
+      dst[3 * i + 2] = ( GLubyte ) ( ( b << 3 ) | ( b >> 2 ) );
+   }
+}
+
+///
+// ConvertColors()
+//
+//    Convert count pixels stored with srcBytes bytes each to the decoded
+//    format: 1 byte stays luminance, 2 and 3 bytes become RGB, 4 RGBA
+//
+static void ConvertColors ( GLubyte *dst, const GLubyte *src, int count, int srcBytes )
+{
+   switch ( srcBytes )
+   {
+      case 1:
+         memcpy ( dst, src, count );
+         break;
+
+      case 2:
+         Expand555 ( dst, src, count );
+         break;
+
+      case 3:
+         SwizzleBGR ( dst, src, count );
+         break;
+
+      default:
+         SwizzleBGRA ( dst, src, count );
+         break;
+   }
+}
+
+///
+// ConvertPixels()
+//
+//    Convert count pixels of the file, looking them up in the color map
+//    for color-mapped images
+//
+static void ConvertPixels ( const TGAImage *image, GLubyte *dst, const GLubyte *src, int count )
+{
+   int components = image->components;
+   int i;
+
+   if ( image->palette == NULL )
+   {
+      ConvertColors ( dst, src, count, image->srcBytes );
+   }
+   else if ( image->srcBytes == 1 )
+   {
+      for ( i = 0; i < count; i++ )
+      {
+         memcpy ( &dst[i * components], &image->palette[src[i] * components], components );
+      }
+   }
+   else
+   {
+      for ( i = 0; i < count; i++ )
+      {
+         memcpy ( &dst[i * components], &image->palette[ReadShort ( &src[2 * i] ) * components], components );
+      }
+   }
+}
+
+///
+// NextRun()
+//
+//    Return where the next pixel in file order goes and how many pixels
+//    fit before the end of its row, at most count
+//
+static GLubyte *NextRun ( TGAImage *image, int *count )
+{
+   int row = image->descriptor & TGA_TOP_TO_BOTTOM_BIT ? image->height - 1 - image->y : image->y;
+
+   if ( *count > image->width - image->x )
+   {
+      *count = image->width - image->x;
+   }
+
+   return &image->pixels[( row * image->width + image->x ) * image->components];
+}
+
+///
+// Advance()
+//
+static void Advance ( TGAImage *image, int count )
+{
+   image->x += count;
+
+   if ( image->x == image->width )
+   {
+      image->x = 0;
+      image->y++;
+   }
+}
+
+///
+// WriteRaw()
+//
+//    Convert count pixels of the file into the image
+//
+static void WriteRaw ( TGAImage *image, const GLubyte *src, int count )
+{
+   while ( count > 0 )
+   {
+      int      run = count;
+      GLubyte *dst = NextRun ( image, &run );
+
+      ConvertPixels ( image, dst, src, run );
+      Advance ( image, run );
+      src += run * image->srcBytes;
+      count -= run;
+   }
+}
+
+///
+// WriteRepeat()
+//
+//    Write one pixel of the file count times into the image
+//
+static void WriteRepeat ( TGAImage *image, const GLubyte *src, int count )
+{
+   GLubyte pattern[16];
+   int     components = image->components;
+   int     i;
+
+   // Four copies of the pixel, written with one store of up to 16 bytes
+   ConvertPixels ( image, pattern, src, 1 );
+
+   for ( i = 1; i < 4; i++ )
+   {
+      memcpy ( &pattern[i * components], pattern, components );
+   }
+
+   while ( count > 0 )
+   {
+      int      run = count;
+      GLubyte *dst = NextRun ( image, &run );
+
+      // Constant sizes let the copies compile to plain stores
+      if ( components == 3 )
+      {
+         for ( i = 0; i + 4 <= run; i += 4 )
+         {
+            memcpy ( &dst[i * 3], pattern, 12 );
+         }
+      }
+      else
+      {
+         for ( i = 0; i + 4 <= run; i += 4 )
+         {
+            memcpy ( &dst[i * components], pattern, components == 4 ? 16 : 4 );
+         }
+      }
+
+      memcpy ( &dst[i * components], pattern, ( run - i ) * components );
+      Advance ( image, run );
+      count -= run;
+   }
+}
+
+///
+// DecodeRLE()
+//
+//    Decode run-length packets until the image is full.  Packets may cross
+//    row boundaries.
+//
+static GLboolean DecodeRLE ( TGAImage *image )
+{
+   const GLubyte *src = image->data;
+   int            remaining = image->width * image->height;
+
+   while ( remaining > 0 )
+   {
+      int count;
+
+      if ( src == image->dataEnd )
+      {
+         return GL_FALSE;
+      }
+
+      count = ( *src & 127 ) + 1;
+      count = count < remaining ? count : remaining;
+
+      if ( *src++ & 128 )
+      {
+         if ( image->dataEnd - src < image->srcBytes )
+         {
+            return GL_FALSE;
+         }
+
+         WriteRepeat ( image, src, count );
+         src += image->srcBytes;
+      }
+      else
+      {
+         if ( ( image->dataEnd - src ) / image->srcBytes < count )
+         {
+            return GL_FALSE;
+         }
+
+         WriteRaw ( image, src, count );
+         src += count * image->srcBytes;
+      }
+
+      remaining -= count;
+   }
+
+   return GL_TRUE;
+}
+
+///
+// MirrorRows()
+//
+//    Reverse the pixels of every row, for images stored right to left
+//
+static void MirrorRows ( TGAImage *image )
+{
+   int components = image->components;
+   int x;
+   int y;
+   int k;
+
+   for ( y = 0; y < image->height; y++ )
+   {
+      GLubyte *row = &image->pixels[y * image->width * components];
+
+      for ( x = 0; x < image->width / 2; x++ )
+      {
+         GLubyte *left = &row[x * components];
+         GLubyte *right = &row[( image->width - 1 - x ) * components];
+
+         for ( k = 0; k < components; k++ )
+         {
+            GLubyte t = left[k];
+
+            left[k] = right[k];
+            right[k] = t;
+         }
+      }
+   }
+}
+
+///
+// DecodedComponents()
+//
+//    Components of the decoded image for a pixel depth in bits, 0 if the
+//    depth is not supported
+//
+static int DecodedComponents ( int depth )
+{
+   switch ( depth )
+   {
+      case 8:
+         return 1;
+
+      case 15:
+      case 16:
+      case 24:
+         return 3;
+
+      case 32:
+         return 4;
+   }
+
+   return 0;
+}
+
+///
+// ReadHeader()
+//
+//    Parse and validate the header and locate the pixel data
+//
+static GLboolean ReadHeader ( const GLubyte *header, int size, TGAImage *image )
+{
+   int mapType;
+   int paletteBytes = 0;
+   int depth;
+
+   if ( size < TGA_HEADER_SIZE )
+   {
+      esLogMessage ( "esDecodeTGA: file is too short\n" );
+      return GL_FALSE;
+   }
+
+   memset ( image, 0, sizeof ( TGAImage ) );
+   mapType = header[1];
+   image->type = header[2];
+   image->paletteStart = ReadShort ( &header[3] );
+   image->paletteSize = ReadShort ( &header[5] );
+   image->paletteDepth = header[7];
+   image->width = ReadShort ( &header[12] );
+   image->height = ReadShort ( &header[14] );
+   depth = header[16];
+   image->descriptor = header[17];
+
+   switch ( image->type & ~TGA_RLE_BIT )
+   {
+      case TGA_COLOR_MAPPED:
+         if ( mapType != 1 || ( depth != 8 && depth != 16 ) )
+         {
+            esLogMessage ( "esDecodeTGA: unsupported color map\n" );
+            return GL_FALSE;
+         }
+
+         image->components = DecodedComponents ( image->paletteDepth );
+         break;
+
+      case TGA_TRUE_COLOR:
+         image->components = depth == 8 ? 0 : DecodedComponents ( depth );
+         break;
+
+      case TGA_GRAYSCALE:
+         image->components = depth == 8 ? 1 : 0;
+         break;
+
+      default:
+         esLogMessage ( "esDecodeTGA: unsupported image type %d\n", image->type );
+         return GL_FALSE;
+   }
+
+   if ( image->components == 0 || image->width == 0 || image->height == 0 )
+   {
+      esLogMessage ( "esDecodeTGA: unsupported %d-bit image of %d x %d pixels\n", depth, image->width, image->height );
+      return GL_FALSE;
+   }
+
+   // Pixel counts and offsets into the decoded image must fit in an int
+   if ( image->width * ( double ) image->height * image->components > 0x7FFFFFFF )
+   {
+      esLogMessage ( "esDecodeTGA: image of %d x %d pixels is too large\n", image->width, image->height );
+      return GL_FALSE;
+   }
+
+   image->srcBytes = ( depth + 7 ) / 8;
+
+   // A color map may be present even if the image does not use it
+   if ( mapType == 1 )
+   {
+      paletteBytes = image->paletteSize * ( ( image->paletteDepth + 7 ) / 8 );
+   }
+
+   image->data = header + TGA_HEADER_SIZE + header[0] + paletteBytes;
+   image->dataEnd = header + size;
+
+   if ( image->data > image->dataEnd )
+   {
+      esLogMessage ( "esDecodeTGA: file is too short\n" );
+      return GL_FALSE;
+   }
+
+   return GL_TRUE;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esDecodeTGA()
+//
+GLboolean ESUTIL_API esDecodeTGA ( const void *data, int size, int *width, int *height, int *components, void *pixels )
+{
+   TGAImage  image;
+   GLboolean result;
+
+   if ( !ReadHeader ( data, size, &image ) )
+   {
+      return GL_FALSE;
+   }
+
+   *width = image.width;
+   *height = image.height;
+
+   if ( components != NULL )
+   {
+      *components = image.components;
+   }
+
+   if ( pixels == NULL )
+   {
+      return GL_TRUE;
+   }
+
+   image.pixels = pixels;
+
+   if ( ( image.type & ~TGA_RLE_BIT ) == TGA_COLOR_MAPPED )
+   {
+      int entryBytes = ( image.paletteDepth + 7 ) / 8;
+      int depth = image.srcBytes * 8;
+
+      if ( image.paletteStart + image.paletteSize > 1 << depth )
+      {
+         esLogMessage ( "esDecodeTGA: color map is larger than the index range\n" );
+         return GL_FALSE;
+      }
+
+      // Indices outside the color map read as black
+      image.palette = calloc ( ( size_t ) 1 << depth, image.components );
+
+      if ( image.palette == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      ConvertColors ( &image.palette[image.paletteStart * image.components],
+                      image.data - image.paletteSize * entryBytes, image.paletteSize, entryBytes );
+   }
+
+   if ( image.type & TGA_RLE_BIT )
+   {
+      result = DecodeRLE ( &image );
+   }
+   else
+   {
+      result = ( image.dataEnd - image.data ) / image.srcBytes >= image.width * image.height;
+
+      if ( result )
+      {
+         WriteRaw ( &image, image.data, image.width * image.height );
+      }
+   }
+
+   if ( !result )
+   {
+      esLogMessage ( "esDecodeTGA: pixel data is truncated\n" );
+   }
+   else if ( image.descriptor & TGA_RIGHT_TO_LEFT_BIT )
+   {
+      MirrorRows ( &image );
+   }
+
+   free ( image.palette );
+
+   return result;
+}
+
+///
+// esGetTGAPixelData()
+//
+const void *ESUTIL_API esGetTGAPixelData ( const void *data, int size )
+{
+   TGAImage image;
+
+   // Only uncompressed grayscale images stored bottom to top, left to
+   // right, are laid out the way esDecodeTGA returns them
+   if ( !ReadHeader ( data, size, &image ) || image.type != TGA_GRAYSCALE ||
+         ( image.descriptor & ( TGA_TOP_TO_BOTTOM_BIT | TGA_RIGHT_TO_LEFT_BIT ) ) != 0 ||
+         image.dataEnd - image.data < image.width * image.height )
+   {
+      return NULL;
+   }
+
+   return image.data;
+}
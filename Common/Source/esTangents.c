@@ -0,0 +1,452 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESTangents.c
+//
+//    Per-vertex tangent generation for normal mapping.  Each triangle's
+//    texture space axes are computed first, then every vertex averages the
+//    axes of the triangles around it weighted by the corner angle, as
+//    MikkTSpace does.  Both passes are independent per triangle or per
+//    vertex, so they are split across threads with esParallelFor, and the
+//    triangle pass handles four triangles at a time with SSE when present.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define ES_TANGENTS_SSE
+#endif
+
+///
+// Defines
+//
+#define ES_PI              (3.14159265f)
+
+// Triangles or vertices per thread below which splitting does not pay off
+#define TANGENT_MIN_RANGE  16384
+
+///
+// Types
+//
+typedef struct
+{
+   const GLfloat *positions;
+   const GLfloat *normals;
+   const GLfloat *texCoords;
+   const GLuint  *indices;
+   int            numFaces;
+
+   // Per-triangle texture space axes scaled by the sign of the uv area,
+   // and the angle at each corner, stored as separate arrays
+   GLfloat       *face[9];
+
+   // Triangle corners around each vertex: cornerStart[v] .. cornerStart[v + 1]
+   // index into corners, which holds 3 * triangle + corner
+   int           *cornerStart;
+   int           *corners;
+
+   GLfloat       *tangents;
+} TangentJob;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// AcosApprox()
+//
+//    Abramowitz and Stegun 4.4.45, error below 7e-5 radians, which is
+//    plenty for a weight.  The SSE path evaluates the same polynomial.
+//
+static float AcosApprox ( float x )
+{
+   float a = fabsf ( x ) > 1.0f ? 1.0f : fabsf ( x );
+   float r = sqrtf ( 1.0f - a ) * ( 1.5707288f + a * ( -0.2121144f + a * ( 0.0742610f - 0.0187293f * a ) ) );
+
+   return x < 0.0f ? ES_PI - r : r;
+}
+
+///
+// TangentFaceScalar()
+//
+static void TangentFaceScalar ( TangentJob *job, int f )
+{
+   const GLuint  *tri = &job->indices[3 * f];
+   const GLfloat *p0 = &job->positions[3 * tri[0]];
+   const GLfloat *p1 = &job->positions[3 * tri[1]];
+   const GLfloat *p2 = &job->positions[3 * tri[2]];
+   const GLfloat *t0 = &job->texCoords[2 * tri[0]];
+   const GLfloat *t1 = &job->texCoords[2 * tri[1]];
+   const GLfloat *t2 = &job->texCoords[2 * tri[2]];
+   float e1[3], e2[3], e3[3];
+   float du1 = t1[0] - t0[0];
+   float dv1 = t1[1] - t0[1];
+   float du2 = t2[0] - t0[0];
+   float dv2 = t2[1] - t0[1];
+   float det = du1 * dv2 - du2 * dv1;
+   float sign = det > 0.0f ? 1.0f : det < 0.0f ? -1.0f : 0.0f;
+   float l1, l2, l3;
+   int   i;
+
+   for ( i = 0; i < 3; i++ )
+   {
+      e1[i] = p1[i] - p0[i];
+      e2[i] = p2[i] - p0[i];
+      e3[i] = p2[i] - p1[i];
+   }
+
+   for ( i = 0; i < 3; i++ )
+   {
+      job->face[i][f] = sign * ( e1[i] * dv2 - e2[i] * dv1 );
+      job->face[3 + i][f] = sign * ( e2[i] * du1 - e1[i] * du2 );
+   }
+
+   l1 = sqrtf ( e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2] );
+   l2 = sqrtf ( e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2] );
+   l3 = sqrtf ( e3[0] * e3[0] + e3[1] * e3[1] + e3[2] * e3[2] );
+   l1 = l1 > 1e-20f ? 1.0f / l1 : 0.0f;
+   l2 = l2 > 1e-20f ? 1.0f / l2 : 0.0f;
+   l3 = l3 > 1e-20f ? 1.0f / l3 : 0.0f;
+
+   job->face[6][f] = AcosApprox ( ( e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2] ) * l1 * l2 );
+   job->face[7][f] = AcosApprox ( -( e1[0] * e3[0] + e1[1] * e3[1] + e1[2] * e3[2] ) * l1 * l3 );
+   job->face[8][f] = AcosApprox ( ( e2[0] * e3[0] + e2[1] * e3[1] + e2[2] * e3[2] ) * l2 * l3 );
+}
+
+#ifdef ES_TANGENTS_SSE
+
+static __m128 AcosApprox4 ( __m128 x )
+{
+   __m128 signMask = _mm_set1_ps ( -0.0f );
+   __m128 a = _mm_min_ps ( _mm_andnot_ps ( signMask, x ), _mm_set1_ps ( 1.0f ) );
+   __m128 poly = _mm_add_ps ( _mm_set1_ps ( 0.0742610f ), _mm_mul_ps ( _mm_set1_ps ( -0.0187293f ), a ) );
+   __m128 r;
+
+   poly = _mm_add_ps ( _mm_set1_ps ( -0.2121144f ), _mm_mul_ps ( a, poly ) );
+   poly = _mm_add_ps ( _mm_set1_ps ( 1.5707288f ), _mm_mul_ps ( a, poly ) );
+   r = _mm_mul_ps ( _mm_sqrt_ps ( _mm_sub_ps ( _mm_set1_ps ( 1.0f ), a ) ), poly );
+
+   // pi - r where x is negative
+   return _mm_or_ps ( _mm_andnot_ps ( _mm_cmplt_ps ( x, _mm_setzero_ps () ), r ),
+                      _mm_and_ps ( _mm_cmplt_ps ( x, _mm_setzero_ps () ), _mm_sub_ps ( _mm_set1_ps ( ES_PI ), r ) ) );
+}
+
+static __m128 Dot4 ( const __m128 *a, const __m128 *b )
+{
+   return _mm_add_ps ( _mm_add_ps ( _mm_mul_ps ( a[0], b[0] ), _mm_mul_ps ( a[1], b[1] ) ), _mm_mul_ps ( a[2], b[2] ) );
+}
+
+static __m128 InverseLength4 ( const __m128 *a )
+{
+   __m128 length = _mm_sqrt_ps ( Dot4 ( a, a ) );
+   __m128 valid = _mm_cmpgt_ps ( length, _mm_set1_ps ( 1e-20f ) );
+
+   return _mm_and_ps ( valid, _mm_div_ps ( _mm_set1_ps ( 1.0f ), _mm_max_ps ( length, _mm_set1_ps ( 1e-20f ) ) ) );
+}
+
+///
+// TangentFace4()
+//
+//    TangentFaceScalar() for triangles f .. f + 3, one per SSE lane.  The
+//    vertex data is gathered into structure-of-arrays form and the results
+//    are stored straight into the per-triangle arrays.
+//
+static void TangentFace4 ( TangentJob *job, int f )
+{
+   const GLuint *tri = &job->indices[3 * f];
+   __m128 p0[3], p1[3], p2[3], e1[3], e2[3], e3[3];
+   __m128 t0[2], t1[2], t2[2];
+   __m128 du1, dv1, du2, dv2, det, sign, l1, l2, l3;
+   int    i;
+
+   for ( i = 0; i < 3; i++ )
+   {
+      p0[i] = _mm_setr_ps ( job->positions[3 * tri[0] + i], job->positions[3 * tri[3] + i],
+                            job->positions[3 * tri[6] + i], job->positions[3 * tri[9] + i] );
+      p1[i] = _mm_setr_ps ( job->positions[3 * tri[1] + i], job->positions[3 * tri[4] + i],
+                            job->positions[3 * tri[7] + i], job->positions[3 * tri[10] + i] );
+      p2[i] = _mm_setr_ps ( job->positions[3 * tri[2] + i], job->positions[3 * tri[5] + i],
+                            job->positions[3 * tri[8] + i], job->positions[3 * tri[11] + i] );
+      e1[i] = _mm_sub_ps ( p1[i], p0[i] );
+      e2[i] = _mm_sub_ps ( p2[i], p0[i] );
+      e3[i] = _mm_sub_ps ( p2[i], p1[i] );
+   }
+
+   for ( i = 0; i < 2; i++ )
+   {
+      t0[i] = _mm_setr_ps ( job->texCoords[2 * tri[0] + i], job->texCoords[2 * tri[3] + i],
+                            job->texCoords[2 * tri[6] + i], job->texCoords[2 * tri[9] + i] );
+      t1[i] = _mm_setr_ps ( job->texCoords[2 * tri[1] + i], job->texCoords[2 * tri[4] + i],
+                            job->texCoords[2 * tri[7] + i], job->texCoords[2 * tri[10] + i] );
+      t2[i] = _mm_setr_ps ( job->texCoords[2 * tri[2] + i], job->texCoords[2 * tri[5] + i],
+                            job->texCoords[2 * tri[8] + i], job->texCoords[2 * tri[11] + i] );
+   }
+
+   du1 = _mm_sub_ps ( t1[0], t0[0] );
+   dv1 = _mm_sub_ps ( t1[1], t0[1] );
+   du2 = _mm_sub_ps ( t2[0], t0[0] );
+   dv2 = _mm_sub_ps ( t2[1], t0[1] );
+   det = _mm_sub_ps ( _mm_mul_ps ( du1, dv2 ), _mm_mul_ps ( du2, dv1 ) );
+   sign = _mm_or_ps ( _mm_and_ps ( _mm_cmpgt_ps ( det, _mm_setzero_ps () ), _mm_set1_ps ( 1.0f ) ),
+                      _mm_and_ps ( _mm_cmplt_ps ( det, _mm_setzero_ps () ), _mm_set1_ps ( -1.0f ) ) );
+
+   for ( i = 0; i < 3; i++ )
+   {
+      _mm_storeu_ps ( &job->face[i][f],
+                      _mm_mul_ps ( sign, _mm_sub_ps ( _mm_mul_ps ( e1[i], dv2 ), _mm_mul_ps ( e2[i], dv1 ) ) ) );
+      _mm_storeu_ps ( &job->face[3 + i][f],
+                      _mm_mul_ps ( sign, _mm_sub_ps ( _mm_mul_ps ( e2[i], du1 ), _mm_mul_ps ( e1[i], du2 ) ) ) );
+   }
+
+   l1 = InverseLength4 ( e1 );
+   l2 = InverseLength4 ( e2 );
+   l3 = InverseLength4 ( e3 );
+
+   _mm_storeu_ps ( &job->face[6][f], AcosApprox4 ( _mm_mul_ps ( Dot4 ( e1, e2 ), _mm_mul_ps ( l1, l2 ) ) ) );
+   _mm_storeu_ps ( &job->face[7][f], AcosApprox4 ( _mm_sub_ps ( _mm_setzero_ps (),
+                   _mm_mul_ps ( Dot4 ( e1, e3 ), _mm_mul_ps ( l1, l3 ) ) ) ) );
+   _mm_storeu_ps ( &job->face[8][f], AcosApprox4 ( _mm_mul_ps ( Dot4 ( e2, e3 ), _mm_mul_ps ( l2, l3 ) ) ) );
+}
+
+#endif // ES_TANGENTS_SSE
+
+///
+// TangentFaces()
+//
+//    esParallelFor callback for the per-triangle pass
+//
+static void ESCALLBACK TangentFaces ( void *userData, int begin, int end )
+{
+   TangentJob *job = userData;
+   int         f = begin;
+
+#ifdef ES_TANGENTS_SSE
+
+   for ( ; f + 4 <= end; f += 4 )
+   {
+      TangentFace4 ( job, f );
+   }
+
+#endif
+
+   for ( ; f < end; f++ )
+   {
+      TangentFaceScalar ( job, f );
+   }
+}
+
+///
+// TangentVertices()
+//
+//    esParallelFor callback for the per-vertex pass.  Each corner's axes
+//    are projected onto the plane of the vertex normal, normalized and
+//    weighted by the corner angle before they are summed.
+//
+static void ESCALLBACK TangentVertices ( void *userData, int begin, int end )
+{
+   TangentJob *job = userData;
+   int         v;
+
+   for ( v = begin; v < end; v++ )
+   {
+      const GLfloat *n = &job->normals[3 * v];
+      GLfloat       *out = &job->tangents[4 * v];
+      float          sumT[3] = { 0.0f, 0.0f, 0.0f };
+      float          sumB[3] = { 0.0f, 0.0f, 0.0f };
+      float          cross[3];
+      float          d;
+      float          length;
+      int            c;
+      int            i;
+
+      for ( c = job->cornerStart[v]; c < job->cornerStart[v + 1]; c++ )
+      {
+         int   f = job->corners[c] / 3;
+         float angle = job->face[6 + job->corners[c] % 3][f];
+         float t[3], b[3];
+         float dt = 0.0f, db = 0.0f, lt = 0.0f, lb = 0.0f;
+
+         for ( i = 0; i < 3; i++ )
+         {
+            dt += n[i] * job->face[i][f];
+            db += n[i] * job->face[3 + i][f];
+         }
+
+         for ( i = 0; i < 3; i++ )
+         {
+            t[i] = job->face[i][f] - n[i] * dt;
+            b[i] = job->face[3 + i][f] - n[i] * db;
+            lt += t[i] * t[i];
+            lb += b[i] * b[i];
+         }
+
+         lt = lt > 1e-30f ? angle / sqrtf ( lt ) : 0.0f;
+         lb = lb > 1e-30f ? angle / sqrtf ( lb ) : 0.0f;
+
+         for ( i = 0; i < 3; i++ )
+         {
+            sumT[i] += t[i] * lt;
+            sumB[i] += b[i] * lb;
+         }
+      }
+
+      // Orthogonalize the sum to the normal once more and normalize it
+      d = n[0] * sumT[0] + n[1] * sumT[1] + n[2] * sumT[2];
+
+      for ( i = 0; i < 3; i++ )
+      {
+         sumT[i] -= n[i] * d;
+      }
+
+      length = sqrtf ( sumT[0] * sumT[0] + sumT[1] * sumT[1] + sumT[2] * sumT[2] );
+
+      if ( length < 1e-20f )
+      {
+         // No usable texture mapping, pick any direction perpendicular to the normal
+         if ( fabsf ( n[0] ) < 0.9f )
+         {
+            sumT[0] = 1.0f - n[0] * n[0];
+            sumT[1] = -n[0] * n[1];
+            sumT[2] = -n[0] * n[2];
+         }
+         else
+         {
+            sumT[0] = -n[1] * n[0];
+            sumT[1] = 1.0f - n[1] * n[1];
+            sumT[2] = -n[1] * n[2];
+         }
+
+         length = sqrtf ( sumT[0] * sumT[0] + sumT[1] * sumT[1] + sumT[2] * sumT[2] );
+      }
+
+      out[0] = sumT[0] / length;
+      out[1] = sumT[1] / length;
+      out[2] = sumT[2] / length;
+
+      // Handedness of ( tangent, bitangent, normal )
+      cross[0] = n[1] * out[2] - n[2] * out[1];
+      cross[1] = n[2] * out[0] - n[0] * out[2];
+      cross[2] = n[0] * out[1] - n[1] * out[0];
+      out[3] = cross[0] * sumB[0] + cross[1] * sumB[1] + cross[2] * sumB[2] < 0.0f ? -1.0f : 1.0f;
+   }
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esGenTangents()
+//
+GLboolean ESUTIL_API esGenTangents ( int numVertices, const GLfloat *positions, const GLfloat *normals,
+                                     const GLfloat *texCoords, int numIndices, const GLuint *indices,
+                                     GLfloat *tangents )
+{
+   TangentJob job;
+   GLfloat   *faceData;
+   int        numCorners = numIndices - numIndices % 3;
+   int        i;
+
+   job.positions = positions;
+   job.normals = normals;
+   job.texCoords = texCoords;
+   job.indices = indices;
+   job.numFaces = numCorners / 3;
+   job.tangents = tangents;
+
+   // Nothing to do, and malloc ( 0 ) may return NULL
+   if ( job.numFaces == 0 )
+   {
+      return GL_TRUE;
+   }
+
+   faceData = malloc ( sizeof ( GLfloat ) * 9 * job.numFaces );
+   job.cornerStart = calloc ( numVertices + 1, sizeof ( int ) );
+   job.corners = malloc ( sizeof ( int ) * numCorners );
+
+   if ( faceData == NULL || job.cornerStart == NULL || job.corners == NULL )
+   {
+      free ( faceData );
+      free ( job.cornerStart );
+      free ( job.corners );
+      return GL_FALSE;
+   }
+
+   for ( i = 0; i < 9; i++ )
+   {
+      job.face[i] = &faceData[i * job.numFaces];
+   }
+
+   esParallelFor ( job.numFaces, TANGENT_MIN_RANGE, TangentFaces, &job );
+
+   // Bucket the corners by vertex with a counting sort
+   for ( i = 0; i < numCorners; i++ )
+   {
+      job.cornerStart[indices[i] + 1]++;
+   }
+
+   for ( i = 0; i < numVertices; i++ )
+   {
+      job.cornerStart[i + 1] += job.cornerStart[i];
+   }
+
+   for ( i = 0; i < numCorners; i++ )
+   {
+      job.corners[job.cornerStart[indices[i]]++] = i;
+   }
+
+   // The fill advanced each start to the next vertex's start; shift back
+   for ( i = numVertices; i > 0; i-- )
+   {
+      job.cornerStart[i] = job.cornerStart[i - 1];
+   }
+
+   job.cornerStart[0] = 0;
+
+   esParallelFor ( numVertices, TANGENT_MIN_RANGE, TangentVertices, &job );
+
+   free ( faceData );
+   free ( job.cornerStart );
+   free ( job.corners );
+
+   return GL_TRUE;
+}
@@ -0,0 +1,360 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESTexture.c
+//
+//    Creates immutable textures from 8-bit images in memory.  Storage is
+//    allocated with glTexStorage in the sized format matching the image, so
+//    that uploads are plain copies.  GPUs have no 24-bit texel format, and
+//    drivers expand RGB images to RGBA a texel at a time as they upload
+//    them; here three component images are stored as RGBA8 and expanded
+//    with SIMD on all cores, straight into the pixel unpack buffer the
+//    texture is uploaded from.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined ( __SSE2__ ) || defined ( _M_X64 ) || ( defined ( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define USE_SSE2
+#elif defined ( __ARM_NEON ) || defined ( __ARM_NEON__ )
+#include <arm_neon.h>
+#define USE_NEON
+#endif
+
+///
+// Macros
+//
+#define EXPAND_BLOCK    16384   // Texels expanded by each task of esParallelFor
+
+///
+//  Types
+//
+typedef struct
+{
+   const GLubyte *rgb;
+   GLubyte       *rgba;
+   size_t         count;
+} ExpandJob;
+
+///
+//  Tables
+//
+static const GLenum internalFormats[] = { GL_NONE, GL_R8, GL_RG8, GL_RGBA8, GL_RGBA8 };
+static const GLenum formats[] = { GL_NONE, GL_RED, GL_RG, GL_RGBA, GL_RGBA };
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// ExpandRGB()
+//
+//    Expand RGB texels to RGBA with an alpha of 255
+//
+static void ExpandRGB ( const GLubyte *rgb, GLubyte *rgba, size_t count )
+{
+   size_t i = 0;
+
+#if defined ( USE_SSE2 )
+   const __m128i alpha = _mm_set1_epi32 ( ( int ) 0xFF000000 );
+   const __m128i mask0 = _mm_setr_epi32 ( 0x00FFFFFF, 0, 0, 0 );
+   const __m128i mask1 = _mm_setr_epi32 ( 0, 0x00FFFFFF, 0, 0 );
+   const __m128i mask2 = _mm_setr_epi32 ( 0, 0, 0x00FFFFFF, 0 );
+   const __m128i mask3 = _mm_setr_epi32 ( 0, 0, 0, 0x00FFFFFF );
+
+   // Each load holds four texels and the first bytes of the next; texel k
+   // is moved from byte 3k to lane k by shifting the register k bytes up.
+   // The 16 byte load needs two more texels after the four it expands.
+   for ( ; i + 6 <= count; i += 4 )
+   {
+      __m128i src = _mm_loadu_si128 ( ( const __m128i * ) ( rgb + i * 3 ) );
+      __m128i dst = _mm_or_si128 ( _mm_and_si128 ( src, mask0 ), _mm_and_si128 ( _mm_slli_si128 ( src, 1 ), mask1 ) );
+
+      dst = _mm_or_si128 ( dst, _mm_and_si128 ( _mm_slli_si128 ( src, 2 ), mask2 ) );
+      dst = _mm_or_si128 ( dst, _mm_and_si128 ( _mm_slli_si128 ( src, 3 ), mask3 ) );
+      _mm_storeu_si128 ( ( __m128i * ) ( rgba + i * 4 ), _mm_or_si128 ( dst, alpha ) );
+   }
+#elif defined ( USE_NEON )
+   for ( ; i + 16 <= count; i += 16 )
+   {
+      uint8x16x3_t src = vld3q_u8 ( rgb + i * 3 );
+      uint8x16x4_t dst;
+
+      dst.val[0] = src.val[0];
+      dst.val[1] = src.val[1];
+      dst.val[2] = src.val[2];
+      dst.val[3] = vdupq_n_u8 ( 255 );
+      vst4q_u8 ( rgba + i * 4, dst );
+   }
+#endif
+
+   for ( ; i < count; i++ )
+   {
+      rgba[i * 4] = rgb[i * 3];
+      rgba[i * 4 + 1] = rgb[i * 3 + 1];
+      rgba[i * 4 + 2] = rgb[i * 3 + 2];
+      rgba[i * 4 + 3] = 255;
+   }
+}
+
+///
+// ExpandBlocks()
+//
+//    esParallelFor task expanding blocks [begin, end) of the texels
+//
+static void ESCALLBACK ExpandBlocks ( void *userData, int begin, int end )
+{
+   const ExpandJob *job = userData;
+   size_t first = ( size_t ) begin * EXPAND_BLOCK;
+   size_t last = ( size_t ) end * EXPAND_BLOCK;
+
+   if ( last > job->count )
+   {
+      last = job->count;
+   }
+
+   ExpandRGB ( job->rgb + first * 3, job->rgba + first * 4, last - first );
+}
+
+///
+// RowAlignment()
+//
+//    Largest unpack alignment both the rows and the start of the image
+//    are aligned to, so tightly packed images take the driver's fast path
+//
+static GLint RowAlignment ( const void *image, size_t rowSize )
+{
+   size_t bits = ( size_t ) image | rowSize;
+   GLint  alignment = 8;
+
+   while ( bits & ( alignment - 1 ) )
+   {
+      alignment >>= 1;
+   }
+
+   return alignment;
+}
+
+///
+// CreateTexture()
+//
+//    Allocate and fill a 2D, 3D or cube map texture.  Images are stored
+//    face after face, each face's levels one after the other.
+//
+static GLuint CreateTexture ( GLenum target, const void *pixels, int width, int height, int depth,
+                              int components, int numLevels )
+{
+   int       numFaces = target == GL_TEXTURE_CUBE_MAP ? 6 : 1;
+   int       maxSize = width > height ? width : height;
+   int       storedLevels = numLevels > 0 ? numLevels : 1;
+   int       totalLevels = 1;
+   size_t    count = 0;
+   GLuint    textureId;
+   GLuint    pixelBuffer = 0;
+   GLint     alignment, unpackBuffer;
+   const GLubyte *source = pixels;
+   size_t    offset = 0;
+   int       face, level;
+
+   if ( depth > maxSize )
+   {
+      maxSize = depth;
+   }
+
+   while ( maxSize >> totalLevels )
+   {
+      totalLevels++;
+   }
+
+   if ( width < 1 || height < 1 || depth < 1 || components < 1 || components > 4 ||
+         numLevels < 0 || numLevels > totalLevels )
+   {
+      return 0;
+   }
+
+   if ( numLevels > 0 )
+   {
+      totalLevels = numLevels;
+   }
+
+   for ( level = 0; level < storedLevels; level++ )
+   {
+      count += ( size_t ) ( width >> level > 1 ? width >> level : 1 ) *
+               ( height >> level > 1 ? height >> level : 1 ) *
+               ( depth >> level > 1 ? depth >> level : 1 );
+   }
+
+   count *= numFaces;
+
+   glGenTextures ( 1, &textureId );
+   glBindTexture ( target, textureId );
+
+   if ( target == GL_TEXTURE_3D )
+   {
+      glTexStorage3D ( target, totalLevels, internalFormats[components], width, height, depth );
+   }
+   else
+   {
+      glTexStorage2D ( target, totalLevels, internalFormats[components], width, height );
+   }
+
+   if ( pixels == NULL )
+   {
+      return textureId;
+   }
+
+   // The application's unpack buffer is put back once the pixels are sent
+   glGetIntegerv ( GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer );
+
+   if ( components == 3 )
+   {
+      // Expand into a pixel unpack buffer, which the texture is uploaded from
+      ExpandJob job;
+
+      glGenBuffers ( 1, &pixelBuffer );
+      glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, pixelBuffer );
+      glBufferData ( GL_PIXEL_UNPACK_BUFFER, count * 4, NULL, GL_STREAM_DRAW );
+
+      job.rgb = pixels;
+      job.rgba = glMapBufferRange ( GL_PIXEL_UNPACK_BUFFER, 0, count * 4, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+      job.count = count;
+
+      if ( job.rgba != NULL )
+      {
+         esParallelFor ( ( int ) ( ( count + EXPAND_BLOCK - 1 ) / EXPAND_BLOCK ), 4, ExpandBlocks, &job );
+      }
+
+      if ( job.rgba == NULL || !glUnmapBuffer ( GL_PIXEL_UNPACK_BUFFER ) )
+      {
+         glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, unpackBuffer );
+         glDeleteBuffers ( 1, &pixelBuffer );
+         glDeleteTextures ( 1, &textureId );
+         return 0;
+      }
+
+      // Upload from offsets into the buffer
+      source = NULL;
+      components = 4;
+   }
+   else
+   {
+      glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
+   }
+
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+
+   for ( face = 0; face < numFaces; face++ )
+   {
+      for ( level = 0; level < storedLevels; level++ )
+      {
+         int levelWidth = width >> level > 1 ? width >> level : 1;
+         int levelHeight = height >> level > 1 ? height >> level : 1;
+         int levelDepth = depth >> level > 1 ? depth >> level : 1;
+         const void *image = source != NULL ? ( const void * ) ( source + offset ) : ( const void * ) offset;
+
+         glPixelStorei ( GL_UNPACK_ALIGNMENT, RowAlignment ( image, ( size_t ) levelWidth * components ) );
+
+         if ( target == GL_TEXTURE_3D )
+         {
+            glTexSubImage3D ( target, level, 0, 0, 0, levelWidth, levelHeight, levelDepth,
+                              formats[components], GL_UNSIGNED_BYTE, image );
+            offset += ( size_t ) levelWidth * levelHeight * levelDepth * components;
+         }
+         else
+         {
+            glTexSubImage2D ( numFaces == 6 ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target, level, 0, 0,
+                              levelWidth, levelHeight, formats[components], GL_UNSIGNED_BYTE, image );
+            offset += ( size_t ) levelWidth * levelHeight * components;
+         }
+      }
+   }
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+   glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, unpackBuffer );
+
+   if ( pixelBuffer != 0 )
+   {
+      // The upload is queued and the buffer is released once it completes
+      glDeleteBuffers ( 1, &pixelBuffer );
+   }
+
+   if ( numLevels == 0 && totalLevels > 1 )
+   {
+      glGenerateMipmap ( target );
+   }
+
+   return textureId;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateTexture2D()
+//
+//    Create an immutable 2D texture from an 8-bit image and its levels
+//
+GLuint ESUTIL_API esCreateTexture2D ( const void *pixels, int width, int height, int components, int numLevels )
+{
+   return CreateTexture ( GL_TEXTURE_2D, pixels, width, height, 1, components, numLevels );
+}
+
+///
+// esCreateTexture3D()
+//
+//    Create an immutable 3D texture from an 8-bit volume and its levels
+//
+GLuint ESUTIL_API esCreateTexture3D ( const void *pixels, int width, int height, int depth, int components,
+                                      int numLevels )
+{
+   return CreateTexture ( GL_TEXTURE_3D, pixels, width, height, depth, components, numLevels );
+}
+
+///
+// esCreateTextureCube()
+//
+//    Create an immutable cube map from six 8-bit faces and their levels
+//
+GLuint ESUTIL_API esCreateTextureCube ( const void *pixels, int size, int components, int numLevels )
+{
+   return CreateTexture ( GL_TEXTURE_CUBE_MAP, pixels, size, size, 1, components, numLevels );
+}
@@ -0,0 +1,761 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESTextureStreamer.c
+//
+//    Loads 2D textures in the background.  Each texture starts out as a
+//    1x1 placeholder while worker threads read and decode its file.  Once
+//    per frame esUpdateTextureStreamer copies decoded pixels into a pixel
+//    unpack buffer, never more than the frame's byte budget, and
+//    respecifies the texture from the buffer once all of its pixels are
+//    there, so the name the application holds never changes.  KTX files
+//    need no decoding: the worker only brings the mapped file into memory
+//    and the upload happens in one step, into a new texture object created
+//    under the same name.  If that upload fails the placeholder is put back
+//    and the fallback file is loaded instead.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+///
+//  Macros
+//
+#define ES_STREAM_MAX_THREADS   8
+#define ES_STREAM_PAGE_SIZE     4096
+
+// Job states
+#define JOB_QUEUED              0
+#define JOB_DECODING            1
+#define JOB_DECODED             2
+#define JOB_FAILED              3
+
+///
+//  Types
+//
+typedef struct
+{
+   char          *fileName;
+   char          *fallbackFileName;
+   GLuint         texture;
+   GLboolean      mipmaps;
+   GLubyte        placeholder[4];
+   int            state;
+
+   // Set once fileName has failed, so only the fallback file is tried
+   GLboolean      fallback;
+
+   // Filled in by the worker: the mapped file for KTX, decoded pixels
+   // otherwise
+   GLboolean      isKTX;
+   ESFileMapping  file;
+   GLubyte       *pixels;
+   int            width;
+   int            height;
+   int            components;
+} StreamJob;
+
+struct ESTextureStreamer
+{
+   void          *ioContext;
+   GLsizeiptr     budget;
+
+   // Jobs in request order; workers take them from nextDecode on
+   StreamJob    **jobs;
+   int            numJobs;
+   int            maxJobs;
+   int            nextDecode;
+
+   // Job whose pixels are being copied into the unpack buffer
+   StreamJob     *current;
+   GLuint         unpackBuffer;
+   GLsizeiptr     copied;
+
+   int            numThreads;
+   GLboolean      quit;
+#ifdef _WIN32
+   HANDLE             threads[ES_STREAM_MAX_THREADS];
+   CRITICAL_SECTION   lock;
+   CONDITION_VARIABLE wake;
+#else
+   pthread_t          threads[ES_STREAM_MAX_THREADS];
+   pthread_mutex_t    lock;
+   pthread_cond_t     wake;
+#endif
+};
+
+///
+//  Tables
+//
+static const GLubyte defaultPlaceholder[4] = { 128, 128, 128, 255 };
+
+// Parameters the application may have set on the placeholder
+static const GLenum textureParams[] =
+{
+   GL_TEXTURE_MIN_FILTER,
+   GL_TEXTURE_MAG_FILTER,
+   GL_TEXTURE_WRAP_S,
+   GL_TEXTURE_WRAP_T,
+   GL_TEXTURE_SWIZZLE_R,
+   GL_TEXTURE_SWIZZLE_G,
+   GL_TEXTURE_SWIZZLE_B,
+   GL_TEXTURE_SWIZZLE_A,
+};
+
+#define NUM_TEXTURE_PARAMS    ( sizeof ( textureParams ) / sizeof ( textureParams[0] ) )
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// Lock()
+//
+static void Lock ( ESTextureStreamer *streamer )
+{
+#ifdef _WIN32
+   EnterCriticalSection ( &streamer->lock );
+#else
+   pthread_mutex_lock ( &streamer->lock );
+#endif
+}
+
+///
+// Unlock()
+//
+static void Unlock ( ESTextureStreamer *streamer )
+{
+#ifdef _WIN32
+   LeaveCriticalSection ( &streamer->lock );
+#else
+   pthread_mutex_unlock ( &streamer->lock );
+#endif
+}
+
+///
+// CopyString()
+//
+static char *CopyString ( const char *string )
+{
+   char *copy;
+
+   if ( string == NULL )
+   {
+      return NULL;
+   }
+
+   copy = malloc ( strlen ( string ) + 1 );
+
+   if ( copy != NULL )
+   {
+      strcpy ( copy, string );
+   }
+
+   return copy;
+}
+
+///
+// FreeJob()
+//
+static void FreeJob ( StreamJob *job )
+{
+   if ( job->isKTX )
+   {
+      esUnmapFile ( &job->file );
+   }
+
+   free ( job->pixels );
+   free ( job->fileName );
+   free ( job->fallbackFileName );
+   free ( job );
+}
+
+///
+// DecodeFile()
+//
+//    Runs on a worker.  A KTX file stays mapped until it is uploaded; every
+//    page is read once here so the upload does not wait for the disk.
+//
+static GLboolean DecodeFile ( ESTextureStreamer *streamer, StreamJob *job, const char *fileName )
+{
+   const GLubyte *data;
+   int            i;
+
+   if ( fileName == NULL || !esMapFile ( streamer->ioContext, fileName, &job->file ) )
+   {
+      return GL_FALSE;
+   }
+
+   data = job->file.data;
+
+   if ( job->file.size >= 12 && data[1] == 'K' && data[2] == 'T' && data[3] == 'X' )
+   {
+      volatile GLubyte touch = 0;
+
+      for ( i = 0; i < job->file.size; i += ES_STREAM_PAGE_SIZE )
+      {
+         touch += data[i];
+      }
+
+      job->isKTX = GL_TRUE;
+      return GL_TRUE;
+   }
+
+   if ( esDecodeTGA ( data, job->file.size, &job->width, &job->height, &job->components, NULL ) )
+   {
+      job->pixels = malloc ( ( size_t ) job->width * job->height * job->components );
+
+      if ( job->pixels != NULL &&
+           !esDecodeTGA ( data, job->file.size, &job->width, &job->height, &job->components, job->pixels ) )
+      {
+         free ( job->pixels );
+         job->pixels = NULL;
+      }
+   }
+
+   esUnmapFile ( &job->file );
+   return job->pixels != NULL;
+}
+
+///
+// Worker()
+//
+//    Decode queued jobs in request order until the streamer is deleted
+//
+#ifdef _WIN32
+static DWORD WINAPI Worker ( LPVOID param )
+#else
+static void *Worker ( void *param )
+#endif
+{
+   ESTextureStreamer *streamer = param;
+
+   Lock ( streamer );
+
+   while ( !streamer->quit )
+   {
+      if ( streamer->nextDecode < streamer->numJobs )
+      {
+         StreamJob *job = streamer->jobs[streamer->nextDecode++];
+         GLboolean  decoded;
+
+         job->state = JOB_DECODING;
+         Unlock ( streamer );
+
+         decoded = !job->fallback && DecodeFile ( streamer, job, job->fileName );
+
+         if ( !decoded )
+         {
+            job->fallback = GL_TRUE;
+            decoded = DecodeFile ( streamer, job, job->fallbackFileName );
+         }
+
+         Lock ( streamer );
+         job->state = decoded ? JOB_DECODED : JOB_FAILED;
+         continue;
+      }
+
+#ifdef _WIN32
+      SleepConditionVariableCS ( &streamer->wake, &streamer->lock, INFINITE );
+#else
+      pthread_cond_wait ( &streamer->wake, &streamer->lock );
+#endif
+   }
+
+   Unlock ( streamer );
+   return 0;
+}
+
+///
+// NextReadyJob()
+//
+//    First job in request order that a worker has finished with
+//
+static StreamJob *NextReadyJob ( ESTextureStreamer *streamer )
+{
+   StreamJob *job = NULL;
+   int        i;
+
+   Lock ( streamer );
+
+   for ( i = 0; i < streamer->nextDecode && job == NULL; i++ )
+   {
+      if ( streamer->jobs[i]->state == JOB_DECODED || streamer->jobs[i]->state == JOB_FAILED )
+      {
+         job = streamer->jobs[i];
+      }
+   }
+
+   Unlock ( streamer );
+   return job;
+}
+
+///
+// FinishJob()
+//
+//    Remove a job once its texture holds the file's contents, or the
+//    placeholder for good if the file could not be loaded
+//
+static void FinishJob ( ESTextureStreamer *streamer, StreamJob *job )
+{
+   int i;
+
+   if ( job->state == JOB_FAILED )
+   {
+      esLogMessage ( "esTextureStreamer FAILED to load : { %s }\n", job->fileName );
+   }
+
+   Lock ( streamer );
+
+   for ( i = 0; i < streamer->numJobs; i++ )
+   {
+      if ( streamer->jobs[i] == job )
+      {
+         memmove ( &streamer->jobs[i], &streamer->jobs[i + 1], ( streamer->numJobs - i - 1 ) * sizeof ( StreamJob * ) );
+         streamer->numJobs--;
+         streamer->nextDecode -= i < streamer->nextDecode;
+         break;
+      }
+   }
+
+   Unlock ( streamer );
+
+   if ( streamer->current == job )
+   {
+      streamer->current = NULL;
+   }
+
+   FreeJob ( job );
+}
+
+///
+// RetryFallback()
+//
+//    Queue a job again to load its fallback file
+//
+static void RetryFallback ( ESTextureStreamer *streamer, StreamJob *job )
+{
+   int i;
+
+   esUnmapFile ( &job->file );
+   job->isKTX = GL_FALSE;
+   job->fallback = GL_TRUE;
+   job->state = JOB_QUEUED;
+
+   Lock ( streamer );
+
+   // Move the job behind the ones not decoded yet
+   for ( i = 0; i < streamer->numJobs; i++ )
+   {
+      if ( streamer->jobs[i] == job )
+      {
+         memmove ( &streamer->jobs[i], &streamer->jobs[i + 1], ( streamer->numJobs - i - 1 ) * sizeof ( StreamJob * ) );
+         streamer->nextDecode -= i < streamer->nextDecode;
+         streamer->jobs[streamer->numJobs - 1] = job;
+         break;
+      }
+   }
+
+#ifdef _WIN32
+   WakeConditionVariable ( &streamer->wake );
+#else
+   pthread_cond_signal ( &streamer->wake );
+#endif
+   Unlock ( streamer );
+}
+
+///
+// UploadKTX()
+//
+//    Upload a KTX file into a new texture object created under the job's
+//    texture name, which drivers never confuse with the placeholder they
+//    may still be sampling.  The placeholder is put back if the upload
+//    fails.  Returns GL_TRUE on success.
+//
+static GLboolean UploadKTX ( StreamJob *job )
+{
+   GLint     values[NUM_TEXTURE_PARAMS];
+   GLboolean uploaded;
+   size_t    i;
+
+   glBindTexture ( GL_TEXTURE_2D, job->texture );
+
+   for ( i = 0; i < NUM_TEXTURE_PARAMS; i++ )
+   {
+      glGetTexParameteriv ( GL_TEXTURE_2D, textureParams[i], &values[i] );
+   }
+
+   // Binding the name of the deleted texture creates a new one
+   glDeleteTextures ( 1, &job->texture );
+   glBindTexture ( GL_TEXTURE_2D, job->texture );
+
+   uploaded = esUploadTextureKTX ( job->file.data, job->file.size, GL_TEXTURE_2D );
+
+   if ( !uploaded )
+   {
+      // The failed upload may have left immutable storage behind
+      glDeleteTextures ( 1, &job->texture );
+      glBindTexture ( GL_TEXTURE_2D, job->texture );
+      glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, job->placeholder );
+   }
+
+   for ( i = 0; i < NUM_TEXTURE_PARAMS; i++ )
+   {
+      glTexParameteri ( GL_TEXTURE_2D, textureParams[i], values[i] );
+   }
+
+   return uploaded;
+}
+
+///
+// CopyPixels()
+//
+//    Copy up to budget bytes of the current job's pixels into the unpack
+//    buffer, which was orphaned when the job started so the GPU is never
+//    still reading the range being written
+//
+static GLsizeiptr CopyPixels ( ESTextureStreamer *streamer, GLsizeiptr budget )
+{
+   StreamJob *job = streamer->current;
+   GLsizeiptr total = ( GLsizeiptr ) job->width * job->height * job->components;
+   GLsizeiptr count = total - streamer->copied < budget ? total - streamer->copied : budget;
+   void      *dst;
+
+   if ( streamer->copied == 0 )
+   {
+      glBufferData ( GL_PIXEL_UNPACK_BUFFER, total, NULL, GL_STREAM_DRAW );
+   }
+
+   dst = glMapBufferRange ( GL_PIXEL_UNPACK_BUFFER, streamer->copied, count,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT );
+
+   if ( dst != NULL )
+   {
+      memcpy ( dst, job->pixels + streamer->copied, count );
+      glUnmapBuffer ( GL_PIXEL_UNPACK_BUFFER );
+   }
+   else
+   {
+      glBufferSubData ( GL_PIXEL_UNPACK_BUFFER, streamer->copied, count, job->pixels + streamer->copied );
+   }
+
+   streamer->copied += count;
+   return count;
+}
+
+///
+// TexImageFromBuffer()
+//
+//    Respecify the current job's texture from the filled unpack buffer
+//
+static void TexImageFromBuffer ( ESTextureStreamer *streamer )
+{
+   static const GLenum internalFormats[5] = { GL_NONE, GL_R8, GL_NONE, GL_RGB8, GL_RGBA8 };
+   static const GLenum formats[5] = { GL_NONE, GL_RED, GL_NONE, GL_RGB, GL_RGBA };
+   StreamJob *job = streamer->current;
+   GLint      alignment;
+
+   glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, 1 );
+
+   glBindTexture ( GL_TEXTURE_2D, job->texture );
+   glTexImage2D ( GL_TEXTURE_2D, 0, internalFormats[job->components], job->width, job->height, 0,
+                  formats[job->components], GL_UNSIGNED_BYTE, NULL );
+
+   if ( job->mipmaps )
+   {
+      glGenerateMipmap ( GL_TEXTURE_2D );
+   }
+
+   glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateTextureStreamer()
+//
+ESTextureStreamer *ESUTIL_API esCreateTextureStreamer ( void *ioContext, GLsizeiptr budget )
+{
+   ESTextureStreamer *streamer = calloc ( 1, sizeof ( ESTextureStreamer ) );
+   int                numThreads = esGetNumCores () - 1;
+   int                i;
+
+   if ( streamer == NULL )
+   {
+      return NULL;
+   }
+
+   streamer->ioContext = ioContext;
+   streamer->budget = budget > 0 ? budget : 1;
+
+#ifdef _WIN32
+   InitializeCriticalSection ( &streamer->lock );
+   InitializeConditionVariable ( &streamer->wake );
+#else
+   pthread_mutex_init ( &streamer->lock, NULL );
+   pthread_cond_init ( &streamer->wake, NULL );
+#endif
+
+   // The calling thread keeps rendering, so it is not counted
+   numThreads = numThreads < 1 ? 1 : numThreads > ES_STREAM_MAX_THREADS ? ES_STREAM_MAX_THREADS : numThreads;
+
+   for ( i = 0; i < numThreads; i++ )
+   {
+#ifdef _WIN32
+      streamer->threads[i] = CreateThread ( NULL, 0, Worker, streamer, 0, NULL );
+
+      if ( streamer->threads[i] == NULL )
+      {
+         break;
+      }
+#else
+      if ( pthread_create ( &streamer->threads[i], NULL, Worker, streamer ) != 0 )
+      {
+         break;
+      }
+#endif
+      streamer->numThreads++;
+   }
+
+   if ( streamer->numThreads == 0 )
+   {
+      esLogMessage ( "esCreateTextureStreamer: could not start a worker thread\n" );
+      esDeleteTextureStreamer ( streamer );
+      return NULL;
+   }
+
+   glGenBuffers ( 1, &streamer->unpackBuffer );
+   return streamer;
+}
+
+///
+// esStreamTexture()
+//
+GLuint ESUTIL_API esStreamTexture ( ESTextureStreamer *streamer, const char *fileName, const char *fallbackFileName,
+                                    GLboolean mipmaps, const GLubyte placeholder[4] )
+{
+   StreamJob *job = calloc ( 1, sizeof ( StreamJob ) );
+
+   if ( job == NULL )
+   {
+      return 0;
+   }
+
+   job->fileName = CopyString ( fileName );
+   job->fallbackFileName = CopyString ( fallbackFileName );
+   job->mipmaps = mipmaps;
+   memcpy ( job->placeholder, placeholder != NULL ? placeholder : defaultPlaceholder, 4 );
+
+   if ( job->fileName == NULL || ( fallbackFileName != NULL && job->fallbackFileName == NULL ) )
+   {
+      FreeJob ( job );
+      return 0;
+   }
+
+   // A 1x1 level 0 is a complete mip chain, whatever the filters
+   glGenTextures ( 1, &job->texture );
+   glBindTexture ( GL_TEXTURE_2D, job->texture );
+   glTexImage2D ( GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, job->placeholder );
+
+   Lock ( streamer );
+
+   if ( streamer->numJobs == streamer->maxJobs )
+   {
+      int         maxJobs = streamer->maxJobs > 0 ? streamer->maxJobs * 2 : 16;
+      StreamJob **jobs = realloc ( streamer->jobs, maxJobs * sizeof ( StreamJob * ) );
+
+      if ( jobs == NULL )
+      {
+         Unlock ( streamer );
+         esLogMessage ( "esStreamTexture: out of memory, { %s } keeps its placeholder\n", fileName );
+         FreeJob ( job );
+         return 0;
+      }
+
+      streamer->jobs = jobs;
+      streamer->maxJobs = maxJobs;
+   }
+
+   streamer->jobs[streamer->numJobs++] = job;
+
+#ifdef _WIN32
+   WakeConditionVariable ( &streamer->wake );
+#else
+   pthread_cond_signal ( &streamer->wake );
+#endif
+   Unlock ( streamer );
+
+   return job->texture;
+}
+
+///
+// esUpdateTextureStreamer()
+//
+//    Jobs are uploaded in request order as they become ready.  A KTX file
+//    is uploaded whole, so one larger than the budget goes first in a frame.
+//
+int ESUTIL_API esUpdateTextureStreamer ( ESTextureStreamer *streamer )
+{
+   GLsizeiptr budget = streamer->budget;
+   GLint      texture;
+   GLint      unpackBuffer;
+   int        pending;
+
+   glGetIntegerv ( GL_TEXTURE_BINDING_2D, &texture );
+   glGetIntegerv ( GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer );
+
+   while ( budget > 0 )
+   {
+      StreamJob *job = streamer->current != NULL ? streamer->current : NextReadyJob ( streamer );
+
+      if ( job == NULL )
+      {
+         break;
+      }
+
+      if ( job->state == JOB_FAILED )
+      {
+         FinishJob ( streamer, job );
+      }
+      else if ( job->isKTX )
+      {
+         if ( job->file.size > budget && budget < streamer->budget )
+         {
+            break;
+         }
+
+         glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
+         budget -= job->file.size;
+
+         if ( UploadKTX ( job ) )
+         {
+            FinishJob ( streamer, job );
+         }
+         else if ( !job->fallback && job->fallbackFileName != NULL )
+         {
+            esLogMessage ( "esTextureStreamer FAILED to upload : { %s }, loading { %s }\n",
+                           job->fileName, job->fallbackFileName );
+            RetryFallback ( streamer, job );
+         }
+         else
+         {
+            job->state = JOB_FAILED;
+            FinishJob ( streamer, job );
+         }
+      }
+      else
+      {
+         streamer->current = job;
+         glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, streamer->unpackBuffer );
+         budget -= CopyPixels ( streamer, budget );
+
+         if ( streamer->copied == ( GLsizeiptr ) job->width * job->height * job->components )
+         {
+            TexImageFromBuffer ( streamer );
+            streamer->copied = 0;
+            FinishJob ( streamer, job );
+         }
+      }
+   }
+
+   glBindTexture ( GL_TEXTURE_2D, texture );
+   glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, unpackBuffer );
+
+   Lock ( streamer );
+   pending = streamer->numJobs;
+   Unlock ( streamer );
+
+   return pending;
+}
+
+///
+// esDeleteTextureStreamer()
+//
+void ESUTIL_API esDeleteTextureStreamer ( ESTextureStreamer *streamer )
+{
+   int i;
+
+   Lock ( streamer );
+   streamer->quit = GL_TRUE;
+#ifdef _WIN32
+   WakeAllConditionVariable ( &streamer->wake );
+#else
+   pthread_cond_broadcast ( &streamer->wake );
+#endif
+   Unlock ( streamer );
+
+   for ( i = 0; i < streamer->numThreads; i++ )
+   {
+#ifdef _WIN32
+      WaitForSingleObject ( streamer->threads[i], INFINITE );
+      CloseHandle ( streamer->threads[i] );
+#else
+      pthread_join ( streamer->threads[i], NULL );
+#endif
+   }
+
+   for ( i = 0; i < streamer->numJobs; i++ )
+   {
+      FreeJob ( streamer->jobs[i] );
+   }
+
+#ifdef _WIN32
+   DeleteCriticalSection ( &streamer->lock );
+#else
+   pthread_mutex_destroy ( &streamer->lock );
+   pthread_cond_destroy ( &streamer->wake );
+#endif
+
+   if ( streamer->unpackBuffer != 0 )
+   {
+      glDeleteBuffers ( 1, &streamer->unpackBuffer );
+   }
+
+   free ( streamer->jobs );
+   free ( streamer );
+}
@@ -0,0 +1,200 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESThread.c
+//
+//    Minimal fork-join helper used by the CPU heavy utilities (tangent
+//    generation, BVH builds, texture processing) to spread independent
+//    work over the available cores.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+///
+// Defines
+//
+#define ES_MAX_THREADS   64
+
+///
+// Types
+//
+typedef struct
+{
+   ESParallelForFunc func;
+   void             *userData;
+   int               begin;
+   int               end;
+} ParallelRange;
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+#ifdef _WIN32
+static DWORD WINAPI ParallelWorker ( LPVOID param )
+#else
+static void *ParallelWorker ( void *param )
+#endif
+{
+   ParallelRange *range = param;
+
+   range->func ( range->userData, range->begin, range->end );
+
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esGetNumCores()
+//
+int ESUTIL_API esGetNumCores ( void )
+{
+   int numCores;
+
+#ifdef _WIN32
+   SYSTEM_INFO info;
+
+   GetSystemInfo ( &info );
+   numCores = ( int ) info.dwNumberOfProcessors;
+#else
+   numCores = ( int ) sysconf ( _SC_NPROCESSORS_ONLN );
+#endif
+
+   return numCores < 1 ? 1 : numCores > ES_MAX_THREADS ? ES_MAX_THREADS : numCores;
+}
+
+///
+// esGetTime()
+//
+double ESUTIL_API esGetTime ( void )
+{
+#ifdef _WIN32
+   LARGE_INTEGER frequency, counter;
+
+   QueryPerformanceFrequency ( &frequency );
+   QueryPerformanceCounter ( &counter );
+   return ( double ) counter.QuadPart / ( double ) frequency.QuadPart;
+#else
+   struct timespec now;
+
+   clock_gettime ( CLOCK_MONOTONIC, &now );
+   return ( double ) now.tv_sec + ( double ) now.tv_nsec * 1e-9;
+#endif
+}
+
+///
+// esParallelFor()
+//
+//    Split [0, count) into one contiguous range per core, run all but the
+//    first on new threads and the first on the calling thread, then wait.
+//    A range is never smaller than minRange so small jobs stay serial.  If
+//    a thread cannot be created its range runs on the calling thread.
+//
+void ESUTIL_API esParallelFor ( int count, int minRange, ESParallelForFunc func, void *userData )
+{
+   ParallelRange ranges[ES_MAX_THREADS];
+   int           started[ES_MAX_THREADS];
+#ifdef _WIN32
+   HANDLE        threads[ES_MAX_THREADS];
+#else
+   pthread_t     threads[ES_MAX_THREADS];
+#endif
+   int           numRanges = esGetNumCores ();
+   int           i;
+
+   if ( count <= 0 )
+   {
+      return;
+   }
+
+   minRange = minRange < 1 ? 1 : minRange;
+
+   if ( numRanges > ( count + minRange - 1 ) / minRange )
+   {
+      numRanges = ( count + minRange - 1 ) / minRange;
+   }
+
+   for ( i = 0; i < numRanges; i++ )
+   {
+      ranges[i].func = func;
+      ranges[i].userData = userData;
+      ranges[i].begin = ( int ) ( ( long long ) count * i / numRanges );
+      ranges[i].end = ( int ) ( ( long long ) count * ( i + 1 ) / numRanges );
+   }
+
+   for ( i = 1; i < numRanges; i++ )
+   {
+#ifdef _WIN32
+      threads[i] = CreateThread ( NULL, 0, ParallelWorker, &ranges[i], 0, NULL );
+      started[i] = threads[i] != NULL;
+#else
+      started[i] = pthread_create ( &threads[i], NULL, ParallelWorker, &ranges[i] ) == 0;
+#endif
+
+      if ( !started[i] )
+      {
+         ParallelWorker ( &ranges[i] );
+      }
+   }
+
+   ParallelWorker ( &ranges[0] );
+
+   for ( i = 1; i < numRanges; i++ )
+   {
+      if ( started[i] )
+      {
+#ifdef _WIN32
+         WaitForSingleObject ( threads[i], INFINITE );
+         CloseHandle ( threads[i] );
+#else
+         pthread_join ( threads[i], NULL );
+#endif
+      }
+   }
+}
@@ -0,0 +1,652 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESUploadScheduler.c
+//
+//    Spreads large texture and buffer uploads over several frames.  Each
+//    upload is cut into tiles of whole rows, or whole slices of 3D and
+//    array textures, sent with glTexSubImage2D/3D or glBufferSubData.
+//    Compressed textures are cut into rows of 4x4 blocks and sent with
+//    glCompressedTexSubImage2D/3D.  The
+//    main loop runs the scheduler once before drawing each frame; it sends
+//    tiles in request order until the frame's byte budget is spent or the
+//    next tile is predicted to overrun its time budget, using the rate at
+//    which earlier tiles were submitted.  At least one tile is sent each
+//    frame, so every upload makes progress.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+//  Macros
+//
+#define UPLOAD_TILE_SIZE    ( 256 * 1024 )  // Largest tile unless a single row is bigger
+
+///
+//  Types
+//
+typedef struct
+{
+   // Texture uploads have a format; buffer uploads have GL_NONE.  Compressed
+   // uploads hold the internal format, with type GL_NONE.
+   GLuint         object;
+   GLenum         target;
+   int            bindIndex;
+   GLint          level;
+   GLint          offset[3];
+   GLsizei        size[3];
+   GLenum         format;
+   GLenum         type;
+   size_t         rowSize;
+
+   // Rows per slice, and texels per row: 4 for rows of compressed blocks
+   GLsizei        numRows;
+   GLint          rowHeight;
+   GLintptr       bufferOffset;
+   const GLubyte *data;
+
+   // Rows over all slices for textures, bytes for buffers
+   size_t         total;
+   size_t         sent;
+   GLboolean      uploaded;
+
+   ESUploadDoneFunc done;
+   void          *userData;
+} UploadJob;
+
+struct ESUploadScheduler
+{
+   GLsizeiptr     byteBudget;
+   double         timeBudget;
+
+   // Submission rate of earlier tiles in bytes per second, 0 until measured
+   double         rate;
+
+   // Pending uploads in request order, from jobs[first] on
+   UploadJob     *jobs;
+   int            first;
+   int            numJobs;
+   int            maxJobs;
+};
+
+///
+//  Tables
+//
+static const GLenum bindTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+static const GLenum bindingQueries[] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_3D, GL_TEXTURE_BINDING_2D_ARRAY,
+                                         GL_TEXTURE_BINDING_CUBE_MAP
+                                       };
+
+// Unpack state reset while tiles are read from tightly packed client memory
+static const GLenum unpackParams[] = { GL_UNPACK_ALIGNMENT, GL_UNPACK_ROW_LENGTH, GL_UNPACK_SKIP_ROWS,
+                                       GL_UNPACK_SKIP_PIXELS, GL_UNPACK_IMAGE_HEIGHT, GL_UNPACK_SKIP_IMAGES
+                                     };
+static const GLint  unpackValues[] = { 1, 0, 0, 0, 0, 0 };
+
+#define NUM_UNPACK_PARAMS    ( sizeof ( unpackParams ) / sizeof ( unpackParams[0] ) )
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// PixelSize()
+//
+//    Bytes per pixel of a glTexSubImage format and type, 0 if unknown
+//
+static int PixelSize ( GLenum format, GLenum type )
+{
+   int components;
+
+   switch ( type )
+   {
+      case GL_UNSIGNED_SHORT_5_6_5:
+      case GL_UNSIGNED_SHORT_4_4_4_4:
+      case GL_UNSIGNED_SHORT_5_5_5_1:
+         return 2;
+
+      case GL_UNSIGNED_INT_2_10_10_10_REV:
+      case GL_UNSIGNED_INT_10F_11F_11F_REV:
+      case GL_UNSIGNED_INT_5_9_9_9_REV:
+      case GL_UNSIGNED_INT_24_8:
+         return 4;
+
+      case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+         return 8;
+   }
+
+   switch ( format )
+   {
+      case GL_RED:
+      case GL_RED_INTEGER:
+      case GL_ALPHA:
+      case GL_LUMINANCE:
+      case GL_DEPTH_COMPONENT:
+         components = 1;
+         break;
+
+      case GL_RG:
+      case GL_RG_INTEGER:
+      case GL_LUMINANCE_ALPHA:
+         components = 2;
+         break;
+
+      case GL_RGB:
+      case GL_RGB_INTEGER:
+         components = 3;
+         break;
+
+      case GL_RGBA:
+      case GL_RGBA_INTEGER:
+         components = 4;
+         break;
+
+      default:
+         return 0;
+   }
+
+   switch ( type )
+   {
+      case GL_UNSIGNED_BYTE:
+      case GL_BYTE:
+         return components;
+
+      case GL_UNSIGNED_SHORT:
+      case GL_SHORT:
+      case GL_HALF_FLOAT:
+         return components * 2;
+
+      case GL_UNSIGNED_INT:
+      case GL_INT:
+      case GL_FLOAT:
+         return components * 4;
+   }
+
+   return 0;
+}
+
+///
+// BindIndex()
+//
+//    Index in bindTargets of the target a texture is bound to for
+//    uploads to target, -1 if target is not supported
+//
+static int BindIndex ( GLenum target )
+{
+   switch ( target )
+   {
+      case GL_TEXTURE_2D:
+         return 0;
+
+      case GL_TEXTURE_3D:
+         return 1;
+
+      case GL_TEXTURE_2D_ARRAY:
+         return 2;
+
+      case GL_TEXTURE_CUBE_MAP_POSITIVE_X:
+      case GL_TEXTURE_CUBE_MAP_NEGATIVE_X:
+      case GL_TEXTURE_CUBE_MAP_POSITIVE_Y:
+      case GL_TEXTURE_CUBE_MAP_NEGATIVE_Y:
+      case GL_TEXTURE_CUBE_MAP_POSITIVE_Z:
+      case GL_TEXTURE_CUBE_MAP_NEGATIVE_Z:
+         return 3;
+   }
+
+   return -1;
+}
+
+///
+// AddJob()
+//
+static GLboolean AddJob ( ESUploadScheduler *scheduler, const UploadJob *job )
+{
+   if ( scheduler->first > 0 && scheduler->numJobs == scheduler->maxJobs )
+   {
+      // Reuse the room of the finished jobs before growing
+      scheduler->numJobs -= scheduler->first;
+      memmove ( scheduler->jobs, scheduler->jobs + scheduler->first, sizeof ( UploadJob ) * scheduler->numJobs );
+      scheduler->first = 0;
+   }
+
+   if ( scheduler->numJobs == scheduler->maxJobs )
+   {
+      int        maxJobs = scheduler->maxJobs > 0 ? scheduler->maxJobs * 2 : 16;
+      UploadJob *jobs = realloc ( scheduler->jobs, sizeof ( UploadJob ) * maxJobs );
+
+      if ( jobs == NULL )
+      {
+         return GL_FALSE;
+      }
+
+      scheduler->jobs = jobs;
+      scheduler->maxJobs = maxJobs;
+   }
+
+   scheduler->jobs[scheduler->numJobs++] = *job;
+   return GL_TRUE;
+}
+
+///
+// SendTile()
+//
+//    Send the next tile of a job, of at most maxSize bytes unless one row
+//    is bigger.  Returns the bytes sent.
+//
+static size_t SendTile ( UploadJob *job, size_t maxSize )
+{
+   size_t         rows, slices = 1, first = job->sent;
+   GLint          y, z;
+   GLsizei        height, imageSize;
+   const GLubyte *data;
+
+   if ( job->format == GL_NONE )
+   {
+      size_t size = job->total - job->sent < maxSize ? job->total - job->sent : maxSize;
+
+      glBufferSubData ( GL_COPY_WRITE_BUFFER, job->bufferOffset + job->sent, size, job->data + job->sent );
+      job->sent += size;
+      return size;
+   }
+
+   y = ( GLint ) ( first % job->numRows );
+   z = ( GLint ) ( first / job->numRows );
+   rows = maxSize / job->rowSize > 0 ? maxSize / job->rowSize : 1;
+
+   if ( y == 0 && rows >= ( size_t ) job->numRows )
+   {
+      // Whole slices
+      slices = rows / job->numRows;
+      slices = slices < ( size_t ) ( job->size[2] - z ) ? slices : ( size_t ) ( job->size[2] - z );
+      rows = job->numRows;
+   }
+   else if ( rows > ( size_t ) ( job->numRows - y ) )
+   {
+      rows = job->numRows - y;
+   }
+
+   // The last row of blocks may cover fewer texels than a block
+   y *= job->rowHeight;
+   height = ( GLsizei ) rows * job->rowHeight < job->size[1] - y ? ( GLsizei ) rows * job->rowHeight : job->size[1] - y;
+   data = job->data + first * job->rowSize;
+   imageSize = ( GLsizei ) ( rows * slices * job->rowSize );
+
+   if ( job->bindIndex == 1 || job->bindIndex == 2 )
+   {
+      if ( job->type == GL_NONE )
+      {
+         glCompressedTexSubImage3D ( job->target, job->level, job->offset[0], job->offset[1] + y, job->offset[2] + z,
+                                     job->size[0], height, ( GLsizei ) slices, job->format, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage3D ( job->target, job->level, job->offset[0], job->offset[1] + y, job->offset[2] + z,
+                           job->size[0], height, ( GLsizei ) slices, job->format, job->type, data );
+      }
+   }
+   else
+   {
+      if ( job->type == GL_NONE )
+      {
+         glCompressedTexSubImage2D ( job->target, job->level, job->offset[0], job->offset[1] + y,
+                                     job->size[0], height, job->format, imageSize, data );
+      }
+      else
+      {
+         glTexSubImage2D ( job->target, job->level, job->offset[0], job->offset[1] + y,
+                           job->size[0], height, job->format, job->type, data );
+      }
+   }
+
+   job->sent += rows * slices;
+   return rows * slices * job->rowSize;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esCreateUploadScheduler()
+//
+//    Create a scheduler sending up to byteBudget bytes and taking about
+//    timeBudget seconds per frame
+//
+ESUploadScheduler *ESUTIL_API esCreateUploadScheduler ( GLsizeiptr byteBudget, double timeBudget )
+{
+   ESUploadScheduler *scheduler;
+
+   if ( byteBudget <= 0 )
+   {
+      return NULL;
+   }
+
+   scheduler = calloc ( 1, sizeof ( ESUploadScheduler ) );
+
+   if ( scheduler != NULL )
+   {
+      scheduler->byteBudget = byteBudget;
+      scheduler->timeBudget = timeBudget;
+   }
+
+   return scheduler;
+}
+
+///
+// esScheduleTextureUpload()
+//
+//    Queue an upload to a region of a texture level
+//
+GLboolean ESUTIL_API esScheduleTextureUpload ( ESUploadScheduler *scheduler, GLuint texture, GLenum target, GLint level,
+                                               GLint xoffset, GLint yoffset, GLint zoffset,
+                                               GLsizei width, GLsizei height, GLsizei depth,
+                                               GLenum format, GLenum type, const void *pixels,
+                                               ESUploadDoneFunc done, void *userData )
+{
+   UploadJob job;
+   int       bindIndex = BindIndex ( target );
+   int       pixelSize = PixelSize ( format, type );
+
+   // Only 3D and array textures have slices
+   if ( scheduler == NULL || pixels == NULL || pixelSize == 0 || bindIndex < 0 ||
+         width < 1 || height < 1 || depth < 1 || ( depth > 1 && bindIndex != 1 && bindIndex != 2 ) )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( &job, 0, sizeof ( job ) );
+   job.object = texture;
+   job.target = target;
+   job.bindIndex = bindIndex;
+   job.level = level;
+   job.offset[0] = xoffset;
+   job.offset[1] = yoffset;
+   job.offset[2] = zoffset;
+   job.size[0] = width;
+   job.size[1] = height;
+   job.size[2] = depth;
+   job.format = format;
+   job.type = type;
+   job.rowSize = ( size_t ) width * pixelSize;
+   job.numRows = height;
+   job.rowHeight = 1;
+   job.total = ( size_t ) height * depth;
+   job.data = pixels;
+   job.done = done;
+   job.userData = userData;
+
+   return AddJob ( scheduler, &job );
+}
+
+///
+// esScheduleCompressedTextureUpload()
+//
+//    Queue an upload to a region of a compressed texture level
+//
+GLboolean ESUTIL_API esScheduleCompressedTextureUpload ( ESUploadScheduler *scheduler, GLuint texture, GLenum target,
+                                                         GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+                                                         GLsizei width, GLsizei height, GLsizei depth,
+                                                         GLenum internalFormat, GLsizei imageSize, const void *data,
+                                                         ESUploadDoneFunc done, void *userData )
+{
+   UploadJob job;
+   int       bindIndex = BindIndex ( target );
+   GLsizei   numRows = ( height + 3 ) / 4;
+
+   // The data must split into rows of blocks of the same size
+   if ( scheduler == NULL || data == NULL || internalFormat == GL_NONE || bindIndex < 0 ||
+         width < 1 || height < 1 || depth < 1 || ( depth > 1 && bindIndex != 1 && bindIndex != 2 ) ||
+         imageSize < 1 || imageSize % ( ( GLsizeiptr ) numRows * depth ) != 0 )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( &job, 0, sizeof ( job ) );
+   job.object = texture;
+   job.target = target;
+   job.bindIndex = bindIndex;
+   job.level = level;
+   job.offset[0] = xoffset;
+   job.offset[1] = yoffset;
+   job.offset[2] = zoffset;
+   job.size[0] = width;
+   job.size[1] = height;
+   job.size[2] = depth;
+   job.format = internalFormat;
+   job.type = GL_NONE;
+   job.rowSize = ( size_t ) imageSize / ( ( size_t ) numRows * depth );
+   job.numRows = numRows;
+   job.rowHeight = 4;
+   job.total = ( size_t ) numRows * depth;
+   job.data = data;
+   job.done = done;
+   job.userData = userData;
+
+   return AddJob ( scheduler, &job );
+}
+
+///
+// esScheduleBufferUpload()
+//
+//    Queue an upload to a range of a buffer
+//
+GLboolean ESUTIL_API esScheduleBufferUpload ( ESUploadScheduler *scheduler, GLuint buffer, GLintptr offset,
+                                              GLsizeiptr size, const void *data,
+                                              ESUploadDoneFunc done, void *userData )
+{
+   UploadJob job;
+
+   if ( scheduler == NULL || data == NULL || size < 1 || offset < 0 )
+   {
+      return GL_FALSE;
+   }
+
+   memset ( &job, 0, sizeof ( job ) );
+   job.object = buffer;
+   job.target = GL_COPY_WRITE_BUFFER;
+   job.bindIndex = -1;
+   job.bufferOffset = offset;
+   job.total = ( size_t ) size;
+   job.format = GL_NONE;
+   job.data = data;
+   job.done = done;
+   job.userData = userData;
+
+   return AddJob ( scheduler, &job );
+}
+
+///
+// esUpdateUploadScheduler()
+//
+//    Send this frame's tiles, and report the uploads they complete
+//
+int ESUTIL_API esUpdateUploadScheduler ( ESUploadScheduler *scheduler )
+{
+   GLsizeiptr budget;
+   double     start, now;
+   GLint      unpackState[NUM_UNPACK_PARAMS], unpackBuffer, copyBuffer;
+   GLint      bindings[4];
+   GLboolean  bound[4] = { GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE };
+   GLboolean  tileSent = GL_FALSE;
+   int        next, i;
+   size_t     p;
+
+   if ( scheduler == NULL || scheduler->first == scheduler->numJobs )
+   {
+      return 0;
+   }
+
+   // Pixels are read from client memory, tightly packed
+   for ( p = 0; p < NUM_UNPACK_PARAMS; p++ )
+   {
+      glGetIntegerv ( unpackParams[p], &unpackState[p] );
+      glPixelStorei ( unpackParams[p], unpackValues[p] );
+   }
+
+   glGetIntegerv ( GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer );
+   glGetIntegerv ( GL_COPY_WRITE_BUFFER_BINDING, &copyBuffer );
+   glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
+
+   budget = scheduler->byteBudget;
+   start = esGetTime ();
+
+   for ( next = scheduler->first; next < scheduler->numJobs && budget > 0; )
+   {
+      UploadJob *job = &scheduler->jobs[next];
+      size_t     tileSize = budget < UPLOAD_TILE_SIZE ? ( size_t ) budget : UPLOAD_TILE_SIZE;
+      size_t     sent = 0;
+
+      now = esGetTime ();
+
+      // Leave the rest for the next frame if this tile would overrun the time budget
+      if ( tileSent && scheduler->timeBudget > 0.0 && scheduler->rate > 0.0 &&
+            now - start + tileSize / scheduler->rate > scheduler->timeBudget )
+      {
+         break;
+      }
+
+      if ( job->format == GL_NONE )
+      {
+         job->uploaded = glIsBuffer ( job->object );
+
+         if ( job->uploaded )
+         {
+            glBindBuffer ( GL_COPY_WRITE_BUFFER, job->object );
+            sent = SendTile ( job, tileSize );
+         }
+      }
+      else
+      {
+         // Binding a deleted name would create a new texture
+         job->uploaded = glIsTexture ( job->object );
+
+         if ( job->uploaded )
+         {
+            if ( !bound[job->bindIndex] )
+            {
+               glGetIntegerv ( bindingQueries[job->bindIndex], &bindings[job->bindIndex] );
+               bound[job->bindIndex] = GL_TRUE;
+            }
+
+            glBindTexture ( bindTargets[job->bindIndex], job->object );
+            sent = SendTile ( job, tileSize );
+         }
+      }
+
+      if ( sent > 0 )
+      {
+         double elapsed = esGetTime () - now;
+
+         if ( elapsed > 0.0 )
+         {
+            scheduler->rate = scheduler->rate > 0.0 ? 0.75 * scheduler->rate + 0.25 * sent / elapsed : sent / elapsed;
+         }
+
+         budget -= ( GLsizeiptr ) sent;
+         tileSent = GL_TRUE;
+      }
+
+      if ( !job->uploaded || job->sent == job->total )
+      {
+         next++;
+      }
+   }
+
+   for ( i = 0; i < 4; i++ )
+   {
+      if ( bound[i] )
+      {
+         glBindTexture ( bindTargets[i], bindings[i] );
+      }
+   }
+
+   glBindBuffer ( GL_COPY_WRITE_BUFFER, copyBuffer );
+   glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, unpackBuffer );
+
+   for ( p = 0; p < NUM_UNPACK_PARAMS; p++ )
+   {
+      glPixelStorei ( unpackParams[p], unpackState[p] );
+   }
+
+   // Report completed uploads with the application's state back in place.
+   // Callbacks may schedule more uploads, which can move the jobs down.
+   for ( i = next - scheduler->first; i > 0; i-- )
+   {
+      UploadJob job = scheduler->jobs[scheduler->first++];
+
+      if ( job.done != NULL )
+      {
+         job.done ( job.userData, job.uploaded );
+      }
+   }
+
+   if ( scheduler->first == scheduler->numJobs )
+   {
+      scheduler->first = scheduler->numJobs = 0;
+   }
+
+   return scheduler->numJobs - scheduler->first;
+}
+
+///
+// esDeleteUploadScheduler()
+//
+//    Drop the uploads still pending, reporting them as not uploaded
+//
+void ESUTIL_API esDeleteUploadScheduler ( ESUploadScheduler *scheduler )
+{
+   int i;
+
+   if ( scheduler == NULL )
+   {
+      return;
+   }
+
+   for ( i = scheduler->first; i < scheduler->numJobs; i++ )
+   {
+      if ( scheduler->jobs[i].done != NULL )
+      {
+         scheduler->jobs[i].done ( scheduler->jobs[i].userData, GL_FALSE );
+      }
+   }
+
+   free ( scheduler->jobs );
+   free ( scheduler );
+}
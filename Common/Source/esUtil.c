@@ -55,45 +55,21 @@ typedef AAsset esFile;
 typedef FILE esFile;
 #endif
 
-#ifdef __APPLE__
-#include "FileWrapper.h"
+#if defined ( _WIN32 )
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
 #endif
 
-///
-//  Macros
-//
-#define INVERTED_BIT            (1 << 5)
-
-///
-//  Types
-//
-#ifndef __APPLE__
-#pragma pack(push,x1)                            // Byte alignment (8-bit)
-#pragma pack(1)
+#ifdef ANDROID
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #endif
 
-typedef struct
 #ifdef __APPLE__
-__attribute__ ( ( packed ) )
-#endif
-{
-   unsigned char  IdSize,
-            MapType,
-            ImageType;
-   unsigned short PaletteStart,
-            PaletteSize;
-   unsigned char  PaletteEntryDepth;
-   unsigned short X,
-            Y,
-            Width,
-            Height;
-   unsigned char  ColorDepth,
-            Descriptor;
-
-} TGA_HEADER;
-
-#ifndef __APPLE__
-#pragma pack(pop,x1)
+#include "FileWrapper.h"
 #endif
 
 #ifndef __APPLE__
@@ -369,55 +345,296 @@ static int esFileRead ( esFile *pFile, int bytesToRead, void *buffer )
 #ifdef ANDROID
    bytesRead = AAsset_read ( pFile, buffer, bytesToRead );
 #else
-   bytesRead = fread ( buffer, bytesToRead, 1, pFile );
+   bytesRead = ( int ) fread ( buffer, 1, bytesToRead, pFile );
 #endif
 
    return bytesRead;
 }
 
 ///
-// esLoadTGA()
+// esFileSize()
 //
-//    Loads a 8-bit, 24-bit or 32-bit TGA image from a file
+//    Wrapper for platform specific File size
 //
-char *ESUTIL_API esLoadTGA ( void *ioContext, const char *fileName, int *width, int *height )
+static int esFileSize ( esFile *pFile )
 {
-   char        *buffer;
-   esFile      *fp;
-   TGA_HEADER   Header;
-   int          bytesRead;
+   int size;
+
+#ifdef ANDROID
+   size = ( int ) AAsset_getLength ( pFile );
+#else
+   fseek ( pFile, 0, SEEK_END );
+   size = ( int ) ftell ( pFile );
+   fseek ( pFile, 0, SEEK_SET );
+#endif
+
+   return size;
+}
+
+#ifdef ANDROID
+///
+// MapDataFile()
+//
+//    Map a file of the file system rather than an asset of the APK, such
+//    as a cache file in the application's data directory
+//
+static GLboolean MapDataFile ( const char *fileName, ESFileMapping *mapping )
+{
+   struct stat status;
+   int         fd = open ( fileName, O_RDONLY );
+
+   if ( fd < 0 )
+   {
+      return GL_FALSE;
+   }
+
+   if ( fstat ( fd, &status ) == 0 && status.st_size > 0 )
+   {
+      void *data = mmap ( NULL, ( size_t ) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+      if ( data != MAP_FAILED )
+      {
+         mapping->data = data;
+         mapping->size = ( int ) status.st_size;
+      }
+   }
+
+   close ( fd );
+   return mapping->data != NULL;
+}
+#endif
+
+///
+// esMapFile()
+//
+//    Map a file into memory, or read it if it cannot be mapped
+//
+GLboolean ESUTIL_API esMapFile ( void *ioContext, const char *fileName, ESFileMapping *mapping )
+{
+   esFile *fp;
+
+   memset ( mapping, 0, sizeof ( ESFileMapping ) );
+
+#ifdef ANDROID
+   // Without an asset manager the name is a path in the file system
+   if ( ioContext == NULL )
+   {
+      return MapDataFile ( fileName, mapping );
+   }
+#endif
 
-   // Open the file for reading
    fp = esFileOpen ( ioContext, fileName );
 
    if ( fp == NULL )
    {
-      // Log error as 'error in opening the input file from apk'
-      esLogMessage ( "esLoadTGA FAILED to load : { %s }\n", fileName );
-      return NULL;
+      return GL_FALSE;
    }
 
-   bytesRead = esFileRead ( fp, sizeof ( TGA_HEADER ), &Header );
+   mapping->size = esFileSize ( fp );
 
-   *width = Header.Width;
-   *height = Header.Height;
+#if defined ( ANDROID )
+   // Assets opened with AASSET_MODE_BUFFER are held in memory, and stay
+   // there until the asset is closed
+   mapping->data = AAsset_getBuffer ( fp );
 
-   if ( Header.ColorDepth == 8 ||
-         Header.ColorDepth == 24 || Header.ColorDepth == 32 )
+   if ( mapping->data != NULL )
    {
-      int bytesToRead = sizeof ( char ) * ( *width ) * ( *height ) * Header.ColorDepth / 8;
+      mapping->platform = fp;
+      return GL_TRUE;
+   }
+#elif defined ( _WIN32 )
+   if ( mapping->size > 0 )
+   {
+      HANDLE file = ( HANDLE ) _get_osfhandle ( _fileno ( fp ) );
+      HANDLE view = CreateFileMapping ( file, NULL, PAGE_READONLY, 0, 0, NULL );
+
+      if ( view != NULL )
+      {
+         mapping->data = MapViewOfFile ( view, FILE_MAP_READ, 0, 0, 0 );
 
-      // Allocate the image data buffer
-      buffer = ( char * ) malloc ( bytesToRead );
+         if ( mapping->data != NULL )
+         {
+            // The mapping keeps the file open
+            mapping->platform = view;
+            esFileClose ( fp );
+            return GL_TRUE;
+         }
 
-      if ( buffer )
+         CloseHandle ( view );
+      }
+   }
+#else
+   if ( mapping->size > 0 )
+   {
+      void *data = mmap ( NULL, mapping->size, PROT_READ, MAP_PRIVATE, fileno ( fp ), 0 );
+
+      if ( data != MAP_FAILED )
       {
-         bytesRead = esFileRead ( fp, bytesToRead, buffer );
+         mapping->data = data;
          esFileClose ( fp );
+         return GL_TRUE;
+      }
+   }
+#endif
+
+   mapping->buffer = mapping->size > 0 ? malloc ( mapping->size ) : NULL;
 
-         return ( buffer );
+   if ( mapping->buffer == NULL || esFileRead ( fp, mapping->size, mapping->buffer ) != mapping->size )
+   {
+      free ( mapping->buffer );
+      esFileClose ( fp );
+      memset ( mapping, 0, sizeof ( ESFileMapping ) );
+      return GL_FALSE;
+   }
+
+   mapping->data = mapping->buffer;
+   esFileClose ( fp );
+
+   return GL_TRUE;
+}
+
+///
+// esUnmapFile()
+//
+//    Release a file mapped by esMapFile
+//
+void ESUTIL_API esUnmapFile ( ESFileMapping *mapping )
+{
+   if ( mapping->buffer != NULL )
+   {
+      free ( mapping->buffer );
+   }
+   else if ( mapping->data != NULL )
+   {
+#if defined ( ANDROID )
+      if ( mapping->platform != NULL )
+      {
+         AAsset_close ( ( AAsset * ) mapping->platform );
+      }
+      else
+      {
+         munmap ( ( void * ) mapping->data, mapping->size );
+      }
+#elif defined ( _WIN32 )
+      UnmapViewOfFile ( mapping->data );
+      CloseHandle ( ( HANDLE ) mapping->platform );
+#else
+      munmap ( ( void * ) mapping->data, mapping->size );
+#endif
+   }
+
+   memset ( mapping, 0, sizeof ( ESFileMapping ) );
+}
+
+///
+// esLoadTGA()
+//
+//    Loads a TGA image from a file
+//
+char *ESUTIL_API esLoadTGA ( void *ioContext, const char *fileName, int *width, int *height )
+{
+   char          *buffer = NULL;
+   ESFileMapping  file;
+   int            components;
+
+   if ( esMapFile ( ioContext, fileName, &file ) &&
+         esDecodeTGA ( file.data, file.size, width, height, &components, NULL ) )
+   {
+      buffer = ( char * ) malloc ( ( size_t ) *width * *height * components );
+
+      if ( buffer != NULL && !esDecodeTGA ( file.data, file.size, width, height, &components, buffer ) )
+      {
+         free ( buffer );
+         buffer = NULL;
+      }
+   }
+
+   if ( buffer == NULL )
+   {
+      // Log error as 'error in opening the input file from apk'
+      esLogMessage ( "esLoadTGA FAILED to load : { %s }\n", fileName );
+   }
+
+   esUnmapFile ( &file );
+
+   return ( buffer );
+}
+
+///
+// esLoadTGATexture()
+//
+//    Loads a TGA image from a file into the bound texture
+//
+GLboolean ESUTIL_API esLoadTGATexture ( void *ioContext, const char *fileName, GLenum target, int *width, int *height )
+{
+   static const GLenum formats[] = { GL_NONE, GL_RED, GL_NONE, GL_RGB, GL_RGBA };
+   static const GLenum internalFormats[] = { GL_NONE, GL_R8, GL_NONE, GL_RGB8, GL_RGBA8 };
+   ESFileMapping file;
+   const void   *pixels = NULL;
+   GLuint        pixelBuffer = 0;
+   GLint         alignment, unpackBuffer;
+   int           components;
+   GLboolean     result;
+
+   // The application's unpack buffer is put back once the pixels are sent
+   glGetIntegerv ( GL_PIXEL_UNPACK_BUFFER_BINDING, &unpackBuffer );
+
+   result = esMapFile ( ioContext, fileName, &file ) &&
+            esDecodeTGA ( file.data, file.size, width, height, &components, NULL );
+
+   if ( result )
+   {
+      // Upload straight from the mapped file if the pixels need no decoding,
+      // otherwise decode into a mapped pixel unpack buffer
+      pixels = esGetTGAPixelData ( file.data, file.size );
+
+      if ( pixels == NULL )
+      {
+         GLsizeiptr size = ( GLsizeiptr ) *width * *height * components;
+         void      *mapped;
+
+         glGenBuffers ( 1, &pixelBuffer );
+         glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, pixelBuffer );
+         glBufferData ( GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW );
+         mapped = glMapBufferRange ( GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT );
+
+         result = mapped != NULL && esDecodeTGA ( file.data, file.size, width, height, &components, mapped );
+
+         if ( mapped != NULL )
+         {
+            result = glUnmapBuffer ( GL_PIXEL_UNPACK_BUFFER ) && result;
+         }
+      }
+      else
+      {
+         glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, 0 );
       }
    }
 
-   return ( NULL );
+   if ( result )
+   {
+      // Decoded rows are tightly packed
+      glGetIntegerv ( GL_UNPACK_ALIGNMENT, &alignment );
+      glPixelStorei ( GL_UNPACK_ALIGNMENT, 1 );
+      glTexImage2D ( target, 0, internalFormats[components], *width, *height, 0,
+                     formats[components], GL_UNSIGNED_BYTE, pixels );
+      glPixelStorei ( GL_UNPACK_ALIGNMENT, alignment );
+   }
+   else
+   {
+      esLogMessage ( "esLoadTGATexture FAILED to load : { %s }\n", fileName );
+   }
+
+   glBindBuffer ( GL_PIXEL_UNPACK_BUFFER, unpackBuffer );
+
+   if ( pixelBuffer != 0 )
+   {
+      // The texture has its own copy, or the upload is queued and the
+      // buffer is released once it completes
+      glDeleteBuffers ( 1, &pixelBuffer );
+   }
+
+   esUnmapFile ( &file );
+
+   return result;
 }
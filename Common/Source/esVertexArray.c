@@ -0,0 +1,418 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ESVertexArray.c
+//
+//    A cache of vertex array objects keyed by vertex layout.  Lets the
+//    draw path bind all of its vertex state with a single call to
+//    glBindVertexArray instead of re-issuing glVertexAttribPointer and
+//    glEnableVertexAttribArray for every draw.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <stdlib.h>
+#include <string.h>
+
+///
+// Defines
+//
+#define INITIAL_CACHE_SIZE  16
+
+///
+// Types
+//
+typedef struct
+{
+   GLuint         hash;
+   GLuint         vao;
+   ESVertexLayout layout;
+} ESVertexArrayEntry;
+
+struct ESVertexArrayCache
+{
+   ESVertexArrayEntry *entries;
+   int                 capacity;
+   int                 count;
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+///
+// HashWord()
+//
+//    Fold one 32-bit word into an FNV-1a hash
+//
+static GLuint HashWord ( GLuint hash, GLuint word )
+{
+   int i;
+
+   for ( i = 0; i < 4; i++ )
+   {
+      hash ^= ( word >> ( i * 8 ) ) & 0xFF;
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+///
+// HashLayout()
+//
+//    FNV-1a hash of the layout, field by field so that struct padding and
+//    the contents of disabled attributes do not affect the result
+//
+static GLuint HashLayout ( const ESVertexLayout *layout )
+{
+   GLuint hash = 2166136261u;
+   GLuint index;
+
+   hash = HashWord ( hash, layout->enabledMask );
+   hash = HashWord ( hash, layout->indexBuffer );
+
+   for ( index = 0; index < ES_MAX_VERTEX_ATTRIBS; index++ )
+   {
+      const ESVertexAttrib *attrib = &layout->attribs[index];
+
+      if ( ( layout->enabledMask & ( 1u << index ) ) == 0 )
+      {
+         continue;
+      }
+
+      hash = HashWord ( hash, attrib->buffer );
+      hash = HashWord ( hash, ( GLuint ) attrib->size );
+      hash = HashWord ( hash, attrib->type );
+      hash = HashWord ( hash, attrib->normalized );
+      hash = HashWord ( hash, attrib->integer );
+      hash = HashWord ( hash, ( GLuint ) attrib->stride );
+      hash = HashWord ( hash, attrib->offset );
+      hash = HashWord ( hash, attrib->divisor );
+   }
+
+   return hash;
+}
+
+///
+// LayoutsEqual()
+//
+//    Compare the fields that HashLayout covers
+//
+static GLboolean LayoutsEqual ( const ESVertexLayout *a, const ESVertexLayout *b )
+{
+   GLuint index;
+
+   if ( a->enabledMask != b->enabledMask || a->indexBuffer != b->indexBuffer )
+   {
+      return GL_FALSE;
+   }
+
+   for ( index = 0; index < ES_MAX_VERTEX_ATTRIBS; index++ )
+   {
+      const ESVertexAttrib *x = &a->attribs[index];
+      const ESVertexAttrib *y = &b->attribs[index];
+
+      if ( ( a->enabledMask & ( 1u << index ) ) == 0 )
+      {
+         continue;
+      }
+
+      if ( x->buffer != y->buffer || x->size != y->size || x->type != y->type ||
+           x->normalized != y->normalized || x->integer != y->integer ||
+           x->stride != y->stride || x->offset != y->offset || x->divisor != y->divisor )
+      {
+         return GL_FALSE;
+      }
+   }
+
+   return GL_TRUE;
+}
+
+///
+// CreateVertexArray()
+//
+//    Build a vertex array object that captures the layout
+//
+static GLuint CreateVertexArray ( const ESVertexLayout *layout )
+{
+   GLuint vao;
+   GLuint index;
+
+   glGenVertexArrays ( 1, &vao );
+   glBindVertexArray ( vao );
+
+   for ( index = 0; index < ES_MAX_VERTEX_ATTRIBS; index++ )
+   {
+      const ESVertexAttrib *attrib = &layout->attribs[index];
+
+      if ( ( layout->enabledMask & ( 1u << index ) ) == 0 )
+      {
+         continue;
+      }
+
+      glBindBuffer ( GL_ARRAY_BUFFER, attrib->buffer );
+
+      if ( attrib->integer )
+      {
+         glVertexAttribIPointer ( index, attrib->size, attrib->type, attrib->stride,
+                                  ( const void * ) ( size_t ) attrib->offset );
+      }
+      else
+      {
+         glVertexAttribPointer ( index, attrib->size, attrib->type, attrib->normalized,
+                                 attrib->stride, ( const void * ) ( size_t ) attrib->offset );
+      }
+
+      glVertexAttribDivisor ( index, attrib->divisor );
+      glEnableVertexAttribArray ( index );
+   }
+
+   // The element array binding is part of the vertex array state
+   glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, layout->indexBuffer );
+
+   glBindVertexArray ( 0 );
+   glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+
+   return vao;
+}
+
+///
+// GrowCache()
+//
+//    Double the size of the open addressing table and rehash the entries
+//
+static GLboolean GrowCache ( ESVertexArrayCache *cache )
+{
+   ESVertexArrayEntry *oldEntries = cache->entries;
+   int oldCapacity = cache->capacity;
+   int capacity = oldCapacity ? oldCapacity * 2 : INITIAL_CACHE_SIZE;
+   int i;
+
+   cache->entries = calloc ( capacity, sizeof ( ESVertexArrayEntry ) );
+
+   if ( cache->entries == NULL )
+   {
+      cache->entries = oldEntries;
+      return GL_FALSE;
+   }
+
+   cache->capacity = capacity;
+
+   for ( i = 0; i < oldCapacity; i++ )
+   {
+      if ( oldEntries[i].vao != 0 )
+      {
+         int slot = oldEntries[i].hash & ( capacity - 1 );
+
+         while ( cache->entries[slot].vao != 0 )
+         {
+            slot = ( slot + 1 ) & ( capacity - 1 );
+         }
+
+         cache->entries[slot] = oldEntries[i];
+      }
+   }
+
+   free ( oldEntries );
+   return GL_TRUE;
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+//
+/// \brief Reset a vertex layout to no enabled attributes and no index buffer
+/// \param layout Layout to initialize
+//
+void ESUTIL_API esInitVertexLayout ( ESVertexLayout *layout )
+{
+   memset ( layout, 0, sizeof ( ESVertexLayout ) );
+}
+
+//
+/// \brief Enable an attribute in a vertex layout.  Parameters match glVertexAttribPointer,
+///        except that the data is always sourced from a buffer object at a byte offset.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param buffer Buffer object the attribute is read from
+/// \param size, type, normalized, stride As for glVertexAttribPointer
+/// \param offset Byte offset of the first element in the buffer
+//
+void ESUTIL_API esVertexLayoutAttrib ( ESVertexLayout *layout, GLuint index, GLuint buffer,
+                                       GLint size, GLenum type, GLboolean normalized,
+                                       GLsizei stride, GLuint offset )
+{
+   ESVertexAttrib *attrib;
+
+   if ( index >= ES_MAX_VERTEX_ATTRIBS )
+   {
+      return;
+   }
+
+   attrib = &layout->attribs[index];
+   attrib->buffer = buffer;
+   attrib->size = size;
+   attrib->type = type;
+   attrib->normalized = normalized;
+   attrib->stride = stride;
+   attrib->offset = offset;
+   attrib->integer = GL_FALSE;
+   attrib->divisor = 0;
+
+   layout->enabledMask |= 1u << index;
+}
+
+//
+/// \brief Enable an integer attribute in a vertex layout.  Parameters match glVertexAttribIPointer,
+///        except that the data is always sourced from a buffer object at a byte offset.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param buffer Buffer object the attribute is read from
+/// \param size, type, stride As for glVertexAttribIPointer
+/// \param offset Byte offset of the first element in the buffer
+//
+void ESUTIL_API esVertexLayoutAttribI ( ESVertexLayout *layout, GLuint index, GLuint buffer,
+                                        GLint size, GLenum type, GLsizei stride, GLuint offset )
+{
+   if ( index >= ES_MAX_VERTEX_ATTRIBS )
+   {
+      return;
+   }
+
+   esVertexLayoutAttrib ( layout, index, buffer, size, type, GL_FALSE, stride, offset );
+   layout->attribs[index].integer = GL_TRUE;
+}
+
+//
+/// \brief Set the instance divisor of an attribute, as for glVertexAttribDivisor.  Call after
+///        the attribute has been enabled with esVertexLayoutAttrib or esVertexLayoutAttribI.
+/// \param layout Layout to modify
+/// \param index Attribute location
+/// \param divisor Number of instances drawn per element of the attribute, 0 to advance per vertex
+//
+void ESUTIL_API esVertexLayoutDivisor ( ESVertexLayout *layout, GLuint index, GLuint divisor )
+{
+   if ( index >= ES_MAX_VERTEX_ATTRIBS )
+   {
+      return;
+   }
+
+   layout->attribs[index].divisor = divisor;
+}
+
+//
+/// \brief Create an empty vertex array cache
+/// \return The new cache, NULL on failure
+//
+ESVertexArrayCache *ESUTIL_API esCreateVertexArrayCache ( void )
+{
+   ESVertexArrayCache *cache = calloc ( 1, sizeof ( ESVertexArrayCache ) );
+
+   if ( cache != NULL && !GrowCache ( cache ) )
+   {
+      free ( cache );
+      return NULL;
+   }
+
+   return cache;
+}
+
+//
+/// \brief Return a vertex array object matching the layout, creating it on first use
+/// \param cache Vertex array cache
+/// \param layout Vertex layout and bound buffers, initialized with esInitVertexLayout
+/// \return The vertex array object, 0 on failure
+//
+GLuint ESUTIL_API esGetVertexArray ( ESVertexArrayCache *cache, const ESVertexLayout *layout )
+{
+   GLuint hash = HashLayout ( layout );
+   int slot;
+
+   // Keep the table at most half full so probe sequences stay short
+   if ( ( cache->count + 1 ) * 2 > cache->capacity && !GrowCache ( cache ) )
+   {
+      return 0;
+   }
+
+   slot = hash & ( cache->capacity - 1 );
+
+   while ( cache->entries[slot].vao != 0 )
+   {
+      ESVertexArrayEntry *entry = &cache->entries[slot];
+
+      if ( entry->hash == hash && LayoutsEqual ( &entry->layout, layout ) )
+      {
+         return entry->vao;
+      }
+
+      slot = ( slot + 1 ) & ( cache->capacity - 1 );
+   }
+
+   cache->entries[slot].hash = hash;
+   cache->entries[slot].layout = *layout;
+   cache->entries[slot].vao = CreateVertexArray ( layout );
+   cache->count++;
+
+   return cache->entries[slot].vao;
+}
+
+//
+/// \brief Delete all vertex array objects held by the cache and free the cache
+/// \param cache Vertex array cache
+//
+void ESUTIL_API esDeleteVertexArrayCache ( ESVertexArrayCache *cache )
+{
+   int i;
+
+   if ( cache == NULL )
+   {
+      return;
+   }
+
+   for ( i = 0; i < cache->capacity; i++ )
+   {
+      if ( cache->entries[i].vao != 0 )
+      {
+         glDeleteVertexArrays ( 1, &cache->entries[i].vao );
+      }
+   }
+
+   free ( cache->entries );
+   free ( cache );
+}
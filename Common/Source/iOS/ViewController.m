@@ -134,6 +134,9 @@ extern void esMain( ESContext *esContext );
     _esContext.width = view.drawableWidth;
     _esContext.height = view.drawableHeight;
     
+    // Send this frame's share of the scheduled uploads
+    esUpdateUploadScheduler( _esContext.uploadScheduler );
+    
     if ( _esContext.drawFunc )
     {
         _esContext.drawFunc( &_esContext );
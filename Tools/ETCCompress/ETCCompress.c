@@ -0,0 +1,1434 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2013 Dan Ginsburg, Budirijanto Purnomo
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+//
+// Book:      OpenGL(R) ES 3.0 Programming Guide, 2nd Edition
+// Authors:   Dan Ginsburg, Budirijanto Purnomo, Dave Shreiner, Aaftab Munshi
+// ISBN-10:   0-321-93388-5
+// ISBN-13:   978-0-321-93388-1
+// Publisher: Addison-Wesley Professional
+// URLs:      http://www.opengles-book.com
+//            http://my.safaribooksonline.com/book/animation-and-3d/9780133440133
+//
+// ETCCompress.c
+//
+//    Offline ETC2 / EAC texture compressor.  Reads a TGA image, builds a
+//    box filtered mip chain, encodes every level on all cores and writes a
+//    KTX file for esLoadKTX.  The PSNR of the top level against the source
+//    image is reported so presets and formats can be compared.
+//
+//    The tool needs no GPU or window system: it is built from the Common
+//    sources that do not call EGL or GL and runs on any host.
+//
+//    Usage: ETCCompress [-format rgb|rgba|r11|rg11] [-quality fast|medium|high]
+//                       [-nomips] input.tga output.ktx
+//
+//       rgb    GL_COMPRESSED_RGB8_ETC2       default for 24-bit images
+//       rgba   GL_COMPRESSED_RGBA8_ETC2_EAC  default for 32-bit images
+//       r11    GL_COMPRESSED_R11_EAC         default for 8-bit images
+//       rg11   GL_COMPRESSED_RG11_EAC        red and green of the image
+//
+//    ETC2 RGB blocks are encoded in the individual, differential and
+//    planar modes; the T and H modes are decoded but never chosen.
+//
+
+///
+//  Includes
+//
+#include "esUtil.h"
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+///
+//  Macros
+//
+#define MAX_LEVELS   32
+
+///
+//  Types
+//
+
+// Encoder effort, selected with -quality
+typedef struct
+{
+   const char *name;
+   int         refinePasses;     // ETC base color refinements per modifier table
+   int         colorRadius;      // ETC base colors searched around the best fit
+   int         planar;           // try ETC2 planar blocks
+   int         multiplierRadius; // EAC multipliers searched around the fitted one
+   int         baseRadius;       // EAC base codewords searched around the fitted one
+} Quality;
+
+// Output format, selected with -format
+typedef struct
+{
+   const char *name;
+   GLenum      internalFormat;
+   GLenum      baseFormat;
+   int         blockBytes;
+} Format;
+
+// Best encoding found for one 2x4 or 4x2 ETC subblock
+typedef struct
+{
+   int color[3];
+   int table;
+   int selectors[8];
+   int error;
+} SubblockFit;
+
+// One mip level shared by the encoding threads
+typedef struct
+{
+   const GLubyte *pixels;  // RGBA8, bottom row first
+   int            width;
+   int            height;
+   const Format  *format;
+   const Quality *quality;
+   GLubyte       *blocks;
+} EncodeJob;
+
+static const Quality qualities[] =
+{
+   { "fast",   0, 0, 0, 0, 0 },
+   { "medium", 2, 0, 1, 1, 1 },
+   { "high",   4, 1, 1, 3, 3 },
+};
+
+static const Format formats[] =
+{
+   { "rgb",  GL_COMPRESSED_RGB8_ETC2,      GL_RGB,  8 },
+   { "rgba", GL_COMPRESSED_RGBA8_ETC2_EAC, GL_RGBA, 16 },
+   { "r11",  GL_COMPRESSED_R11_EAC,        GL_RED,  8 },
+   { "rg11", GL_COMPRESSED_RG11_EAC,       GL_RG,   16 },
+};
+
+// ETC modifier tables, indexed by the 2-bit selector
+static const int etcModifiers[8][4] =
+{
+   {  2,   8,  -2,   -8 },
+   {  5,  17,  -5,  -17 },
+   {  9,  29,  -9,  -29 },
+   { 13,  42, -13,  -42 },
+   { 18,  60, -18,  -60 },
+   { 24,  80, -24,  -80 },
+   { 33, 106, -33, -106 },
+   { 47, 183, -47, -183 },
+};
+
+// ETC2 T and H mode distances
+static const int etcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+// EAC modifier tables, indexed by the 3-bit selector
+static const int eacModifiers[16][8] =
+{
+   { -3, -6,  -9, -15, 2, 5, 8, 14 },
+   { -3, -7, -10, -13, 2, 6, 9, 12 },
+   { -2, -5,  -8, -13, 1, 4, 7, 12 },
+   { -2, -4,  -6, -13, 1, 3, 5, 12 },
+   { -3, -6,  -8, -12, 2, 5, 7, 11 },
+   { -3, -7,  -9, -11, 2, 6, 8, 10 },
+   { -4, -7,  -8, -11, 3, 6, 7, 10 },
+   { -3, -5,  -8, -11, 2, 4, 7, 10 },
+   { -2, -6,  -8, -10, 1, 5, 7,  9 },
+   { -2, -5,  -8, -10, 1, 4, 7,  9 },
+   { -2, -4,  -8, -10, 1, 3, 7,  9 },
+   { -2, -5,  -7, -10, 1, 4, 6,  9 },
+   { -3, -4,  -7, -10, 2, 3, 6,  9 },
+   { -1, -2,  -3, -10, 0, 1, 2,  9 },
+   { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+   { -3, -5,  -7,  -9, 2, 4, 6,  8 },
+};
+
+// Pixels of the two subblocks for each flip bit.  Pixels are numbered
+// down the columns, the order of the selector bits in a block
+static const int subblockPixels[2][2][8] =
+{
+   { { 0, 1, 2, 3, 4, 5, 6, 7 }, { 8, 9, 10, 11, 12, 13, 14, 15 } },
+   { { 0, 1, 4, 5, 8, 9, 12, 13 }, { 2, 3, 6, 7, 10, 11, 14, 15 } },
+};
+
+//////////////////////////////////////////////////////////////////
+//
+//  Private Functions
+//
+//
+
+static int Clamp ( int value, int low, int high )
+{
+   return value < low ? low : value > high ? high : value;
+}
+
+static int SignExtend3 ( int value )
+{
+   return ( ( value & 7 ) ^ 4 ) - 4;
+}
+
+///
+// Quantize()
+//
+//    Nearest bits-wide value to an 8-bit one
+//
+static int Quantize ( int value, int bits )
+{
+   return ( Clamp ( value, 0, 255 ) * ( ( 1 << bits ) - 1 ) + 127 ) / 255;
+}
+
+///
+// Expand()
+//
+//    Widen a 4 to 7-bit value to 8 bits by replicating its high bits
+//
+static int Expand ( int value, int bits )
+{
+   return ( value << ( 8 - bits ) ) | ( value >> ( 2 * bits - 8 ) );
+}
+
+///
+// FetchBlock()
+//
+//    Copy a 4x4 block, clamping to the edge of the level
+//
+static void FetchBlock ( const EncodeJob *job, int blockX, int blockY, GLubyte block[16][4] )
+{
+   int x, y;
+
+   for ( x = 0; x < 4; x++ )
+   {
+      for ( y = 0; y < 4; y++ )
+      {
+         int px = Clamp ( blockX * 4 + x, 0, job->width - 1 );
+         int py = Clamp ( blockY * 4 + y, 0, job->height - 1 );
+
+         memcpy ( block[x * 4 + y], job->pixels + ( ( size_t ) py * job->width + px ) * 4, 4 );
+      }
+   }
+}
+
+///
+// EvaluateSubblock()
+//
+//    Pick the best selector of every pixel for the fit's color and table
+//    and return the squared error.  Stops early once the error reaches
+//    limit, in which case the selectors are incomplete.
+//
+static int EvaluateSubblock ( const GLubyte block[16][4], const int *pixels, int bits, SubblockFit *fit, int limit )
+{
+   const int *modifiers = etcModifiers[fit->table];
+   int        color[3];
+   int        error = 0;
+   int        i, s;
+
+   color[0] = Expand ( fit->color[0], bits );
+   color[1] = Expand ( fit->color[1], bits );
+   color[2] = Expand ( fit->color[2], bits );
+
+   for ( i = 0; i < 8 && error < limit; i++ )
+   {
+      const GLubyte *p = block[pixels[i]];
+      int            best = INT_MAX;
+
+      for ( s = 0; s < 4; s++ )
+      {
+         int dr = Clamp ( color[0] + modifiers[s], 0, 255 ) - p[0];
+         int dg = Clamp ( color[1] + modifiers[s], 0, 255 ) - p[1];
+         int db = Clamp ( color[2] + modifiers[s], 0, 255 ) - p[2];
+         int e = dr * dr + dg * dg + db * db;
+
+         if ( e < best )
+         {
+            best = e;
+            fit->selectors[i] = s;
+         }
+      }
+
+      error += best;
+   }
+
+   fit->error = error;
+   return error;
+}
+
+///
+// FitSubblock()
+//
+//    Find the base color, within [low, high] per channel, and modifier
+//    table that encode a subblock best.  Every table starts from the
+//    quantized average color, which is then moved to the average of the
+//    pixels minus their modifiers until the error stops falling.
+//
+static void FitSubblock ( const GLubyte block[16][4], const int *pixels, int bits, const int low[3],
+                          const int high[3], const Quality *quality, SubblockFit *fit )
+{
+   SubblockFit candidate;
+   int         average[3] = { 0, 0, 0 };
+   int         table, pass, c, i;
+   int         dr, dg, db;
+
+   for ( i = 0; i < 8; i++ )
+   {
+      for ( c = 0; c < 3; c++ )
+      {
+         average[c] += block[pixels[i]][c];
+      }
+   }
+
+   fit->error = INT_MAX;
+
+   for ( table = 0; table < 8 && fit->error > 0; table++ )
+   {
+      candidate.table = table;
+
+      for ( c = 0; c < 3; c++ )
+      {
+         candidate.color[c] = Clamp ( Quantize ( ( average[c] + 4 ) / 8, bits ), low[c], high[c] );
+      }
+
+      EvaluateSubblock ( block, pixels, bits, &candidate, INT_MAX );
+
+      for ( pass = 0; pass < quality->refinePasses; pass++ )
+      {
+         SubblockFit refined = candidate;
+         int         moved = GL_FALSE;
+
+         for ( c = 0; c < 3; c++ )
+         {
+            int sum = 0;
+
+            for ( i = 0; i < 8; i++ )
+            {
+               sum += block[pixels[i]][c] - etcModifiers[table][candidate.selectors[i]];
+            }
+
+            refined.color[c] = Clamp ( Quantize ( ( sum + 4 ) / 8, bits ), low[c], high[c] );
+            moved |= refined.color[c] != candidate.color[c];
+         }
+
+         if ( !moved || EvaluateSubblock ( block, pixels, bits, &refined, candidate.error ) >= candidate.error )
+         {
+            break;
+         }
+
+         candidate = refined;
+      }
+
+      if ( candidate.error < fit->error )
+      {
+         *fit = candidate;
+      }
+   }
+
+   // Search the neighbourhood of the best color with every table
+   if ( quality->colorRadius > 0 && fit->error > 0 )
+   {
+      int center[3];
+      int r = quality->colorRadius;
+
+      memcpy ( center, fit->color, sizeof ( center ) );
+
+      for ( dr = -r; dr <= r; dr++ )
+      {
+         for ( dg = -r; dg <= r; dg++ )
+         {
+            for ( db = -r; db <= r; db++ )
+            {
+               candidate.color[0] = center[0] + dr;
+               candidate.color[1] = center[1] + dg;
+               candidate.color[2] = center[2] + db;
+
+               if ( candidate.color[0] < low[0] || candidate.color[0] > high[0] ||
+                    candidate.color[1] < low[1] || candidate.color[1] > high[1] ||
+                    candidate.color[2] < low[2] || candidate.color[2] > high[2] )
+               {
+                  continue;
+               }
+
+               for ( table = 0; table < 8; table++ )
+               {
+                  candidate.table = table;
+
+                  if ( EvaluateSubblock ( block, pixels, bits, &candidate, fit->error ) < fit->error )
+                  {
+                     *fit = candidate;
+                  }
+               }
+            }
+         }
+      }
+   }
+}
+
+///
+// PackETC1()
+//
+//    Write an individual or differential mode block
+//
+static void PackETC1 ( GLubyte out[8], int differential, int flip, const SubblockFit *first, const SubblockFit *second )
+{
+   unsigned int msb = 0;
+   unsigned int lsb = 0;
+   int          c, i;
+
+   for ( c = 0; c < 3; c++ )
+   {
+      if ( differential )
+      {
+         out[c] = ( GLubyte ) ( ( first->color[c] << 3 ) | ( ( second->color[c] - first->color[c] ) & 7 ) );
+      }
+      else
+      {
+         out[c] = ( GLubyte ) ( ( first->color[c] << 4 ) | second->color[c] );
+      }
+   }
+
+   out[3] = ( GLubyte ) ( ( first->table << 5 ) | ( second->table << 2 ) | ( differential << 1 ) | flip );
+
+   for ( i = 0; i < 8; i++ )
+   {
+      msb |= ( unsigned int ) ( first->selectors[i] >> 1 ) << subblockPixels[flip][0][i];
+      lsb |= ( unsigned int ) ( first->selectors[i] & 1 ) << subblockPixels[flip][0][i];
+      msb |= ( unsigned int ) ( second->selectors[i] >> 1 ) << subblockPixels[flip][1][i];
+      lsb |= ( unsigned int ) ( second->selectors[i] & 1 ) << subblockPixels[flip][1][i];
+   }
+
+   out[4] = ( GLubyte ) ( msb >> 8 );
+   out[5] = ( GLubyte ) msb;
+   out[6] = ( GLubyte ) ( lsb >> 8 );
+   out[7] = ( GLubyte ) lsb;
+}
+
+///
+// PlanarChannelError()
+//
+static int PlanarChannelError ( const GLubyte block[16][4], int c, int origin, int horizontal, int vertical )
+{
+   int error = 0;
+   int x, y;
+
+   for ( x = 0; x < 4; x++ )
+   {
+      for ( y = 0; y < 4; y++ )
+      {
+         int value = ( x * ( horizontal - origin ) + y * ( vertical - origin ) + 4 * origin + 2 ) >> 2;
+         int d = Clamp ( value, 0, 255 ) - block[x * 4 + y][c];
+
+         error += d * d;
+      }
+   }
+
+   return error;
+}
+
+///
+// EncodePlanar()
+//
+//    Fit a plane through each channel by least squares, then search the
+//    quantized colors around it.  Channels are independent in this mode.
+//
+static int EncodePlanar ( const GLubyte block[16][4], const Quality *quality, GLubyte out[8] )
+{
+   static const int bits[3] = { 6, 7, 6 };
+   int              origin[3], horizontal[3], vertical[3];
+   int              radius = 1 + quality->colorRadius;
+   int              error = 0;
+   int              c, x, y, o, h, v;
+   unsigned long long packed;
+
+   for ( c = 0; c < 3; c++ )
+   {
+      float sum = 0.0f, sumX = 0.0f, sumY = 0.0f;
+      float slopeX, slopeY, base;
+      int   fitted[3];
+      int   max = ( 1 << bits[c] ) - 1;
+      int   best = INT_MAX;
+
+      for ( x = 0; x < 4; x++ )
+      {
+         for ( y = 0; y < 4; y++ )
+         {
+            float p = block[x * 4 + y][c];
+
+            sum += p;
+            sumX += ( x - 1.5f ) * p;
+            sumY += ( y - 1.5f ) * p;
+         }
+      }
+
+      // Each coordinate is sampled four times, so sum ( x - 1.5 )^2 is 20
+      slopeX = sumX / 20.0f;
+      slopeY = sumY / 20.0f;
+      base = sum / 16.0f - 1.5f * ( slopeX + slopeY );
+
+      fitted[0] = Quantize ( ( int ) floorf ( base + 0.5f ), bits[c] );
+      fitted[1] = Quantize ( ( int ) floorf ( base + 4.0f * slopeX + 0.5f ), bits[c] );
+      fitted[2] = Quantize ( ( int ) floorf ( base + 4.0f * slopeY + 0.5f ), bits[c] );
+
+      for ( o = Clamp ( fitted[0] - radius, 0, max ); o <= Clamp ( fitted[0] + radius, 0, max ); o++ )
+      {
+         for ( h = Clamp ( fitted[1] - radius, 0, max ); h <= Clamp ( fitted[1] + radius, 0, max ); h++ )
+         {
+            for ( v = Clamp ( fitted[2] - radius, 0, max ); v <= Clamp ( fitted[2] + radius, 0, max ); v++ )
+            {
+               int e = PlanarChannelError ( block, c, Expand ( o, bits[c] ), Expand ( h, bits[c] ), Expand ( v, bits[c] ) );
+
+               if ( e < best )
+               {
+                  best = e;
+                  origin[c] = o;
+                  horizontal[c] = h;
+                  vertical[c] = v;
+               }
+            }
+         }
+      }
+
+      error += best;
+   }
+
+   packed = ( unsigned long long ) origin[0] << 57 |
+            ( unsigned long long ) ( origin[1] >> 6 ) << 56 |
+            ( unsigned long long ) ( origin[1] & 63 ) << 49 |
+            ( unsigned long long ) ( origin[2] >> 5 ) << 48 |
+            ( unsigned long long ) ( ( origin[2] >> 3 ) & 3 ) << 43 |
+            ( unsigned long long ) ( origin[2] & 7 ) << 39 |
+            ( unsigned long long ) ( horizontal[0] >> 1 ) << 34 |
+            ( unsigned long long ) 1 << 33 |
+            ( unsigned long long ) ( horizontal[0] & 1 ) << 32 |
+            ( unsigned long long ) horizontal[1] << 25 |
+            ( unsigned long long ) horizontal[2] << 19 |
+            ( unsigned long long ) vertical[0] << 13 |
+            ( unsigned long long ) vertical[1] << 6 |
+            ( unsigned long long ) vertical[2];
+
+   // A planar block reads as a differential block whose red and green
+   // stay in range and whose blue overflows.  The unused bits 63, 55, 47-45
+   // and 42 are set to make it so.
+   if ( ( int ) ( ( packed >> 59 ) & 31 ) + SignExtend3 ( ( int ) ( packed >> 56 ) ) < 0 )
+   {
+      packed |= ( unsigned long long ) 1 << 63;
+   }
+
+   if ( ( int ) ( ( packed >> 51 ) & 31 ) + SignExtend3 ( ( int ) ( packed >> 48 ) ) < 0 )
+   {
+      packed |= ( unsigned long long ) 1 << 55;
+   }
+
+   if ( ( ( origin[2] >> 3 ) & 3 ) + ( ( origin[2] >> 1 ) & 3 ) >= 4 )
+   {
+      packed |= ( unsigned long long ) 7 << 45;
+   }
+   else
+   {
+      packed |= ( unsigned long long ) 1 << 42;
+   }
+
+   for ( c = 0; c < 8; c++ )
+   {
+      out[c] = ( GLubyte ) ( packed >> ( 56 - 8 * c ) );
+   }
+
+   return error;
+}
+
+///
+// EncodeETC2Block()
+//
+//    Try both flips in individual and differential mode, then planar
+//    mode, and keep the block with the lowest squared error
+//
+static int EncodeETC2Block ( const GLubyte block[16][4], const Quality *quality, GLubyte out[8] )
+{
+   static const int zero[3] = { 0, 0, 0 };
+   static const int max4[3] = { 15, 15, 15 };
+   static const int max5[3] = { 31, 31, 31 };
+   SubblockFit      first, second;
+   GLubyte          planar[8];
+   int              low[3], high[3];
+   int              bestError = INT_MAX;
+   int              flip, c, error;
+
+   for ( flip = 0; flip < 2 && bestError > 0; flip++ )
+   {
+      const int *pixels0 = subblockPixels[flip][0];
+      const int *pixels1 = subblockPixels[flip][1];
+
+      // Individual mode, two independent 444 colors
+      FitSubblock ( block, pixels0, 4, zero, max4, quality, &first );
+      FitSubblock ( block, pixels1, 4, zero, max4, quality, &second );
+
+      if ( first.error + second.error < bestError )
+      {
+         bestError = first.error + second.error;
+         PackETC1 ( out, 0, flip, &first, &second );
+      }
+
+      // Differential mode, a 555 color and a second one within [-4, 3] of
+      // it, fitted starting from either subblock
+      FitSubblock ( block, pixels0, 5, zero, max5, quality, &first );
+
+      for ( c = 0; c < 3; c++ )
+      {
+         low[c] = Clamp ( first.color[c] - 4, 0, 31 );
+         high[c] = Clamp ( first.color[c] + 3, 0, 31 );
+      }
+
+      FitSubblock ( block, pixels1, 5, low, high, quality, &second );
+
+      if ( first.error + second.error < bestError )
+      {
+         bestError = first.error + second.error;
+         PackETC1 ( out, 1, flip, &first, &second );
+      }
+
+      FitSubblock ( block, pixels1, 5, zero, max5, quality, &second );
+
+      for ( c = 0; c < 3; c++ )
+      {
+         low[c] = Clamp ( second.color[c] - 3, 0, 31 );
+         high[c] = Clamp ( second.color[c] + 4, 0, 31 );
+      }
+
+      FitSubblock ( block, pixels0, 5, low, high, quality, &first );
+
+      if ( first.error + second.error < bestError )
+      {
+         bestError = first.error + second.error;
+         PackETC1 ( out, 1, flip, &first, &second );
+      }
+   }
+
+   if ( quality->planar && bestError > 0 )
+   {
+      error = EncodePlanar ( block, quality, planar );
+
+      if ( error < bestError )
+      {
+         bestError = error;
+         memcpy ( out, planar, sizeof ( planar ) );
+      }
+   }
+
+   return bestError;
+}
+
+///
+// EACValue()
+//
+//    Decoded value of one EAC selector, 0-255 for alpha, 0-2047 for R11
+//
+static int EACValue ( int base, int multiplier, int modifier, int r11 )
+{
+   if ( !r11 )
+   {
+      return Clamp ( base + modifier * multiplier, 0, 255 );
+   }
+
+   if ( multiplier == 0 )
+   {
+      return Clamp ( base * 8 + 4 + modifier, 0, 2047 );
+   }
+
+   return Clamp ( base * 8 + 4 + modifier * multiplier * 8, 0, 2047 );
+}
+
+///
+// EncodeEACBlock()
+//
+//    For every modifier table, fit the multiplier to the block's range
+//    and the base codeword to its midpoint, then search around both
+//
+static int EncodeEACBlock ( const int values[16], int r11, const Quality *quality, GLubyte out[8] )
+{
+   int                unit = r11 ? 8 : 1;
+   int                minMultiplier = r11 ? 0 : 1;
+   int                low = values[0], high = values[0];
+   int                bestError = INT_MAX;
+   int                bestBase = 0, bestMultiplier = 1, bestTable = 0;
+   int                selectors[16], bestSelectors[16];
+   int                table, multiplier, base, i, s;
+   unsigned long long packed;
+
+   for ( i = 1; i < 16; i++ )
+   {
+      low = values[i] < low ? values[i] : low;
+      high = values[i] > high ? values[i] : high;
+   }
+
+   for ( table = 0; table < 16 && bestError > 0; table++ )
+   {
+      const int *modifiers = eacModifiers[table];
+      int        span = ( modifiers[7] - modifiers[3] ) * unit;
+      int        fitted = Clamp ( ( high - low + span / 2 ) / span, minMultiplier, 15 );
+      int        firstMultiplier = Clamp ( fitted - quality->multiplierRadius, minMultiplier, 15 );
+      int        lastMultiplier = Clamp ( fitted + quality->multiplierRadius, minMultiplier, 15 );
+
+      for ( multiplier = firstMultiplier; multiplier <= lastMultiplier; multiplier++ )
+      {
+         int scale = r11 ? ( multiplier ? multiplier * 8 : 1 ) : multiplier;
+
+         // Center the table's range of modifiers on the block's range
+         int center = ( low + high ) / 2 - ( modifiers[3] + modifiers[7] ) * scale / 2;
+         int fittedBase = ( center - ( r11 ? 4 : 0 ) + unit / 2 ) / unit;
+         int firstBase = Clamp ( fittedBase - quality->baseRadius, 0, 255 );
+         int lastBase = Clamp ( fittedBase + quality->baseRadius, 0, 255 );
+
+         for ( base = firstBase; base <= lastBase; base++ )
+         {
+            int palette[8];
+            int error = 0;
+
+            for ( s = 0; s < 8; s++ )
+            {
+               palette[s] = EACValue ( base, multiplier, modifiers[s], r11 );
+            }
+
+            for ( i = 0; i < 16 && error < bestError; i++ )
+            {
+               int best = INT_MAX;
+
+               for ( s = 0; s < 8; s++ )
+               {
+                  int d = palette[s] - values[i];
+
+                  if ( d * d < best )
+                  {
+                     best = d * d;
+                     selectors[i] = s;
+                  }
+               }
+
+               error += best;
+            }
+
+            if ( error < bestError )
+            {
+               bestError = error;
+               bestBase = base;
+               bestMultiplier = multiplier;
+               bestTable = table;
+               memcpy ( bestSelectors, selectors, sizeof ( selectors ) );
+            }
+         }
+      }
+   }
+
+   packed = 0;
+
+   for ( i = 0; i < 16; i++ )
+   {
+      packed = ( packed << 3 ) | ( unsigned long long ) bestSelectors[i];
+   }
+
+   out[0] = ( GLubyte ) bestBase;
+   out[1] = ( GLubyte ) ( ( bestMultiplier << 4 ) | bestTable );
+
+   for ( i = 0; i < 6; i++ )
+   {
+      out[2 + i] = ( GLubyte ) ( packed >> ( 40 - 8 * i ) );
+   }
+
+   return bestError;
+}
+
+///
+// EncodeBlock()
+//
+static void EncodeBlock ( const EncodeJob *job, const GLubyte block[16][4], GLubyte *out )
+{
+   int values[16];
+   int c, i;
+
+   switch ( job->format->internalFormat )
+   {
+      case GL_COMPRESSED_RGB8_ETC2:
+         EncodeETC2Block ( block, job->quality, out );
+         break;
+
+      case GL_COMPRESSED_RGBA8_ETC2_EAC:
+         for ( i = 0; i < 16; i++ )
+         {
+            values[i] = block[i][3];
+         }
+
+         EncodeEACBlock ( values, GL_FALSE, job->quality, out );
+         EncodeETC2Block ( block, job->quality, out + 8 );
+         break;
+
+      default:
+         // R11 and RG11, one EAC block per channel on the 11-bit scale
+         for ( c = 0; c < job->format->blockBytes / 8; c++ )
+         {
+            for ( i = 0; i < 16; i++ )
+            {
+               values[i] = ( block[i][c] * 2047 + 127 ) / 255;
+            }
+
+            EncodeEACBlock ( values, GL_TRUE, job->quality, out + 8 * c );
+         }
+         break;
+   }
+}
+
+///
+// EncodeRows()
+//
+//    esParallelFor work function, encodes block rows [begin, end)
+//
+static void ESCALLBACK EncodeRows ( void *userData, int begin, int end )
+{
+   EncodeJob *job = userData;
+   int        blocksX = ( job->width + 3 ) / 4;
+   GLubyte    block[16][4];
+   int        x, y;
+
+   for ( y = begin; y < end; y++ )
+   {
+      for ( x = 0; x < blocksX; x++ )
+      {
+         FetchBlock ( job, x, y, block );
+         EncodeBlock ( job, block, job->blocks + ( ( size_t ) y * blocksX + x ) * job->format->blockBytes );
+      }
+   }
+}
+
+///
+// DecodeETC2Block()
+//
+//    Decode the RGB of any ETC2 block, including the T and H modes the
+//    encoder does not produce
+//
+static void DecodeETC2Block ( const GLubyte *in, float block[16][4] )
+{
+   unsigned int high = ( unsigned int ) in[0] << 24 | ( unsigned int ) in[1] << 16 | ( unsigned int ) in[2] << 8 | in[3];
+   unsigned int low = ( unsigned int ) in[4] << 24 | ( unsigned int ) in[5] << 16 | ( unsigned int ) in[6] << 8 | in[7];
+   int          base[2][3];
+   int          paint[4][3];
+   int          sum[3];
+   int          c, i, s, x, y;
+
+   if ( high & 2 )
+   {
+      for ( c = 0; c < 3; c++ )
+      {
+         sum[c] = ( in[c] >> 3 ) + SignExtend3 ( in[c] );
+      }
+   }
+
+   if ( ( high & 2 ) && ( sum[0] < 0 || sum[0] > 31 || sum[1] < 0 || sum[1] > 31 ) )
+   {
+      int first[3], second[3];
+      int distance;
+
+      if ( sum[0] < 0 || sum[0] > 31 )
+      {
+         // T mode
+         first[0] = ( ( high >> 27 ) & 3 ) << 2 | ( ( high >> 24 ) & 3 );
+         first[1] = ( high >> 20 ) & 15;
+         first[2] = ( high >> 16 ) & 15;
+         second[0] = ( high >> 12 ) & 15;
+         second[1] = ( high >> 8 ) & 15;
+         second[2] = ( high >> 4 ) & 15;
+         distance = etcDistances[( ( high >> 2 ) & 3 ) << 1 | ( high & 1 )];
+
+         for ( c = 0; c < 3; c++ )
+         {
+            paint[0][c] = Expand ( first[c], 4 );
+            paint[1][c] = Clamp ( Expand ( second[c], 4 ) + distance, 0, 255 );
+            paint[2][c] = Expand ( second[c], 4 );
+            paint[3][c] = Clamp ( Expand ( second[c], 4 ) - distance, 0, 255 );
+         }
+      }
+      else
+      {
+         // H mode, the order of the two colors holds the distance's low bit
+         int index;
+
+         first[0] = ( high >> 27 ) & 15;
+         first[1] = ( ( high >> 24 ) & 7 ) << 1 | ( ( high >> 20 ) & 1 );
+         first[2] = ( ( high >> 19 ) & 1 ) << 3 | ( ( high >> 15 ) & 7 );
+         second[0] = ( high >> 11 ) & 15;
+         second[1] = ( high >> 7 ) & 15;
+         second[2] = ( high >> 3 ) & 15;
+         index = ( ( high >> 2 ) & 1 ) << 2 | ( high & 1 ) << 1;
+         index |= ( first[0] << 8 | first[1] << 4 | first[2] ) >= ( second[0] << 8 | second[1] << 4 | second[2] );
+         distance = etcDistances[index];
+
+         for ( c = 0; c < 3; c++ )
+         {
+            paint[0][c] = Clamp ( Expand ( first[c], 4 ) + distance, 0, 255 );
+            paint[1][c] = Clamp ( Expand ( first[c], 4 ) - distance, 0, 255 );
+            paint[2][c] = Clamp ( Expand ( second[c], 4 ) + distance, 0, 255 );
+            paint[3][c] = Clamp ( Expand ( second[c], 4 ) - distance, 0, 255 );
+         }
+      }
+
+      for ( i = 0; i < 16; i++ )
+      {
+         s = ( ( low >> ( i + 16 ) ) & 1 ) << 1 | ( ( low >> i ) & 1 );
+
+         for ( c = 0; c < 3; c++ )
+         {
+            block[i][c] = ( float ) paint[s][c];
+         }
+      }
+   }
+   else if ( ( high & 2 ) && ( sum[2] < 0 || sum[2] > 31 ) )
+   {
+      // Planar mode
+      int origin[3], horizontal[3], vertical[3];
+
+      origin[0] = Expand ( ( high >> 25 ) & 63, 6 );
+      origin[1] = Expand ( ( ( high >> 24 ) & 1 ) << 6 | ( ( high >> 17 ) & 63 ), 7 );
+      origin[2] = Expand ( ( ( high >> 16 ) & 1 ) << 5 | ( ( high >> 11 ) & 3 ) << 3 | ( ( high >> 7 ) & 7 ), 6 );
+      horizontal[0] = Expand ( ( ( high >> 2 ) & 31 ) << 1 | ( high & 1 ), 6 );
+      horizontal[1] = Expand ( ( low >> 25 ) & 127, 7 );
+      horizontal[2] = Expand ( ( low >> 19 ) & 63, 6 );
+      vertical[0] = Expand ( ( low >> 13 ) & 63, 6 );
+      vertical[1] = Expand ( ( low >> 6 ) & 127, 7 );
+      vertical[2] = Expand ( low & 63, 6 );
+
+      for ( x = 0; x < 4; x++ )
+      {
+         for ( y = 0; y < 4; y++ )
+         {
+            for ( c = 0; c < 3; c++ )
+            {
+               int value = ( x * ( horizontal[c] - origin[c] ) + y * ( vertical[c] - origin[c] ) + 4 * origin[c] + 2 ) >> 2;
+
+               block[x * 4 + y][c] = ( float ) Clamp ( value, 0, 255 );
+            }
+         }
+      }
+   }
+   else
+   {
+      // Individual or differential mode
+      int flip = high & 1;
+      int tables[2];
+
+      for ( c = 0; c < 3; c++ )
+      {
+         if ( high & 2 )
+         {
+            base[0][c] = Expand ( in[c] >> 3, 5 );
+            base[1][c] = Expand ( sum[c], 5 );
+         }
+         else
+         {
+            base[0][c] = Expand ( in[c] >> 4, 4 );
+            base[1][c] = Expand ( in[c] & 15, 4 );
+         }
+      }
+
+      tables[0] = ( high >> 5 ) & 7;
+      tables[1] = ( high >> 2 ) & 7;
+
+      for ( i = 0; i < 16; i++ )
+      {
+         int subblock = flip ? ( i & 3 ) >= 2 : i >= 8;
+
+         s = ( ( low >> ( i + 16 ) ) & 1 ) << 1 | ( ( low >> i ) & 1 );
+
+         for ( c = 0; c < 3; c++ )
+         {
+            block[i][c] = ( float ) Clamp ( base[subblock][c] + etcModifiers[tables[subblock]][s], 0, 255 );
+         }
+      }
+   }
+}
+
+///
+// DecodeEACBlock()
+//
+//    Decode an EAC block into one channel of a block, on the 0-255 scale
+//
+static void DecodeEACBlock ( const GLubyte *in, int r11, float block[16][4], int channel )
+{
+   unsigned long long packed = 0;
+   int                i;
+
+   for ( i = 2; i < 8; i++ )
+   {
+      packed = ( packed << 8 ) | in[i];
+   }
+
+   for ( i = 0; i < 16; i++ )
+   {
+      int modifier = eacModifiers[in[1] & 15][( packed >> ( 45 - 3 * i ) ) & 7];
+      int value = EACValue ( in[0], in[1] >> 4, modifier, r11 );
+
+      block[i][channel] = r11 ? value * 255.0f / 2047.0f : ( float ) value;
+   }
+}
+
+///
+// ReportPSNR()
+//
+//    Decode a level and print the PSNR of each channel group
+//
+static void ReportPSNR ( const EncodeJob *job )
+{
+   static const char *names[2][4] = { { "RGB", "A", "", "" }, { "R", "G", "", "" } };
+   double             squares[4] = { 0.0, 0.0, 0.0, 0.0 };
+   int                blocksX = ( job->width + 3 ) / 4;
+   int                blocksY = ( job->height + 3 ) / 4;
+   int                eac = job->format->internalFormat == GL_COMPRESSED_R11_EAC ||
+                            job->format->internalFormat == GL_COMPRESSED_RG11_EAC;
+   int                groups = 0;
+   int                bx, by, x, y, c, g;
+
+   for ( by = 0; by < blocksY; by++ )
+   {
+      for ( bx = 0; bx < blocksX; bx++ )
+      {
+         const GLubyte *in = job->blocks + ( ( size_t ) by * blocksX + bx ) * job->format->blockBytes;
+         float          block[16][4];
+
+         switch ( job->format->internalFormat )
+         {
+            case GL_COMPRESSED_RGB8_ETC2:
+               DecodeETC2Block ( in, block );
+               groups = 1;
+               break;
+
+            case GL_COMPRESSED_RGBA8_ETC2_EAC:
+               DecodeEACBlock ( in, GL_FALSE, block, 3 );
+               DecodeETC2Block ( in + 8, block );
+               groups = 2;
+               break;
+
+            default:
+               groups = job->format->blockBytes / 8;
+
+               for ( c = 0; c < groups; c++ )
+               {
+                  DecodeEACBlock ( in + 8 * c, GL_TRUE, block, c );
+               }
+               break;
+         }
+
+         for ( x = 0; x < 4 && bx * 4 + x < job->width; x++ )
+         {
+            for ( y = 0; y < 4 && by * 4 + y < job->height; y++ )
+            {
+               const GLubyte *p = job->pixels + ( ( size_t ) ( by * 4 + y ) * job->width + bx * 4 + x ) * 4;
+               const float   *d = block[x * 4 + y];
+
+               if ( eac )
+               {
+                  for ( c = 0; c < groups; c++ )
+                  {
+                     squares[c] += ( d[c] - p[c] ) * ( d[c] - p[c] );
+                  }
+               }
+               else
+               {
+                  for ( c = 0; c < 3; c++ )
+                  {
+                     squares[0] += ( d[c] - p[c] ) * ( d[c] - p[c] );
+                  }
+
+                  squares[1] += ( d[3] - p[3] ) * ( d[3] - p[3] );
+               }
+            }
+         }
+      }
+   }
+
+   for ( g = 0; g < groups; g++ )
+   {
+      double samples = ( double ) job->width * job->height * ( !eac && g == 0 ? 3 : 1 );
+      double mse = squares[g] / samples;
+
+      if ( mse > 0.0 )
+      {
+         printf ( "  %-3s PSNR %.2f dB\n", names[eac][g], 10.0 * log10 ( 255.0 * 255.0 / mse ) );
+      }
+      else
+      {
+         printf ( "  %-3s PSNR lossless\n", names[eac][g] );
+      }
+   }
+}
+
+///
+// Downsample()
+//
+//    Box filter an RGBA8 level to the next mip level
+//
+static GLubyte *Downsample ( const GLubyte *src, int width, int height, int *outWidth, int *outHeight )
+{
+   int      w = width > 1 ? width / 2 : 1;
+   int      h = height > 1 ? height / 2 : 1;
+   GLubyte *dst = malloc ( ( size_t ) w * h * 4 );
+   int      x, y, c;
+
+   if ( dst == NULL )
+   {
+      return NULL;
+   }
+
+   for ( y = 0; y < h; y++ )
+   {
+      const GLubyte *row0 = src + ( size_t ) ( y * 2 ) * width * 4;
+      const GLubyte *row1 = src + ( size_t ) ( height > 1 ? y * 2 + 1 : y * 2 ) * width * 4;
+
+      for ( x = 0; x < w; x++ )
+      {
+         int x0 = x * 2 * 4;
+         int x1 = ( width > 1 ? x * 2 + 1 : x * 2 ) * 4;
+
+         for ( c = 0; c < 4; c++ )
+         {
+            dst[( ( size_t ) y * w + x ) * 4 + c] = ( GLubyte ) ( ( row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2 ) / 4 );
+         }
+      }
+   }
+
+   *outWidth = w;
+   *outHeight = h;
+   return dst;
+}
+
+///
+// LoadImage()
+//
+//    Read a TGA file and widen it to RGBA8, bottom row first
+//
+static GLubyte *LoadImage ( const char *fileName, int *width, int *height, int *components )
+{
+   FILE    *fp = fopen ( fileName, "rb" );
+   GLubyte *data = NULL;
+   GLubyte *pixels = NULL;
+   GLubyte *rgba = NULL;
+   long     size;
+   size_t   i, count;
+
+   if ( fp == NULL )
+   {
+      fprintf ( stderr, "ETCCompress: cannot open %s\n", fileName );
+      return NULL;
+   }
+
+   if ( fseek ( fp, 0, SEEK_END ) == 0 && ( size = ftell ( fp ) ) > 0 && size <= INT_MAX &&
+        fseek ( fp, 0, SEEK_SET ) == 0 && ( data = malloc ( size ) ) != NULL &&
+        fread ( data, 1, size, fp ) == ( size_t ) size &&
+        esDecodeTGA ( data, ( int ) size, width, height, components, NULL ) )
+   {
+      count = ( size_t ) *width * *height;
+      pixels = malloc ( count * *components );
+      rgba = malloc ( count * 4 );
+
+      if ( pixels != NULL && rgba != NULL &&
+           esDecodeTGA ( data, ( int ) size, width, height, components, pixels ) )
+      {
+         for ( i = 0; i < count; i++ )
+         {
+            const GLubyte *p = pixels + i * *components;
+
+            rgba[i * 4 + 0] = p[0];
+            rgba[i * 4 + 1] = p[*components >= 3 ? 1 : 0];
+            rgba[i * 4 + 2] = p[*components >= 3 ? 2 : 0];
+            rgba[i * 4 + 3] = *components == 4 ? p[3] : 255;
+         }
+      }
+      else
+      {
+         free ( rgba );
+         rgba = NULL;
+      }
+   }
+
+   if ( rgba == NULL )
+   {
+      fprintf ( stderr, "ETCCompress: cannot read %s\n", fileName );
+   }
+
+   free ( pixels );
+   free ( data );
+   fclose ( fp );
+   return rgba;
+}
+
+///
+// WriteUint32()
+//
+static void WriteUint32 ( FILE *fp, unsigned int value )
+{
+   fwrite ( &value, sizeof ( value ), 1, fp );
+}
+
+///
+// WriteKTX()
+//
+//    Write a KTX 1.1 file in native byte order.  The rows are bottom to
+//    top, as TGA images and glCompressedTexImage2D store them, which the
+//    KTXorientation entry records.
+//
+static int WriteKTX ( const char *fileName, const Format *format, int width, int height,
+                      int numLevels, GLubyte *const *levels, const int *levelSizes )
+{
+   static const GLubyte identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+   static const char    orientation[] = "KTXorientation\0S=r,T=u";
+   static const GLubyte padding[3] = { 0, 0, 0 };
+   unsigned int         keyValueSize = ( unsigned int ) sizeof ( orientation );
+   unsigned int         keyValuePadding = ( 4 - keyValueSize % 4 ) % 4;
+   FILE                *fp = fopen ( fileName, "wb" );
+   int                  level;
+   int                  ok;
+
+   if ( fp == NULL )
+   {
+      return GL_FALSE;
+   }
+
+   fwrite ( identifier, sizeof ( identifier ), 1, fp );
+   WriteUint32 ( fp, 0x04030201 );
+   WriteUint32 ( fp, 0 );                     // glType
+   WriteUint32 ( fp, 1 );                     // glTypeSize
+   WriteUint32 ( fp, 0 );                     // glFormat
+   WriteUint32 ( fp, format->internalFormat );
+   WriteUint32 ( fp, format->baseFormat );
+   WriteUint32 ( fp, width );
+   WriteUint32 ( fp, height );
+   WriteUint32 ( fp, 0 );                     // pixelDepth
+   WriteUint32 ( fp, 0 );                     // numberOfArrayElements
+   WriteUint32 ( fp, 1 );                     // numberOfFaces
+   WriteUint32 ( fp, numLevels );
+   WriteUint32 ( fp, 4 + keyValueSize + keyValuePadding );
+   WriteUint32 ( fp, keyValueSize );
+   fwrite ( orientation, keyValueSize, 1, fp );
+   fwrite ( padding, keyValuePadding, 1, fp );
+
+   // Block sizes are multiples of 8, so no level needs padding
+   for ( level = 0; level < numLevels; level++ )
+   {
+      WriteUint32 ( fp, levelSizes[level] );
+      fwrite ( levels[level], levelSizes[level], 1, fp );
+   }
+
+   ok = !ferror ( fp );
+   ok = fclose ( fp ) == 0 && ok;
+   return ok;
+}
+
+///
+// PrintUsage()
+//
+static void PrintUsage ( void )
+{
+   fprintf ( stderr,
+             "usage: ETCCompress [-format rgb|rgba|r11|rg11] [-quality fast|medium|high]\n"
+             "                   [-nomips] input.tga output.ktx\n" );
+}
+
+//////////////////////////////////////////////////////////////////
+//
+//  Public Functions
+//
+//
+
+///
+// esLogMessage()
+//
+//    esTGA.c reports errors through esLogMessage.  There is no platform
+//    layer in the tool, so they go to stderr.
+//
+void ESUTIL_API esLogMessage ( const char *formatStr, ... )
+{
+   va_list params;
+
+   va_start ( params, formatStr );
+   vfprintf ( stderr, formatStr, params );
+   va_end ( params );
+}
+
+///
+// main()
+//
+int main ( int argc, char *argv[] )
+{
+   const Format  *format = NULL;
+   const Quality *quality = &qualities[1];
+   const char    *inputName = NULL;
+   const char    *outputName = NULL;
+   GLubyte       *levels[MAX_LEVELS];
+   int            levelSizes[MAX_LEVELS];
+   int            mipmaps = GL_TRUE;
+   int            numLevels = 0;
+   int            totalSize = 0;
+   int            width, height, components;
+   int            i, ok;
+   EncodeJob      job;
+
+   for ( i = 1; i < argc; i++ )
+   {
+      if ( strcmp ( argv[i], "-format" ) == 0 && i + 1 < argc )
+      {
+         const char *name = argv[++i];
+
+         for ( format = formats; format < formats + sizeof ( formats ) / sizeof ( formats[0] ); format++ )
+         {
+            if ( strcmp ( format->name, name ) == 0 )
+            {
+               break;
+            }
+         }
+
+         if ( format == formats + sizeof ( formats ) / sizeof ( formats[0] ) )
+         {
+            PrintUsage ();
+            return 1;
+         }
+      }
+      else if ( strcmp ( argv[i], "-quality" ) == 0 && i + 1 < argc )
+      {
+         const char *name = argv[++i];
+
+         for ( quality = qualities; quality < qualities + sizeof ( qualities ) / sizeof ( qualities[0] ); quality++ )
+         {
+            if ( strcmp ( quality->name, name ) == 0 )
+            {
+               break;
+            }
+         }
+
+         if ( quality == qualities + sizeof ( qualities ) / sizeof ( qualities[0] ) )
+         {
+            PrintUsage ();
+            return 1;
+         }
+      }
+      else if ( strcmp ( argv[i], "-nomips" ) == 0 )
+      {
+         mipmaps = GL_FALSE;
+      }
+      else if ( argv[i][0] != '-' && inputName == NULL )
+      {
+         inputName = argv[i];
+      }
+      else if ( argv[i][0] != '-' && outputName == NULL )
+      {
+         outputName = argv[i];
+      }
+      else
+      {
+         PrintUsage ();
+         return 1;
+      }
+   }
+
+   if ( inputName == NULL || outputName == NULL )
+   {
+      PrintUsage ();
+      return 1;
+   }
+
+   job.pixels = LoadImage ( inputName, &width, &height, &components );
+
+   if ( job.pixels == NULL )
+   {
+      return 1;
+   }
+
+   if ( format == NULL )
+   {
+      format = components == 1 ? &formats[2] : components == 4 ? &formats[1] : &formats[0];
+   }
+
+   job.width = width;
+   job.height = height;
+   job.format = format;
+   job.quality = quality;
+
+   printf ( "%s: %d x %d, %s, %s quality\n", inputName, width, height, format->name, quality->name );
+
+   for ( ;; )
+   {
+      int blocksY = ( job.height + 3 ) / 4;
+      int size = ( ( job.width + 3 ) / 4 ) * blocksY * format->blockBytes;
+      int w, h;
+      GLubyte *next;
+
+      job.blocks = malloc ( size );
+
+      if ( job.blocks == NULL )
+      {
+         fprintf ( stderr, "ETCCompress: out of memory\n" );
+         return 1;
+      }
+
+      esParallelFor ( blocksY, 1, EncodeRows, &job );
+
+      if ( numLevels == 0 )
+      {
+         ReportPSNR ( &job );
+      }
+
+      levels[numLevels] = job.blocks;
+      levelSizes[numLevels] = size;
+      totalSize += size;
+      numLevels++;
+
+      if ( !mipmaps || ( job.width == 1 && job.height == 1 ) )
+      {
+         break;
+      }
+
+      next = Downsample ( job.pixels, job.width, job.height, &w, &h );
+
+      if ( next == NULL )
+      {
+         fprintf ( stderr, "ETCCompress: out of memory\n" );
+         return 1;
+      }
+
+      free ( ( void * ) job.pixels );
+      job.pixels = next;
+      job.width = w;
+      job.height = h;
+   }
+
+   free ( ( void * ) job.pixels );
+
+   ok = WriteKTX ( outputName, format, width, height, numLevels, levels, levelSizes );
+
+   if ( ok )
+   {
+      printf ( "  wrote %s, %d levels, %d bytes of blocks\n", outputName, numLevels, totalSize );
+   }
+   else
+   {
+      fprintf ( stderr, "ETCCompress: cannot write %s\n", outputName );
+   }
+
+   for ( i = 0; i < numLevels; i++ )
+   {
+      free ( levels[i] );
+   }
+
+   return ok ? 0 : 1;
+}
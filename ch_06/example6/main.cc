@@ -1,17 +1,39 @@
-#include <algorithm>
 #include <cstddef>
-#include <vector>
+#include <cstdlib>
+#include <new>
 
+#include "../mesh_registry.hh"
 #include "esUtil.h"
 
-struct UserData {
-		GLuint              program;
-		std::vector<GLuint> vbo_ids;
+// Counts every heap allocation made through operator new so draw ( ) can
+// verify that rendering a frame does not allocate. C++ drivers allocate
+// through it too while they build state on the first frames, so only
+// steady-state reports are meaningful.
+static size_t allocation_count = 0;
+
+void *operator new ( size_t size )
+{
+	++allocation_count;
+
+	if ( auto ptr = std::malloc ( size ? size : 1 ) ) return ptr;
+
+	throw std::bad_alloc { };
+}
 
-		UserData ( size_t n )
-		    : vbo_ids ( n )
-		{
-		}
+void operator delete ( void *ptr ) noexcept
+{
+	std::free ( ptr );
+}
+
+void operator delete ( void *ptr, size_t ) noexcept
+{
+	std::free ( ptr );
+}
+
+struct UserData {
+		GLuint               program;
+		MeshRegistry         meshes;
+		MeshRegistry::Handle triangle;
 };
 
 GLuint load_shader ( GLenum type, char const *shader_src )
@@ -98,6 +120,31 @@ bool init ( ESContext *context )
 	if ( linked ) {
 		user_data->program = program;
 
+		// Upload the geometry once; draw ( ) only refers to it by handle
+		user_data->triangle = user_data->meshes.add (
+		    {
+			{
+			    0,
+			    3,
+			    {
+				0.0,  0.5,  0.0,  // v0
+				-0.5, -0.5, 0.0,  // v1
+				0.5,  -0.5, 0.0,  // v2
+			    },
+			},
+			{
+			    1,
+			    4,
+			    {
+				1, 0, 0, 1,  // c0
+				0, 1, 0, 1,  // c1
+				0, 0, 1, 1,  // c2
+			    },
+			},
+		    },
+		    { 0, 1, 2 }
+		);
+
 		glClearColor ( 0, 0, 0, 0 );
 
 		return true;
@@ -121,118 +168,36 @@ bool init ( ESContext *context )
 	return false;
 }
 
-void draw_primitive_with_VBOs (
-    ESContext			       *context,
-    std::vector<std::vector<GLfloat>> const &vtx_buf,
-    std::vector<GLushort> const             &indices
-)
-{
-	auto user_data = reinterpret_cast<UserData *> ( context->userData );
-
-	if ( user_data->vbo_ids.cend ( )
-	     != std::find (
-		 user_data->vbo_ids.cbegin ( ),
-		 user_data->vbo_ids.cend ( ),
-		 0
-	     ) )
-	{
-		glGenBuffers (
-		    user_data->vbo_ids.size ( ),
-		    user_data->vbo_ids.data ( )
-		);
-
-		size_t i = 0;
-
-		for ( auto const &buf : vtx_buf ) {
-			glBindBuffer (
-			    GL_ARRAY_BUFFER,
-			    user_data->vbo_ids[i++]
-			);
-			glBufferData (
-			    GL_ARRAY_BUFFER,
-			    buf.size ( ) * sizeof ( GLfloat ),
-			    buf.data ( ),
-			    GL_STATIC_DRAW
-			);
-		}
-
-		glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, user_data->vbo_ids[i] );
-
-		glBufferData (
-		    GL_ELEMENT_ARRAY_BUFFER,
-		    indices.size ( ) * sizeof ( GLushort ),
-		    indices.data ( ),
-		    GL_STATIC_DRAW
-		);
-	}
-
-	glBindBuffer ( GL_ARRAY_BUFFER, user_data->vbo_ids[0] );
-	glEnableVertexAttribArray ( 0 );
-
-	glVertexAttribPointer (
-	    0,
-	    3,
-	    GL_FLOAT,
-	    GL_FALSE,
-	    sizeof ( GLfloat ) * 3,
-	    0
-	);
-
-	glBindBuffer ( GL_ARRAY_BUFFER, user_data->vbo_ids[1] );
-	glEnableVertexAttribArray ( 1 );
-
-	glVertexAttribPointer (
-	    1,
-	    4,
-	    GL_FLOAT,
-	    GL_FALSE,
-	    sizeof ( GLfloat ) * 4,
-	    0
-	);
-
-	glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, user_data->vbo_ids[2] );
-	glDrawElements ( GL_TRIANGLES, indices.size ( ), GL_UNSIGNED_SHORT, 0 );
-
-	glDisableVertexAttribArray ( 0 );
-	glDisableVertexAttribArray ( 1 );
-
-	glBindBuffer ( GL_ARRAY_BUFFER, 0 );
-	glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
-}
-
 void draw ( ESContext *context )
 {
-	auto user_data = reinterpret_cast<UserData *> ( context->userData );
+	auto user_data   = reinterpret_cast<UserData *> ( context->userData );
+	auto allocations = allocation_count;
 
 	glViewport ( 0, 0, context->width, context->height );
 	glClear ( GL_COLOR_BUFFER_BIT );
 	glUseProgram ( user_data->program );
 
-	std::vector<GLfloat> vertices {
-		0.0,  0.5,  0.0,  // v0
-		-0.5, -0.5, 0.0,  // v1
-		0.5,  -0.5, 0.0,  // v2
-	};
-
-	std::vector<GLfloat> colors {
-		1, 0, 0, 1,  // c0
-		0, 1, 0, 1,  // c1
-		0, 0, 1, 1,  // c2
-	};
+	user_data->meshes.draw ( user_data->triangle );
 
-	draw_primitive_with_VBOs ( context, { vertices, colors }, { 0, 1, 2 } );
+	if ( allocation_count != allocations ) {
+		esLogMessage (
+		    "draw ( ) made %zu heap allocations\n",
+		    allocation_count - allocations
+		);
+	}
 }
 
 void shutdown ( ESContext *context )
 {
 	auto user_data = reinterpret_cast<UserData *> ( context->userData );
 
+	user_data->meshes.clear ( );
 	glDeleteProgram ( user_data->program );
 }
 
 extern "C" int esMain ( ESContext *context )
 {
-	context->userData = new UserData ( 3 );
+	context->userData = new UserData;
 
 	esCreateWindow (
 	    context,
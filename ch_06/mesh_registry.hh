@@ -0,0 +1,126 @@
+#ifndef MESH_REGISTRY_HH
+#define MESH_REGISTRY_HH
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+#include "esUtil.h"
+
+// Owns the buffer and vertex array objects of every mesh a sample draws.
+// Geometry is uploaded once by add ( ); draw ( ) only binds the mesh's
+// vertex array and issues the draw call, so it never touches the heap.
+class MeshRegistry {
+	public:
+		using Handle = size_t;
+
+		struct Attribute {
+				GLuint               location;
+				GLint                size;
+				std::vector<GLfloat> data;
+		};
+
+		MeshRegistry ( ) = default;
+
+		MeshRegistry ( MeshRegistry const & )            = delete;
+		MeshRegistry &operator= ( MeshRegistry const & ) = delete;
+
+		~MeshRegistry ( )
+		{
+			clear ( );
+		}
+
+		Handle add (
+		    std::initializer_list<Attribute> attributes,
+		    std::vector<GLushort> const     &indices
+		)
+		{
+			Mesh mesh { 0, static_cast<GLsizei> ( indices.size ( ) ) };
+
+			glGenVertexArrays ( 1, &mesh.vao );
+			glBindVertexArray ( mesh.vao );
+
+			for ( auto const &attribute : attributes ) {
+				glBindBuffer ( GL_ARRAY_BUFFER, new_buffer ( ) );
+				glBufferData (
+				    GL_ARRAY_BUFFER,
+				    attribute.data.size ( ) * sizeof ( GLfloat ),
+				    attribute.data.data ( ),
+				    GL_STATIC_DRAW
+				);
+
+				glEnableVertexAttribArray ( attribute.location );
+
+				glVertexAttribPointer (
+				    attribute.location,
+				    attribute.size,
+				    GL_FLOAT,
+				    GL_FALSE,
+				    sizeof ( GLfloat ) * attribute.size,
+				    0
+				);
+			}
+
+			// The element array binding is recorded in the vertex array
+			glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, new_buffer ( ) );
+			glBufferData (
+			    GL_ELEMENT_ARRAY_BUFFER,
+			    indices.size ( ) * sizeof ( GLushort ),
+			    indices.data ( ),
+			    GL_STATIC_DRAW
+			);
+
+			glBindVertexArray ( 0 );
+			glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+			glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+			meshes.push_back ( mesh );
+
+			return meshes.size ( ) - 1;
+		}
+
+		// Delete every mesh; must be called while the context is current
+		void clear ( )
+		{
+			for ( auto const &mesh : meshes ) {
+				glDeleteVertexArrays ( 1, &mesh.vao );
+			}
+
+			if ( !buffers.empty ( ) ) {
+				glDeleteBuffers ( buffers.size ( ), buffers.data ( ) );
+			}
+
+			meshes.clear ( );
+			buffers.clear ( );
+		}
+
+		void draw ( Handle handle, GLenum mode = GL_TRIANGLES ) const
+		{
+			auto const &mesh = meshes[handle];
+
+			glBindVertexArray ( mesh.vao );
+			glDrawElements ( mode, mesh.index_count, GL_UNSIGNED_SHORT, 0 );
+			glBindVertexArray ( 0 );
+		}
+
+	private:
+		struct Mesh {
+				GLuint  vao;
+				GLsizei index_count;
+		};
+
+		GLuint new_buffer ( )
+		{
+			GLuint buffer;
+
+			glGenBuffers ( 1, &buffer );
+			buffers.push_back ( buffer );
+
+			return buffer;
+		}
+
+		std::vector<Mesh>   meshes;
+		std::vector<GLuint> buffers;
+};
+
+#endif  // MESH_REGISTRY_HH